@@ -0,0 +1,401 @@
+#define _GNU_SOURCE //posix_openpt, ptsname_r
+#include "loadLib.h" //Includes the loadLib.h header file for the generator structures and prototypes
+#include <sys/epoll.h> //epoll_create1, epoll_ctl, epoll_wait
+
+const char *ldName[LD_OPS]={"X","C","V","WTD","DEP","BAL","MST","PIN","BLK"}; //Opcode names
+
+/**
+ * @brief Returns a monotonic time stamp in nanoseconds.
+ * @return u64 Nanoseconds since an arbitrary point.
+ */
+u64 ldNow(void){
+        struct timespec ts; //Monotonic clock reading
+        clock_gettime(CLOCK_MONOTONIC,&ts); //Not affected by wall clock changes
+        return ts.tv_sec*1000000000ULL+ts.tv_nsec; //Converts to nanoseconds
+}
+
+/**
+ * @brief Maps a latency to its histogram bucket.
+ * Values below 64 ns have a bucket each; above, every power of two is split
+ * into 2^LD_SUB_BITS equal buckets.
+ * @param v Latency in ns.
+ * @return unsigned int Bucket index.
+ */
+static unsigned int bktOf(u64 v){
+        int e; //Position of the highest set bit
+        if(v<64)return v;
+        e=63-__builtin_clzll(v); //6..63
+        return 64+(e-6)*32+((v>>(e-LD_SUB_BITS))&31);
+}
+
+/**
+ * @brief Returns the middle of a histogram bucket.
+ * @param b Bucket index.
+ * @return u64 Representative latency in ns.
+ */
+static u64 bktVal(unsigned int b){
+        int e; //Power of two of the bucket
+        if(b<64)return b;
+        e=(b-64)/32+6;
+        return ((32ULL+(b-64)%32)<<(e-LD_SUB_BITS))+(1ULL<<(e-LD_SUB_BITS))/2; //Lower bound plus half a bucket
+}
+
+/**
+ * @brief Returns the latency below which a share p of the samples lie.
+ * @param h Histogram.
+ * @param p Share, 0..1.
+ * @return u64 Latency in ns (0 without samples).
+ */
+static u64 pct(const Hist *h,double p){
+        u64 rank=(u64)(p*h->n+0.999999),seen=0; //Rank of the sample, samples passed
+        unsigned int b; //Bucket
+        if(!h->n)return 0;
+        if(!rank)rank=1;
+        for(b=0;b<LD_BKT;b++)if((seen+=h->bkt[b])>=rank)return bktVal(b)<h->max?bktVal(b):h->max;
+        return h->max;
+}
+
+/**
+ * @brief Initializes the generator (no links, no cards, default mix).
+ * @param ld Generator.
+ * @return int 0 on success, -1 on error.
+ */
+int ldInit(Load *ld){
+        memset(ld,0,sizeof(*ld));
+        ld->ep=epoll_create1(EPOLL_CLOEXEC); //One poll set for every link
+        if(ld->ep<0)return -1;
+        return ldMix(ld,LD_MIX_DEFAULT);
+}
+
+/**
+ * @brief Reads card numbers and PINs of active cards from a Db.csv file.
+ * Line format: num,name,phno,usrName,pass,rfid,pin,cardStat,bal,tranCnt
+ * @param ld Generator.
+ * @param path Db.csv path.
+ * @return int Number of cards read, -1 if the file cannot be read.
+ */
+int ldCards(Load *ld,const char *path){
+        char line[512]; //One account line
+        Card c; //Card being read
+        int stat,cap=0; //Card status, allocated cards
+        FILE *fp=fopen(path,"r"); //Account database
+        if(!fp)return -1;
+        while(fgets(line,sizeof(line),fp)){
+                if(sscanf(line,"%*[^,],%*[^,],%*[^,],%*[^,],%*[^,],%8[^,],%4[^,],%d",c.rfid,c.pin,&stat)!=3)continue; //Not an account line
+                if(!stat||(strlen(c.rfid)!=8)||(strlen(c.pin)!=4))continue; //Blocked or malformed card
+                if(ld->nCard==cap){ //Grows the card array
+                        Card *t=realloc(ld->card,(cap?cap*2:64)*sizeof(Card));
+                        if(!t){fclose(fp);return -1;}
+                        ld->card=t;
+                        cap=cap?cap*2:64;
+                }
+                ld->card[ld->nCard++]=c;
+        }
+        fclose(fp);
+        return ld->nCard;
+}
+
+/**
+ * @brief Sets the request mix, e.g. "BAL=50,WTD=25,DEP=25" (unlisted opcodes get 0).
+ * @param ld Generator.
+ * @param spec Comma separated NAME=weight list.
+ * @return int 0 on success, -1 on an unknown name or an all zero mix.
+ */
+int ldMix(Load *ld,const char *spec){
+        unsigned int mix[LD_OPS]={0},sum=0; //New weights
+        const char *p=spec; //Parse position
+        while(*p){
+                int i,len=strcspn(p,"="); //Opcode and its name length
+                char *end; //End of the weight
+                for(i=0;i<LD_OPS;i++)if(((int)strlen(ldName[i])==len)&&!strncmp(p,ldName[i],len))break;
+                if((i==LD_OPS)||(p[len]!='='))return -1; //Unknown opcode or missing weight
+                mix[i]=strtoul(p+len+1,&end,10);
+                if((end==p+len+1)||(*end&&(*end!=',')))return -1; //Weight is not a number
+                p=*end?end+1:end;
+        }
+        for(int i=0;i<LD_OPS;i++)sum+=mix[i];
+        if(!sum)return -1;
+        memcpy(ld->mix,mix,sizeof(mix));
+        ld->mixSum=sum;
+        return 0;
+}
+
+/**
+ * @brief Appends a link for an open descriptor and registers it for input.
+ * @param ld Generator.
+ * @param fd Non-blocking descriptor.
+ * @param hold Own slave descriptor, or -1.
+ * @param name Slave or device path.
+ * @return Link* The link, or NULL on error (descriptors left open).
+ */
+static Link* lkAdd(Load *ld,int fd,int hold,const char *name){
+        struct epoll_event ev; //Registration
+        Link *t=realloc(ld->lk,(ld->n+1)*sizeof(Link)); //One more link
+        Link *l; //New link
+        if(!t)return NULL;
+        ld->lk=t;
+        l=&ld->lk[ld->n];
+        memset(l,0,sizeof(*l));
+        l->fd=fd;
+        l->hold=hold;
+        l->op=-1;
+        l->rng=0x9E3779B97F4A7C15ULL*(ld->n+1); //Different request sequence per link
+        snprintf(l->name,sizeof(l->name),"%s",name);
+        memset(&ev,0,sizeof(ev));
+        ev.events=EPOLLIN;
+        ev.data.u32=ld->n; //Index: the array may move when it grows
+        if(epoll_ctl(ld->ep,EPOLL_CTL_ADD,fd,&ev))return NULL;
+        ld->n++;
+        return l;
+}
+
+/**
+ * @brief Puts a terminal into raw mode: no echo, no line editing, no CR/LF translation.
+ * @param fd Terminal descriptor.
+ */
+static void rawLine(int fd){
+        struct termios opt; //Line settings
+        if(tcgetattr(fd,&opt))return; //Not a terminal (e.g. a FIFO): nothing to set
+        cfmakeraw(&opt);
+        tcsetattr(fd,TCSANOW,&opt);
+}
+
+/**
+ * @brief Creates a pty for one more ATM; the backend opens its slave path.
+ * The generator keeps its own slave descriptor so the master never sees a hang-up
+ * while the backend has not opened (or has closed) the slave.
+ * @param ld Generator.
+ * @return Link* The link, or NULL on error.
+ */
+Link* ldPty(Load *ld){
+        char name[64]; //Slave path
+        Link *l; //New link
+        int hold,fd=posix_openpt(O_RDWR|O_NOCTTY|O_NONBLOCK|O_CLOEXEC); //Master side, the ATM end
+        if(fd<0)return NULL;
+        if(grantpt(fd)||unlockpt(fd)||ptsname_r(fd,name,sizeof(name))){close(fd);return NULL;}
+        hold=open(name,O_RDWR|O_NOCTTY|O_CLOEXEC); //Own slave
+        if(hold<0){close(fd);return NULL;}
+        rawLine(hold); //Requests sent before the backend configures the line are not echoed back
+        l=lkAdd(ld,fd,hold,name);
+        if(!l){close(hold);close(fd);}
+        return l;
+}
+
+/**
+ * @brief Opens an existing device (serial port or pty slave of atm_srv -p) as one more ATM.
+ * @param ld Generator.
+ * @param dev Device path.
+ * @return Link* The link, or NULL on error.
+ */
+Link* ldDev(Load *ld,const char *dev){
+        Link *l; //New link
+        int fd=open(dev,O_RDWR|O_NOCTTY|O_NONBLOCK|O_CLOEXEC); //ATM end of the line
+        if(fd<0)return NULL;
+        rawLine(fd);
+        l=lkAdd(ld,fd,-1,dev);
+        if(!l)close(fd);
+        return l;
+}
+
+/**
+ * @brief Removes a link from the poll set; it takes no further part in the run.
+ * @param ld Generator.
+ * @param l Link.
+ */
+static void lkDrop(Load *ld,Link *l){
+        epoll_ctl(ld->ep,EPOLL_CTL_DEL,l->fd,NULL);
+        l->ready=0;
+        l->op=-1;
+        ld->lost++;
+}
+
+/**
+ * @brief Draws the next opcode from the mix.
+ * @param ld Generator.
+ * @param l Link (its random state advances).
+ * @return int Opcode.
+ */
+static int nextOp(const Load *ld,Link *l){
+        unsigned int r; //Position in the weights
+        int i; //Opcode
+        l->rng^=l->rng<<13; l->rng^=l->rng>>7; l->rng^=l->rng<<17; //xorshift64
+        r=(l->rng>>16)%ld->mixSum;
+        for(i=0;r>=ld->mix[i];i++)r-=ld->mix[i];
+        return i;
+}
+
+/**
+ * @brief Builds and sends the next request of a link.
+ * @param ld Generator.
+ * @param l Link.
+ * @return int 0 on success, -1 if the request could not be written in full.
+ */
+static int lkSend(Load *ld,Link *l){
+        char buf[64]; //Request frame with CR LF
+        int op=nextOp(ld,l),n; //Opcode, frame length
+        const Card *c=&ld->card[(l->rng>>24)%ld->nCard]; //Card of the request
+        unsigned int amt=100*(1+(l->rng>>40)%5); //100..500, deposits and withdrawals cancel out on average
+        switch(op){
+                case LD_X:  n=sprintf(buf,"#X:LINEOK$\r\n");break;
+                case LD_C:  n=sprintf(buf,"#C:%s$\r\n",c->rfid);break;
+                case LD_V:  n=sprintf(buf,"#V:%s:%s$\r\n",c->rfid,c->pin);break;
+                case LD_WTD:n=sprintf(buf,"#A:WTD:%s:%u$\r\n",c->rfid,amt);break;
+                case LD_DEP:n=sprintf(buf,"#A:DEP:%s:%u$\r\n",c->rfid,amt);break;
+                case LD_BAL:n=sprintf(buf,"#A:BAL:%s$\r\n",c->rfid);break;
+                case LD_MST:n=sprintf(buf,"#A:MST:%s:%u$\r\n",c->rfid,(unsigned int)(1+(l->rng>>48)%3));break; //Entries 1..3 as atm_mst asks for
+                case LD_PIN:n=sprintf(buf,"#A:PIN:%s:%s$\r\n",c->rfid,c->pin);break; //Same PIN: full write path, data unchanged
+                default:    n=sprintf(buf,"#A:BLK:%s$\r\n",c->rfid);break;
+        }
+        l->op=op;
+        l->rxLen=0;
+        l->sent=ldNow();
+        return (write(l->fd,buf,n)==n)?0:-1; //A pty takes a whole short frame or nothing
+}
+
+/**
+ * @brief Reads what a link has received and cuts out the next complete reply.
+ * @param l Link.
+ * @param out Set to the reply (without CR LF, null-terminated inside rx) when one is complete.
+ * @return int 1 if a reply is complete, 0 if more input is needed, -1 on hang-up or overflow.
+ */
+static int lkRecv(Link *l,char **out){
+        char *nl; //End of the reply
+        ssize_t r; //Read result
+        if(l->rxLen==LD_RX_SZ-1)return -1; //Reply longer than any the protocol has
+        r=read(l->fd,l->rx+l->rxLen,LD_RX_SZ-1-l->rxLen);
+        if(r<0)return ((errno==EAGAIN)||(errno==EINTR))?0:-1;
+        if(!r)return -1; //Hang-up
+        l->rxLen+=r;
+        l->rx[l->rxLen]='\0';
+        if(!(nl=memchr(l->rx,'\n',l->rxLen)))return 0; //Reply not complete yet
+        *nl='\0';
+        if((nl>l->rx)&&(nl[-1]=='\r'))nl[-1]='\0';
+        *out=l->rx;
+        return 1;
+}
+
+/**
+ * @brief Sends #X to every link until it answers, then drains duplicate replies.
+ * A backend resets the line when it opens it, which can discard an early #X,
+ * so unanswered links are asked again every 200 ms.
+ * @param ld Generator.
+ * @param secs Seconds to wait for the backend.
+ * @return int Number of ready links.
+ */
+int ldWait(Load *ld,int secs){
+        struct epoll_event ev[256]; //Ready links
+        u64 end=ldNow()+secs*1000000000ULL,ask=0,drain=0; //Deadline, next #X round, end of the drain
+        int ready=0,i,n; //Ready links, counters
+        char *rep; //Reply
+        while(ldNow()<(drain?drain:end)){
+                if(!drain&&(ldNow()>=ask)){ //(Re)sends #X to the silent links
+                        for(i=0;i<ld->n;i++)if(!ld->lk[i].ready)
+                                if(write(ld->lk[i].fd,"#X:LINEOK$\r\n",12)<0&&(errno!=EAGAIN))lkDrop(ld,&ld->lk[i]);
+                        ask=ldNow()+200000000ULL;
+                }
+                n=epoll_wait(ld->ep,ev,256,50);
+                for(i=0;i<n;i++){
+                        Link *l=&ld->lk[ev[i].data.u32];
+                        int r; //Receive result
+                        while((r=lkRecv(l,&rep))>0){
+                                if(!l->ready&&!strcmp(rep,"@X:LINEOK$")){l->ready=1;ready++;}
+                                l->rxLen=0; //Handshake replies (and duplicates) are discarded
+                        }
+                        if(r<0){epoll_ctl(ld->ep,EPOLL_CTL_DEL,l->fd,NULL);if(l->ready){l->ready=0;ready--;}}
+                }
+                if(!drain&&(ready==ld->n))drain=ldNow()+300000000ULL; //Everyone answered: collects late duplicates
+        }
+        for(i=0;i<ld->n;i++)if(!ld->lk[i].ready){ //Never answered
+                fprintf(stderr,"load: no reply on %s\n",ld->lk[i].name);
+                lkDrop(ld,&ld->lk[i]);
+        }
+        return ready;
+}
+
+/**
+ * @brief Runs the closed loop on every ready link.
+ * Each reply is timed from the write of its request; the next request goes out at once.
+ * @param ld Generator.
+ * @param secs Run time in seconds (0: no limit).
+ * @param maxReq Stop after this many replies (0: no limit).
+ * @param stop Set asynchronously (signal) to end the run early.
+ * @return double Elapsed seconds.
+ */
+double ldRun(Load *ld,double secs,u64 maxReq,volatile int *stop){
+        struct epoll_event ev[256]; //Links with input
+        u64 t0=ldNow(),end=secs>0?t0+(u64)(secs*1e9):~0ULL,done=0,now,chk=t0; //Start, deadline, replies, clock, next timeout scan
+        int i,n,live=0; //Counters, links in the loop
+        char *rep; //Reply
+        if(!ld->nCard){fputs("load: no cards\n",stderr);return 0;}
+        for(i=0;i<ld->n;i++)if(ld->lk[i].ready){ //First request of every link
+                if(lkSend(ld,&ld->lk[i]))lkDrop(ld,&ld->lk[i]);
+                else live++;
+        }
+        while(live&&!*stop&&((now=ldNow())<end)&&(!maxReq||(done<maxReq))){
+                n=epoll_wait(ld->ep,ev,256,100);
+                for(i=0;i<n;i++){
+                        Link *l=&ld->lk[ev[i].data.u32];
+                        int r=lkRecv(l,&rep); //Receive result
+                        if(!r)continue;
+                        if((r<0)||(l->op<0)||(rep[0]!='@')){ //Hang-up, overflow or stray output
+                                fprintf(stderr,"load: %s: %s\n",l->name,(r<0)?"link lost":"unexpected output");
+                                lkDrop(ld,l);live--;continue;
+                        }
+                        now=ldNow();
+                        Hist *h=&ld->h[l->op]; //Histogram of the opcode
+                        u64 lat=now-l->sent; //Reply latency
+                        h->bkt[bktOf(lat)]++;
+                        h->n++;
+                        if(lat>h->max)h->max=lat;
+                        if(!strncmp(rep,"@ERR",4))h->errs++;
+                        done++;
+                        if(lkSend(ld,l)){lkDrop(ld,l);live--;}
+                }
+                if((now=ldNow())>=chk){ //Once a second: drops links whose reply is overdue
+                        for(i=0;i<ld->n;i++)if(ld->lk[i].ready&&(ld->lk[i].op>=0)&&(now-ld->lk[i].sent>LD_TIMEOUT_NS)){
+                                fprintf(stderr,"load: %s: no reply to %s\n",ld->lk[i].name,ldName[ld->lk[i].op]);
+                                lkDrop(ld,&ld->lk[i]);live--;
+                        }
+                        chk=now+1000000000ULL;
+                }
+        }
+        return (ldNow()-t0)/1e9;
+}
+
+/**
+ * @brief Prints throughput and p50/p99/p999/max latency per opcode.
+ * @param ld Generator.
+ * @param secs Elapsed seconds of the run.
+ * @param fp Output stream.
+ */
+void ldReport(const Load *ld,double secs,FILE *fp){
+        u64 tot=0,errs=0; //All replies, all error replies
+        int i; //Opcode
+        fprintf(fp,"%-5s %10s %10s %9s %9s %9s %9s %8s\n","op","replies","req/s","p50 us","p99 us","p999 us","max us","@ERR");
+        for(i=0;i<LD_OPS;i++){
+                const Hist *h=&ld->h[i];
+                if(!h->n)continue;
+                fprintf(fp,"%-5s %10llu %10.0f %9.1f %9.1f %9.1f %9.1f %8llu\n",ldName[i],h->n,h->n/secs,
+                                pct(h,0.50)/1e3,pct(h,0.99)/1e3,pct(h,0.999)/1e3,h->max/1e3,h->errs);
+                tot+=h->n;
+                errs+=h->errs;
+        }
+        fprintf(fp,"total %10llu %10.0f req/s over %.2f s, %d links, %llu lost, %llu @ERR replies\n",tot,tot/secs,secs,ld->n,ld->lost,errs);
+}
+
+/**
+ * @brief Closes every link and releases the generator.
+ * @param ld Generator.
+ */
+void ldClose(Load *ld){
+        for(int i=0;i<ld->n;i++){
+                close(ld->lk[i].fd);
+                if(ld->lk[i].hold>=0)close(ld->lk[i].hold);
+        }
+        if(ld->ep>=0)close(ld->ep);
+        free(ld->lk);
+        free(ld->card);
+        ld->lk=NULL;
+        ld->card=NULL;
+        ld->n=ld->nCard=0;
+}
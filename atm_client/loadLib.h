@@ -0,0 +1,161 @@
+#ifndef _LOADLIB_H //If _LOADLIB_H is not defined
+#define _LOADLIB_H //Define _LOADLIB_H to prevent multiple inclusions of this header file
+
+/*
+ * loadLib.h
+ *
+ * ATM load generator: plays many ATMs against a backend (atm_main or atm_server)
+ * over pseudo-terminals. Each link is a closed loop like a real ATM: one request
+ * in flight, the next one is sent as soon as the reply ("@...$\r\n") is complete.
+ * Requests are drawn from a weighted mix of the real protocol (#X, #C, #V and
+ * #A:WTD/DEP/BAL/MST/PIN/BLK) using cards read from Db.csv, and the time to each
+ * reply is recorded per opcode in a log-linear histogram (about 1.6% resolution)
+ * for throughput and p50/p99/p999 reports.
+ * Links are either ptys created here (the backend opens the printed slave paths)
+ * or existing devices opened by path (e.g. the slaves of atm_srv -p).
+ */
+
+#include<stdio.h> //FILE, printf
+#include<stdlib.h> //malloc, calloc, exit
+#include<string.h> //String manipulation functions
+#include<unistd.h> //read, write, close
+#include<fcntl.h> //open, O_NONBLOCK
+#include<errno.h> //Error number definitions
+#include<time.h> //clock_gettime
+#include<termios.h> //Raw line settings for the ptys
+
+typedef unsigned long long int u64; //Typedef for unsigned 64-bit integer
+
+#define LD_X   0 //#X:LINEOK$           line check
+#define LD_C   1 //#C:<rfid>$           card check
+#define LD_V   2 //#V:<rfid>:<pin>$     PIN check
+#define LD_WTD 3 //#A:WTD:<rfid>:<amt>$ withdrawal
+#define LD_DEP 4 //#A:DEP:<rfid>:<amt>$ deposit
+#define LD_BAL 5 //#A:BAL:<rfid>$       balance
+#define LD_MST 6 //#A:MST:<rfid>:<n>$   mini statement entry 1..3
+#define LD_PIN 7 //#A:PIN:<rfid>:<pin>$ PIN change (to the card's current PIN)
+#define LD_BLK 8 //#A:BLK:<rfid>$       block card (changes the database for good)
+#define LD_OPS 9 //Number of opcodes
+
+#define LD_MIX_DEFAULT "X=5,C=15,V=15,WTD=15,DEP=15,BAL=25,MST=10" //Read-mostly mix that leaves balances level
+#define LD_SUB_BITS 5 //Histogram: 2^5 sub-buckets per power of two
+#define LD_BKT (64+58*32) //Histogram buckets covering 0..2^64 ns
+#define LD_RX_SZ 256 //Reply buffer per link
+#define LD_TIMEOUT_NS 5000000000ULL //A reply slower than this drops the link
+
+typedef struct{ //Latency histogram of one opcode
+        u64 bkt[LD_BKT]; //Samples per bucket
+        u64 n; //Samples
+        u64 max; //Slowest reply (ns)
+        u64 errs; //Replies starting with "@ERR"
+}Hist;
+
+typedef struct{ //One card of the database
+        char rfid[9]; //Card number
+        char pin[5]; //PIN
+}Card;
+
+typedef struct{ //One simulated ATM
+        int fd; //Descriptor read and written by the generator (pty master or device)
+        int hold; //Own slave descriptor of a created pty (keeps it open while the backend reconnects), else -1
+        char name[64]; //Slave path or device path
+        char rx[LD_RX_SZ]; //Partial reply
+        int rxLen; //Bytes in rx
+        int op; //Opcode of the request in flight, -1 when idle
+        int ready; //Link answered the #X handshake
+        u64 sent; //Send time of the request in flight (ns)
+        u64 rng; //xorshift state for this link's requests
+}Link;
+
+typedef struct{ //Load generator state
+        Link *lk; //Links
+        int n; //Number of links
+        int ep; //epoll descriptor
+        Card *card; //Cards requests are drawn from
+        int nCard; //Number of cards
+        unsigned int mix[LD_OPS]; //Weight of every opcode
+        unsigned int mixSum; //Sum of the weights
+        Hist h[LD_OPS]; //Latency per opcode
+        u64 lost; //Links dropped (timeout, hang-up or unexpected reply)
+}Load;
+
+extern const char *ldName[LD_OPS]; //Opcode names, as used in mix specifications
+
+/**
+ * @brief Returns a monotonic time stamp in nanoseconds.
+ * @return u64 Nanoseconds since an arbitrary point.
+ */
+u64 ldNow(void);
+
+/**
+ * @brief Initializes the generator (no links, no cards, default mix).
+ * @param ld Generator.
+ * @return int 0 on success, -1 on error.
+ */
+int ldInit(Load *ld);
+
+/**
+ * @brief Reads card numbers and PINs from a Db.csv file.
+ * @param ld Generator.
+ * @param path Db.csv path.
+ * @return int Number of cards read, -1 if the file cannot be read.
+ */
+int ldCards(Load *ld,const char *path);
+
+/**
+ * @brief Sets the request mix, e.g. "BAL=50,WTD=25,DEP=25" (unlisted opcodes get 0).
+ * @param ld Generator.
+ * @param spec Comma separated NAME=weight list.
+ * @return int 0 on success, -1 on an unknown name or an all zero mix.
+ */
+int ldMix(Load *ld,const char *spec);
+
+/**
+ * @brief Creates a pty for one more ATM; the backend opens its slave path.
+ * @param ld Generator.
+ * @return Link* The link, or NULL on error.
+ */
+Link* ldPty(Load *ld);
+
+/**
+ * @brief Opens an existing device (serial port or pty slave of atm_srv -p) as one more ATM.
+ * @param ld Generator.
+ * @param dev Device path.
+ * @return Link* The link, or NULL on error.
+ */
+Link* ldDev(Load *ld,const char *dev);
+
+/**
+ * @brief Sends #X to every link until it answers, then drains duplicate replies.
+ * Links that never answer are dropped.
+ * @param ld Generator.
+ * @param secs Seconds to wait for the backend.
+ * @return int Number of ready links.
+ */
+int ldWait(Load *ld,int secs);
+
+/**
+ * @brief Runs the closed loop on every ready link.
+ * @param ld Generator.
+ * @param secs Run time in seconds (0: no limit).
+ * @param maxReq Stop after this many replies (0: no limit).
+ * @param stop Set asynchronously (signal) to end the run early.
+ * @return double Elapsed seconds.
+ */
+double ldRun(Load *ld,double secs,u64 maxReq,volatile int *stop);
+
+/**
+ * @brief Prints throughput and p50/p99/p999/max latency per opcode.
+ * @param ld Generator.
+ * @param secs Elapsed seconds of the run.
+ * @param fp Output stream.
+ */
+void ldReport(const Load *ld,double secs,FILE *fp);
+
+/**
+ * @brief Closes every link and releases the generator.
+ * @param ld Generator.
+ */
+void ldClose(Load *ld);
+
+#endif //End of _LOADLIB_H guard
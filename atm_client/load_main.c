@@ -0,0 +1,104 @@
+#include "loadLib.h" //Includes the loadLib.h header file for the load generator
+#include <signal.h> //sigaction, kill
+#include <sys/wait.h> //waitpid for the backend
+#include <sys/resource.h> //setrlimit, two descriptors per pty
+
+//ATM load generator: many simulated ATMs against atm_main or atm_server over ptys.
+//Usage: ./atm_load [-n count] [-s device]... [-f device_list] [-o pty_list] [-x backend_cmd]
+//                  [-d Db.csv] [-m mix] [-t seconds] [-r requests] [-w seconds]
+//  -n count        create count ptys; their slave paths are written to the pty list
+//  -s device       drive an existing device (e.g. a slave printed by atm_srv -p), may be repeated
+//  -f device_list  file with one device path per line
+//  -o pty_list     where the created slave paths go (default: stdout)
+//  -x backend_cmd  shell command started once the pty list is written, stopped (SIGTERM) at the end,
+//                  e.g. -o /tmp/ptys -x "../atm_server/atm_srv -f /tmp/ptys >/dev/null"
+//                  or   -n 1 -o /tmp/pty -x "../atmz/atm $(cat /tmp/pty) >/dev/null"
+//  -d Db.csv       cards and PINs to use (default ../dataz/Db.csv)
+//  -m mix          request weights, e.g. "BAL=50,WTD=25,DEP=25" (default LD_MIX_DEFAULT);
+//                  opcodes X C V WTD DEP BAL MST PIN BLK; BLK blocks real cards
+//  -t seconds      run time (default 10)
+//  -r requests     stop after this many replies
+//  -w seconds      time the backend has to start and answer #X on every link (default 30)
+//Prints throughput and p50/p99/p999 latency per opcode.
+
+static volatile int stop=0; //Set by the signal handler
+
+//Signal handler: ends the run early, the report is still printed.
+static void onSig(int sig){
+        (void)sig;
+        stop=1;
+}
+
+//The main function: opens the links, starts the backend, runs the load and reports.
+int main(int argc,char **argv){
+        Load ld; //Generator
+        struct sigaction sa; //Stop signals
+        struct rlimit rl; //Descriptor limit
+        const char *db="../dataz/Db.csv",*out=NULL,*cmd=NULL; //Card source, pty list, backend command
+        double secs=10,el; //Run time, elapsed time
+        u64 maxReq=0; //Reply limit
+        int opt,i,n,wait=30,made=0; //getopt result, counters, handshake time, ptys created
+        char line[256]; //Device list line
+        FILE *fp; //Device list or pty list
+        pid_t be=0; //Backend process
+
+        if(ldInit(&ld)){perror("load");return 1;}
+        if(!getrlimit(RLIMIT_NOFILE,&rl)){rl.rlim_cur=rl.rlim_max;setrlimit(RLIMIT_NOFILE,&rl);} //Thousands of ptys need more than 1024 descriptors
+        while((opt=getopt(argc,argv,"n:s:f:o:x:d:m:t:r:w:"))!=-1){
+                switch(opt){
+                        case 'n':n=atoi(optarg);
+                                 for(i=0;i<n;i++,made++)if(!ldPty(&ld)){perror("load: pty");break;}
+                                 break;
+                        case 's':if(!ldDev(&ld,optarg))perror(optarg);
+                                 break;
+                        case 'f':if(!(fp=fopen(optarg,"r"))){perror(optarg);break;}
+                                 while(fgets(line,sizeof(line),fp)){
+                                        line[strcspn(line,"\r\n")]='\0';
+                                        if(line[0]&&!ldDev(&ld,line))perror(line);
+                                 }
+                                 fclose(fp);
+                                 break;
+                        case 'o':out=optarg;break;
+                        case 'x':cmd=optarg;break;
+                        case 'd':db=optarg;break;
+                        case 'm':if(ldMix(&ld,optarg)){fprintf(stderr,"load: bad mix: %s\n",optarg);return 1;}
+                                 break;
+                        case 't':secs=atof(optarg);break;
+                        case 'r':maxReq=strtoull(optarg,NULL,10);break;
+                        case 'w':wait=atoi(optarg);break;
+                        default :fprintf(stderr,"usage: %s [-n count] [-s device]... [-f device_list] [-o pty_list] [-x backend_cmd]\n"
+                                         "       [-d Db.csv] [-m mix] [-t seconds] [-r requests] [-w seconds]\n",argv[0]);
+                                 return 1;
+                }
+        }
+        if(!ld.n){fputs("load: no links\n",stderr);return 1;}
+        if(ldCards(&ld,db)<=0){fprintf(stderr,"load: no active cards in %s\n",db);return 1;}
+
+        if(made){ //Slave paths for the backend
+                if(!(fp=out?fopen(out,"w"):stdout)){perror(out);return 1;}
+                for(i=0;i<ld.n;i++)if(ld.lk[i].hold>=0)fprintf(fp,"%s\n",ld.lk[i].name);
+                if(fp!=stdout)fclose(fp);
+                else fflush(stdout);
+        }
+        if(cmd){ //Backend under test
+                be=fork();
+                if(!be){setpgid(0,0);execl("/bin/sh","sh","-c",cmd,(char*)NULL);_exit(127);} //Own process group: the stop signal reaches the whole command
+                if(be<0){perror("load: fork");return 1;}
+                setpgid(be,be); //Also set here, so a stop right after fork cannot miss the group
+        }
+
+        memset(&sa,0,sizeof(sa));
+        sa.sa_handler=onSig;
+        sigaction(SIGINT,&sa,NULL);
+        sigaction(SIGTERM,&sa,NULL);
+
+        n=ldWait(&ld,wait); //Backend must answer #X on every link
+        fprintf(stderr,"load: %d of %d links ready, %d cards\n",n,ld.n,ld.nCard);
+        if(n){
+                el=ldRun(&ld,secs,maxReq,&stop);
+                ldReport(&ld,el,stdout);
+        }
+        if(be>0){kill(-be,SIGTERM);waitpid(be,NULL,0);} //Backend saves and exits, as on Ctrl+C
+        ldClose(&ld);
+        return n?0:1;
+}
@@ -0,0 +1,281 @@
+#define _GNU_SOURCE //posix_openpt, ptsname, accept4
+#include "srvLib.h" //Includes the srvLib.h header file for the server structures and prototypes
+#include <sys/epoll.h> //epoll_create1, epoll_ctl, epoll_wait
+#include <sys/socket.h> //socket, bind, listen, accept4
+#include <netinet/in.h> //sockaddr_in
+#include <netinet/tcp.h> //TCP_NODELAY
+#include <arpa/inet.h> //inet_ntop
+#include "jrnLib.h" //jrnMaint for snapshot housekeeping, jrnSync for the group commit
+
+/**
+ * @brief Registers a descriptor with the server and links a new endpoint for it.
+ * @param s Server.
+ * @param fd Descriptor (already non-blocking).
+ * @param hold Pty slave kept open by the server, or -1.
+ * @param kind Endpoint kind.
+ * @param name Endpoint name.
+ * @return Ep* The endpoint, or NULL on error (fd and hold are left open).
+ */
+static Ep* epAdd(Srv *s,int fd,int hold,char kind,const char *name){
+        struct epoll_event ev; //Registration
+        Ep *e=calloc(1,sizeof(Ep)); //New endpoint
+        if(!e)return NULL;
+        e->fd=fd;
+        e->hold=hold;
+        e->kind=kind;
+        e->ev=EPOLLIN;
+        snprintf(e->name,sizeof(e->name),"%s",name);
+        memset(&ev,0,sizeof(ev));
+        ev.events=e->ev;
+        ev.data.ptr=e; //Events lead straight to the endpoint
+        if(epoll_ctl(s->ep,EPOLL_CTL_ADD,fd,&ev)){free(e);return NULL;}
+        e->nxt=s->eps; //Links at the front
+        if(s->eps)s->eps->prv=e;
+        s->eps=e;
+        s->nEp++;
+        return e;
+}
+
+/**
+ * @brief Unregisters, closes and frees an endpoint.
+ * @param s Server.
+ * @param e Endpoint to drop.
+ */
+static void epDrop(Srv *s,Ep *e){
+#ifdef DBG //Conditional compilation block for debugging
+        printf("DBG_SRV:drop %s\n",e->name); //Reports the lost endpoint
+#endif //End of DBG conditional block
+        epoll_ctl(s->ep,EPOLL_CTL_DEL,e->fd,NULL);
+        lnkClose(e->fd); //Last replies are tried once, unread input is dropped
+        close(e->fd);
+        if(e->hold>=0)close(e->hold);
+        if(e->prv)e->prv->nxt=e->nxt; //Unlinks
+        else s->eps=e->nxt;
+        if(e->nxt)e->nxt->prv=e->prv;
+        s->nEp--;
+        free(e);
+}
+
+/**
+ * @brief Changes the events an endpoint is polled for, if they differ.
+ * @param s Server.
+ * @param e Endpoint.
+ * @param want New event mask.
+ */
+static void epWant(Srv *s,Ep *e,unsigned int want){
+        struct epoll_event ev; //Registration
+        if(e->ev==want)return; //Nothing to change
+        memset(&ev,0,sizeof(ev));
+        ev.events=want;
+        ev.data.ptr=e;
+        if(!epoll_ctl(s->ep,EPOLL_CTL_MOD,e->fd,&ev))e->ev=want;
+}
+
+/**
+ * @brief Sets O_NONBLOCK on a descriptor.
+ * @param fd Descriptor.
+ * @return int 0 on success, -1 on error.
+ */
+static int nonBlock(int fd){
+        int fl=fcntl(fd,F_GETFL); //Current flags
+        return (fl<0)?-1:fcntl(fd,F_SETFL,fl|O_NONBLOCK);
+}
+
+/**
+ * @brief Creates the epoll instance of a server.
+ * @param s Server to initialize.
+ * @param db Loaded account database.
+ * @return int 0 on success, -1 on error.
+ */
+int srvInit(Srv *s,Acc *db){
+        memset(s,0,sizeof(Srv));
+        s->db=db;
+        s->ep=epoll_create1(EPOLL_CLOEXEC); //Not inherited by the snapshot child
+        return (s->ep<0)?-1:0;
+}
+
+/**
+ * @brief Adds a serial device (or an existing pty slave) as an endpoint.
+ * @param s Server.
+ * @param dev Device path.
+ * @return int 0 on success, -1 on error.
+ */
+int srvSerial(Srv *s,const char *dev){
+        int fd=openSerial(dev); //Raw 8N1, same settings as atm_main
+        if(fd<0)return -1;
+        if(nonBlock(fd)||!epAdd(s,fd,-1,EP_SERIAL,dev)){close(fd);return -1;}
+        return 0;
+}
+
+/**
+ * @brief Creates a pty endpoint; an ATM (or simulator) connects by opening its slave path.
+ * The server keeps a slave descriptor of its own, so the master never sees a hangup
+ * and the pty stays usable when a client closes and reopens it.
+ * @param s Server.
+ * @return Ep* The endpoint (its name is the slave path), or NULL on error.
+ */
+Ep* srvPty(Srv *s){
+        struct termios opt; //Slave settings
+        char *name; //Slave path
+        Ep *e; //New endpoint
+        int hold,fd=posix_openpt(O_RDWR|O_NOCTTY|O_NONBLOCK); //Master side, polled by the server
+        if(fd<0)return NULL;
+        if(grantpt(fd)||unlockpt(fd)||!(name=ptsname(fd))){close(fd);return NULL;}
+        hold=open(name,O_RDWR|O_NOCTTY); //Server's own slave
+        if(hold<0){close(fd);return NULL;}
+        tcgetattr(hold,&opt); //Raw line: no echo, no CR/LF translation
+        cfmakeraw(&opt);
+        tcsetattr(hold,TCSANOW,&opt);
+        e=epAdd(s,fd,hold,EP_PTY,name);
+        if(!e){close(hold);close(fd);}
+        return e;
+}
+
+/**
+ * @brief Listens for ATM connections on a TCP port.
+ * @param s Server.
+ * @param port TCP port.
+ * @return int 0 on success, -1 on error.
+ */
+int srvTcp(Srv *s,int port){
+        struct sockaddr_in a; //Listening address
+        char name[32]; //Endpoint name
+        int one=1,fd=socket(AF_INET,SOCK_STREAM|SOCK_NONBLOCK|SOCK_CLOEXEC,0); //Listening socket
+        if(fd<0)return -1;
+        memset(&a,0,sizeof(a));
+        a.sin_family=AF_INET;
+        a.sin_addr.s_addr=htonl(INADDR_ANY);
+        a.sin_port=htons(port);
+        setsockopt(fd,SOL_SOCKET,SO_REUSEADDR,&one,sizeof(one)); //Restart without waiting for TIME_WAIT
+        sprintf(name,"tcp:%d",port);
+        if(bind(fd,(struct sockaddr*)&a,sizeof(a))||listen(fd,SOMAXCONN)||!epAdd(s,fd,-1,EP_LISTEN,name)){close(fd);return -1;}
+        return 0;
+}
+
+/**
+ * @brief Accepts every pending connection of a listening endpoint.
+ * @param s Server.
+ * @param l Listening endpoint.
+ */
+static void onAccept(Srv *s,Ep *l){
+        struct sockaddr_in a; //Peer address
+        socklen_t al; //Address length
+        char name[64],ip[INET_ADDRSTRLEN]; //Endpoint name, peer IP
+        int one=1,fd; //TCP_NODELAY, accepted socket
+        for(;;){
+                al=sizeof(a);
+                fd=accept4(l->fd,(struct sockaddr*)&a,&al,SOCK_NONBLOCK|SOCK_CLOEXEC);
+                if(fd<0){
+                        if((errno!=EAGAIN)&&(errno!=EINTR))perror("srv: accept"); //EMFILE etc.: retried on the next event
+                        return;
+                }
+                setsockopt(fd,IPPROTO_TCP,TCP_NODELAY,&one,sizeof(one)); //Replies are small and already coalesced
+                inet_ntop(AF_INET,&a.sin_addr,ip,sizeof(ip));
+                snprintf(name,sizeof(name),"tcp:%s:%d",ip,ntohs(a.sin_port));
+                if(!epAdd(s,fd,-1,EP_TCP,name)){perror("srv: accept");close(fd);}
+        }
+}
+
+/**
+ * @brief Handles every complete frame buffered on a link and queues the replies.
+ * Stops early when the link's output buffer is nearly full and marks the link (more);
+ * reply then waits for EPOLLOUT even if every reply was written, so the remaining
+ * frames are handled without new input from the peer. Every reply is shorter
+ * than the SRV_TX_HIGH margin, so none is written before srvRun's jrnSync.
+ * @param s Server.
+ * @param e Link endpoint.
+ * @return int 0 if the link is still usable, -1 if it failed.
+ */
+static int serve(Srv *s,Ep *e){
+        char buf[SRV_FRAME_LEN]; //Current frame
+        Lnk *l=lnkGet(e->fd); //Link buffers
+        int n; //Frame length
+        if(!l)return -1;
+        while((l->txLen<=SRV_TX_HIGH)&&(n=lnkFrame(e->fd,buf,sizeof(buf)))){
+                if(n<0){ //Dropped bytes, the next frame is still served
+                        fprintf(stderr,"srv: framing error on %s\n",e->name);
+                        continue;
+                }
+                procMsg(s->db,e->fd,buf,n); //Same handling as atm_main
+                e->frames++;
+        }
+        e->more=(l->txLen>SRV_TX_HIGH); //Stopped before the ring was empty
+        return 0;
+}
+
+/**
+ * @brief Sends the replies serve queued on a link.
+ * @param s Server.
+ * @param e Link endpoint, dropped if the write fails.
+ */
+static void reply(Srv *s,Ep *e){
+        Lnk *l=lnkGet(e->fd); //Link buffers
+        if(!l||(lnkFlush(e->fd)&&(errno!=EAGAIN))){epDrop(s,e);return;} //One write for all replies
+        epWant(s,e,(l->txLen||e->more)?EPOLLOUT:EPOLLIN); //Unsent replies or unserved frames: wait for room, stop reading meanwhile
+}
+
+/**
+ * @brief Handles the events of one link endpoint; the replies are sent later by reply.
+ * @param s Server.
+ * @param e Link endpoint.
+ * @param ev Events reported by epoll.
+ * @return int 0 if the endpoint is still there, -1 if it was dropped.
+ */
+static int onLink(Srv *s,Ep *e,unsigned int ev){
+        int n; //lnkRead result
+        if(ev&EPOLLIN){
+                n=lnkRead(e->fd); //One read per event, epoll reports the rest again
+                if((n==0)||((n<0)&&(errno!=EAGAIN)&&(errno!=EINTR))){epDrop(s,e);return -1;} //Closed or failed
+        }else if((ev&(EPOLLHUP|EPOLLERR))&&!(ev&EPOLLOUT)){ //Peer gone while nothing was readable
+                epDrop(s,e);
+                return -1;
+        }
+        if(serve(s,e)){epDrop(s,e);return -1;}
+        return 0;
+}
+
+/**
+ * @brief Runs the event loop until *stop becomes non-zero.
+ * Every ready link is served first; then one jrnSync makes the journal records of the
+ * whole batch durable (group commit, with jrnGroup set) before any of its replies is sent.
+ * @param s Server.
+ * @param stop Set by a signal handler to end the loop.
+ * @return int 0 when stopped, -1 if epoll failed.
+ */
+int srvRun(Srv *s,volatile sig_atomic_t *stop){
+        struct epoll_event ev[SRV_MAX_EVENTS]; //Ready endpoints
+        int n,i; //Event count, index
+        while(!*stop){
+                n=epoll_wait(s->ep,ev,SRV_MAX_EVENTS,SRV_TICK_MS);
+                if(n<0){
+                        if(errno==EINTR)continue; //Signal: *stop is checked again
+                        perror("srv: epoll_wait");
+                        return -1;
+                }
+                for(i=0;i<n;i++){
+                        Ep *e=ev[i].data.ptr; //Endpoint of the event
+                        if(e->kind==EP_LISTEN){onAccept(s,e);ev[i].data.ptr=NULL;} //Nothing to reply
+                        else if(onLink(s,e,ev[i].events))ev[i].data.ptr=NULL; //Freed by epDrop
+                }
+                jrnSync(); //One fdatasync for every request of the batch
+                for(i=0;i<n;i++)if(ev[i].data.ptr)reply(s,ev[i].data.ptr); //Replies only once their records are on disk
+                if(!n)jrnMaint(s->db); //Idle: reaps a finished snapshot, starts a due one
+        }
+        return 0;
+}
+
+/**
+ * @brief Prints per-endpoint counters, closes every endpoint and the epoll instance.
+ * @param s Server.
+ */
+void srvClose(Srv *s){
+        while(s->eps){
+                Ep *e=s->eps; //Endpoint being closed
+                Lnk *l=(e->kind!=EP_LISTEN)?lnkGet(e->fd):NULL; //Its counters
+                if(l)
+                        printf("%-24s frames:%llu rx:%llu bytes/%llu reads tx:%llu bytes/%llu writes errors:%llu\n",e->name,
+                                        e->frames,l->rxBytes,l->rxCalls,l->txBytes,l->txCalls,l->rxErrs);
+                epDrop(s,e);
+        }
+        close(s->ep);
+}
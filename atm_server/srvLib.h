@@ -0,0 +1,94 @@
+#ifndef _SRVLIB_H //If _SRVLIB_H is not defined
+#define _SRVLIB_H //Define _SRVLIB_H to prevent multiple inclusions of this header file
+
+/*
+ * srvLib.h
+ *
+ * Multi-ATM server: one epoll loop multiplexing many ATM endpoints over one
+ * shared in-memory account database. Endpoints are serial devices, ptys
+ * created by the server, and TCP connections. Every endpoint is non-blocking
+ * and has its own lnkLib buffers, so frames are handled as they complete and
+ * a slow or silent link never holds up the others. Frames go through the same
+ * procMsg (checkRFID/verifyPin/act) as the single-port atm_main.
+ * While a link's replies cannot be written it is not read either
+ * (backpressure); it resumes when the peer catches up.
+ */
+
+#include "atmLib.h" //Acc, procMsg
+#include "lnkLib.h" //Per-link buffers
+#include <signal.h> //sig_atomic_t
+
+#define SRV_MAX_EVENTS 256 //Events fetched per epoll_wait
+#define SRV_FRAME_LEN  100 //Longest frame accepted (same as atm_main's buffer)
+#define SRV_TX_HIGH    (LNK_TX_SZ-256) //Stop handling a link's frames once this much output is queued
+#define SRV_TICK_MS    1000 //epoll_wait timeout, for housekeeping (reaping snapshots)
+
+#define EP_SERIAL 'S' //Serial device opened by path
+#define EP_PTY    'P' //Pty created by the server
+#define EP_TCP    'T' //Accepted TCP connection
+#define EP_LISTEN 'L' //TCP listening socket
+
+typedef struct E{ //Structure holding one endpoint
+        int fd; //Descriptor polled by the server
+        int hold; //Pty: the server's own slave descriptor (keeps the pty alive between clients), else -1
+        char kind; //EP_SERIAL, EP_PTY, EP_TCP or EP_LISTEN
+        unsigned int ev; //Events currently registered
+        char name[64]; //Device path, pty slave path or peer address
+        u64 frames; //Frames handled
+        int more; //serve stopped on a full output buffer: complete frames may still be buffered
+        struct E *prv,*nxt; //Neighbours in the endpoint list
+}Ep;
+
+typedef struct{ //Structure holding the server state
+        int ep; //epoll descriptor
+        Acc *db; //Shared account database
+        Ep *eps; //All endpoints
+        int nEp; //Number of endpoints
+}Srv;
+
+/**
+ * @brief Creates the epoll instance of a server.
+ * @param s Server to initialize.
+ * @param db Loaded account database.
+ * @return int 0 on success, -1 on error.
+ */
+int srvInit(Srv *s,Acc *db);
+
+/**
+ * @brief Adds a serial device (or an existing pty slave) as an endpoint.
+ * @param s Server.
+ * @param dev Device path.
+ * @return int 0 on success, -1 on error.
+ */
+int srvSerial(Srv *s,const char *dev);
+
+/**
+ * @brief Creates a pty endpoint; an ATM (or simulator) connects by opening its slave path.
+ * @param s Server.
+ * @return Ep* The endpoint (its name is the slave path), or NULL on error.
+ */
+Ep* srvPty(Srv *s);
+
+/**
+ * @brief Listens for ATM connections on a TCP port.
+ * @param s Server.
+ * @param port TCP port.
+ * @return int 0 on success, -1 on error.
+ */
+int srvTcp(Srv *s,int port);
+
+/**
+ * @brief Runs the event loop until *stop becomes non-zero.
+ * @param s Server.
+ * @param stop Set by a signal handler to end the loop.
+ * @return int 0 when stopped, -1 if epoll failed.
+ */
+int srvRun(Srv *s,volatile sig_atomic_t *stop);
+
+/**
+ * @brief Prints per-endpoint counters, closes every endpoint and the epoll instance.
+ * @param s Server.
+ */
+void srvClose(Srv *s);
+
+#endif //End of _SRVLIB_H guard
@@ -0,0 +1,87 @@
+#include "srvLib.h" //Includes the srvLib.h header file for the server functions
+#include "jrnLib.h" //Journal flush on shutdown
+#include "rptLib.h" //Report of what changed since the last #Q
+#include <sys/resource.h> //setrlimit, one descriptor per endpoint
+
+//Multi-ATM server: serves any number of ATMs over serial devices, ptys and TCP
+//from one shared account database.
+//Usage: ./atm_srv [-l] [-s device]... [-f device_list] [-p count] [-t port]
+//  -l              lazy history loading: only account records are read at startup,
+//                  a history is read when a request or a save first needs it
+//  -s device       serial device (or pty slave) of one ATM, may be repeated
+//  -f device_list  file with one device path per line
+//  -p count        create count ptys; their slave paths are printed, one per line
+//  -t port         accept ATMs on a TCP port
+//#Q takes a background snapshot; Db.csv and the history files are written on SIGINT/SIGTERM,
+//which stop the server.
+
+static volatile sig_atomic_t stop=0; //Set by the signal handler
+
+//Signal handler: asks the event loop to stop.
+static void onSig(int sig){
+        (void)sig;
+        stop=1;
+}
+
+//The main function: loads the database, opens the endpoints and runs the event loop.
+int main(int argc,char **argv){
+        Acc *db=NULL; //Shared account database
+        Srv srv; //Server state
+        struct sigaction sa; //Stop signals
+        struct rlimit rl; //Descriptor limit
+        char line[256]; //Device list line
+        FILE *fp; //Device list
+        int opt,i,n; //getopt result, counters
+
+        while((opt=getopt(argc,argv,"ls:f:p:t:"))!=-1)if(opt=='l')lazyHist=1; //Load mode is needed before syncData
+        bgSave=1; //#Q must not hold every account while the files are written
+        jrnGroup=1; //srvRun syncs the journal once per epoll_wait batch
+        optind=1; //Second pass opens the endpoints
+        syncData(&db); //Snapshot or CSV, then the journal
+        if(srvInit(&srv,db)){perror("srv");return 1;}
+        if(!getrlimit(RLIMIT_NOFILE,&rl)){rl.rlim_cur=rl.rlim_max;setrlimit(RLIMIT_NOFILE,&rl);} //Hundreds of ATMs need more than 1024 descriptors
+
+        while((opt=getopt(argc,argv,"ls:f:p:t:"))!=-1){
+                switch(opt){
+                        case 'l':break; //Handled before syncData
+                        case 's':if(srvSerial(&srv,optarg))perror(optarg); //Bad device: the others are still served
+                                 break;
+                        case 'f':if(!(fp=fopen(optarg,"r"))){perror(optarg);break;}
+                                 while(fgets(line,sizeof(line),fp)){
+                                        line[strcspn(line,"\r\n")]='\0';
+                                        if(line[0]&&srvSerial(&srv,line))perror(line);
+                                 }
+                                 fclose(fp);
+                                 break;
+                        case 'p':n=atoi(optarg);
+                                 for(i=0;i<n;i++){
+                                        Ep *e=srvPty(&srv); //New pty
+                                        if(!e){perror("srv: pty");break;}
+                                        printf("%s\n",e->name); //Slave path for the ATM side
+                                 }
+                                 fflush(stdout); //Readers of the list must not wait for the buffer
+                                 break;
+                        case 't':if(srvTcp(&srv,atoi(optarg)))perror("srv: tcp");
+                                 break;
+                        default :fprintf(stderr,"usage: %s [-l] [-s device]... [-f device_list] [-p count] [-t port]\n",argv[0]);
+                                 return 1;
+                }
+        }
+        if(!srv.nEp){fputs("srv: no endpoints\n",stderr);return 1;}
+
+        memset(&sa,0,sizeof(sa));
+        sa.sa_handler=onSig; //No SA_RESTART: epoll_wait returns EINTR
+        sigaction(SIGINT,&sa,NULL);
+        sigaction(SIGTERM,&sa,NULL);
+        signal(SIGPIPE,SIG_IGN); //A vanished TCP peer shows up as EPIPE on write
+#ifdef DBG //Conditional compilation block for debugging
+        printf("DBG_SRV:%d endpoints\n",srv.nEp);
+#endif //End of DBG conditional block
+
+        n=srvRun(&srv,&stop); //Until a stop signal
+        jrnFlush(db); //Saves Db.csv, the history files and the snapshot
+        rptWait(NULL); //A report of #Q still being written
+        if(!rptStart(db,RPT_CHANGED))rptWait(NULL); //Statements changed since then
+        srvClose(&srv);
+        return n?1:0;
+}
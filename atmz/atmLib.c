@@ -1,48 +1,105 @@
 #include "atmLib.h" //Includes the atmLib.h header file for function declarations, structures, and macros
+#include "idxLib.h" //RFID hash index used by getAcc
+#include "jrnLib.h" //Write-ahead journal used by act and syncData
+#include "snapLib.h" //Binary snapshot loaded by syncData
+#include "lnkLib.h" //Per-link receive buffering used by rx_str
+#include "lockLib.h" //Per-account locks held while a request reads or changes an account
+#include "poolLib.h" //Slabs the account and transaction nodes come from
+#include "wrLib.h" //Buffered writer for Db.csv, the history files and the reports
+#include "csvLib.h" //Vectorized reader for Db.csv and the history files
+#include "rptLib.h" //Background report writer behind saveFile and #Q
+#include "rollLib.h" //Bank-wide rollups kept by addTran, read by #R
+#include <sys/stat.h> //stat, to pick the newer of Db.snap and Db.csv
 
 #define BAUD B9600 //Defines the baud rate for serial communication (9600 bps)
 
+Idx rfIdx; //RFID index over the loaded accounts, built by syncData
+int loadThreads; //Threads loadCsv reads history files with, 0 for one per online CPU
+int lazyHist; //Non-zero: syncData loads account records only, histories are read by histFault on first use
+int bgSave; //Non-zero: #Q starts a background snapshot instead of saving in place
+
+static pthread_t scanTh; //Thread counting the history files of a lazy import in the rollups
+static int scanOn; //scanTh still has to be joined
+static int scanBusy; //Non-zero until the rollups hold every history file (atomic)
+
+//Accounts whose history files loadCsv's threads read
+typedef struct{
+        Acc **acc; //Accounts in list order
+        u64 cnt; //Number of accounts
+        u64 next; //First account no thread has taken yet
+        int scan; //Non-zero: records are only counted in the rollups (lazyHist), not kept
+        pthread_mutex_t mx; //Guards next
+}HistJob;
+
+//History file read into memory, not linked yet
+typedef struct{
+        Tran stk[LOAD_BUF]; //Records on the stack for short histories
+        Tran *rec; //Records as read (stk or the heap)
+        u64 cnt; //Number of records
+        int app; //File is oldest first (HIST_MARK)
+        int whole; //Appendable and no record is cut
+}HistRd;
+
+static int histRead(u64 num,Csv *cv,HistRd *h); //Reads one history file, also used by histFault and histFetch
+static Tran* histLink(HistRd *h,u64 skip); //Links records read by histRead
+static int loadHist(Acc *usr,Csv *cv); //Reads and links one history file
+static int scanHist(const Acc *usr,Csv *cv); //Counts one history file in the rollups
+static void loadHists(Acc *head,u64 cnt,int scan); //Reads or scans every history file on loader threads
+static void* scanWork(void *arg); //Background rollup scan of a lazy import
+static int histTail(const Acc *usr); //Checks that a history file can be appended to without reading it
+
+/**
+ * @brief Initializes the serial port for communication.
+ * @param dev Path of the serial device (SERIAL_DEV, /dev/ttyUSB0, for the real ATM).
+ * @return int File descriptor for the opened serial port. Exits program on failure to open.
+ */
+int initSerial(const char *dev){
+        int fd=openSerial(dev); //Configured port
+        if(fd==-1){ //Checks if the port opening failed
+                perror(dev); //Prints the system error message for the device
+                exit(1); //Exits the program with status 1 (error)
+        }
+        return fd; //Returns the file descriptor of the initialized serial port
+}
+
 /**
- * @brief Initializes the serial port (/dev/ttyUSB0) for communication.
+ * @brief Opens and configures a serial port (or pty) for communication.
  * Configures the port to raw mode, sets baud rate, enables local connection and reading,
  * sets 8 data bits, no parity, 1 stop bit, and disables canonical mode, echo, and signal chars.
  * Makes read a blocking function.
- * @param void No parameters.
- * @return int File descriptor for the opened serial port. Exits program on failure to open.
+ * @param dev Path of the serial device.
+ * @return int File descriptor for the opened serial port, or -1 on error (errno set).
  */
-int initSerial(void){
-
-        int fd; //File descriptor for the serial port
-        struct termios opt; //Structure to hold terminal attributes
-        //Comment indicating the start of serial port opening logic
-        //fd=open("/dev/ttyUSB0",O_RDWR|O_NOCTTY| O_NDELAY); //Alternative open call with non-blocking reads (commented out)
-        fd=open("/dev/ttyUSB0",O_RDWR|O_NOCTTY); //Opens the serial port /dev/ttyUSB0 for read/write, not as controlling terminal
-        if(fd==-1){ //Checks if the port opening failed
-                perror("open"); //Prints the system error message for "open"
-                exit(1); //Exits the program with status 1 (error)
-        }
-        //make read a blocking func //Comment indicating configuration for blocking read
-        fcntl(fd,F_SETFL,0); //Sets file status flags for 'fd'; 0 makes read() blocking
-        // Get and modify current options: //Comment indicating the process of getting and setting terminal attributes
-
-        tcgetattr (fd, &opt) ; //Gets the current terminal attributes for 'fd' and stores them in 'opt'
-
-        cfmakeraw   (&opt) ; //Sets the terminal to raw mode (non-canonical, no echo, etc.)
-        cfsetispeed (&opt, BAUD) ; //Sets the input baud rate
-        cfsetospeed (&opt, BAUD) ; //Sets the output baud rate
-
-        opt.c_cflag |= (CLOCAL | CREAD) ; //Enables local connection (ignore modem control lines) and enables receiver
-        opt.c_cflag &= ~PARENB ; //Disables parity generation and detection
-        opt.c_cflag &= ~CSTOPB ; //Sets one stop bit (instead of two)
-        opt.c_cflag &= ~CSIZE ; //Clears the character size bits
-        opt.c_cflag |= CS8 ; //Sets character size to 8 bits
-        opt.c_lflag &= ~(ICANON | ECHO | ECHOE | ISIG) ; //Disables canonical mode, echo, echo erase, and signal characters
-        opt.c_oflag &= ~OPOST ; //Disables implementation-defined output processing
-
-        tcsetattr (fd, TCSANOW | TCSAFLUSH, &opt) ; //Sets the modified terminal attributes immediately and flushes pending I/O
-
-        usleep (10000) ;        //Pauses for 10 milliseconds to allow settings to take effect
-        return fd; //Returns the file descriptor of the initialized serial port
+int openSerial(const char *dev){
+
+        int fd; //File descriptor for the serial port
+        struct termios opt; //Structure to hold terminal attributes
+        //Comment indicating the start of serial port opening logic
+        //fd=open("/dev/ttyUSB0",O_RDWR|O_NOCTTY| O_NDELAY); //Alternative open call with non-blocking reads (commented out)
+        fd=open(dev,O_RDWR|O_NOCTTY); //Opens the serial port for read/write, not as controlling terminal
+        if(fd==-1)return -1; //Checks if the port opening failed, errno tells why
+        //make read a blocking func //Comment indicating configuration for blocking read
+        fcntl(fd,F_SETFL,0); //Sets file status flags for 'fd'; 0 makes read() blocking
+        // Get and modify current options: //Comment indicating the process of getting and setting terminal attributes
+
+        tcgetattr (fd, &opt) ; //Gets the current terminal attributes for 'fd' and stores them in 'opt'
+
+        cfmakeraw   (&opt) ; //Sets the terminal to raw mode (non-canonical, no echo, etc.)
+        cfsetispeed (&opt, BAUD) ; //Sets the input baud rate
+        cfsetospeed (&opt, BAUD) ; //Sets the output baud rate
+
+        opt.c_cflag |= (CLOCAL | CREAD) ; //Enables local connection (ignore modem control lines) and enables receiver
+        opt.c_cflag &= ~PARENB ; //Disables parity generation and detection
+        opt.c_cflag &= ~CSTOPB ; //Sets one stop bit (instead of two)
+        opt.c_cflag &= ~CSIZE ; //Clears the character size bits
+        opt.c_cflag |= CS8 ; //Sets character size to 8 bits
+        opt.c_lflag &= ~(ICANON | ECHO | ECHOE | ISIG) ; //Disables canonical mode, echo, echo erase, and signal characters
+        opt.c_oflag &= ~OPOST ; //Disables implementation-defined output processing
+
+        tcsetattr (fd, TCSANOW | TCSAFLUSH, &opt) ; //Sets the modified terminal attributes immediately and flushes pending I/O
+
+        usleep (10000) ;        //Pauses for 10 milliseconds to allow settings to take effect
+        return fd; //Returns the file descriptor of the initialized serial port
 }
 
 /**
@@ -52,7 +109,7 @@ int initSerial(void){
  */
 void flushSerial (const int fd)
 {
-        tcflush (fd, TCIOFLUSH) ; //Discards data written but not transmitted and data received but not read
+        tcflush (fd, TCIOFLUSH) ; //Discards data written but not transmitted and data received but not read
 }
 
 /**
@@ -61,32 +118,57 @@ void flushSerial (const int fd)
  * @param void No return value.
  */
 void endSerial(const int fd){
-        close(fd); //Closes the file descriptor associated with the serial port
+        lnkClose(fd); //Drops the link's buffered bytes
+        close(fd); //Closes the file descriptor associated with the serial port
 }
 
 /**
  * @brief Transmits a single character over the serial port.
+ * Queued responses are sent first so the order on the line is kept.
  * @param fd The file descriptor of the serial port.
  * @param ch The character to be transmitted.
  * @return int The number of bytes written (1 on success, -1 on error).
  */
 int tx_char(const int fd,const char ch){
-        return write(fd,&ch,1); //Writes one character 'ch' to the serial port 'fd'
+        if(lnkPut(fd,&ch,1)<0||lnkFlush(fd))return -1; //Queues behind pending output, then sends everything
+        return 1;
 }
 
 /**
- * @brief Transmits a null-terminated string over the serial port, followed by a carriage return and newline (CR LF).
+ * @brief Queues a null-terminated string followed by a carriage return and newline (CR LF) on the serial port.
+ * The response is copied into the link's output buffer; it is written, together with
+ * any other queued responses, by the next rx_str or lnkFlush.
  * @param fd The file descriptor of the serial port.
  * @param str The null-terminated string to transmit.
- * @return int Returns the result of the last write operation (typically bytes written for CR LF, or error).
- * Note: The function performs two write calls.
+ * @return int Number of bytes queued (including CR LF), or -1 on error.
  */
 int tx_str(const int fd,const char *str){
-        write(fd,str,strlen(str)); //Writes the string 'str' to the serial port 'fd'
-        write(fd,"\r\n",2); //Writes carriage return and newline characters to the serial port
+        size_t n=strlen(str); //Length of the response
+        if((lnkPut(fd,str,n)<0)||(lnkPut(fd,"\r\n",2)<0))return -1; //No system call unless the buffer is full
+        lnkGet(fd)->txFrames++; //One more response
 #ifdef DBG //Conditional compilation block for debugging
-        printf("DBG_TX:%s\n",str); //Prints the transmitted string to the console if DBG is defined
+        printf("DBG_TX:%s\n",str); //Prints the transmitted string to the console if DBG is defined
 #endif //End of DBG conditional block
+        return n+2;
+}
+
+/**
+ * @brief Formats a response directly into the link's output buffer, followed by CR LF.
+ * Replaces sprintf into a local buffer followed by tx_str.
+ * @param fd The file descriptor of the serial port.
+ * @param fmt printf style format of the response.
+ * @return int Length of the response (without CR LF), or -1 on error.
+ */
+int tx_fmt(const int fd,const char *fmt,...){
+        va_list ap; //Arguments after fmt
+        int n; //Formatted length
+        va_start(ap,fmt);
+        n=lnkVfmt(fd,fmt,ap); //Formats in place
+        va_end(ap);
+#ifdef DBG //Conditional compilation block for debugging
+        if(n>=0)printf("DBG_TX:%.*s\n",n,lnkGet(fd)->tx+lnkGet(fd)->txLen-n-2); //The response just queued
+#endif //End of DBG conditional block
+        return n;
 }
 
 /**
@@ -96,41 +178,44 @@ int tx_str(const int fd,const char *str){
  * @return char The received character. Returns -1 if read fails to get 1 byte.
  */
 char rx_char(const int fd){
-        char ch; //Buffer for the received character
-        if(read(fd,&ch,1)!=1)return -1; //Reads one character from 'fd' into 'ch'; returns -1 if 1 byte is not read
-        return ch; //Returns the received character
+        char ch; //Buffer for the received character
+        if(read(fd,&ch,1)!=1)return -1; //Reads one character from 'fd' into 'ch'; returns -1 if 1 byte is not read
+        return ch; //Returns the received character
 }
 
 /**
- * @brief Receives a string from the serial port until a newline character ('\n') is encountered
- * or the buffer length 'len' is almost reached. The newline and preceding carriage return
- * are replaced with a null terminator.
+ * @brief Receives the next frame ("#...$") from the serial port.
+ * Bytes are read in blocks into the link's ring buffer (lnkLib) and complete frames
+ * are cut out of it; the trailing "\r\n" is removed. Queued responses are flushed
+ * before waiting for more input. Garbage between frames is skipped
+ * and dropped bytes are reported as framing errors.
  * @param fd The file descriptor of the serial port.
- * @param str Pointer to the character array where the received string will be stored.
- * @param len The maximum number of characters to read (size of the 'str' buffer).
- * @param void No return value. Exits on read error.
- */
-void rx_str(const int fd,char *str,size_t len){
-        int i=0,j=0; //i: index for 'str' buffer, j: return value of read()
-        char ch; //Buffer for each character read
-        for(;i<len-1;i++){ //Loop to read characters up to len-1 or until newline
-                j=read(fd,&ch,1); //Reads one character from the serial port
-                if(j==-1){ //If read() returns an error
-                        printf("i=%d\n",i); //Prints the current index 'i'
-                        perror("read_str"); //Prints the system error message for "read_str"
-                        exit(1); //Exits the program with status 1 (error)
-                }else if(j==0){ //If read() returns 0 (no data, non-blocking scenario, though configured as blocking)
-                        i--; //Decrement 'i' to retry reading for the current position
-                        continue; //Continues to the next iteration of the loop
-                }
-                str[i]=ch; //Stores the read character in the buffer
-                if(ch=='\n')break; //If the character is a newline, exit the loop
-        }
-        str[i-1]='\0';//Replaces the carriage return (assuming it's before '\n') with a null terminator
+ * @param str Pointer to the character array where the received frame will be stored.
+ * @param len The size of the 'str' buffer; longer frames are dropped.
+ * @return int Length of the frame, or -1 if the link failed or was closed.
+ */
+int rx_str(const int fd,char *str,size_t len){
+        int n; //Frame length or read result
+        while((n=lnkFrame(fd,str,len))<=0){ //No complete frame buffered yet
+                if(n<0){ //Bytes were dropped, keep going with the next frame
+                        fprintf(stderr,"rx_str: framing error on fd %d, bytes dropped\n",fd);
+                        continue;
+                }
+                if(lnkFlush(fd)){ //Replies to everything handled so far leave in one write
+                        perror("rx_str: flush");
+                        return -1;
+                }
+                n=lnkRead(fd); //One read for everything that has arrived
+                if(n>0)continue;
+                if((n<0)&&(errno==EINTR))continue; //Interrupted by a signal, not an error
+                if(n==0)errno=EPIPE; //Other end closed (pty or socket)
+                perror("rx_str");
+                return -1;
+        }
 #ifdef DBG //Conditional compilation block for debugging
-        printf("DBG_RX:%s\n",str); //Prints the received string to the console if DBG is defined
+        printf("DBG_RX:%s\n",str); //Prints the received string to the console if DBG is defined
 #endif //End of DBG conditional block
-
+        return n; //Frame length
 }
 
 /**
@@ -140,8 +225,50 @@ void rx_str(const int fd,char *str,size_t len){
  * @return int Returns 1 if the message format is okay, 0 otherwise.
  */
 int isMsgOk(const char *buf){
-        if((buf[0]=='#')&&(buf[strlen(buf)-1]=='$'))return 1; //Checks first and last characters for format markers
-        return 0; //Returns 0 if format is not okay
+        if((buf[0]=='#')&&(buf[strlen(buf)-1]=='$'))return 1; //Checks first and last characters for format markers
+        return 0; //Returns 0 if format is not okay
+}
+
+/**
+ * @brief Handles one received frame: checks its format and runs the requested operation.
+ * Shared by the single-port loop (atm_main) and the multi-ATM server (atm_server).
+ * #C (card check), #V (PIN check), #A (action), #X (line check), #Q (save), #R (rollups).
+ * The frame is tokenized once (msgParse); the handlers work on field views into buf.
+ * @param db Pointer to the head of the account database.
+ * @param fd File descriptor the frame came from; replies are queued on it.
+ * @param buf The received frame (without "\r\n"), need not be null-terminated.
+ * @param len Length of the frame, as returned by rx_str/lnkFrame.
+ * @return int 1 if the frame was handled, 0 if it was malformed or unknown.
+ */
+int procMsg(Acc *db,const int fd,const char *buf,size_t len){
+        Msg m; //Op code and field views
+        if(msgParse(buf,len,&m))return 0; //Checks the '#', '$' and ':' layout of the frame
+        //#<opt>:<data>$ //Expected message format: '#' followed by option, ':', data, and '$'
+        switch(m.op){ //Switch statement based on the option code
+                //Case for RFID check operation
+                case 'C':return checkRFID(db,fd,&m); //If option is 'C', calls the checkRFID function
+                //Case for PIN verification operation
+                case 'V':return verifyPin(db,fd,&m); //If option is 'V', calls the verifyPin function
+                //Case for performing an ATM action
+                case 'A':puts("acting."); //If option is 'A', prints "acting." to the console
+                         return act(db,fd,&m); //Calls the 'act' function to perform the specified ATM action
+                //Case for checking the connection status
+                case 'X':tx_str(fd,"@X:LINEOK$"); //If option is 'X', sends a "LINEOK" message back
+                         break; //Exits the switch statement
+                case 'R':return rollQuery(fd,&m); //Day or hour totals of the bank
+                case 'Q': //Case for quit/save operation
+                         if(bgSave){ //Server: a forked snapshot, the other links keep being served; Db.csv is written at shutdown
+                                jrnCheckpoint(db);
+                                puts(histScanning()?"snapshot deferred, rollups still being counted":"snapshot started");
+                         }else{
+                                jrnFlush(db); //Saves the current account data to the primary data file (Db.csv) and empties the journal
+                                puts("data saved"); //Prints "data saved" to the console
+                         }
+                         if(rptStart(db,RPT_CHANGED)==1)puts("report still running, changes go into the next one"); //Human-readable files (DataBase.csv) are written in the background
+                         break; //Exits the switch statement
+                default: return 0; //Unknown option
+        } //End of switch statement
+        return 1; //Handled
 }
 
 /**
@@ -149,33 +276,69 @@ int isMsgOk(const char *buf){
  * Extracts RFID from the buffer, searches for it, and sends a status message back via serial.
  * Message format: #C:<rfid>$
  * Response: @OK:ACTIVE:<username>$ or @ERR:BLOCK$ or @ERR:INVALID$
+ * A frame with the wrong layout is answered with @ERR:INVALID$ as well.
  * @param head Pointer to the head of the linked list of accounts.
  * @param fd File descriptor for serial communication.
- * @param buf Pointer to the received message buffer containing the RFID.
- * @param void No return value.
+ * @param m Tokenized frame: one field, the 8 digit RFID.
+ * @return int 1 if the frame was well formed, 0 otherwise.
  */
-void checkRFID(Acc *head,const int fd,const char *buf){
-        //#C:<rfid>$ //Expected message format
-        //check rfid in database
-        char rfid[9]; //Buffer to store the extracted 8-character RFID + null terminator
-        char temp[32]; //Buffer for formatting the response string
-        strncpy(rfid,buf+3,8); //Copies 8 characters starting from buf[3] (after "#C:") into 'rfid'
-        rfid[8]='\0'; //Null-terminates the rfid string
-        Acc *usr=getAcc(head,rfid); //Searches for the account with the given rfid
+int checkRFID(Acc *head,const int fd,const Msg *m){
+        //#C:<rfid>$ //Expected message format
+        //check rfid in database
+        if((m->nf!=1)||!fldDigits(m->f[0],MSG_RFID_LEN)){ //Card number missing, too long or not numeric
+                tx_str(fd,"@ERR:INVALID$");
+                return 0;
+        }
+        Acc *usr=getAcc(head,m->f[0].p); //Searches for the account with the given rfid (read in place)
 #ifdef INT //Conditional compilation for interactive mode
-        checkMC(fd); //Performs a microcontroller connectivity check
+        checkMC(fd); //Performs a microcontroller connectivity check
 #endif //End of INT conditional block
-        if(usr){ //If the account (user) is found
-                //card status check
-                if(usr->cardStat){ //If the card status is active
-                        sprintf(temp,"@OK:ACTIVE:%s$",usr->usrName); //Formats an "ACTIVE" response with username
-                        tx_str(fd,temp); //Sends the formatted response
-                }else{ //If the card status is not active (blocked)
-                        tx_str(fd,"@ERR:BLOCK$"); //Sends a "BLOCKED" error response
-                }
-        }else{ //If the account (user) is not found
-                tx_str(fd,"@ERR:INVALID$"); //Sends an "INVALID" error response
-        }
+        if(usr){ //If the account (user) is found
+                lockAcc(usr); //Card status may be changed by a BLK on another link
+                //card status check
+                if(usr->cardStat){ //If the card status is active
+                        tx_fmt(fd,"@OK:ACTIVE:%s$",usr->usrName); //Sends an "ACTIVE" response with username
+                }else{ //If the card status is not active (blocked)
+                        tx_str(fd,"@ERR:BLOCK$"); //Sends a "BLOCKED" error response
+                }
+                unlockAcc(usr);
+        }else{ //If the account (user) is not found
+                tx_str(fd,"@ERR:INVALID$"); //Sends an "INVALID" error response
+        }
+        return 1;
+}
+
+/**
+ * @brief Sends the bank-wide totals of one day, or of one hour of it, read from the rollups (no account is visited).
+ * Message format: #R$ or #R:$ (today), #R:<YYYYMMDD>$ (that day), #R:<YYYYMMDD>:<HH>$ (that hour)
+ * Response: @OK:ROLL:<YYYYMMDD>[:<HH>]:<count>,<amount>:...$ with count and amount of withdrawals,
+ * deposits, transfers in and transfers out, in that order; @ERR:NODATA$ for a day older than the
+ * days kept, @ERR:PARTIAL$ while the history files of a lazy import are still being counted,
+ * @ERR:INVALID$ for a malformed frame
+ * @param fd File descriptor the frame came from.
+ * @param m The tokenized frame.
+ * @return int 1 if the frame was well formed, 0 otherwise.
+ */
+int rollQuery(const int fd,const Msg *m){
+        RollDay d; //Rollups of the day
+        const RollCell *c; //Cells of the day or of the hour
+        char amt[4][MON_LEN]; //Amount text of every type
+        unsigned long long day=getTimeStamp()/1000000,hh=24; //YYYYMMDD (today unless given), hour (24: whole day)
+        int i; //Type counter
+        if((m->nf>2)||((m->nf>=1)&&m->f[0].len&&!fldDigits(m->f[0],8))||((m->nf==2)&&(fldNum(m->f[1],&hh)||(hh>23)))){
+                tx_str(fd,"@ERR:INVALID$");
+                return 0;
+        }
+        if(histScanning()){tx_str(fd,"@ERR:PARTIAL$");return 1;} //Lazy import: history files still being counted
+        if((m->nf>=1)&&m->f[0].len)fldNum(m->f[0],&day);
+        if(rollGet(day,&d)){tx_str(fd,"@ERR:NODATA$");return 1;}
+        c=(hh<24)?d.hour[hh]:d.tot;
+        for(i=0;i<4;i++)monFmt(amt[i],c[WITHDRAW+i].sum);
+        if(hh<24)tx_fmt(fd,"@OK:ROLL:%llu:%02llu:%llu,%s:%llu,%s:%llu,%s:%llu,%s$",day,hh,c[WITHDRAW].cnt,amt[0],c[DEPOSIT].cnt,amt[1],
+                        c[TRANSFER_IN].cnt,amt[2],c[TRANSFER_OUT].cnt,amt[3]);
+        else tx_fmt(fd,"@OK:ROLL:%llu:%llu,%s:%llu,%s:%llu,%s:%llu,%s$",day,c[WITHDRAW].cnt,amt[0],c[DEPOSIT].cnt,amt[1],
+                        c[TRANSFER_IN].cnt,amt[2],c[TRANSFER_OUT].cnt,amt[3]);
+        return 1;
 }
 
 /**
@@ -183,38 +346,48 @@ void checkRFID(Acc *head,const int fd,const char *buf){
  * Extracts RFID and PIN from the buffer, finds the account, compares PINs, and sends a status message.
  * Message format: #V:<rfid>:<pin>$
  * Response: @OK:MATCHED$ or @ERR:WRONG$
+ * A frame with the wrong layout or an unknown card is answered with @ERR:INVALID$.
  * @param head Pointer to the head of the linked list of accounts.
  * @param fd File descriptor for serial communication.
- * @param buf Pointer to the received message buffer containing RFID and PIN.
- * @param void No return value.
+ * @param m Tokenized frame: the 8 digit RFID and the 4 digit PIN.
+ * @return int 1 if the frame was well formed, 0 otherwise.
  */
-void verifyPin(Acc *head,const int fd,const char *buf){
-        //#V:<rfid>:<pin>$ //Expected message format
-        //verify rfid with pin
-        char rfid[9]; //Buffer for extracted RFID (8 chars + null)
-        char pin[5]; //Buffer for extracted PIN (4 chars + null)
-
-        strncpy(rfid,buf+3,8); //Extracts RFID (8 chars from buf[3])
-        rfid[8]='\0'; //Null-terminates RFID string
-        strncpy(pin,buf+12,4); //Extracts PIN (4 chars from buf[12], after "<rfid>:")
-        pin[4]='\0'; //Null-terminates PIN string
-
-        Acc *usr=getAcc(head,rfid); //Retrieves the account associated with the RFID
+int verifyPin(Acc *head,const int fd,const Msg *m){
+        //#V:<rfid>:<pin>$ //Expected message format
+        //verify rfid with pin
+        if((m->nf!=2)||!fldDigits(m->f[0],MSG_RFID_LEN)||!fldDigits(m->f[1],MSG_PIN_LEN)){ //Wrong layout
+                tx_str(fd,"@ERR:INVALID$");
+                return 0;
+        }
+        Fld pin=m->f[1]; //PIN, compared in place
+
+        Acc *usr=getAcc(head,m->f[0].p); //Retrieves the account associated with the RFID
 #ifdef INT //Conditional compilation for interactive mode
-        checkMC(fd); //Performs a microcontroller connectivity check
+        checkMC(fd); //Performs a microcontroller connectivity check
 #endif //End of INT conditional block
-        if(!strcmp(pin,usr->pin)){ //Compares the extracted PIN with the stored PIN for the user
-                tx_str(fd,"@OK:MATCHED$"); //If PINs match, sends "MATCHED" response
-
-        }else{ //If PINs do not match
-                tx_str(fd,"@ERR:WRONG$"); //Sends "WRONG" PIN error response
-
-        }
+        if(!usr){ //Unknown card: one bad frame must not take the server down
+                tx_str(fd,"@ERR:INVALID$");
+                return 1;
+        }
+        lockAcc(usr); //PIN may be changed by a PIN request on another link
+        if(!memcmp(pin.p,usr->pin,MSG_PIN_LEN)&&!usr->pin[MSG_PIN_LEN]){ //Compares the extracted PIN with the stored PIN for the user
+                tx_str(fd,"@OK:MATCHED$"); //If PINs match, sends "MATCHED" response
+
+        }else{ //If PINs do not match
+                tx_str(fd,"@ERR:WRONG$"); //Sends "WRONG" PIN error response
+
+        }
+        unlockAcc(usr);
+        return 1;
 }
 
 /**
  * @brief Processes various ATM actions like withdrawal, deposit, balance inquiry, etc.
- * Extracts RFID, request type, and other data from the buffer, then calls appropriate sub-functions.
+ * Takes the RFID, request type and other data from the field views of the frame, then calls appropriate sub-functions.
+ * Field counts and lengths are checked first; a malformed request is answered with @ERR:INVALID$.
+ * Account changes are appended to the journal (jrnLog) instead of rewriting the whole database.
+ * The account is locked (lockAcc) from the first read to the journal record, so
+ * concurrent requests for the same account apply one after the other.
  * Supported requests and formats:
  * #A:WTD:<rfid>:<amt>$  (Withdraw)
  * #A:DEP:<rfid>:<amt>$  (Deposit)
@@ -224,93 +397,102 @@ void verifyPin(Acc *head,const int fd,const char *buf){
  * #A:BLK:<rfid>$       (Block Card)
  * @param head Pointer to the head of the linked list of accounts.
  * @param fd File descriptor for serial communication.
- * @param buf Pointer to the received message buffer containing the action request.
- * @param void No return value.
+ * @param m Tokenized frame: request code, RFID and the request's argument, if any.
+ * @return int 1 if the frame was well formed, 0 otherwise.
  */
-void act(Acc *head,const int fd,const char *buf){
-        //#A:WTD:<rfid>:<amt>$  -> @OK:DONE$,@ERR:LOWBAL$,@ERR:NEGAMT$,@ERR:MAXAMT$ //Withdrawal format and responses
-        //#A:DEP:<rfid>:<amt>$  -> @OK:DONE$,@ERR:NEGAMT$,@ERR:MAXAMT$ //Deposit format and responses
-        //#A:BAL:<rfid>$        -> @OK:BAL=<amt>$ //Balance inquiry format and response
-        //#A:PIN:<rfid>:<pin>$  -> @OK:DONE$ //PIN change format and response
-        //#A:MST:<rfid>:<txNo>$ -> @TXN:<type>:<ddmmyyyyhhmm>:<amt>$ //Mini statement format and response
-        //#A:BLK:<rfid>$        -> @OK:DONE$ //Block card format and response
-
-        char rfid[9]; //Buffer for extracted RFID
-        char req[4]; //Buffer for extracted request code (e.g., "WTD", "DEP") (3 chars + null)
-        char pin[5]; //Buffer for extracted new PIN (for PIN change)
-        double amt=0; //Variable to store extracted amount for transactions
-        char txn=0; //Variable to store transaction number for mini statement
-
-        //extract rfid //Comment indicating RFID extraction
-        strncpy(rfid,buf+7,8); //Extracts RFID (8 chars from buf[7], after "#A:XXX:")
-        rfid[8]='\0'; //Null-terminates RFID string
-        //get Acc //Comment indicating account retrieval
-        Acc *usr=getAcc(head,rfid); //Retrieves user account based on RFID
-        //extract req //Comment indicating request code extraction
-        strncpy(req,buf+3,3); //Extracts the 3-letter request code (from buf[3], after "#A:")
-        req[3]='\0'; //Null-terminate the request string (corrected from req[4])
-
-        printf("req=%s,rfid=%s\n",req,rfid); //Debug print of request and RFID
-
-        if(!strcmp(req,"WTD")){ //If request is "WTD" (Withdraw)
-                amt=extAmt(buf); //Extracts the withdrawal amount from the buffer
-                withdraw(fd,usr,amt); //Calls the withdraw function
-                saveData(head); //Saves all account data after the transaction
-        }else if(!strcmp(req,"DEP")){ //If request is "DEP" (Deposit)
-                amt=extAmt(buf); //Extracts the deposit amount from the buffer
-                deposit(fd,usr,amt); //Calls the deposit function
-                saveData(head); //Saves all account data
-        }else if(!strcmp(req,"BAL")){ //If request is "BAL" (Balance Inquiry)
-                balance(fd,usr); //Calls the balance inquiry function
-        }else if(!strcmp(req,"MST")){ //If request is "MST" (Mini Statement)
-                //mini statement //Comment indicating mini statement logic
-                txn=buf[16]-'0'; //Extracts transaction number (single digit char at buf[16]) and converts to int
-                miniStatement(fd,usr,txn); //Calls the mini statement function
-        }else if(!strcmp(req,"TNF")){ //If request is "TNF" (Transfer - currently not implemented)
+int act(Acc *head,const int fd,const Msg *m){
+        //#A:WTD:<rfid>:<amt>$  -> @OK:DONE$,@ERR:LOWBAL$,@ERR:NEGAMT$,@ERR:MAXAMT$ //Withdrawal format and responses
+        //#A:DEP:<rfid>:<amt>$  -> @OK:DONE$,@ERR:NEGAMT$,@ERR:MAXAMT$ //Deposit format and responses
+        //#A:BAL:<rfid>$        -> @OK:BAL=<amt>$ //Balance inquiry format and response
+        //#A:PIN:<rfid>:<pin>$  -> @OK:DONE$ //PIN change format and response
+        //#A:MST:<rfid>:<txNo>$ -> @TXN:<type>:<ddmmyyyyhhmm>:<amt>$ //Mini statement format and response
+        //#A:BLK:<rfid>$        -> @OK:DONE$ //Block card format and response
+
+        char pin[5]; //New PIN (for PIN change), stored null-terminated in the account
+        i64 amt=0; //Variable to store extracted amount for transactions (paise)
+        u64 txn=0; //Transaction number for mini statement
+        u64 cnt; //Transaction count before a WTD/DEP, tells whether the request changed the account
+        Fld req,rfid,arg; //Request code, card number and argument views
+        int ok; //Field check result
+
+        if((m->nf<2)||(m->f[0].len!=MSG_REQ_LEN)||!fldDigits(m->f[1],MSG_RFID_LEN)){ //Request code and card are always present
+                tx_str(fd,"@ERR:INVALID$");
+                return 0;
+        }
+        req=m->f[0];
+        rfid=m->f[1];
+        arg=(m->nf>2)?m->f[2]:(Fld){NULL,0}; //Argument, empty for BAL and BLK
+        //check the argument of the request //Comment indicating per-request validation
+        if(FLD_IS(req,"WTD")||FLD_IS(req,"DEP"))ok=(m->nf==3)&&!fldAmt(arg,&amt); //Amount
+        else if(FLD_IS(req,"PIN"))ok=(m->nf==3)&&fldDigits(arg,MSG_PIN_LEN); //New PIN
+        else if(FLD_IS(req,"MST"))ok=(m->nf==3)&&!fldNum(arg,&txn); //Transaction number
+        else ok=(m->nf==2); //BAL, BLK, TNF and unknown codes take no argument
+        if(!ok){ //Missing, extra or malformed argument
+                tx_str(fd,"@ERR:INVALID$");
+                return 0;
+        }
+        //get Acc //Comment indicating account retrieval
+        Acc *usr=getAcc(head,rfid.p); //Retrieves user account based on RFID (read in place)
+
+        printf("req=%.*s,rfid=%.*s\n",(int)req.len,req.p,(int)rfid.len,rfid.p); //Debug print of request and RFID
+        if(!usr){ //Unknown card: one bad frame must not take the server down
+                tx_str(fd,"@ERR:INVALID$");
+                return 1;
+        }
+
+        lockAcc(usr); //Balance check, update and journal record form one step
+        if(FLD_IS(req,"WTD")){ //If request is "WTD" (Withdraw)
+                cnt=usr->tranCnt; //Transaction count before the request
+                withdraw(fd,usr,amt); //Calls the withdraw function
+                if(usr->tranCnt!=cnt)jrnLog(head,usr,JRN_WTD); //Journals the withdrawal if it went through
+        }else if(FLD_IS(req,"DEP")){ //If request is "DEP" (Deposit)
+                cnt=usr->tranCnt; //Transaction count before the request
+                deposit(fd,usr,amt); //Calls the deposit function
+                if(usr->tranCnt!=cnt)jrnLog(head,usr,JRN_DEP); //Journals the deposit if it went through
+        }else if(FLD_IS(req,"BAL")){ //If request is "BAL" (Balance Inquiry)
+                balance(fd,usr); //Calls the balance inquiry function
+        }else if(FLD_IS(req,"MST")){ //If request is "MST" (Mini Statement)
+                //mini statement //Comment indicating mini statement logic
+                miniStatement(fd,usr,(txn<=127)?(char)txn:0); //Out of range numbers get the "no transaction" reply
+        }else if(FLD_IS(req,"TNF")){ //If request is "TNF" (Transfer - currently not implemented)
             //This block is empty, indicating TNF is a placeholder or future feature
-        }else if(!strcmp(req,"PIN")){ //If request is "PIN" (PIN Change)
-                strncpy(pin,buf+16,4); //Extracts the new PIN (4 chars from buf[16])
-            pin[4] = '\0'; //Null-terminate the pin string
-                pinChange(fd,usr,pin); //Calls the PIN change function
-                saveData(head); //Saves all account data
-        }else if(!strcmp(req,"BLK")){ //If request is "BLK" (Block Card)
-                usr->cardStat=BLOCKED; //Sets the user's card status to BLOCKED
+        }else if(FLD_IS(req,"PIN")){ //If request is "PIN" (PIN Change)
+                memcpy(pin,arg.p,MSG_PIN_LEN); //Copies the new PIN, it outlives the frame
+                pin[MSG_PIN_LEN]='\0'; //Null-terminate the pin string
+                pinChange(fd,usr,pin); //Calls the PIN change function
+                jrnLog(head,usr,JRN_PIN); //Journals the new PIN
+        }else if(FLD_IS(req,"BLK")){ //If request is "BLK" (Block Card)
+                usr->cardStat=BLOCKED; //Sets the user's card status to BLOCKED
 #ifdef INT //Conditional compilation for interactive mode
-                checkMC(fd); //Performs a microcontroller connectivity check
+                checkMC(fd); //Performs a microcontroller connectivity check
 #endif //End of INT conditional block
-                tx_str(fd,"@OK:DONE$"); //Sends a confirmation message
-                saveData(head); //Saves all account data
-        }else{ //If the request code is unknown
+                tx_str(fd,"@OK:DONE$"); //Sends a confirmation message
+                jrnLog(head,usr,JRN_BLK); //Journals the blocked card
+        }else{ //If the request code is unknown
             //This block is empty, unknown requests are ignored
-        }
+        }
+        unlockAcc(usr);
+        jrnMaint(head); //Snapshot housekeeping, outside the account lock
+        return 1;
 }
 
 /**
- * @brief Extracts a floating-point amount from a message buffer.
- * The amount is assumed to start at index 16 of the buffer and end just before the trailing '$'.
- * Example: #A:WTD:<rfid>:<amt>$ or #A:DEP:<rfid>:<amt>$
- * @param buf Pointer to the character array (message buffer).
- * @return double The extracted amount as a double.
- */
-double extAmt(const char *buf){
-        char dup[20]; //Temporary buffer to hold the amount string
-        strcpy(dup,buf+16); //Copies the substring starting from index 16 (where amount begins) into 'dup'
-        dup[strlen(dup)-1]='\0'; //Removes the trailing '$' by replacing it with a null terminator
-        return atof(dup); //Converts the amount string 'dup' to a double and returns it
-}
-
-/**
- * @brief Searches for an account in the linked list by RFID.
+ * @brief Searches for an account by RFID.
+ * Uses the RFID index once syncData has built it, otherwise walks the linked list.
+ * At most 8 characters are compared, so rfid may also point at an 8 digit
+ * card number inside a received frame (not null-terminated).
+ * A closed account (CLOSED tombstone) is not found, its card is unknown from then on.
  * @param head Pointer to the head of the linked list of accounts.
  * @param rfid The RFID string to search for.
  * @return Acc* Pointer to the found account structure if successful, NULL otherwise.
  */
 Acc* getAcc(Acc *head,const char *rfid){
-        while(head){ //Iterates through the linked list of accounts
-                if(!strcmp(rfid,head->rfid)) break; //If the current account's RFID matches the search RFID, exit loop
-                head=head->nxt; //Moves to the next account in the list
-        }
-        return head; //Returns the pointer to the found account, or NULL if not found (end of list reached)
+        if(rfIdx.cap)head=idxGet(&rfIdx,rfid); //O(1) lookup through the index
+        else while(head){ //Iterates through the linked list of accounts
+                if(!strncmp(rfid,head->rfid,8)) break; //If the current account's RFID matches the search RFID, exit loop
+                head=head->nxt; //Moves to the next account in the list
+        }
+        return (head&&(head->cardStat!=CLOSED))?head:NULL; //Returns the pointer to the found account, or NULL if not found or closed
 }
 
 /// Start of deposit function block marker (custom comment style)
@@ -324,24 +506,24 @@ Acc* getAcc(Acc *head,const char *rfid){
  * @param amt The amount to be deposited.
  * @param void No return value.
  */
-void deposit(const int fd,Acc *usr,const f64 amt){
-        //#A:DEP:<rfid>:<amt>$  -> @OK:DONE$,@ERR:NEGAMT$,@ERR:MAXAMT$ //Message format and possible responses
+void deposit(const int fd,Acc *usr,const i64 amt){
+        //#A:DEP:<rfid>:<amt>$  -> @OK:DONE$,@ERR:NEGAMT$,@ERR:MAXAMT$ //Message format and possible responses
 #ifdef INT //Conditional compilation for interactive mode
-        checkMC(fd); //Performs microcontroller connectivity check
+        checkMC(fd); //Performs microcontroller connectivity check
 #endif //End of INT conditional block
-        if(amt<=0){ //Checks if the deposit amount is non-positive
-                tx_str(fd,"@ERR:NEGAMT$"); //Sends "negative amount" error response
+        if(amt<=0){ //Checks if the deposit amount is non-positive
+                tx_str(fd,"@ERR:NEGAMT$"); //Sends "negative amount" error response
 
-        }else if(amt<MAX_DEPOSIT){ //Checks if the amount is within the maximum deposit limit
-                usr->bal += amt; //Adds the amount to the user's balance
-                //update 2 transc //Comment indicating transaction record update
-                addTran(usr,+amt,DEPOSIT); //Adds a new transaction record for this deposit
-                tx_str(fd,"@OK:DONE$"); //Sends "DONE" success response
+        }else if(amt<MAX_DEPOSIT){ //Checks if the amount is within the maximum deposit limit
+                usr->bal += amt; //Adds the amount to the user's balance
+                //update 2 transc //Comment indicating transaction record update
+                addTran(usr,+amt,DEPOSIT); //Adds a new transaction record for this deposit
+                tx_str(fd,"@OK:DONE$"); //Sends "DONE" success response
 
-        }else{ //If the amount exceeds the maximum deposit limit
-                tx_str(fd,"@ERR:MAXAMT$"); //Sends "maximum amount exceeded" error response
+        }else{ //If the amount exceeds the maximum deposit limit
+                tx_str(fd,"@ERR:MAXAMT$"); //Sends "maximum amount exceeded" error response
 
-        }
+        }
 }
 /// End of deposit function block marker
 
@@ -356,28 +538,28 @@ void deposit(const int fd,Acc *usr,const f64 amt){
  * @param amt The amount to be withdrawn.
  * @param void No return value.
  */
-void withdraw(const int fd,Acc *usr,const f64 amt){
-        //#A:WTD:<rfid>:<amt>$  -> @OK:DONE$,@ERR:LOWBAL$,@ERR:NEGAMT$,@ERR:MAXAMT$ //Message format and responses
+void withdraw(const int fd,Acc *usr,const i64 amt){
+        //#A:WTD:<rfid>:<amt>$  -> @OK:DONE$,@ERR:LOWBAL$,@ERR:NEGAMT$,@ERR:MAXAMT$ //Message format and responses
 #ifdef INT //Conditional compilation for interactive mode
-        checkMC(fd); //Performs microcontroller connectivity check
+        checkMC(fd); //Performs microcontroller connectivity check
 #endif //End of INT conditional block
-        if(amt<=0){ //Checks if withdrawal amount is non-positive
-                tx_str(fd,"@ERR:NEGAMT$"); //Sends "negative amount" error
-        }else if(amt<MAX_WITHDRAW){ //Checks if amount is within the maximum withdrawal limit
-                if(amt<=(usr->bal)){ //Checks if user has sufficient balance
-                        usr->bal -= amt; //Subtracts the amount from user's balance
-                        //update 2 transc //Comment indicating transaction record update
-                        addTran(usr,-amt,WITHDRAW);//1 //Adds transaction record (amount is negative for withdrawal in history)
-                        tx_str(fd,"@OK:DONE$"); //Sends "DONE" success response
-
-                }else{ //If balance is insufficient
-                        tx_str(fd,"@ERR:LOWBAL$"); //Sends "low balance" error
-
-                }
-        }else{ //If amount exceeds maximum withdrawal limit
-                tx_str(fd,"@ERR:MAXAMT$"); //Sends "maximum amount exceeded" error
-
-        }
+        if(amt<=0){ //Checks if withdrawal amount is non-positive
+                tx_str(fd,"@ERR:NEGAMT$"); //Sends "negative amount" error
+        }else if(amt<MAX_WITHDRAW){ //Checks if amount is within the maximum withdrawal limit
+                if(amt<=(usr->bal)){ //Checks if user has sufficient balance
+                        usr->bal -= amt; //Subtracts the amount from user's balance
+                        //update 2 transc //Comment indicating transaction record update
+                        addTran(usr,-amt,WITHDRAW);//1 //Adds transaction record (amount is negative for withdrawal in history)
+                        tx_str(fd,"@OK:DONE$"); //Sends "DONE" success response
+
+                }else{ //If balance is insufficient
+                        tx_str(fd,"@ERR:LOWBAL$"); //Sends "low balance" error
+
+                }
+        }else{ //If amount exceeds maximum withdrawal limit
+                tx_str(fd,"@ERR:MAXAMT$"); //Sends "maximum amount exceeded" error
+
+        }
 }
 /// End of withdraw function block marker
 
@@ -391,14 +573,14 @@ void withdraw(const int fd,Acc *usr,const f64 amt){
  * @param void No return value.
  */
 void balance(const int fd,Acc *usr){
-        //#A:BAL:<rfid>$        -> @OK:BAL=<amt>$ //Message format and response
-        puts("in bal."); //Debug print to server console
-        char buf[50]; //Buffer to format the response string
-        sprintf(buf,"@OK:BAL=%.2lf$",usr->bal); //Formats the balance into the response string, to 2 decimal places
+        //#A:BAL:<rfid>$        -> @OK:BAL=<amt>$ //Message format and response
+        char bal[MON_LEN]; //Balance in rupees
+        puts("in bal."); //Debug print to server console
 #ifdef INT //Conditional compilation for interactive mode
-        checkMC(fd); //Performs microcontroller connectivity check
+        checkMC(fd); //Performs microcontroller connectivity check
 #endif //End of INT conditional block
-        tx_str(fd,buf); //Sends the formatted balance response
+        monFmt(bal,usr->bal); //Paise to rupees, without printf
+        tx_fmt(fd,"@OK:BAL=%s$",bal); //Sends the balance, to 2 decimal places
 
 }
 /// End of balance function block marker (custom comment style)
@@ -414,12 +596,12 @@ void balance(const int fd,Acc *usr){
  * @param void No return value.
  */
 void pinChange(const int fd,Acc *usr,const char *pin){
-        //#A:PIN:<rfid>:<pin>$  -> @OK:DONE$ //Message format and response
-        strcpy(usr->pin,pin); //Copies the new PIN into the user's account structure
+        //#A:PIN:<rfid>:<pin>$  -> @OK:DONE$ //Message format and response
+        strcpy(usr->pin,pin); //Copies the new PIN into the user's account structure
 #ifdef INT //Conditional compilation for interactive mode
-        checkMC(fd); //Performs microcontroller connectivity check
+        checkMC(fd); //Performs microcontroller connectivity check
 #endif //End of INT conditional block
-        tx_str(fd,"@OK:DONE$"); //Sends "DONE" success response
+        tx_str(fd,"@OK:DONE$"); //Sends "DONE" success response
 
 }
 /// End of pinChange function block marker
@@ -435,39 +617,35 @@ void pinChange(const int fd,Acc *usr,const char *pin){
  * @param void No return value.
  */
 void miniStatement(const int fd,Acc *usr,char txn){ //txn is char but used as int after '0' subtraction
-        //#A:MST:<rfid>:<txNo>$ -> @TXN:<type>:<ddmmyyyyhhmm>:<amt>$ //Message format and response
-        char buf[70]; //Buffer to format the transaction detail string for sending
-        u64 dum; //Temporary variable for timestamp decomposition
-        double amt; //Variable to store transaction amount
-        unsigned int dd,mon,yy,hh,mm; //Variables for date and time components
-        if(txn > 0 && txn <= usr->tranCnt){ //Checks if the requested transaction number is valid
-                Tran *t = usr->tranHist; //Points to the start of the transaction history linked list
-                while(--txn){ //Traverses the list to the desired transaction (txn is 1-based)
-                        t=t->nxt; //Moves to the next transaction
-                }
-                dum=(t->id)/100000; //Extracts timestamp part from transaction ID (YYYYMMDDHHMMSSxxx -> YYYYMMDDHHMM)
-                mm=dum%100; //Extracts minutes
-                dum/=100; //Removes minutes part
-                hh=dum%100; //Extracts hours
-                dum/=100; //Removes hours part
-                dd=dum%100; //Extracts day
-                dum/=100; //Removes day part
-                mon=dum%100; //Extracts month
-                dum/=100; //Removes month part
-                yy=dum; //Remaining part is year
-                amt=t->amt; //Gets the transaction amount
-                amt=(amt<0)?-amt:amt; //Makes the amount positive for display purposes
-                sprintf(buf,"@TXN:%d:%02u/%02u/%04u %02u:%02u:%.2lf$",t->type,dd,mon,yy,hh,mm,amt); //Formats the transaction details string
+        //#A:MST:<rfid>:<txNo>$ -> @TXN:<type>:<ddmmyyyyhhmm>:<amt>$ //Message format and response
+        u64 dum; //Temporary variable for timestamp decomposition
+        char amt[MON_LEN]; //Transaction amount in rupees
+        unsigned int dd,mon,yy,hh,mm; //Variables for date and time components
+        Tran *t; //Requested transaction
+        if((txn>0)&&((u64)txn>usr->tranCnt-usr->tranLazy))histFault(usr); //Older than what lazy loading has in memory
+        t=(txn>0)?recentGet(usr,txn):NULL; //Requested transaction (txn is 1-based), by index from the recent ring
+        if(t){ //Checks if the requested transaction number is valid
+                dum=(t->id)/100000; //Extracts timestamp part from transaction ID (YYYYMMDDHHMMSSxxx -> YYYYMMDDHHMM)
+                mm=dum%100; //Extracts minutes
+                dum/=100; //Removes minutes part
+                hh=dum%100; //Extracts hours
+                dum/=100; //Removes hours part
+                dd=dum%100; //Extracts day
+                dum/=100; //Removes day part
+                mon=dum%100; //Extracts month
+                dum/=100; //Removes month part
+                yy=dum; //Remaining part is year
+                monFmt(amt,(t->amt<0)?-t->amt:t->amt); //Formats the amount, made positive for display purposes
 #ifdef INT //Conditional compilation for interactive mode
-                checkMC(fd); //Performs microcontroller connectivity check
+                checkMC(fd); //Performs microcontroller connectivity check
 #endif //End of INT conditional block
-                tx_str(fd,buf); //Sends the transaction details
-        }else{ //If the transaction number is invalid or out of range
+                tx_fmt(fd,"@TXN:%d:%02u/%02u/%04u %02u:%02u:%s$",t->type,dd,mon,yy,hh,mm,amt); //Sends the transaction details
+        }else{ //If the transaction number is invalid or out of range
 #ifdef INT //Conditional compilation for interactive mode
-                checkMC(fd); //Performs microcontroller connectivity check
+                checkMC(fd); //Performs microcontroller connectivity check
 #endif //End of INT conditional block
-                tx_str(fd,"@TXN:7:0:0$"); //Sends an error/placeholder transaction detail (type 7, zero amount/date)
-        }
+                tx_str(fd,"@TXN:7:0:0$"); //Sends an error/placeholder transaction detail (type 7, zero amount/date)
+        }
 }
 /// End of miniStatement function block marker
 
@@ -479,60 +657,173 @@ void miniStatement(const int fd,Acc *usr,char txn){ //txn is char but used as in
  * @param type The type of transaction (e.g., DEPOSIT, WITHDRAW).
  * @param void No return value.
  */
-void addTran(Acc *usr,f64 amt,char type){
-        Tran *new=calloc(1,sizeof(Tran)); //Allocates and zero-initializes memory for a new transaction node
-        new->amt=amt; //Sets the transaction amount
-        new->id =getTranId(usr); //Generates and sets a unique transaction ID
-        new->type=type; //Sets the transaction type
-        new->nxt=NULL; //Initializes the next pointer to NULL
+void addTran(Acc *usr,i64 amt,char type){
+        Tran *new=poolGet(&tranPool); //Zeroed transaction node from the slab, no malloc on the request path
+        new->amt=amt; //Sets the transaction amount
+        new->id =getTranId(usr); //Generates and sets a unique transaction ID
+        new->type=type; //Sets the transaction type
+        new->nxt=NULL; //Initializes the next pointer to NULL
+
+        new->nxt=usr->tranHist; //Links the new transaction to the existing head of the transaction history
+        usr->tranHist=new; //Updates the user's transaction history to point to the new transaction as the head
+        usr->rTop=(usr->rTop+1)&(ACC_RECENT-1); //Newest slot of the recent ring moves on, overwriting the oldest
+        usr->recent[usr->rTop]=new;
+        if(usr->rCnt<ACC_RECENT)usr->rCnt++;
+
+        (usr->tranCnt)++; //Increments the user's transaction counter
+        usr->dirty|=DIRTY_ROW|DIRTY_HIST|DIRTY_RPT; //Balance row, history file and statement all change
+        rollAdd(new->id,amt,type); //Day and hour totals of the bank
+}
+
+/**
+ * @brief Refills an account's recent ring from the head of its history list.
+ * The list is newest first, so its i-th node goes i slots behind the newest slot.
+ * @param usr Pointer to the user's account structure.
+ */
+void recentBuild(Acc *usr){
+        Tran *t=usr->tranHist; //History iterator, newest first
+        unsigned int k=0; //Nodes taken
+        for(;t&&(k<ACC_RECENT)&&(k<usr->tranCnt);t=t->nxt,k++)usr->recent[(ACC_RECENT-1-k)&(ACC_RECENT-1)]=t; //Newest in the last slot
+        usr->rTop=ACC_RECENT-1; //Slot of the newest node
+        usr->rCnt=k;
+}
 
-        new->nxt=usr->tranHist; //Links the new transaction to the existing head of the transaction history
-        usr->tranHist=new; //Updates the user's transaction history to point to the new transaction as the head
+/**
+ * @brief Returns the k-th newest transaction of an account (1 = newest).
+ * The newest ACC_RECENT are read from the ring without touching the list; older
+ * entries continue from the oldest ring entry instead of the head.
+ * @param usr Pointer to the user's account structure.
+ * @param k 1-based position from the newest transaction.
+ * @return Tran* The transaction, or NULL if the history is shorter.
+ */
+Tran* recentGet(const Acc *usr,u64 k){
+        Tran *t; //History iterator
+        if(!k||(k>usr->tranCnt))return NULL; //Outside the history
+        if(k<=usr->rCnt)return usr->recent[(usr->rTop-(k-1))&(ACC_RECENT-1)]; //O(1): slot k-1 behind the newest
+        if(usr->rCnt){ //Skips the part of the list the ring covers
+                t=usr->recent[(usr->rTop-(usr->rCnt-1))&(ACC_RECENT-1)]; //Oldest ring entry (position rCnt)
+                k-=usr->rCnt;
+        }else{t=usr->tranHist;k--;} //No ring yet: walk from the head
+        while(t&&k--)t=t->nxt; //Remaining steps
+        return t;
+}
 
-        (usr->tranCnt)++; //Increments the user's transaction counter
+/**
+ * @brief Links the older part of a lazily loaded history behind the transactions added since startup.
+ * Records saveHist appended to the file since startup are already in front and are skipped.
+ * The caller holds the account lock (or every lock): nodes come from tranPool.
+ * @param usr Pointer to the user's account structure, tranLazy non-zero.
+ * @param h Records of the history file (freed here), NULL to link the snapshot slice.
+ */
+static void histJoin(Acc *usr,HistRd *h){
+        Tran *m=usr->tranHist,*t; //Transactions added since startup (newest first), iterator
+        u64 nm=usr->tranCnt-usr->tranLazy,up=0,j; //Number of them, how many of them the file holds, counter
+        if(!h){ //Snapshot slice: links it in place
+                for(j=0;j+1<usr->tranLazy;j++)usr->tranOld[j].nxt=&usr->tranOld[j+1];
+                usr->tranOld[usr->tranLazy-1].nxt=NULL;
+                usr->tranHist=usr->tranOld;
+        }else{ //History file; the rollups already hold its records (scanHist at import)
+                if(usr->tranSaved>=usr->tranLazy)up=usr->tranSaved-usr->tranLazy; //Appended since startup
+                else if(h->cnt>usr->tranLazy)up=h->cnt-usr->tranLazy; //Failed append: only the oldest tranLazy are from before
+                if(up>h->cnt)up=h->cnt;
+                usr->tranHist=histLink(h,up);
+                usr->tranCnt=nm+h->cnt-up; //File count replaces the one from Db.csv
+                usr->tranSaved=(h->whole&&usr->tranSaved)?h->cnt:0; //Anything else (a missing file too) is rewritten
+                if(!usr->tranSaved)usr->dirty|=DIRTY_HIST;
+                if(h->rec!=h->stk)free(h->rec);
+        }
+        usr->tranLazy=0;
+        usr->tranOld=NULL;
+        if(m){ //Newer transactions go in front
+                for(t=m,j=1;t->nxt&&(j<nm);t=t->nxt,j++);
+                t->nxt=usr->tranHist;
+                usr->tranHist=m;
+        }
+        recentBuild(usr); //Ring may now reach older transactions
+}
+
+/**
+ * @brief Reads the part of an account's history that lazy loading left on disk.
+ * Transactions added since startup stay in front; the older ones are linked behind them,
+ * from the snapshot slice in place or from the history file (which recounts them).
+ * @param usr Pointer to the user's account structure.
+ */
+void histFault(Acc *usr){
+        Csv c=CSV_INIT; //Reader for this one file
+        HistRd h; //Its records
+        if(!usr->tranLazy)return; //History is complete
+        if(usr->tranOld){histJoin(usr,NULL);return;}
+        histRead(usr->num,&c,&h); //A missing file reads as empty
+        csvFree(&c);
+        histJoin(usr,&h);
+}
+
+/**
+ * @brief histFault for threads that must not hold an account's stripe over a disk read.
+ * The history file is read with the stripe released; the stripe is taken again only to
+ * link the records in. If a save changed the file meanwhile, it is read again.
+ * @param usr Pointer to the user's account structure, not locked by the caller.
+ */
+void histFetch(Acc *usr){
+        Csv c=CSV_INIT; //Reader for this one file
+        HistRd h; //Its records
+        u64 s; //tranSaved when the read started
+        lockAcc(usr);
+        while(usr->tranLazy&&!usr->tranOld){ //History file: read without the stripe
+                s=usr->tranSaved;
+                unlockAcc(usr);
+                histRead(usr->num,&c,&h);
+                lockAcc(usr);
+                if(usr->tranLazy&&(usr->tranSaved==s)){histJoin(usr,&h);break;} //File is as read
+                if(h.rec!=h.stk)free(h.rec); //Appended or rewritten meanwhile
+        }
+        histFault(usr); //Snapshot slice: memory only, linked under the stripe
+        unlockAcc(usr);
+        csvFree(&c);
 }
 
 /**
  * @brief Generates a unique 17-digit transaction ID.
  * The ID is formed by concatenating a 14-digit timestamp (YYYYMMDDHHMMSS)
- * with a 3-digit random number. The random number generator is seeded with the user's account number.
- * @param usr Pointer to the user's account (used to seed srand for pseudo-randomness).
+ * with a 3-digit random number. The random number is drawn from a private seed (rand_r) set to the
+ * user's account number, so concurrent requests do not share the global rand state.
+ * @param usr Pointer to the user's account (used as the seed for pseudo-randomness).
  * @return u64 The generated unique transaction ID.
  */
 u64 getTranId(Acc *usr){
-        //17 digit unq TranID //Comment describing the transaction ID format
-        srand(usr->num); //Seeds the random number generator with the user's account number for varied results per user
-        return getTimeStamp()*1000 +(rand()%1000); //Combines timestamp (shifted left by 3 decimal places) and a 0-999 random number
+        //17 digit unq TranID //Comment describing the transaction ID format
+        unsigned int seed=(unsigned int)usr->num; //Seeded with the user's account number for varied results per user
+        return getTimeStamp()*1000 +(rand_r(&seed)%1000); //Combines timestamp (shifted left by 3 decimal places) and a 0-999 random number
 }
 /// End of getTranId function block marker
 
 /**
  * @brief Retrieves the current system time and formats it as a 14-digit timestamp.
  * The format is YYYYMMDDHHMMSS.
- * Uses localtime, so it reflects the system's configured timezone.
+ * Uses localtime_r, so it reflects the system's configured timezone and is thread-safe.
  * @param void No parameters.
  * @return u64 The current timestamp as an unsigned long long integer.
  */
 u64 getTimeStamp(void){
-        time_t rawtime; //Variable to store raw time value
-        struct tm *timeinfo; //Pointer to structure holding broken-down time components
+        time_t rawtime; //Variable to store raw time value
+        struct tm tmBuf,*timeinfo; //Broken-down time components, in a caller-owned buffer
 
-        // Get current UTC time //Comment states UTC, but localtime() is used below which is typically local time.
-        time(&rawtime); //Gets the current calendar time as a time_t object
+        // Get current UTC time //Comment states UTC, but localtime() is used below which is typically local time.
+        time(&rawtime); //Gets the current calendar time as a time_t object
 
-        // Convert to IST (UTC +5:30) //Comment indicating potential timezone adjustment (currently commented out)
-        timeinfo =localtime(&rawtime); //Converts time_t to struct tm in local time
+        // Convert to IST (UTC +5:30) //Comment indicating potential timezone adjustment (currently commented out)
+        timeinfo =localtime_r(&rawtime,&tmBuf); //Converts time_t to struct tm in local time
 
-        // Format as<x_bin_102>MMDDHHMMSS (14-digit ID) //Comment describing the output format
-        u64 timeStamp = //Calculates the timestamp value
-                (timeinfo->tm_year+1900)*10000000000ULL+ //Year (tm_year is years since 1900)
-                (timeinfo->tm_mon+1)*100000000ULL+ //Month (tm_mon is 0-11, so +1)
-                timeinfo->tm_mday*1000000ULL+ //Day of the month
-                timeinfo->tm_hour*10000ULL+ //Hours
-                timeinfo->tm_min *100ULL+ //Minutes
-                timeinfo->tm_sec; //Seconds
+        // Format as<x_bin_102>MMDDHHMMSS (14-digit ID) //Comment describing the output format
+        u64 timeStamp = //Calculates the timestamp value
+                (timeinfo->tm_year+1900)*10000000000ULL+ //Year (tm_year is years since 1900)
+                (timeinfo->tm_mon+1)*100000000ULL+ //Month (tm_mon is 0-11, so +1)
+                timeinfo->tm_mday*1000000ULL+ //Day of the month
+                timeinfo->tm_hour*10000ULL+ //Hours
+                timeinfo->tm_min *100ULL+ //Minutes
+                timeinfo->tm_sec; //Seconds
 
-        return timeStamp; //Returns the formatted timestamp
+        return timeStamp; //Returns the formatted timestamp
 }
 // End of getTimeStamp function block marker (custom comment style)
 /* //Start of a commented-out block
@@ -550,105 +841,390 @@ checkMC();
  * @param void No return value. Loop continues until handshake is successful.
  */
 void checkMC(const int fd){
-        char buf[20]; //Buffer to receive the response string
-        while(1){ //Loop until the correct response is received
-                tx_str(fd,"@Y:LINEOK$"); //Sends a line check message
-                rx_str(fd,buf,sizeof(buf)); //Receives the response
-                if(!strcmp(buf,"#Y:LINEOK$"))break; //If the response matches the expected handshake, exit loop
-        }
+        char buf[20]; //Buffer to receive the response string
+        while(1){ //Loop until the correct response is received
+                tx_str(fd,"@Y:LINEOK$"); //Sends a line check message
+                if(rx_str(fd,buf,sizeof(buf))<0)return; //Link lost, nothing to check
+                if(!strcmp(buf,"#Y:LINEOK$"))break; //If the response matches the expected handshake, exit loop
+        }
 }
 // End of checkMC function block marker
 
+/**
+ * @brief Loads the account database at startup.
+ * Uses the binary snapshot (Db.snap) when it is at least as new as Db.csv, so that a
+ * Db.csv exported later by the bank application is still picked up; otherwise, or if
+ * the snapshot cannot be used, imports the CSV files (with lazyHist the history files are
+ * only counted in the rollups, by a thread that goes on after this returns, see histScanning).
+ * Then builds the RFID index and replays the journal.
+ * @param head A pointer to the Acc* pointer that will store the head of the loaded account list.
+ * @param void No return value.
+ */
+void syncData(Acc **head){
+        struct stat sn,cs; //Modification times of the snapshot and the CSV database
+        int snap=!stat(SNAP_FILE,&sn); //A snapshot exists
+        if(snap&&!stat("../dataz/Db.csv",&cs)) //Both exist: the newer one wins
+                snap=(sn.st_mtim.tv_sec>cs.st_mtim.tv_sec)||
+                        ((sn.st_mtim.tv_sec==cs.st_mtim.tv_sec)&&(sn.st_mtim.tv_nsec>=cs.st_mtim.tv_nsec));
+        if(!snap||loadSnap(head)){ //CSV import when there is no usable snapshot
+                loadCsv(head);
+                rollBuild(*head); //Rollups come with a snapshot, here from the loaded histories
+                if(lazyHist){ //Lazy import: the history files stay on disk and are counted after startup
+                        scanBusy=1;
+                        if(pthread_create(&scanTh,NULL,scanWork,*head))scanWork(*head); //No thread: counted now
+                        else scanOn=1;
+                }
+        }
+        if(idxBuild(&rfIdx,*head))perror("syncData: rfid index"); //Indexes every card; getAcc falls back to the list on failure
+        jrnReplay(*head,JRN_OLD); //Changes of a snapshot that did not finish
+        jrnReplay(*head,JRN_FILE); //Changes since the last snapshot
+        for(Acc *a=*head;a;a=a->nxt){ //Recent rings over the final histories
+                recentBuild(a);
+                a->dirty|=DIRTY_RPT; //The first report after a start is whole
+        }
+#ifdef DBG //Conditional compilation block for debugging
+        poolStats(&accPool,stdout); //Slab use after the load
+        poolStats(&tranPool,stdout);
+#endif //End of DBG conditional block
+}
+
+/**
+ * @brief Reads an account's history file "../dataz/<account_number>.csv" into records, without linking them.
+ * Files starting with HIST_MARK hold records oldest first; older files are newest first.
+ * Takes no pool nodes, so it needs no lock. The caller frees `h->rec` when it is not `h->stk`.
+ * A missing file leaves `h` empty.
+ * @param num Account number.
+ * @param cv Reader to use (closed; its buffer is reused from file to file).
+ * @param h Filled with the records.
+ * @return int Number of records read, -1 if the file cannot be opened; exits when memory is exhausted.
+ */
+static int histRead(u64 num,Csv *cv,HistRd *h){
+        char spName[40]; //File name
+        Tran *g; //Grown buffer
+        u64 cap=LOAD_BUF; //Buffer size
+        int r; //csvTran result
+        h->rec=h->stk;
+        h->cnt=0;
+        h->whole=0;
+        sprintf(spName,"../dataz/%llu.csv",num); //Formats the transaction file name using account number
+        if(csvOpen(cv,spName))return -1; //No history yet
+        h->app=csvLine(cv,HIST_MARK); //Layout of the file; otherwise the first line is already a record
+        while((r=csvTran(cv,&h->rec[h->cnt]))==1){ //Reads 3 fields per transaction
+                if(++h->cnt<cap)continue;
+                if(!(g=malloc(2*cap*sizeof(Tran)))){perror("loadHist");exit(1);} //A partial history would be saved over the file
+                memcpy(g,h->rec,h->cnt*sizeof(Tran));
+                if(h->rec!=h->stk)free(h->rec);
+                h->rec=g;
+                cap*=2;
+        }
+        csvClose(cv); //Closes the account-specific transaction file
+        h->whole=h->app&&!r; //A cut last record (crash during an append) has the file rewritten
+        return h->cnt;
+}
+
+/**
+ * @brief Links records read by histRead into a history list, newest first.
+ * The nodes are taken from tranPool as one run, in list order, so the caller holds
+ * the account lock (or runs before the threads start).
+ * @param h Records read by histRead.
+ * @param skip Newest records to leave out.
+ * @return Tran* Head of the list, NULL if no record is left; exits when memory is exhausted.
+ */
+static Tran* histLink(HistRd *h,u64 skip){
+        u64 n=h->cnt-skip,i; //Records linked, counter
+        Tran *c; //List nodes
+        if(!n)return NULL;
+        if(!(c=poolGetN(&tranPool,n))){perror("loadHist");exit(1);} //One run of nodes for the whole history
+        for(i=0;i<n;i++){ //List is newest first
+                c[i]=h->rec[h->app?n-1-i:skip+i]; //Appendable files are oldest first
+                c[i].nxt=(i+1<n)?&c[i+1]:NULL;
+        }
+        return c;
+}
+
+/**
+ * @brief Reads an account's history file "../dataz/<account_number>.csv" into memory, newest first.
+ * Older layouts and cut files have the file rewritten by the next save (see histRead).
+ * @param usr Pointer to the `Acc` structure, its history must be empty.
+ * @param cv Reader to use (closed; its buffer is reused from file to file).
+ * @return int Number of transactions read, -1 if the file cannot be opened; exits when memory is exhausted.
+ */
+static int loadHist(Acc *usr,Csv *cv){
+        HistRd h; //Records of the file
+        if(histRead(usr->num,cv,&h)<0)return -1; //No history yet
+        usr->tranHist=histLink(&h,0);
+        if(h.rec!=h.stk)free(h.rec);
+        usr->tranCnt=h.cnt;
+        usr->tranSaved=h.whole?h.cnt:0; //Anything else is rewritten in the appendable layout
+        if(!usr->tranSaved)usr->dirty|=DIRTY_HIST;
+        return h.cnt;
+}
+
+/**
+ * @brief Counts an account's history file in the rollups without keeping its records.
+ * Used by a lazy import, so #R covers the histories that are still on disk.
+ * @param usr Pointer to the `Acc` structure.
+ * @param cv Reader to use (closed; its buffer is reused from file to file).
+ * @return int Number of records counted, -1 if the file cannot be opened.
+ */
+static int scanHist(const Acc *usr,Csv *cv){
+        char spName[40]; //File name
+        Tran t; //Record being counted
+        int n=0; //Records counted
+        sprintf(spName,"../dataz/%llu.csv",usr->num);
+        if(csvOpen(cv,spName))return -1; //No history yet
+        csvLine(cv,HIST_MARK); //Either layout, order does not matter here
+        for(;csvTran(cv,&t)==1;n++)rollAdd(t.id,t.amt,t.type);
+        csvClose(cv);
+        return n;
+}
+
+/**
+ * @brief Rollup scan thread of a lazy import: counts every history file, then clears scanBusy.
+ * The account list does not change after syncData, so it is walked without locks.
+ * @param arg Head of the account list.
+ * @return void* NULL.
+ */
+static void* scanWork(void *arg){
+        Acc *head=arg,*a; //Accounts, iterator
+        u64 n=0; //Accounts imported
+        for(a=head;a;a=a->nxt)n++;
+        loadHists(head,n,1);
+        __atomic_store_n(&scanBusy,0,__ATOMIC_RELEASE);
+        return NULL;
+}
+
+/**
+ * @brief Tells whether the rollups are still incomplete (lazy import still being counted).
+ * @return int Non-zero while the scan runs.
+ */
+int histScanning(void){
+        return __atomic_load_n(&scanBusy,__ATOMIC_ACQUIRE);
+}
+
+/**
+ * @brief Waits for the rollup scan of a lazy import, if one was started. Main thread only.
+ */
+void histScanWait(void){
+        if(!scanOn)return;
+        pthread_join(scanTh,NULL);
+        scanOn=0;
+}
+
+/**
+ * @brief Checks, without reading the records, that new records can be appended to a history
+ * file: it starts with HIST_MARK and its last record is complete.
+ * @param usr Pointer to the `Acc` structure.
+ * @return int 1 if the file can be appended to, 0 otherwise (missing, older layout or cut).
+ */
+static int histTail(const Acc *usr){
+        char spName[40],mark[sizeof(HIST_MARK)+1]; //File name, first line
+        int ok=0; //Result
+        sprintf(spName,"../dataz/%llu.csv",usr->num);
+        FILE *sp=fopen(spName,"r");
+        if(!sp)return 0;
+        if(fgets(mark,sizeof(mark),sp)&&!strcmp(mark,HIST_MARK "\n")&&!fseek(sp,-1,SEEK_END))ok=(fgetc(sp)=='\n'); //Last byte ends a record
+        fclose(sp);
+        return ok;
+}
+
+/**
+ * @brief Brings an account's history file up to date.
+ * When the file already holds the oldest `tranSaved` transactions, only the newer ones are
+ * appended, so the cost follows the new data, not the length of the history; otherwise the
+ * whole file is written to a temporary name and renamed over the old one.
+ * @param usr Pointer to the `Acc` structure.
+ * @param w Writer to use (closed; its buffer is reused from file to file).
+ * @param bytes Incremented by the bytes written.
+ * @return int 0 on success, -1 on a write error (the old file is kept).
+ */
+static int saveHist(Acc *usr,Wr *w,u64 *bytes){
+        char spName[40],tmpName[44]; //File name and its temporary name
+        Tran *t,**v=NULL; //History iterator, records to write, newest first
+        u64 k=0,i; //Records to write, counter
+        int app=usr->tranSaved&&(usr->tranSaved<=usr->tranCnt),err=0; //Appends, write error
+        if(usr->tranLazy&&(!app||(usr->tranSaved<usr->tranLazy)||!histTail(usr))){ //Rewrite, or a file that cannot be appended to
+                histFault(usr);
+                app=usr->tranSaved&&(usr->tranSaved<=usr->tranCnt);
+        }
+        sprintf(spName,"../dataz/%llu.csv",usr->num); //Formats the transaction file name
+        sprintf(tmpName,"%s.tmp",spName); //Temporary name in the same directory (rename stays atomic)
+        i=app?usr->tranCnt-usr->tranSaved:usr->tranCnt; //Newest records that are not in the file
+        if(app&&!i)return 0; //Nothing new
+        if(i&&!(v=malloc(i*sizeof(Tran*)))){perror("saveData: transaction file");return -1;}
+        for(t=usr->tranHist;t&&(k<i);t=t->nxt)v[k++]=t; //List is newest first, the file oldest first
+        if(wrOpen(w,app?spName:tmpName,app)){perror("saveData: transaction file");free(v);return -1;}
+        if(!app)wrStr(w,HIST_MARK "\n");
+        while(k--){ //Writes transaction details to the file: "%llu,<amt>,%c\n"
+                wrU64(w,v[k]->id,0);
+                wrChr(w,',');
+                wrMon(w,v[k]->amt);
+                wrChr(w,',');
+                wrChr(w,v[k]->type);
+                wrChr(w,'\n');
+        }
+        free(v);
+        if(wrClose(w)||(!app&&rename(tmpName,spName))){perror("saveData: transaction file");err=-1;}
+        *bytes+=w->bytes;
+        if(app&&err){usr->tranSaved=0;return -1;} //Tail of the file is unknown, the next save rewrites it
+        if(!err)usr->tranSaved=usr->tranCnt;
+        return err;
+}
+
+/**
+ * @brief Loader thread: takes LOAD_CHUNK accounts at a time and reads (or scans) their history files.
+ * Each account is filled by exactly one thread, so no account is shared.
+ * @param arg Pointer to the `HistJob`.
+ * @return void* NULL.
+ */
+static void* histWork(void *arg){
+        HistJob *j=arg; //Shared job
+        Csv c=CSV_INIT; //This thread's reader
+        u64 i,end; //Chunk taken
+        for(;;){
+                pthread_mutex_lock(&j->mx);
+                i=j->next;
+                end=j->next=(i+LOAD_CHUNK<j->cnt)?i+LOAD_CHUNK:j->cnt;
+                pthread_mutex_unlock(&j->mx);
+                if(i>=end)break; //Every account is taken
+                for(;i<end;i++){
+                        if(j->scan)scanHist(j->acc[i],&c);
+                        else loadHist(j->acc[i],&c);
+                }
+        }
+        csvFree(&c);
+        return NULL;
+}
+
+/**
+ * @brief Reads the history files of an account list on up to `loadThreads` threads.
+ * Falls back to the calling thread alone when threads or memory are short.
+ * @param head Pointer to the first account.
+ * @param cnt Number of accounts in the list.
+ * @param scan Non-zero to only count the records in the rollups (scanHist); rollAdd is atomic.
+ */
+static void loadHists(Acc *head,u64 cnt,int scan){
+        pthread_t th[LOAD_THREADS_MAX]; //Loader threads
+        HistJob j={NULL,cnt,0,scan,PTHREAD_MUTEX_INITIALIZER}; //Accounts to fill
+        long nt=loadThreads?loadThreads:sysconf(_SC_NPROCESSORS_ONLN); //Threads asked for
+        long i,run=0; //Counter, threads started
+        if(nt>LOAD_THREADS_MAX)nt=LOAD_THREADS_MAX;
+        if((nt>(long)((cnt+LOAD_CHUNK-1)/LOAD_CHUNK)))nt=(cnt+LOAD_CHUNK-1)/LOAD_CHUNK; //No idle threads
+        if((nt<=1)||!(j.acc=malloc(cnt*sizeof(Acc*)))){ //One thread: no table needed
+                Csv c=CSV_INIT; //Reader for every file
+                for(;head;head=head->nxt){
+                        if(scan)scanHist(head,&c);
+                        else loadHist(head,&c);
+                }
+                csvFree(&c);
+                return;
+        }
+        for(i=0;head;head=head->nxt)j.acc[i++]=head;
+        for(i=1;i<nt;i++)if(!pthread_create(&th[run],NULL,histWork,&j))run++; //Calling thread is the last worker
+        histWork(&j);
+        for(i=0;i<run;i++)pthread_join(th[i],NULL);
+        free(j.acc);
+}
+
 /**
  * @brief Loads account data and transaction histories from CSV files into memory.
  * Reads main account data from "../dataz/Db.csv".
- * For each account, reads its transaction history from "../dataz/<account_number>.csv".
+ * Then reads every account's transaction history from "../dataz/<account_number>.csv",
+ * on `loadThreads` threads (see loadHists).
  * Builds a linked list of accounts, each with its linked list of transactions.
+ * Both file kinds are parsed by csvLib; reading stops at the first malformed Db.csv row.
  * @param head A pointer to the Acc* pointer that will store the head of the loaded account list.
- * @param void No return value.
+ * @return int 0 on success, -1 if Db.csv cannot be opened.
  */
-void syncData(Acc **head){
-        FILE *fp=fopen("../dataz/Db.csv","r"); //Opens the main database file for reading
-        int d; //Unused variable
-        if(!fp)return; //If the file cannot be opened, return (database remains empty or as is)
-        puts("syncing"); //Prints "syncing" to console to indicate data loading process
-        Acc temp,*tail=NULL; //temp: temporary Acc structure to read data into, tail: pointer to the last node in the list
-
-        temp.nxt=NULL; //Initializes next pointer of temp (important for memmove)
-        temp.tranHist=NULL; //Initializes transaction history of temp
-        temp.tranCnt=0; //Initializes transaction count of temp
-        //Reads account data line by line from Db.csv
-        while(fscanf(fp,"%llu,%[^,],%llu,%[^,],%[^,],%[^,],%[^,],%d,%lf,%llu",
-                &(temp.num),temp.name,&(temp.phno),temp.usrName,temp.pass,
-                temp.rfid,temp.pin,&(temp.cardStat),&(temp.bal),&(temp.tranCnt))==10){ //Reads 10 fields per account
-
-
-                Acc *new =calloc(1,sizeof(Acc)); //Allocates memory for a new account node
-                memmove(new,&temp,sizeof(Acc)); //Copies the data from 'temp' to the new 'new' node
-                new->tranHist = NULL; //Explicitly set tranHist to NULL for the new node before loading its transactions
-                new->tranCnt = 0; //Explicitly set tranCnt to 0 for the new node
-                if(!(*head))*head=new; //If the list is empty, the new node becomes the head
-                if(tail)tail->nxt=new; //If the list is not empty, append the new node to the end
-                tail=new; //Update the tail pointer to the new node
-
-                //save bank statement //Comment indicating loading of transaction history (statement)
-                char spName[30]; //Buffer for the transaction file name
-                sprintf(spName,"../dataz/%llu.csv",new->num); //Formats the transaction file name using account number
-                FILE *sp=fopen(spName,"r"); //Opens the account-specific transaction file for reading
-                if(!sp)continue; //If transaction file doesn't exist or can't be opened, skip to next account
-                Tran *th=NULL,*tt=NULL,tm; //th: head of transaction list for current account, tt: tail, tm: temporary Tran
-                int cnt=0; //Counter for transactions loaded for the current account
-                tm.nxt=NULL; //Initialize next pointer for tm (important for memmove)
-                //Reads transaction data line by line from the account's .csv file
-                while(fscanf(sp,"%llu,%lf,%c",&(tm.id),&(tm.amt),&(tm.type))==3){ //Reads 3 fields per transaction
-                        Tran *c=malloc(sizeof(Tran)); //Allocates memory for a new transaction node
-                        cnt++; //Increments transaction counter for this account
-                        memmove(c,&tm,sizeof(Tran)); //Copies data from 'tm' to new transaction node 'c'
-                        c->nxt = NULL; // Ensure the new transaction node's next pointer is NULL before linking
-                        if(!th)th=c; //If this is the first transaction, it becomes the head (th)
-                        if(tt)tt->nxt=c; //Append to the end of the transaction list
-                        tt=c; //Update tail (tt) of the transaction list
-                }
-                new->tranHist=th; //Assigns the loaded transaction history to the current account
-                new->tranCnt=cnt; //Assigns the loaded transaction count to the current account
-                fclose(sp); //Closes the account-specific transaction file
-        }
-
-        fclose(fp); //Closes the main database file (Db.csv)
-}
-
-// End of syncData function block marker
+int loadCsv(Acc **head){
+        Csv fp=CSV_INIT; //Reader for the main database file
+        u64 cnt=0; //Accounts read
+        int r; //csvAcc result
+        if(csvOpen(&fp,"../dataz/Db.csv")){csvFree(&fp);return -1;} //If the file cannot be opened, return (database remains empty or as is)
+        puts("syncing"); //Prints "syncing" to console to indicate data loading process
+        Acc temp,*tail=NULL; //temp: temporary Acc structure to read data into, tail: pointer to the last node in the list
+
+        memset(&temp,0,sizeof(temp)); //No stack garbage in fields the file does not set (recent ring)
+        temp.nxt=NULL; //Initializes next pointer of temp (important for memmove)
+        temp.tranHist=NULL; //Initializes transaction history of temp
+        temp.tranCnt=0; //Initializes transaction count of temp
+        //Reads account data line by line from Db.csv
+        while((r=csvAcc(&fp,&temp))==1){ //Reads 10 fields per account
+
+
+                Acc *new =poolGet(&accPool); //Zeroed account node from the slab
+                memmove(new,&temp,sizeof(Acc)); //Copies the data from 'temp' to the new 'new' node
+                new->tranHist = NULL; //Explicitly set tranHist to NULL for the new node before loading its transactions
+                new->tranCnt = 0; //Explicitly set tranCnt to 0 for the new node
+                if(lazyHist)new->tranCnt=new->tranLazy=new->tranSaved=temp.tranCnt; //Db.csv count stands in for the file until histFault
+                if(!(*head))*head=new; //If the list is empty, the new node becomes the head
+                if(tail)tail->nxt=new; //If the list is not empty, append the new node to the end
+                tail=new; //Update the tail pointer to the new node
+
+                cnt++;
+        }
+
+        if(r)fprintf(stderr,"loadCsv: Db.csv row %llu is malformed, later rows are not loaded\n",cnt+1);
+        csvClose(&fp); //Closes the main database file (Db.csv)
+        csvFree(&fp);
+        if(!lazyHist)loadHists(*head,cnt,0); //Transaction histories (statements), in parallel
+        return 0; //Success
+}
+
+// End of loadCsv function block marker
 
 /**
  * @brief Saves the current state of all accounts and their transaction histories to CSV files.
  * Writes main account data to "../dataz/Db.csv".
  * For each account, writes its transaction history to "../dataz/<account_number>.csv".
+ * Every file is written to a ".tmp" name first and renamed over the old one, so a crash
+ * (or a killed snapshot child) never leaves a half written file behind.
+ * Only changed data is written: nothing at all when no account is dirty, otherwise Db.csv
+ * (one file for every row) and the history files of accounts marked DIRTY_HIST.
+ * Prints how many files and bytes the save wrote.
+ * Waits for the rollup scan of a lazy import first: a file appended to during it would be counted twice.
  * This function is for creating machine-readable data backups.
  * @param head Pointer to the head of the linked list of accounts.
- * @param void No return value.
+ * @return int 0 on success, -1 if any file could not be written.
  */
-void saveData(Acc *head){
-
-        FILE *fp=fopen("../dataz/Db.csv","w"); //Opens/creates the main database file for writing (overwrites existing)
-
-        while(head){ //Iterates through each account in the linked list
-                //Writes account details to Db.csv
-                fprintf(fp,"%llu,%s,%llu,%s,%s,%s,%s,%d,%lf,%llu\n",head->num,head->name,head->phno,
-                                head->usrName,head->pass,head->rfid,head->pin,head->cardStat,head->bal,head->tranCnt);
-
-                //save bank statement //Comment indicating saving of transaction history
-                char spName[30]; //Buffer for transaction file name
-                sprintf(spName,"../dataz/%llu.csv",head->num); //Formats the transaction file name
-                FILE *sp=fopen(spName,"w"); //Opens/creates the account-specific transaction file for writing
-                Tran *t=head->tranHist; //Points to the head of the current account's transaction history
-                while(t){ //Iterates through each transaction for the current account
-                        fprintf(sp,"%llu,%lf,%c\n",t->id,t->amt,t->type); //Writes transaction details to the file
-                        t=t->nxt; //Moves to the next transaction
-                }
-                fclose(sp); //Closes the account-specific transaction file
-                head=head->nxt; //Moves to the next account in the main list
-        }
-        fclose(fp); //Closes the main database file (Db.csv)
+int saveData(Acc *head){
+        int err=0,files=1; //Set when any file fails, files written (Db.csv included)
+        u64 bytes=0; //Bytes written
+        Wr fp=WR_INIT,sp=WR_INIT; //Db.csv, then every history file in turn
+        Acc *db=head; //First account, head is advanced by the loop below
+
+        histScanWait(); //History files must not change under the rollup scan
+        while(db&&!(db->dirty&(DIRTY_ROW|DIRTY_HIST)))db=db->nxt; //Looks for any change since the last save
+        if(!db){printf("saveData: 0 files, 0 bytes\n");return 0;} //Files already hold this state
+        db=head;
+
+        if(wrOpen(&fp,"../dataz/Db.csv.tmp",0)){perror("saveData: Db.csv");wrFree(&fp);return -1;} //Nothing written, old files stay intact
+
+        while(head){ //Iterates through each account in the linked list
+                //Writes account details to Db.csv: "%llu,%s,%llu,%s,%s,%s,%s,%d,<bal>,%llu\n"
+                wrU64(&fp,head->num,0); wrChr(&fp,',');
+                wrStr(&fp,head->name); wrChr(&fp,',');
+                wrU64(&fp,head->phno,0); wrChr(&fp,',');
+                wrStr(&fp,head->usrName); wrChr(&fp,',');
+                wrStr(&fp,head->pass); wrChr(&fp,',');
+                wrStr(&fp,head->rfid); wrChr(&fp,',');
+                wrStr(&fp,head->pin); wrChr(&fp,',');
+                wrI64(&fp,head->cardStat); wrChr(&fp,',');
+                wrMon(&fp,head->bal); wrChr(&fp,',');
+                wrU64(&fp,head->tranCnt,0); wrChr(&fp,'\n');
+                if(!(head->dirty&DIRTY_HIST)){head=head->nxt;continue;} //History file is up to date
+
+                if(saveHist(head,&sp,&bytes))err=-1; //Keeps DIRTY_HIST, the next save tries again
+                else{head->dirty&=~DIRTY_HIST;files++;} //History file is current
+                head=head->nxt; //Moves to the next account in the main list
+        }
+        wrFree(&sp);
+        if(wrClose(&fp)||rename("../dataz/Db.csv.tmp","../dataz/Db.csv")){perror("saveData: Db.csv");err=-1;} //Main file last, after every history
+        else for(;db;db=db->nxt)db->dirty&=~DIRTY_ROW; //Every row is current
+        bytes+=fp.bytes;
+        wrFree(&fp);
+        printf("saveData: %d files, %llu bytes\n",files,bytes); //What this save touched
+        return err; //0 if everything was written
 }
 // End of saveData function block marker
 
@@ -658,51 +1234,11 @@ void saveData(Acc *head){
  * to human-readable CSV files in the "../filez/" directory.
  * Writes main account overview to "../filez/DataBase.csv" with headers.
  * For each account, writes its formatted transaction history to "../filez/<account_number>.csv" with headers.
+ * The files are written by the report threads of rptLib.h; this waits for them.
  * @param head Pointer to the head of the linked list of accounts.
  * @param void No return value.
  */
 void saveFile(Acc *head){
-        unsigned int dd,mon,yy,hh,mm; //Variables for date and time components from transaction ID
-        u64 dum; //Temporary variable for timestamp decomposition
-        FILE *fp=fopen("../filez/DataBase.csv","w"); //Opens/creates the human-readable main database file
-
-        //Writes headers to the main human-readable database file
-        fprintf(fp,"Account ID,Holder's name,Mobile no.,Username,Password,ATM card no.,ATM pin,Card Satus,Balance,Transactions count\n");
-        Acc *currentAcc = head; //Use a temporary pointer to iterate, to keep original head if needed later
-        while(currentAcc){ //Iterates through each account
-                //Writes account details to DataBase.csv, converting card status to "ACTIVE" or "BLOCKED"
-                fprintf(fp,"%llu,%s,%llu,%s,%s,%s,%s,%s,%lf,%llu\n",currentAcc->num,currentAcc->name,currentAcc->phno,
-                                currentAcc->usrName,currentAcc->pass,currentAcc->rfid,currentAcc->pin,(currentAcc->cardStat)?"ACTIVE":"BLOCKED"
-                                ,currentAcc->bal,currentAcc->tranCnt);
-
-                //save bank statement //Comment indicating saving of human-readable transaction history
-                char spName[40]; //Buffer for the transaction statement file name
-                sprintf(spName,"../filez/%llu.csv",currentAcc->num); //Formats the statement file name
-                FILE *sp=fopen(spName,"w"); //Opens/creates the account-specific statement file
-                Tran *t=currentAcc->tranHist; //Points to the head of the current account's transaction history
-                fprintf(sp,"Date,Time,Transaction ID,Amount,Type\n"); //Writes headers to the statement file
-                while(t){ //Iterates through each transaction
-                        //Decomposes transaction ID to get date and time
-                        dum=(t->id)/100000; //Extracts YYYYMMDDHHMM part
-                        mm=dum%100; //Extracts minutes
-                        dum/=100;
-                        hh=dum%100; //Extracts hours
-                        dum/=100;
-                        dd=dum%100; //Extracts day
-                        dum/=100;
-                        mon=dum%100; //Extracts month
-                        dum/=100;
-                        yy=dum; //Extracts year
-                        //Writes formatted transaction details: Date, Time, ID, Amount, Type
-                        fprintf(sp,"%u/%u/%u,%u:%u,%llu,%lf,",dd,mon,yy,hh,mm,t->id,t->amt);
-                        if(t->type==DEPOSIT)            fprintf(sp,"%s\n","Deposit"); //Prints "Deposit" if type is DEPOSIT
-                        else if(t->type==WITHDRAW)      fprintf(sp,"%s\n","Withdraw"); //Prints "Withdraw" if type is WITHDRAW
-                        else if(t->type==TRANSFER_IN)   fprintf(sp,"%s\n","Tranfer IN"); //Prints "Transfer IN" (Note: "Tranfer" typo)
-                        else if(t->type==TRANSFER_OUT)  fprintf(sp,"%s\n","Tranfer OUT"); //Prints "Transfer OUT" (Note: "Tranfer" typo)
-                        t=t->nxt; //Moves to the next transaction
-                }
-                fclose(sp); //Closes the account-specific statement file
-                currentAcc=currentAcc->nxt; //Moves to the next account in the main list
-        }
-        fclose(fp); //Closes the main human-readable database file
+        while(rptStart(head,RPT_ALL)==1)rptWait(NULL); //A report already running may have skipped some statements
+        rptWait(NULL); //Until every file is written
 }
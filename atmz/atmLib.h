@@ -8,7 +8,7 @@
  * This file contains:
  * - Macro definitions for constants and debugging.
  * - Standard library includes.
- * - Type definitions for custom data structures (u64, f64, Tran, Acc).
+ * - Type definitions for custom data structures (u64, Tran, Acc; money is i64 paise, see monLib.h).
  * - Function prototypes for ATM operations, serial communication,
  * data handling, and utility functions.
  */
@@ -25,75 +25,110 @@
 #include<errno.h> //Error number definitions
 #include<time.h> //Time and date functions
 #include<termios.h> //POSIX terminal control definitions (for serial communication)
+#include<stdarg.h> //Variable arguments (for tx_fmt)
+#include "msgLib.h" //Frame tokenizer (Msg, Fld) used by the request handlers
+#include "monLib.h" //Money in paise (i64) and its parse/format routines
 
-#define MAX_DEPOSIT     30000 //Defines the maximum deposit amount allowed in a single transaction (30K)
-#define MAX_WITHDRAW    30000 //Defines the maximum withdrawal amount allowed in a single transaction (30k)
-#define MAX_TRANSFER    100000//Defines the maximum transfer amount allowed in a single transaction (1lk)
+#define SERIAL_DEV "/dev/ttyUSB0" //Serial port of the single ATM handled by atm_main
+
+#define MAX_DEPOSIT     RUPEES(30000) //Defines the maximum deposit amount allowed in a single transaction (30K, in paise)
+#define MAX_WITHDRAW    RUPEES(30000) //Defines the maximum withdrawal amount allowed in a single transaction (30k, in paise)
+#define MAX_TRANSFER    RUPEES(100000)//Defines the maximum transfer amount allowed in a single transaction (1lk, in paise)
 
 #define NAME_LEN 30 //Defines the maximum length for account holder names
 #define MAX_PASS_LEN 20 //Defines the maximum length for passwords
 #define MAX_USRN_LEN 20 //Defines the maximum length for usernames
 
 #define BLOCKED 0 //Defines the status code for a blocked card
-#define ACTIVE  1 //Defines the status code for an active card
+#define ACTIVE  1 //Defines the status code for an active card
+#define CLOSED  3 //Account closed at the bank (tombstone kept until the bank compacts it)
+
+#define DIRTY_ROW  1 //Account fields differ from its Db.csv row
+#define DIRTY_HIST 2 //History differs from its <num>.csv file
+#define DIRTY_RPT  4 //Changed since its ../filez statement was written (see rptLib.h)
+#define HIST_MARK "#APPEND" //First line of a history file kept oldest first (new records are appended); older files are newest first
+
+#define LOAD_THREADS_MAX 64 //Most threads loadCsv reads history files with
+#define LOAD_CHUNK 32 //Accounts a loader thread takes at a time
+#define LOAD_BUF 64 //History records histRead reads on the stack before it needs the heap
 
 #define WITHDRAW 1 //Defines the transaction type code for withdrawal
-#define DEPOSIT  2 //Defines the transaction type code for deposit
+#define DEPOSIT  2 //Defines the transaction type code for deposit
 #define TRANSFER_IN 3 //Defines the transaction type code for transfer in
 #define TRANSFER_OUT 4 //Defines the transaction type code for transfer out
 
+#define ACC_RECENT 8 //Newest transactions of an account reachable by index (power of two)
+
 #define CAPS(ch) (ch &=~(32)) //Macro to convert a character to uppercase (by clearing the 6th bit)
 
 //decorations //ANSI escape codes for text color formatting in the console
-#define RESET   "\033[0m" //Resets text formatting to default
-#define BBLACK  "\033[1;30m" //Bold Black text
-#define BRED    "\033[1;31m" //Bold Red text
-#define BGREEN  "\033[1;32m" //Bold Green text
+#define RESET   "\033[0m" //Resets text formatting to default
+#define BBLACK  "\033[1;30m" //Bold Black text
+#define BRED    "\033[1;31m" //Bold Red text
+#define BGREEN  "\033[1;32m" //Bold Green text
 #define BYELLOW "\033[1;33m" //Bold Yellow text
-#define BBLUE   "\033[1;34m" //Bold Blue text
-#define BPINK   "\033[1;35m" //Bold Pink text
-#define BCYAN   "\033[1;36m" //Bold Cyan text
-#define BWHITE  "\033[1;37m" //Bold White text
+#define BBLUE   "\033[1;34m" //Bold Blue text
+#define BPINK   "\033[1;35m" //Bold Pink text
+#define BCYAN   "\033[1;36m" //Bold Cyan text
+#define BWHITE  "\033[1;37m" //Bold White text
 
 
 typedef unsigned long long int u64; //Typedef for unsigned 64-bit integer
-typedef double f64; //Typedef for double-precision floating-point number (64-bit)
 
-// "%lu,%lf,%c",id,amt,type //Format string comment for transaction data in files
-// "%lu,%s,%lu,%s,%s,%s,%s,%d,%lf,%lu",num,name,phno,usrName,pass,rfid,pin,cardStat,bal,tranCnt //Format string comment for account data in files
+// "%lu,<amt>,%c",id,amt,type //Format string comment for transaction data in files (after a HIST_MARK line, oldest first); <amt> is monFmt rupees
+// "%lu,%s,%lu,%s,%s,%s,%s,%d,<bal>,%lu",num,name,phno,usrName,pass,rfid,pin,cardStat,bal,tranCnt //Format string comment for account data in files
 typedef struct A{ //Structure to represent a single transaction
-        f64 amt; //Amount of the transaction
-        u64 id; //Unique ID for the transaction
-        char type; //Type of transaction (e.g., WITHDRAW, DEPOSIT)
+        i64 amt; //Amount of the transaction in paise
+        u64 id; //Unique ID for the transaction
+        char type; //Type of transaction (e.g., WITHDRAW, DEPOSIT)
 
-        struct A *nxt; //Pointer to the next transaction in a linked list (for transaction history)
+        struct A *nxt; //Pointer to the next transaction in a linked list (for transaction history)
 }Tran; //Typedef name for struct A
 
-// "%lu,%s,%lu,%s,%s,%s,%s,%d,%lf,%lu",num,name,phno,usrName,pass,rfid,pin,cardStat,bal,tranCnt //Format string comment for account data
+// "%lu,%s,%lu,%s,%s,%s,%s,%d,<bal>,%lu",num,name,phno,usrName,pass,rfid,pin,cardStat,bal,tranCnt //Format string comment for account data
 typedef struct B{ //Structure to represent a bank account
-        u64 num;//Unique account number/ID
-        f64 bal;//Current bank balance of the account
-        u64 phno;//Phone number of the account holder
-        char usrName[MAX_USRN_LEN]; //Username associated with the account
-        char pass[MAX_PASS_LEN]; //Password for the account
-        char rfid[9]; //RFID card number (8 chars + null terminator)
-        char pin[5]; //ATM PIN (4 digits + null terminator)
-        int cardStat;//Card status: 1 for active, 0 for blocked
-        char name[NAME_LEN];//Name of the account holder
-
-        Tran *tranHist; //Pointer to the head of the linked list of transactions for this account
-        u64 tranCnt; //Total count of transactions for this account
-        struct B *nxt; //Pointer to the next account in a linked list (for the database)
+        u64 num;//Unique account number/ID
+        i64 bal;//Current bank balance of the account in paise
+        u64 phno;//Phone number of the account holder
+        char usrName[MAX_USRN_LEN]; //Username associated with the account
+        char pass[MAX_PASS_LEN]; //Password for the account
+        char rfid[9]; //RFID card number (8 chars + null terminator)
+        char pin[5]; //ATM PIN (4 digits + null terminator)
+        int cardStat;//Card status: 1 for active, 0 for blocked
+        char name[NAME_LEN];//Name of the account holder
+
+        Tran *tranHist; //Pointer to the head of the linked list of transactions for this account
+        u64 tranCnt; //Total count of transactions for this account
+        Tran *recent[ACC_RECENT]; //Ring of the newest history nodes, recent[rTop] is the newest
+        unsigned int rTop; //Slot of the newest entry in recent
+        unsigned int rCnt; //Valid entries in recent (at most ACC_RECENT)
+        u64 tranSaved; //Oldest transactions already in the history file, 0 if saveData must rewrite it
+        u64 tranLazy; //Oldest transactions not read into memory yet (lazyHist), 0 once histFault has run
+        Tran *tranOld; //Unlinked snapshot slice holding those transactions, NULL to read them from the history file
+        unsigned char dirty; //DIRTY_ROW|DIRTY_HIST: what saveData still has to write for this account; DIRTY_RPT: the same for the report
+        struct B *nxt; //Pointer to the next account in a linked list (for the database)
 }Acc; //Typedef name for struct B
 
+extern int loadThreads; //Threads loadCsv reads history files with, 0 for one per online CPU
+extern int lazyHist; //Non-zero: syncData loads account records only, histories are read by histFault on first use
+extern int bgSave; //Non-zero: #Q starts a background snapshot (jrnCheckpoint) instead of saving in place (jrnFlush)
+
 
 //Function Prototypes
 
 /**
  * @brief Initializes the serial port for communication.
- * @return int File descriptor for the opened serial port, or -1 on error.
+ * @param dev Path of the serial device (SERIAL_DEV for the real ATM).
+ * @return int File descriptor for the opened serial port; exits on error.
+ */
+int initSerial(const char *dev);
+
+/**
+ * @brief Opens a serial device (or pty) in raw 8N1 mode at BAUD.
+ * @param dev Path of the device.
+ * @return int File descriptor, or -1 on error (errno set).
  */
-int initSerial();
+int openSerial(const char *dev);
 
 /**
  * @brief Closes the serial port.
@@ -110,13 +145,22 @@ void endSerial(const int fd);
 int tx_char(const int fd,const char ch);
 
 /**
- * @brief Transmits a null-terminated string over the serial port, followed by CR LF.
+ * @brief Queues a null-terminated string, followed by CR LF, for the serial port.
+ * Queued responses are written with one system call by the next rx_str (see lnkLib.h).
  * @param fd File descriptor of the serial port.
  * @param str The string to transmit.
- * @return int Total number of bytes written (including CR LF), or error status from write.
+ * @return int Total number of bytes queued (including CR LF), or -1 on error.
  */
 int tx_str(const int fd,const char *str);
 
+/**
+ * @brief Formats a response directly into the serial port's output buffer, followed by CR LF.
+ * @param fd File descriptor of the serial port.
+ * @param fmt printf style format of the response.
+ * @return int Length of the response (without CR LF), or -1 on error.
+ */
+int tx_fmt(const int fd,const char *fmt,...);
+
 /**
  * @brief Receives a single character from the serial port.
  * @param fd File descriptor of the serial port.
@@ -125,12 +169,13 @@ int tx_str(const int fd,const char *str);
 char rx_char(const int fd);
 
 /**
- * @brief Receives a string from the serial port until a newline or max length is reached.
+ * @brief Receives the next "#...$" frame from the serial port (buffered, see lnkLib.h).
  * @param fd File descriptor of the serial port.
- * @param str Buffer to store the received string.
+ * @param str Buffer to store the received frame (without "\r\n").
  * @param len Maximum length of the buffer.
+ * @return int Length of the frame, or -1 if the link failed or was closed.
  */
-void rx_str(const int fd,char *str,size_t len);
+int rx_str(const int fd,char *str,size_t len);
 
 /**
  * @brief Checks if a received message string is in the expected format (#<data>$).
@@ -139,58 +184,73 @@ void rx_str(const int fd,char *str,size_t len);
  */
 int isMsgOk(const char *buf);
 
+/**
+ * @brief Handles one received frame (#C, #V, #A, #X, #Q) and queues the reply on fd.
+ * @param db Pointer to the head of the account database.
+ * @param fd File descriptor the frame came from.
+ * @param buf The received frame (need not be null-terminated).
+ * @param len Length of the frame.
+ * @return int 1 if handled, 0 if malformed or unknown.
+ */
+int procMsg(Acc *db,const int fd,const char *buf,size_t len);
+
 /**
  * @brief Checks the provided RFID against the database.
  * Sends response back via serial: "@OK:ACTIVE:<username>$" or "@ERR:BLOCK$" or "@ERR:INVALID$".
  * @param head Pointer to the head of the account database (linked list).
  * @param fd File descriptor for serial communication.
- * @param buf The received message buffer containing the RFID (e.g., "#C:<rfid>$").
+ * @param m The tokenized frame "#C:<rfid>$".
+ * @return int 1 if the frame was well formed, 0 otherwise.
  */
-void checkRFID(Acc *head,const int fd,const char *buf);
+int checkRFID(Acc *head,const int fd,const Msg *m);
 
 /**
- * @brief Verifies the provided PIN for a given RFID.
- * Sends response back via serial: "@OK:MATCHED$" or "@ERR:WRONG$".
- * @param head Pointer to the head of the account database.
+ * @brief Sends the bank-wide totals of a day or an hour from the rollups (see rollLib.h).
+ * Sends response back via serial: "@OK:ROLL:<day>[:<hour>]:<count>,<amount>:...$" (withdrawals, deposits,
+ * transfers in, transfers out) or "@ERR:NODATA$", "@ERR:PARTIAL$" (lazy import still being counted) or "@ERR:INVALID$".
  * @param fd File descriptor for serial communication.
- * @param buf The received message buffer containing RFID and PIN (e.g., "#V:<rfid>:<pin>$").
+ * @param m The tokenized frame "#R$", "#R:<YYYYMMDD>$" or "#R:<YYYYMMDD>:<HH>$".
+ * @return int 1 if the frame was well formed, 0 otherwise.
  */
-void verifyPin(Acc *head,const int fd,const char *buf);
+int rollQuery(const int fd,const Msg *m);
 
 /**
- * @brief Performs an ATM action based on the request in the buffer.
- * Actions include withdraw, deposit, balance inquiry, PIN change, mini statement, block card.
+ * @brief Verifies the provided PIN for a given RFID.
+ * Sends response back via serial: "@OK:MATCHED$" or "@ERR:WRONG$" or "@ERR:INVALID$".
  * @param head Pointer to the head of the account database.
  * @param fd File descriptor for serial communication.
- * @param buf The received message buffer containing the action request.
+ * @param m The tokenized frame "#V:<rfid>:<pin>$".
+ * @return int 1 if the frame was well formed, 0 otherwise.
  */
-void act(Acc *head,const int fd,const char *buf);
+int verifyPin(Acc *head,const int fd,const Msg *m);
 
 /**
- * @brief Extracts the amount from a message buffer.
- * Assumes amount starts at a specific offset (index 16) in the buffer.
- * @param buf The message buffer (e.g., "#A:WTD:<rfid>:<amt>$" or "#A:DEP:<rfid>:<amt>$").
- * @return double The extracted amount.
+ * @brief Performs an ATM action based on the tokenized request.
+ * Actions include withdraw, deposit, balance inquiry, PIN change, mini statement, block card.
+ * @param head Pointer to the head of the account database.
+ * @param fd File descriptor for serial communication.
+ * @param m The tokenized frame "#A:<req>:<rfid>[:<arg>]$".
+ * @return int 1 if the frame was well formed, 0 otherwise.
  */
-double extAmt(const char *buf);
+int act(Acc *head,const int fd,const Msg *m);
 
 /**
  * @brief Handles a deposit transaction for a user.
  * Sends response back via serial: "@OK:DONE$", "@ERR:NEGAMT$", or "@ERR:MAXAMT$".
  * @param fd File descriptor for serial communication.
  * @param usr Pointer to the user's account structure.
- * @param amt The amount to deposit.
+ * @param amt The amount to deposit, in paise.
  */
-void deposit(const int fd,Acc *usr,const f64 amt);
+void deposit(const int fd,Acc *usr,const i64 amt);
 
 /**
  * @brief Handles a withdrawal transaction for a user.
  * Sends response back via serial: "@OK:DONE$", "@ERR:LOWBAL$", "@ERR:NEGAMT$", or "@ERR:MAXAMT$".
  * @param fd File descriptor for serial communication.
  * @param usr Pointer to the user's account structure.
- * @param amt The amount to withdraw.
+ * @param amt The amount to withdraw, in paise.
  */
-void withdraw(const int fd,Acc *usr,const f64 amt);
+void withdraw(const int fd,Acc *usr,const i64 amt);
 
 /**
  * @brief Handles a balance inquiry for a user.
@@ -221,10 +281,43 @@ void miniStatement(const int fd,Acc *usr,char txn);
 /**
  * @brief Adds a new transaction to the user's transaction history.
  * @param usr Pointer to the user's account structure.
- * @param amt The amount of the transaction (positive for deposit/credit, negative for withdrawal/debit).
+ * @param amt The amount of the transaction in paise (positive for deposit/credit, negative for withdrawal/debit).
  * @param type The type of the transaction (e.g., DEPOSIT, WITHDRAW).
  */
-void addTran(Acc *usr,f64 amt,char type);
+void addTran(Acc *usr,i64 amt,char type);
+
+/**
+ * @brief Refills an account's recent ring from the head of its history list.
+ * Called once per account after loading; addTran keeps the ring current afterwards.
+ * @param usr Pointer to the user's account structure.
+ */
+void recentBuild(Acc *usr);
+
+/**
+ * @brief Reads the part of an account's history that lazy loading left on disk.
+ * The transactions added since startup stay in front of the list; the older ones, from the
+ * snapshot slice or the history file, are linked behind them. Does nothing if the history
+ * is already complete. Callers hold the account lock (or every lock).
+ * @param usr Pointer to the user's account structure.
+ */
+void histFault(Acc *usr);
+
+/**
+ * @brief histFault for background threads (reports, exports), called without the account lock.
+ * The history file is read with the lock released and the lock is taken only to link the
+ * records in, so requests for accounts of the same stripe never wait for the disk.
+ * @param usr Pointer to the user's account structure.
+ */
+void histFetch(Acc *usr);
+
+/**
+ * @brief Returns the k-th newest transaction of an account (1 = newest).
+ * The newest ACC_RECENT are read from the ring in O(1); older ones walk the history list.
+ * @param usr Pointer to the user's account structure.
+ * @param k 1-based position from the newest transaction.
+ * @return Tran* The transaction, or NULL if the history is shorter.
+ */
+Tran* recentGet(const Acc *usr,u64 k);
 
 /**
  * @brief Generates a unique transaction ID.
@@ -249,22 +342,46 @@ u64 getTimeStamp(void);
 void checkMC(const int fd);
 
 /**
- * @brief Synchronizes (loads) account data from "Db.csv" and individual transaction files.
- * Populates the linked list of accounts pointed to by head.
+ * @brief Synchronizes (loads) account data from the binary snapshot "Db.snap", or from "Db.csv"
+ * and individual transaction files when the CSV is newer.
+ * Populates the linked list of accounts pointed to by head and replays the journal on top.
  * @param head Pointer to the pointer of the head of the account database.
  */
 void syncData(Acc **head);
 
+/**
+ * @brief Tells whether the rollups are still incomplete: after a lazy CSV import a thread
+ * counts the history files in them while requests are already served.
+ * @return int Non-zero while that scan runs.
+ */
+int histScanning(void);
+
+/**
+ * @brief Waits until the rollup scan of a lazy import (if any) has finished. Main thread only.
+ */
+void histScanWait(void);
+
+/**
+ * @brief Imports account data from "Db.csv" and individual <acc_num>.csv transaction files.
+ * Every account row is read first; the history files are then read by `loadThreads` threads,
+ * each filling whole accounts, so the result does not depend on the thread count.
+ * @param head Pointer to the pointer of the head of the account database.
+ * @return int 0 on success, -1 if Db.csv cannot be opened.
+ */
+int loadCsv(Acc **head);
+
 /**
  * @brief Saves all account data and their transaction histories to "Db.csv" and individual <acc_num>.csv files.
- * This is the primary data saving function for machine readability.
+ * This is the primary data saving function for machine readability. Files are replaced atomically.
  * @param head Pointer to the head of the account database.
+ * @return int 0 on success, -1 if any file could not be written.
  */
-void saveData(Acc *head);
+int saveData(Acc *head);
 
 /**
  * @brief Saves all account data and their transaction histories to human-readable CSV files.
  * Main database to "DataBase.csv" and individual statements to "<acc_num>.csv" in "filez" directory.
+ * Runs the report of rptLib.h for every account and waits for it (after any report already running).
  * @param head Pointer to the head of the account database.
  */
 void saveFile(Acc *head);
@@ -272,7 +389,7 @@ void saveFile(Acc *head);
 /**
  * @brief Retrieves an account from the database using the RFID.
  * @param head Pointer to the head of the account database.
- * @param rfid The RFID string to search for.
+ * @param rfid The RFID string to search for (the first 8 characters are compared).
  * @return Acc* Pointer to the found account structure, or NULL if not found.
  */
 Acc* getAcc(Acc *head,const char *rfid);
@@ -0,0 +1,1403 @@
+#include "atmLib.h" //Includes the atmLib.h header file which contains declarations for ATM functions and structures
+#include "idxLib.h" //RFID index under test
+#include "snapLib.h" //Binary snapshot under test
+#include "lnkLib.h" //Buffered frame reader under test
+#include "lockLib.h" //Striped account locks under test
+#include "msgLib.h" //Frame tokenizer under test
+#include "poolLib.h" //Node slabs under test
+#include "monLib.h" //Money parse/format routines under test
+#include "wrLib.h" //Buffered CSV and report writer under test
+#include "csvLib.h" //Vectorized CSV reader under test
+#include "rptLib.h" //Background report writer under test
+#include "colLib.h" //Columnar ledger export under test
+#include "rollLib.h" //Per-day and per-hour rollups under test
+#include <sys/wait.h> //waitpid for the writer process
+#include <sys/stat.h> //mkdir
+#include <malloc.h> //mallinfo2, heap used by a load
+
+//Benchmarks for the ATM backend.
+//Usage: ./atm_bench <test> [args]
+//  idx [n ...]   RFID lookup, list walk vs hash index (default n = 10000 100000 1000000)
+//  snap [n] [k]  Startup, CSV import vs binary snapshot, n accounts with k transactions each (default 100000 20)
+//  load [n] [k] [t] CSV import with 1, 2, 4 ... t history loader threads, cold and warm page cache,
+//                then the whole startup (syncData), eager and with lazy history loading (lazyHist),
+//                n accounts with k transactions each (default 100000 20, t = online CPUs, at least 8)
+//  save [n] [k]  Save after one new transaction per account, append to the history files vs rewrite them,
+//                n accounts with k saved transactions each (default 20000 200)
+//  write [n] [k] Writing Db.csv + history files and the ../filez reports, fprintf vs wrLib, in MB/s,
+//                n accounts with k transactions each (default 100000 100, 10M transactions)
+//  pool [n]      n transaction nodes from calloc one by one, from a pool one by one and as one poolGetN run:
+//                time per node, heap per node, pool bytes used vs wasted (default n = 4000000)
+//  rx [n]        Frame reception over a pipe, byte-at-a-time read vs lnkLib ring (default n = 200000 frames)
+//  tx [n]        Response transmission over a pipe, two writes vs one vs coalesced (default n = 200000 responses)
+//  lock [n]      Account updates from 1..8 threads, one global mutex vs striped locks,
+//                uniform and skewed (hot set) accounts (default n = 4000000 operations)
+//  parse [n]     Request parsing, fixed offsets with strncpy/atof vs msgLib field views (default n = 5000000 frames)
+//  mst [n] [k]   Mini statement lookups, list walk vs recent ring, n accounts with k transactions each
+//                built by addTran in arrival order (default 50000 32)
+//  money [n]     Amount parsing and formatting, atof/sprintf("%.2lf") vs monParse/monFmt (default n = 10000000 amounts)
+//  csv [mb]      Parsing a synthetic history file of mb MB and a Db.csv of mb/8 MB, fscanf vs csvLib with
+//                the scalar, SSE2 and AVX2 delimiter scans, in GB/s (default mb = 2048)
+//  report [n] [k] ../filez report in the caller vs on rptLib's threads (1..8 statement threads), in accounts/s,
+//                changed accounts only, and request latency while a report runs (default 100000 100)
+//  col [n] [k]   Columnar ledger export, then totals by type for three queries, history list walk vs colScan
+//                with the plain C and AVX2 block scans (default 100000 100)
+//  roll [n] [k]  Day totals by type, walk over every history vs the rollups, the rollBuild after a CSV import
+//                and the cost of rollAdd in addTran, n accounts with k transactions each (default 100000 100)
+
+/**
+ * @brief Returns a monotonic time stamp in nanoseconds.
+ * @return u64 Nanoseconds since an arbitrary point.
+ */
+static u64 nowNs(void){
+        struct timespec ts; //Monotonic clock reading
+        clock_gettime(CLOCK_MONOTONIC,&ts); //Not affected by wall clock changes
+        return ts.tv_sec*1000000000ULL+ts.tv_nsec; //Converts to nanoseconds
+}
+
+/**
+ * @brief Builds a list of n synthetic accounts with unique 8 digit RFIDs.
+ * @param n Number of accounts.
+ * @return Acc* Head of the list (allocated in one block, free() the head to release).
+ */
+static Acc* fakeDb(u64 n){
+        Acc *db=calloc(n,sizeof(Acc)); //One block keeps setup fast, the list links it node by node
+        u64 i; //Account counter
+        if(!db){perror("fakeDb");exit(1);} //Benchmark cannot run without memory
+        for(i=0;i<n;i++){ //Fills every account
+                db[i].num=20250101000000000ULL+i; //Unique account number
+                sprintf(db[i].rfid,"%08llu",10000000ULL+i*7%90000000ULL); //Unique card number (7 is coprime to 9e7)
+                strcpy(db[i].pin,"1234"); //Fixed PIN
+                db[i].cardStat=ACTIVE; //All cards active
+                db[i].dirty=DIRTY_ROW|DIRTY_HIST|DIRTY_RPT; //Never saved or reported
+                db[i].nxt=(i+1<n)?&db[i+1]:NULL; //Links to the next account
+        }
+        return db; //Returns the head of the list
+}
+
+/**
+ * @brief Times getAcc() over random cards, with and without the RFID index.
+ * @param n Number of accounts in the synthetic database.
+ */
+static void benchIdx(u64 n){
+        Acc *db=fakeDb(n); //Synthetic database
+        u64 lkList=20000000ULL/n+16; //List walks are O(n), so fewer lookups keep the run short
+        u64 lkIdx=2000000; //Index lookups
+        u64 i,t,hit=0; //Counter, start time, found counter (keeps lookups from being optimized away)
+        double nsList,nsIdx; //Average nanoseconds per lookup
+
+        srand(42); //Same card sequence on every run
+        idxFree(&rfIdx); //No index: getAcc walks the list
+        t=nowNs();
+        for(i=0;i<lkList;i++)hit+=getAcc(db,db[rand()%n].rfid)!=NULL; //Random existing cards
+        nsList=(double)(nowNs()-t)/lkList;
+
+        t=nowNs();
+        if(idxBuild(&rfIdx,db)){perror("idxBuild");exit(1);} //Same call syncData makes
+        double msBuild=(nowNs()-t)/1e6; //Index build time
+        t=nowNs();
+        for(i=0;i<lkIdx;i++)hit+=getAcc(db,db[rand()%n].rfid)!=NULL;
+        nsIdx=(double)(nowNs()-t)/lkIdx;
+
+        printf("%-9llu list:%12.1f ns/lookup  index:%8.1f ns/lookup  speedup:%9.1fx  build:%7.1f ms  (%llu hits)\n",
+                        n,nsList,nsIdx,nsList/nsIdx,msBuild,hit);
+        idxFree(&rfIdx); //Releases the index
+        free(db); //Releases the accounts
+}
+
+/**
+ * @brief Gives every account k synthetic transactions (newest first).
+ * @param db Accounts from fakeDb.
+ * @param n Number of accounts.
+ * @param k Transactions per account.
+ */
+static void fakeHist(Acc *db,u64 n,u64 k){
+        Tran *t=calloc(n*k+1,sizeof(Tran)); //One block for every transaction
+        u64 i,j; //Account and transaction counters
+        if(!t){perror("fakeHist");exit(1);}
+        for(i=0;i<n;i++){
+                for(j=0;j<k;j++,t++){
+                        t->id=20250101000000000ULL+(k-j)*1000+i%1000; //Newest first
+                        t->amt=(j&1)?-RUPEES(j*10+i%500):RUPEES(j*25+i%700); //Alternating withdrawals and deposits
+                        t->type=(j&1)?WITHDRAW:DEPOSIT;
+                        t->nxt=(j+1<k)?t+1:NULL;
+                }
+                db[i].tranHist=k?t-k:NULL;
+                db[i].tranCnt=k;
+                db[i].bal=1000+i%9000;
+                snprintf(db[i].name,sizeof(db[i].name),"Holder %llu",i); //CSV fields must not be empty
+                snprintf(db[i].usrName,sizeof(db[i].usrName),"user%u",(unsigned)i); //At most 14 characters
+                strcpy(db[i].pass,"pass");
+                db[i].phno=9000000000ULL+i;
+        }
+}
+
+/**
+ * @brief Evicts a file from the page cache so the next read comes from disk.
+ * @param path File to evict.
+ */
+static void dropCache(const char *path){
+        int fd=open(path,O_RDONLY); //File to evict
+        if(fd<0)return;
+        posix_fadvise(fd,0,0,POSIX_FADV_DONTNEED); //Drops clean cached pages
+        close(fd);
+}
+
+/**
+ * @brief Evicts Db.csv, every history file and Db.snap from the page cache.
+ * @param db Accounts whose history files are evicted.
+ */
+static void dropAll(Acc *db){
+        char name[40]; //History file name
+        sync(); //Written pages must be clean before they can be dropped
+        dropCache("../dataz/Db.csv");
+        dropCache(SNAP_FILE);
+        for(;db;db=db->nxt){
+                sprintf(name,"../dataz/%llu.csv",db->num);
+                dropCache(name);
+        }
+}
+
+/**
+ * @brief Counts accounts and transactions of a loaded database.
+ * @param db Head of the account list.
+ * @return u64 Accounts + transactions, compared between loaders.
+ */
+static u64 census(Acc *db){
+        u64 n=0; //Records seen
+        Tran *t; //Transaction iterator
+        for(;db;db=db->nxt,n++)
+                for(t=db->tranHist;t;t=t->nxt)n++;
+        return n;
+}
+
+/**
+ * @brief Times loading the same database from CSV and from the binary snapshot,
+ * with a cold page cache (files evicted first) and a warm one.
+ * Runs in a scratch directory under /tmp, which is removed afterwards.
+ * @param n Number of accounts.
+ * @param k Transactions per account.
+ */
+static void benchSnap(u64 n,u64 k){
+        char dir[]="/tmp/atm_benchXXXXXX",name[40]; //Scratch directory and history file name
+        Acc *db,*a; //Generated and loaded databases
+        u64 t,i; //Start time, counter
+        double csvCold,csvWarm,snapCold,snapWarm; //Load times in ms
+        struct stat st; //File sizes
+
+        if(!mkdtemp(dir)||chdir(dir)||mkdir("dataz",0777)||mkdir("work",0777)||chdir("work")){perror("benchSnap");exit(1);} //Same ../dataz layout as atmz
+        db=fakeDb(n);
+        fakeHist(db,n,k);
+        if(saveData(db)||saveSnap(db)){fputs("benchSnap: save failed\n",stderr);exit(1);}
+
+        dropAll(db); a=NULL; t=nowNs(); loadCsv(&a); csvCold=(nowNs()-t)/1e6;
+        if(census(a)!=n*(k+1))fputs("benchSnap: CSV load incomplete\n",stderr);
+        a=NULL; t=nowNs(); loadCsv(&a); csvWarm=(nowNs()-t)/1e6; //Nodes of the first load are leaked, the process exits soon
+        dropAll(db); a=NULL; t=nowNs(); loadSnap(&a); snapCold=(nowNs()-t)/1e6;
+        if(census(a)!=n*(k+1))fputs("benchSnap: snapshot load incomplete\n",stderr);
+        a=NULL; t=nowNs(); loadSnap(&a); snapWarm=(nowNs()-t)/1e6;
+
+        stat(SNAP_FILE,&st);
+        printf("%llu accounts x %llu transactions, snapshot %.1f MB\n",n,k,st.st_size/1048576.0);
+        printf("  CSV import   cold:%9.1f ms  warm:%9.1f ms\n",csvCold,csvWarm);
+        printf("  snapshot     cold:%9.1f ms  warm:%9.1f ms  speedup cold:%.1fx warm:%.1fx\n",
+                        snapCold,snapWarm,csvCold/snapCold,csvWarm/snapWarm);
+
+        for(i=0;i<n;i++){sprintf(name,"../dataz/%llu.csv",db[i].num);unlink(name);} //Removes the scratch files
+        unlink("../dataz/Db.csv"); unlink(SNAP_FILE);
+        chdir("/tmp"); //Leaves the scratch directory before removing it
+        sprintf(name,"%s/work",dir); rmdir(name);
+        sprintf(name,"%s/dataz",dir); rmdir(name);
+        rmdir(dir);
+}
+
+/**
+ * @brief Bytes the process has taken from malloc, mmapped blocks (large slabs) included.
+ * @return size_t Heap in use.
+ */
+static size_t heapUse(void){
+        struct mallinfo2 mi=mallinfo2(); //glibc heap counters
+        return mi.uordblks+mi.hblkhd;
+}
+
+/**
+ * @brief Folds a loaded database into one value: account order, every field of every
+ * transaction and the history order, so two loads can be compared for identical results.
+ * @param db Head of the account list.
+ * @return u64 Digest of the database.
+ */
+static u64 digest(Acc *db){
+        u64 h=1469598103934665603ULL,a; //FNV-1a state, amount bits
+        Tran *t; //Transaction iterator
+        for(;db;db=db->nxt){
+                h=(h^db->num)*1099511628211ULL;
+                h=(h^db->tranCnt)*1099511628211ULL;
+                for(t=db->tranHist;t;t=t->nxt){
+                        memcpy(&a,&t->amt,sizeof(a));
+                        h=(h^t->id)*1099511628211ULL;
+                        h=(h^a^((u64)(unsigned char)t->type<<56))*1099511628211ULL;
+                }
+        }
+        return h;
+}
+
+/**
+ * @brief Times the CSV import with 1, 2, 4 ... history loader threads, with a cold page cache
+ * (files evicted first) and a warm one, and checks every load against the single thread one.
+ * Then times the whole startup (syncData) eager and lazy (lazyHist), with the heap each keeps;
+ * a lazy start also reports when its background rollup scan has finished.
+ * Runs in a scratch directory under /tmp, which is removed afterwards.
+ * @param n Number of accounts.
+ * @param k Transactions per account.
+ * @param maxT Most loader threads.
+ */
+static void benchLoad(u64 n,u64 k,int maxT){
+        char dir[]="/tmp/atm_benchXXXXXX",name[40]; //Scratch directory and history file name
+        Acc *db,*a; //Generated and loaded databases
+        u64 t,i,ref=0,d; //Start time, counter, single thread digest, digest of a load
+        double cold,warm,roll,base=0; //Load times in ms, rollups complete (ms), cold single thread time
+        int nt; //Threads of this run
+
+        if(!mkdtemp(dir)||chdir(dir)||mkdir("dataz",0777)||mkdir("work",0777)||chdir("work")){perror("benchLoad");exit(1);} //Same ../dataz layout as atmz
+        db=fakeDb(n);
+        fakeHist(db,n,k);
+        if(saveData(db)){fputs("benchLoad: save failed\n",stderr);exit(1);}
+        printf("%llu accounts x %llu transactions, %ld online CPUs\n",n,k,sysconf(_SC_NPROCESSORS_ONLN));
+        for(nt=1;nt<=maxT;nt*=2){
+                loadThreads=nt;
+                dropAll(db); a=NULL; t=nowNs(); loadCsv(&a); cold=(nowNs()-t)/1e6;
+                d=digest(a);
+                a=NULL; t=nowNs(); loadCsv(&a); warm=(nowNs()-t)/1e6; //Nodes of each load are leaked, the process exits soon
+                if(nt==1){ref=d;base=cold;}
+                printf("  %2d threads  cold:%9.1f ms  warm:%9.1f ms  cold speedup %.2fx  %s\n",
+                                nt,cold,warm,base/cold,(d==ref)?"same result":"RESULT DIFFERS");
+        }
+        for(lazyHist=0;lazyHist<2;lazyHist++){ //Whole startup, eager then lazy, and the heap it keeps
+                size_t m=heapUse(); //Heap in use before the load
+                dropAll(db); a=NULL; t=nowNs(); syncData(&a); cold=(nowNs()-t)/1e6; //Requests could be served from here
+                histScanWait(); roll=(nowNs()-t)/1e6; //Lazy: rollups complete
+                m=heapUse()-m;
+                a=NULL; t=nowNs(); syncData(&a); warm=(nowNs()-t)/1e6;
+                histScanWait();
+                printf("  %s  cold:%9.1f ms  warm:%9.1f ms  rollups complete after %9.1f ms  heap %.1f MB\n",
+                                lazyHist?"lazy syncData ":"eager syncData",cold,warm,roll,m/1048576.0);
+        }
+        lazyHist=0;
+
+        for(i=0;i<n;i++){sprintf(name,"../dataz/%llu.csv",db[i].num);unlink(name);} //Removes the scratch files
+        unlink("../dataz/Db.csv");
+        chdir("/tmp"); //Leaves the scratch directory before removing it
+        sprintf(name,"%s/work",dir); rmdir(name);
+        sprintf(name,"%s/dataz",dir); rmdir(name);
+        rmdir(dir);
+}
+
+/**
+ * @brief Times taking n transaction nodes from calloc, from a pool one at a time (addTran)
+ * and as one run (loadHist), with the heap each needs; then walks a history list built
+ * from the calloc nodes against one built from the run (denser: no malloc headers).
+ * @param n Number of nodes.
+ */
+static void benchPool(u64 n){
+        Pool p=POOL_INIT(sizeof(Tran),128<<10,"bench"); //Pool for the one-by-one variant
+        Pool q=POOL_INIT(sizeof(Tran),128<<10,"bench run"); //Pool for the run variant
+        Tran **v=malloc(n*sizeof(Tran*)),*run,*t; //calloc nodes, run of nodes, iterator
+        u64 t0,i; //Start time, counter
+        size_t m; //Heap before a variant
+        double ms[3],mb[3],walk[2],sum=0; //Times, heap, walk times, checksum
+        if(!v){perror("benchPool");exit(1);}
+
+        m=heapUse(); t0=nowNs();
+        for(i=0;i<n;i++)v[i]=calloc(1,sizeof(Tran));
+        ms[0]=(nowNs()-t0)/1e6; mb[0]=(heapUse()-m)/1048576.0;
+        m=heapUse(); t0=nowNs();
+        for(i=0;i<n;i++)poolGet(&p);
+        ms[1]=(nowNs()-t0)/1e6; mb[1]=(heapUse()-m)/1048576.0;
+        m=heapUse(); t0=nowNs();
+        run=poolGetN(&q,n);
+        ms[2]=(nowNs()-t0)/1e6; mb[2]=(heapUse()-m)/1048576.0;
+        if(!run){perror("benchPool");exit(1);}
+
+        for(i=0;i<n;i++){ //Same history twice, in the calloc nodes and in the run
+                v[i]->amt=run[i].amt=(i64)(i%1000);
+                v[i]->nxt=(i+1<n)?v[i+1]:NULL;
+                run[i].nxt=(i+1<n)?&run[i+1]:NULL;
+        }
+        t0=nowNs(); for(t=v[0];t;t=t->nxt)sum+=t->amt; walk[0]=(nowNs()-t0)/1e6;
+        t0=nowNs(); for(t=run;t;t=t->nxt)sum-=t->amt; walk[1]=(nowNs()-t0)/1e6;
+
+        printf("%llu transaction nodes of %zu bytes\n",n,sizeof(Tran));
+        printf("  calloc       %7.1f ms %5.1f ns/node  heap %7.1f MB %5.1f B/node\n",ms[0],ms[0]*1e6/n,mb[0],mb[0]*1048576/n);
+        printf("  poolGet      %7.1f ms %5.1f ns/node  heap %7.1f MB %5.1f B/node\n",ms[1],ms[1]*1e6/n,mb[1],mb[1]*1048576/n);
+        printf("  poolGetN     %7.1f ms %5.1f ns/node  heap %7.1f MB %5.1f B/node\n",ms[2],ms[2]*1e6/n,mb[2],mb[2]*1048576/n);
+        printf("  list walk    calloc nodes %.1f ms, run %.1f ms%s\n",walk[0],walk[1],sum?"  CHECKSUM MISMATCH":"");
+        poolStats(&p,stdout);
+        poolStats(&q,stdout);
+}
+
+/**
+ * @brief Times saveData after one new transaction per account, once appending the new
+ * records to the history files and once rewriting every file, as before HIST_MARK.
+ * Runs in a scratch directory under /tmp, which is removed afterwards.
+ * @param n Number of accounts.
+ * @param k Transactions already saved per account.
+ */
+static void benchSave(u64 n,u64 k){
+        char dir[]="/tmp/atm_benchXXXXXX",name[40]; //Scratch directory and history file name
+        Acc *db; //Generated database
+        u64 t,i; //Start time, counter
+        double ms[2]; //Append and rewrite save times
+        int v; //Variant: 0 appends, 1 rewrites
+
+        if(!mkdtemp(dir)||chdir(dir)||mkdir("dataz",0777)||mkdir("work",0777)||chdir("work")){perror("benchSave");exit(1);} //Same ../dataz layout as atmz
+        db=fakeDb(n);
+        fakeHist(db,n,k);
+        for(i=0;i<n;i++)recentBuild(&db[i]);
+        if(saveData(db)){fputs("benchSave: save failed\n",stderr);exit(1);}
+        for(v=0;v<2;v++){
+                for(i=0;i<n;i++){
+                        addTran(&db[i],RUPEES(25),DEPOSIT);
+                        if(v)db[i].tranSaved=0; //Forces the whole file to be written
+                }
+                sync(); //Earlier writes do not count against this save
+                t=nowNs();
+                if(saveData(db))fputs("benchSave: save failed\n",stderr);
+                ms[v]=(nowNs()-t)/1e6;
+        }
+        printf("%llu accounts x %llu transactions, one new transaction each\n",n,k);
+        printf("  append  %9.1f ms\n  rewrite %9.1f ms  append speedup %.1fx\n",ms[0],ms[1],ms[1]/ms[0]);
+
+        for(i=0;i<n;i++){sprintf(name,"../dataz/%llu.csv",db[i].num);unlink(name);} //Removes the scratch files
+        unlink("../dataz/Db.csv");
+        chdir("/tmp"); //Leaves the scratch directory before removing it
+        sprintf(name,"%s/work",dir); rmdir(name);
+        sprintf(name,"%s/dataz",dir); rmdir(name);
+        rmdir(dir);
+}
+
+/**
+ * @brief Writes Db.csv and every history file with stdio, as saveData did before wrLib.
+ * @param db Head of the account list.
+ * @param dir Directory to write to.
+ * @return u64 Bytes written.
+ */
+static u64 oldData(Acc *db,const char *dir){
+        char name[64],tmp[68],amt[MON_LEN]; //File names, amount text
+        FILE *fp,*sp; //Db.csv, history file
+        u64 bytes=0; //Bytes written
+        Tran *t,**v; //History walk, records oldest first
+        u64 k; //Records of one account
+        sprintf(name,"%s/Db.csv",dir); sprintf(tmp,"%s.tmp",name);
+        if(!(fp=fopen(tmp,"w"))){perror("oldData");exit(1);}
+        for(;db;db=db->nxt){
+                monFmt(amt,db->bal);
+                bytes+=fprintf(fp,"%llu,%s,%llu,%s,%s,%s,%s,%d,%s,%llu\n",db->num,db->name,db->phno,
+                                db->usrName,db->pass,db->rfid,db->pin,db->cardStat,amt,db->tranCnt);
+                sprintf(name,"%s/%llu.csv",dir,db->num); sprintf(tmp,"%s.tmp",name);
+                if(!(sp=fopen(tmp,"w"))||!(v=malloc((db->tranCnt+1)*sizeof(Tran*)))){perror("oldData");exit(1);}
+                for(k=0,t=db->tranHist;t;t=t->nxt)v[k++]=t;
+                bytes+=fprintf(sp,HIST_MARK "\n");
+                while(k--){
+                        monFmt(amt,v[k]->amt);
+                        bytes+=fprintf(sp,"%llu,%s,%c\n",v[k]->id,amt,v[k]->type);
+                }
+                free(v);
+                if(fclose(sp)||rename(tmp,name)){perror("oldData");exit(1);}
+        }
+        sprintf(name,"%s/Db.csv",dir); sprintf(tmp,"%s.tmp",name);
+        if(fclose(fp)||rename(tmp,name)){perror("oldData");exit(1);}
+        return bytes;
+}
+
+/**
+ * @brief Writes DataBase.csv and every statement with stdio, as saveFile did before wrLib.
+ * @param db Head of the account list.
+ * @param dir Directory to write to.
+ * @return u64 Bytes written.
+ */
+static u64 oldReport(Acc *db,const char *dir){
+        static const char *type[5]={"","Withdraw\n","Deposit\n","Tranfer IN\n","Tranfer OUT\n"}; //Type names
+        char name[64],amt[MON_LEN]; //File name, amount text
+        FILE *fp,*sp; //DataBase.csv, statement
+        u64 bytes=0,dum; //Bytes written, time stamp being split
+        Tran *t; //History walk
+        sprintf(name,"%s/DataBase.csv",dir);
+        if(!(fp=fopen(name,"w"))){perror("oldReport");exit(1);}
+        bytes+=fprintf(fp,"Account ID,Holder's name,Mobile no.,Username,Password,ATM card no.,ATM pin,Card Satus,Balance,Transactions count\n");
+        for(;db;db=db->nxt){
+                monFmt(amt,db->bal);
+                bytes+=fprintf(fp,"%llu,%s,%llu,%s,%s,%s,%s,%s,%s,%llu\n",db->num,db->name,db->phno,db->usrName,db->pass,
+                                db->rfid,db->pin,(db->cardStat)?"ACTIVE":"BLOCKED",amt,db->tranCnt);
+                sprintf(name,"%s/%llu.csv",dir,db->num);
+                if(!(sp=fopen(name,"w"))){perror("oldReport");exit(1);}
+                bytes+=fprintf(sp,"Date,Time,Transaction ID,Amount,Type\n");
+                for(t=db->tranHist;t;t=t->nxt){
+                        unsigned int mm,hh,dd,mon; //Date and time fields
+                        dum=t->id/100000;
+                        mm=dum%100; dum/=100; hh=dum%100; dum/=100; dd=dum%100; dum/=100; mon=dum%100; dum/=100;
+                        monFmt(amt,t->amt);
+                        bytes+=fprintf(sp,"%u/%u/%u,%u:%u,%llu,%s,",dd,mon,(unsigned int)dum,hh,mm,t->id,amt);
+                        if((t->type>=WITHDRAW)&&(t->type<=TRANSFER_OUT))bytes+=fprintf(sp,"%s",type[(int)t->type]);
+                }
+                fclose(sp);
+        }
+        fclose(fp);
+        return bytes;
+}
+
+/**
+ * @brief Compares two files byte for byte.
+ * @param a First file.
+ * @param b Second file.
+ * @return int 1 if both exist and are equal.
+ */
+static int sameFile(const char *a,const char *b){
+        FILE *x=fopen(a,"r"),*y=fopen(b,"r"); //Both files
+        char p[65536],q[65536]; //Chunks
+        size_t m,n; //Chunk lengths
+        int eq=x&&y; //Result
+        while(eq){
+                m=fread(p,1,sizeof(p),x); n=fread(q,1,sizeof(q),y);
+                eq=(m==n)&&!memcmp(p,q,m);
+                if(!m)break;
+        }
+        if(x)fclose(x);
+        if(y)fclose(y);
+        return eq;
+}
+
+/**
+ * @brief Times writing the data files (Db.csv and the history files, rewritten) and the
+ * reports (../filez) for n accounts with k transactions each, stdio fprintf vs wrLib
+ * (saveData and saveFile), in MB/s, and checks that both produce the same bytes.
+ * Runs in a scratch directory under /tmp, which is removed afterwards.
+ * @param n Number of accounts.
+ * @param k Transactions per account.
+ */
+static void benchWrite(u64 n,u64 k){
+        static const char *sub[5]={"dataz","filez","odata","ofilez","work"}; //Scratch subdirectories
+        char dir[]="/tmp/atm_benchXXXXXX",a[64],b[64]; //Scratch directory, file names
+        Acc *db; //Generated database
+        u64 t,i,bytes[2],diff=0; //Start time, counter, data and report bytes, differing files
+        double ms[4]; //Data and report times, stdio then wrLib
+        int d; //Subdirectory
+
+        if(!mkdtemp(dir)||chdir(dir)){perror("benchWrite");exit(1);}
+        for(d=0;d<5;d++)if(mkdir(sub[d],0777)){perror("benchWrite");exit(1);}
+        if(chdir("work")){perror("benchWrite");exit(1);} //Same ../dataz and ../filez layout as atmz
+        db=fakeDb(n);
+        fakeHist(db,n,k);
+        for(i=0;i<n;i++){
+                snprintf(db[i].name,sizeof(db[i].name),"Holder %llu",i);
+                snprintf(db[i].usrName,sizeof(db[i].usrName),"user%u",(unsigned)i); //At most 14 characters
+                strcpy(db[i].pass,"secret");
+                db[i].phno=9000000000ULL+i;
+        }
+
+        sync(); t=nowNs(); bytes[0]=oldData(db,"../odata"); ms[0]=(nowNs()-t)/1e6;
+        sync(); t=nowNs(); bytes[1]=oldReport(db,"../ofilez"); ms[1]=(nowNs()-t)/1e6;
+        sync(); t=nowNs(); if(saveData(db))fputs("benchWrite: save failed\n",stderr); ms[2]=(nowNs()-t)/1e6;
+        sync(); t=nowNs(); saveFile(db); ms[3]=(nowNs()-t)/1e6;
+
+        for(i=0;i<=n;i++){ //Every file of both layouts, Db.csv and DataBase.csv last
+                if(i<n){sprintf(a,"../dataz/%llu.csv",db[i].num);sprintf(b,"../odata/%llu.csv",db[i].num);}
+                else{strcpy(a,"../dataz/Db.csv");strcpy(b,"../odata/Db.csv");}
+                diff+=!sameFile(a,b); unlink(a); unlink(b);
+                if(i<n){sprintf(a,"../filez/%llu.csv",db[i].num);sprintf(b,"../ofilez/%llu.csv",db[i].num);}
+                else{strcpy(a,"../filez/DataBase.csv");strcpy(b,"../ofilez/DataBase.csv");}
+                diff+=!sameFile(a,b); unlink(a); unlink(b);
+        }
+        printf("%llu accounts x %llu transactions, data %.1f MB, reports %.1f MB (%llu files each)\n",
+                        n,k,bytes[0]/1048576.0,bytes[1]/1048576.0,n+1);
+        printf("  data     fprintf %9.1f ms %7.1f MB/s   wrLib %9.1f ms %7.1f MB/s  %.2fx\n",
+                        ms[0],bytes[0]/(ms[0]*1e3),ms[2],bytes[0]/(ms[2]*1e3),ms[0]/ms[2]);
+        printf("  reports  fprintf %9.1f ms %7.1f MB/s   wrLib %9.1f ms %7.1f MB/s  %.2fx\n",
+                        ms[1],bytes[1]/(ms[1]*1e3),ms[3],bytes[1]/(ms[3]*1e3),ms[1]/ms[3]);
+        printf("  output %s\n",diff?"DIFFERS":"identical");
+
+        chdir("/tmp"); //Leaves the scratch directory before removing it
+        for(d=0;d<5;d++){sprintf(a,"%s/%s",dir,sub[d]);rmdir(a);}
+        rmdir(dir);
+}
+
+/**
+ * @brief Receives one frame with one read() per byte, as rx_str did before lnkLib.
+ * @param fd Descriptor to read from.
+ * @param str Buffer for the frame.
+ * @param len Size of 'str'.
+ * @param calls Incremented once per read system call.
+ * @return int 0 on success, -1 at end of file.
+ */
+static int rxBytewise(int fd,char *str,size_t len,u64 *calls){
+        size_t i=0; //Index into 'str'
+        char ch; //Byte read
+        while(i<len-1){
+                ++*calls;
+                if(read(fd,&ch,1)!=1)return -1;
+                str[i++]=ch;
+                if(ch=='\n')break;
+        }
+        str[i-1]='\0'; //Drops the line end, as the old reader did
+        return 0;
+}
+
+/**
+ * @brief Starts a process that writes n request frames into a pipe, in 4 KB chunks.
+ * @param n Number of frames.
+ * @param pid Set to the writer's process id.
+ * @return int Read end of the pipe.
+ */
+static int frameSource(u64 n,pid_t *pid){
+        int p[2]; //Pipe ends
+        if(pipe(p)){perror("frameSource");exit(1);}
+        *pid=fork();
+        if(*pid<0){perror("frameSource");exit(1);}
+        if(!*pid){ //Writer
+                char buf[4096]; //Chunk being filled
+                int used=0; //Bytes in the chunk
+                u64 i; //Frame counter
+                close(p[0]);
+                for(i=0;i<n;i++){
+                        used+=sprintf(buf+used,"#A:DEP:%08llu:%llu$\r\n",10000000ULL+i%90000000ULL,i%30000);
+                        if(used>(int)sizeof(buf)-64){if(write(p[1],buf,used)!=used)_exit(1);used=0;}
+                }
+                if(used&&(write(p[1],buf,used)!=used))_exit(1);
+                _exit(0);
+        }
+        close(p[1]);
+        return p[0];
+}
+
+/**
+ * @brief Times receiving n frames from a pipe with the old byte-at-a-time loop and with lnkLib.
+ * @param n Number of frames.
+ */
+static void benchRx(u64 n){
+        char buf[100]; //Frame buffer, same size as atm_main's
+        pid_t pid; //Writer process
+        u64 t,got,calls=0; //Start time, frames received, read calls of the old loop
+        double msOld,msNew; //Receive times
+        int fd,r; //Read end, lnkFrame result
+        Lnk *l; //Link statistics
+
+        fd=frameSource(n,&pid);
+        t=nowNs();
+        for(got=0;!rxBytewise(fd,buf,sizeof(buf),&calls);got++);
+        msOld=(nowNs()-t)/1e6;
+        close(fd); waitpid(pid,NULL,0);
+        if(got!=n)fprintf(stderr,"benchRx: byte-at-a-time got %llu frames\n",got);
+
+        fd=frameSource(n,&pid);
+        t=nowNs();
+        for(got=0;;){ //Same loop as rx_str, without the debug print
+                r=lnkFrame(fd,buf,sizeof(buf));
+                if(r>0){got++;continue;}
+                if(r<0)continue;
+                if(lnkRead(fd)<=0)break; //Writer done
+        }
+        msNew=(nowNs()-t)/1e6;
+        l=lnkGet(fd);
+        if((got!=n)||l->rxErrs)fprintf(stderr,"benchRx: lnkLib got %llu frames, %llu errors\n",got,l->rxErrs);
+        printf("%llu frames  byte-at-a-time:%8.1f ms %10llu reads   ring:%8.1f ms %8llu reads   speedup:%.1fx\n",
+                        n,msOld,calls,msNew,l->rxCalls,msOld/msNew);
+        lnkClose(fd);
+        close(fd); waitpid(pid,NULL,0);
+}
+
+/**
+ * @brief Starts a process that reads and discards everything written into a pipe.
+ * @param pid Set to the reader's process id.
+ * @return int Write end of the pipe.
+ */
+static int frameSink(pid_t *pid){
+        int p[2]; //Pipe ends
+        if(pipe(p)){perror("frameSink");exit(1);}
+        *pid=fork();
+        if(*pid<0){perror("frameSink");exit(1);}
+        if(!*pid){ //Reader
+                char buf[65536]; //Discarded bytes
+                close(p[1]);
+                while(read(p[0],buf,sizeof(buf))>0);
+                _exit(0);
+        }
+        close(p[0]);
+        return p[1];
+}
+
+/**
+ * @brief tx_fmt without the debug print.
+ * @param fd Descriptor of the link.
+ * @param fmt printf style format of the response.
+ * @return int Length of the response, -1 on error.
+ */
+static int fmtTx(int fd,const char *fmt,...){
+        va_list ap; //Arguments after fmt
+        int n; //Formatted length
+        va_start(ap,fmt);
+        n=lnkVfmt(fd,fmt,ap);
+        va_end(ap);
+        return n;
+}
+
+/**
+ * @brief Times sending n balance responses: payload and CR LF as two writes (the old tx_str),
+ * one write per response through lnkLib, and lnkLib flushing every 8 responses.
+ * @param n Number of responses.
+ */
+static void benchTx(u64 n){
+        const char *name[3]={"two writes","one write","coalesced x8"}; //Variants
+        u64 i,t,calls; //Counter, start time, write calls
+        double ms; //Send time
+        pid_t pid; //Reader process
+        int fd,v,len; //Write end, variant, response length
+        char buf[50]; //Old path's stack buffer
+
+        for(v=0;v<3;v++){
+                fd=frameSink(&pid);
+                calls=0;
+                t=nowNs();
+                for(i=0;i<n;i++){
+                        if(!v){ //sprintf into a stack buffer, then payload and CR LF separately
+                                len=sprintf(buf,"@OK:BAL=%.2lf$",(double)(i%100000));
+                                if(write(fd,buf,len)!=len||write(fd,"\r\n",2)!=2)break;
+                                calls+=2;
+                                continue;
+                        }
+                        if(fmtTx(fd,"@OK:BAL=%.2lf$",(double)(i%100000))<0)break; //Built in the link's buffer
+                        if(((v==1)||((i&7)==7))&&lnkFlush(fd))break;
+                }
+                if(v)lnkFlush(fd);
+                ms=(nowNs()-t)/1e6;
+                if(v){calls=lnkGet(fd)->txCalls;lnkClose(fd);}
+                close(fd); waitpid(pid,NULL,0);
+                printf("%llu responses  %-13s %8.1f ms %9llu writes  %6.0f ns/response\n",n,name[v],ms,calls,ms*1e6/n);
+        }
+}
+
+#define LK_ACCS 100000 //Accounts in the lock benchmark
+#define LK_HOT 8 //Hot accounts of the skewed distribution
+#define LK_HOT_PCT 90 //Share of operations that hit the hot accounts
+
+static pthread_mutex_t lkGlobal=PTHREAD_MUTEX_INITIALIZER; //Baseline: one lock for the whole database
+
+typedef struct{ //Work of one benchmark thread
+        Acc *db; //Accounts
+        u64 ops; //Operations to run
+        u64 seed; //xorshift state, different per thread
+        int striped; //Non-zero: lockAcc/lockPair, zero: lkGlobal
+        int skew; //Non-zero: LK_HOT_PCT of the operations hit LK_HOT accounts
+        u64 deps; //Deposits done, to check the balance sum
+}LkJob;
+
+/**
+ * @brief Picks an account index for the lock benchmark.
+ * @param j Thread's job (random state and distribution).
+ * @return u64 Account index, 0..LK_ACCS-1.
+ */
+static u64 lkPick(LkJob *j){
+        j->seed^=j->seed<<13; j->seed^=j->seed>>7; j->seed^=j->seed<<17; //xorshift64, no shared rand state
+        if(j->skew&&((j->seed>>32)%100<LK_HOT_PCT))return (j->seed>>8)%LK_HOT; //Hot set
+        return (j->seed>>8)%LK_ACCS;
+}
+
+/**
+ * @brief Thread body: three deposits of 1 to one account for every transfer of 1 between two accounts.
+ * @param arg LkJob of the thread.
+ * @return void* Always NULL.
+ */
+static void* lkWork(void *arg){
+        LkJob *j=arg;
+        for(u64 i=0;i<j->ops;i++){
+                Acc *a=&j->db[lkPick(j)]; //Account of the operation
+                if(i&3){ //Deposit: one account
+                        if(j->striped)lockAcc(a); else pthread_mutex_lock(&lkGlobal);
+                        a->bal+=1; a->tranCnt++;
+                        if(j->striped)unlockAcc(a); else pthread_mutex_unlock(&lkGlobal);
+                        j->deps++;
+                }else{ //Transfer: two accounts, ordered by lockPair
+                        Acc *b=&j->db[lkPick(j)]; //Receiving account
+                        if(j->striped)lockPair(a,b); else pthread_mutex_lock(&lkGlobal);
+                        if(a->bal>=1){a->bal-=1;b->bal+=1;a->tranCnt++;b->tranCnt++;}
+                        if(j->striped)unlockPair(a,b); else pthread_mutex_unlock(&lkGlobal);
+                }
+        }
+        return NULL;
+}
+
+/**
+ * @brief Times n account operations split over 1, 2, 4 and 8 threads, global mutex vs striped locks,
+ * for uniform and skewed account choice, and checks that no update was lost.
+ * @param n Total number of operations per run.
+ */
+static void benchLock(u64 n){
+        const char *dist[2]={"uniform","skewed"}; //Distributions
+        const char *kind[2]={"global","striped"}; //Lock schemes
+        Acc *db=fakeDb(LK_ACCS); //Synthetic accounts, balance 0
+        pthread_t th[8]; //Worker threads
+        LkJob job[8]; //Their work
+        int sk,st,nt,i; //Distribution, scheme, thread count, thread
+        for(sk=0;sk<2;sk++)for(st=0;st<2;st++)for(nt=1;nt<=8;nt*=2){
+                i64 sum=0; //Balance sum after the run
+                u64 deps=0,t; //Deposits done, start time
+                double ms; //Run time
+                for(i=0;i<LK_ACCS;i++)db[i].bal=100; //Same starting balances every run
+                for(i=0;i<nt;i++){
+                        job[i]=(LkJob){db,n/nt,0x9E3779B97F4A7C15ULL*(i+1),st,sk,0};
+                }
+                t=nowNs();
+                for(i=0;i<nt;i++)if(pthread_create(&th[i],NULL,lkWork,&job[i])){perror("benchLock");exit(1);}
+                for(i=0;i<nt;i++){pthread_join(th[i],NULL);deps+=job[i].deps;}
+                ms=(nowNs()-t)/1e6;
+                for(i=0;i<LK_ACCS;i++)sum+=db[i].bal;
+                printf("%-7s %-7s %d threads %8.1f ms %7.2f Mops/s  balance sum %s\n",dist[sk],kind[st],nt,ms,
+                                (n/nt*nt)/(ms*1e3),(sum==(i64)(100*LK_ACCS+deps))?"ok":"LOST UPDATES");
+        }
+        free(db);
+}
+
+/**
+ * @brief Parses a frame the way procMsg did before msgLib: strlen in isMsgOk, fixed
+ * offsets copied out with strncpy/strcpy, atof on the copy.
+ * @param buf Null-terminated frame.
+ * @param sum Accumulates amounts, transaction numbers and field bytes so nothing is optimized away.
+ * @return int 1 if the frame was recognized.
+ */
+static int parseOld(const char *buf,double *sum){
+        char rfid[9],req[4],pin[5],dup[20]; //Copies of the fields
+        if((buf[0]!='#')||(buf[strlen(buf)-1]!='$'))return 0; //isMsgOk
+        switch(buf[1]){
+                case 'C':strncpy(rfid,buf+3,8);rfid[8]='\0';*sum+=rfid[7];return 1;
+                case 'V':strncpy(rfid,buf+3,8);rfid[8]='\0';strncpy(pin,buf+12,4);pin[4]='\0';*sum+=rfid[7]+pin[3];return 1;
+                case 'A':
+                        strncpy(rfid,buf+7,8);rfid[8]='\0';
+                        strncpy(req,buf+3,3);req[3]='\0';
+                        *sum+=rfid[7];
+                        if(!strcmp(req,"WTD")||!strcmp(req,"DEP")){ //extAmt
+                                strcpy(dup,buf+16);dup[strlen(dup)-1]='\0';*sum+=atof(dup);
+                        }else if(!strcmp(req,"MST"))*sum+=buf[16]-'0';
+                        else if(!strcmp(req,"PIN")){strncpy(pin,buf+16,4);pin[4]='\0';*sum+=pin[3];}
+                        return 1;
+        }
+        return 0;
+}
+
+/**
+ * @brief Parses a frame with msgParse and the field helpers, checking every field as procMsg does.
+ * @param buf Frame (need not be null-terminated).
+ * @param len Frame length.
+ * @param sum Accumulates the same values as parseOld.
+ * @return int 1 if the frame was recognized and well formed.
+ */
+static int parseNew(const char *buf,size_t len,double *sum){
+        Msg m; //Field views
+        i64 amt; //Converted amount in paise
+        unsigned long long txn; //Converted transaction number
+        if(msgParse(buf,len,&m))return 0;
+        switch(m.op){
+                case 'C':if((m.nf!=1)||!fldDigits(m.f[0],MSG_RFID_LEN))return 0;*sum+=m.f[0].p[7];return 1;
+                case 'V':if((m.nf!=2)||!fldDigits(m.f[0],MSG_RFID_LEN)||!fldDigits(m.f[1],MSG_PIN_LEN))return 0;
+                         *sum+=m.f[0].p[7]+m.f[1].p[3];return 1;
+                case 'A':
+                        if((m.nf<2)||(m.f[0].len!=MSG_REQ_LEN)||!fldDigits(m.f[1],MSG_RFID_LEN))return 0;
+                        *sum+=m.f[1].p[7];
+                        if(FLD_IS(m.f[0],"WTD")||FLD_IS(m.f[0],"DEP")){if((m.nf!=3)||fldAmt(m.f[2],&amt))return 0;*sum+=amt/100.0;}
+                        else if(FLD_IS(m.f[0],"MST")){if((m.nf!=3)||fldNum(m.f[2],&txn))return 0;*sum+=txn;}
+                        else if(FLD_IS(m.f[0],"PIN")){if((m.nf!=3)||!fldDigits(m.f[2],MSG_PIN_LEN))return 0;*sum+=m.f[2].p[3];}
+                        return 1;
+        }
+        return 0;
+}
+
+/**
+ * @brief Times parsing n frames from a mix of every request type, old fixed-offset parser vs msgLib.
+ * Both parsers must agree on the accumulated field values.
+ * @param n Number of frames.
+ */
+static void benchParse(u64 n){
+        static const char *mix[8]={"#C:12345678$","#V:12345678:4321$","#A:WTD:12345678:2500$","#A:DEP:12345678:120.50$",
+                "#A:BAL:12345678$","#A:MST:12345678:3$","#A:PIN:12345678:9876$","#A:WTD:12345678:30000$"}; //Request mix
+        size_t len[8]; //Frame lengths, as rx_str returns them
+        double sum[2]={0,0},ms[2]; //Accumulated values and times of both parsers
+        u64 i,t,ok[2]={0,0}; //Counter, start time, recognized frames
+        for(i=0;i<8;i++)len[i]=strlen(mix[i]);
+        t=nowNs();
+        for(i=0;i<n;i++)ok[0]+=parseOld(mix[i&7],&sum[0]);
+        ms[0]=(nowNs()-t)/1e6;
+        t=nowNs();
+        for(i=0;i<n;i++)ok[1]+=parseNew(mix[i&7],len[i&7],&sum[1]);
+        ms[1]=(nowNs()-t)/1e6;
+        printf("%llu frames  fixed offsets %8.1f ms %6.1f ns/frame\n",n,ms[0],ms[0]*1e6/n);
+        printf("%llu frames  field views   %8.1f ms %6.1f ns/frame  %.2fx  results %s\n",n,ms[1],ms[1]*1e6/n,ms[0]/ms[1],
+                        ((ok[0]==ok[1])&&(sum[0]==sum[1]))?"match":"DIFFER");
+}
+
+/**
+ * @brief Times mini statements of depth 3 (what the firmware asks for) and ACC_RECENT:
+ * each entry fetched by walking the history from the head, as miniStatement did, vs recentGet.
+ * Histories are built with addTran round robin over the accounts, so an account's nodes are
+ * spread over the heap the way a running ATM leaves them.
+ * @param n Number of accounts.
+ * @param k Transactions per account.
+ */
+static void benchMst(u64 n,u64 k){
+        Acc *db=fakeDb(n); //Synthetic accounts
+        u64 i,j,d,e,t,st=2000000/ACC_RECENT,bad=0; //Counters, depth, entry, start time, statements, mismatches
+        u64 seed=88172645463325252ULL; //xorshift state for the account choice
+        double ms[2]; //Walk and ring times
+        i64 sum[2]={0,0}; //Amounts read by each variant, as the MST reply formats them (also keeps the lookups alive)
+        for(j=0;j<k;j++)for(i=0;i<n;i++)addTran(&db[i],(j&1)?-RUPEES(10):RUPEES(25),(j&1)?WITHDRAW:DEPOSIT); //Interleaved arrival
+        for(d=3;d<=ACC_RECENT;d+=ACC_RECENT-3){
+                for(int v=0;v<2;v++){
+                        u64 s=seed; //Same accounts for both variants
+                        t=nowNs();
+                        for(i=0;i<st;i++){
+                                s^=s<<13; s^=s>>7; s^=s<<17;
+                                Acc *a=&db[s%n]; //Account of the statement
+                                for(e=1;e<=d;e++){ //One request per entry, as the firmware sends them
+                                        Tran *x;
+                                        if(!v){x=a->tranHist;for(u64 w=e;--w;)x=x->nxt;} //Old miniStatement walk
+                                        else x=recentGet(a,e);
+                                        sum[v]+=x->amt; //The reply reads the entry either way
+                                }
+                        }
+                        ms[v]=(nowNs()-t)/1e6;
+                }
+                printf("depth %llu  %llu statements  list walk %7.1f ms %6.1f ns/stmt  ring %7.1f ms %6.1f ns/stmt  %.2fx\n",
+                                d,st,ms[0],ms[0]*1e6/st,ms[1],ms[1]*1e6/st,ms[0]/ms[1]);
+        }
+        for(i=0;i<n;i++)for(j=0,bad+=(recentGet(&db[i],1)!=db[i].tranHist);j<k;j++){ //Ring and list agree on every position
+                Tran *x=db[i].tranHist; for(e=0;e<j;e++)x=x->nxt;
+                bad+=(recentGet(&db[i],j+1)!=x);
+        }
+        printf("positions checked: %s, amounts read %s\n",bad?"MISMATCH":"ok",(sum[0]==sum[1])?"agree":"DIFFER");
+}
+
+#define MON_SET 4096 //Distinct amounts benchMoney cycles through (stays in cache, times the routines)
+
+/**
+ * @brief Times parsing and formatting n amounts, the old double path (atof, sprintf "%.2lf")
+ * vs paise (monParse, monFmt), and checks that both give the same values and the same text.
+ * Amounts mix small and large values, both signs, and whole rupees with paise.
+ * @param n Number of amounts.
+ */
+static void benchMoney(u64 n){
+        static char txt[MON_SET][MON_LEN]; //Amounts as the files and frames carry them
+        static i64 val[MON_SET]; //Same amounts in paise
+        size_t len[MON_SET]; //Text lengths
+        char buf[64]; //Formatted amount
+        u64 i,t,bytes=0,bad=0,s=88172645463325252ULL; //Counter, start time, bytes handled, mismatches, xorshift state
+        double ms[4],d,dsum=0; //Times: atof, monParse, sprintf, monFmt; converted value, double checksum
+        i64 v,isum=0; //Converted value, paise checksum
+        for(i=0;i<MON_SET;i++){
+                s^=s<<13; s^=s>>7; s^=s<<17;
+                v=(i64)(s%((i&3)?10000000ULL:100000000000ULL)); //Up to 1 lakh, every fourth up to 10 crore
+                if(i&4)v-=v%100; //Whole rupees
+                val[i]=(i&8)?-v:v;
+                len[i]=sprintf(txt[i],"%.2lf",val[i]/100.0);
+                bytes+=len[i];
+        }
+        bytes=bytes*(n/MON_SET)+(n%MON_SET)*(bytes/MON_SET); //Bytes parsed or written by one pass
+        t=nowNs(); for(i=0;i<n;i++)dsum+=atof(txt[i&(MON_SET-1)]); ms[0]=(nowNs()-t)/1e6;
+        t=nowNs(); for(i=0;i<n;i++){monParse(txt[i&(MON_SET-1)],len[i&(MON_SET-1)],&v);isum+=v;} ms[1]=(nowNs()-t)/1e6;
+        t=nowNs(); for(i=0;i<n;i++)dsum+=sprintf(buf,"%.2lf",val[i&(MON_SET-1)]/100.0); ms[2]=(nowNs()-t)/1e6;
+        t=nowNs(); for(i=0;i<n;i++)isum+=monFmt(buf,val[i&(MON_SET-1)]); ms[3]=(nowNs()-t)/1e6;
+        for(i=0;i<MON_SET;i++){ //Both paths agree on every amount
+                d=atof(txt[i])*100;
+                bad+=monParse(txt[i],len[i],&v)||(v!=val[i])||((i64)(d+((d<0)?-0.5:0.5))!=v);
+                monFmt(buf,val[i]);
+                bad+=strcmp(buf,txt[i])!=0;
+        }
+        printf("%llu amounts  parse   atof     %8.1f ms %6.1f ns/amount %7.1f MB/s\n",n,ms[0],ms[0]*1e6/n,bytes/(ms[0]*1e3));
+        printf("%llu amounts  parse   monParse %8.1f ms %6.1f ns/amount %7.1f MB/s  %.2fx\n",n,ms[1],ms[1]*1e6/n,bytes/(ms[1]*1e3),ms[0]/ms[1]);
+        printf("%llu amounts  format  sprintf  %8.1f ms %6.1f ns/amount %7.1f MB/s\n",n,ms[2],ms[2]*1e6/n,bytes/(ms[2]*1e3));
+        printf("%llu amounts  format  monFmt   %8.1f ms %6.1f ns/amount %7.1f MB/s  %.2fx\n",n,ms[3],ms[3]*1e6/n,bytes/(ms[3]*1e3),ms[2]/ms[3]);
+        printf("results %s (checksums %.0f %lld)\n",bad?"DIFFER":"match",dsum,isum);
+}
+
+/**
+ * @brief Writes a synthetic history file in the appendable layout (HIST_MARK, oldest first).
+ * @param path File to write.
+ * @param mb Size in MB.
+ * @return u64 Bytes written.
+ */
+static u64 fakeHistFile(const char *path,u64 mb){
+        Wr w=WR_INIT; //Writer
+        u64 i,s=88172645463325252ULL; //Record counter, xorshift state
+        i64 v; //Amount
+        if(wrOpen(&w,path,0)){perror("fakeHistFile");exit(1);}
+        wrStr(&w,HIST_MARK "\n");
+        for(i=0;w.bytes+w.len<(mb<<20);i++){
+                s^=s<<13; s^=s>>7; s^=s<<17;
+                v=(i64)(s%((i&3)?3000000ULL:10000000000ULL)); //Up to 30000, every fourth up to 1 crore
+                wrU64(&w,20250101000000000ULL+i*7,0); wrChr(&w,',');
+                wrMon(&w,(i&1)?-v:v); wrChr(&w,',');
+                wrChr(&w,(char)(WITHDRAW+(s>>40)%4)); wrChr(&w,'\n');
+        }
+        if(wrClose(&w)){perror("fakeHistFile");exit(1);}
+        wrFree(&w);
+        return w.bytes;
+}
+
+/**
+ * @brief Writes a synthetic Db.csv.
+ * @param path File to write.
+ * @param mb Size in MB.
+ * @return u64 Bytes written.
+ */
+static u64 fakeDbFile(const char *path,u64 mb){
+        Wr w=WR_INIT; //Writer
+        u64 i; //Row counter
+        if(wrOpen(&w,path,0)){perror("fakeDbFile");exit(1);}
+        for(i=0;w.bytes+w.len<(mb<<20);i++){
+                wrU64(&w,20250101000000000ULL+i,0); wrChr(&w,',');
+                wrStr(&w,"Holder "); wrU64(&w,i,0); wrChr(&w,',');
+                wrU64(&w,9000000000ULL+i,0); wrChr(&w,',');
+                wrStr(&w,"user"); wrU64(&w,i%100000000,0); wrChr(&w,',');
+                wrStr(&w,"secret"); wrChr(&w,',');
+                wrU64(&w,10000000ULL+i*7%90000000ULL,8); wrChr(&w,',');
+                wrU64(&w,i%10000,4); wrChr(&w,',');
+                wrU64(&w,i&1,0); wrChr(&w,',');
+                wrMon(&w,(i64)(i*7919%1000000000ULL)); wrChr(&w,',');
+                wrU64(&w,i%500,0); wrChr(&w,'\n');
+        }
+        if(wrClose(&w)){perror("fakeDbFile");exit(1);}
+        wrFree(&w);
+        return w.bytes;
+}
+
+/**
+ * @brief Reads a history file with fscanf, as loadHist did before csvLib.
+ * @param path File to read.
+ * @param sum Checksum of the records.
+ * @return u64 Records read.
+ */
+static u64 oldHist(const char *path,u64 *sum){
+        char mark[sizeof(HIST_MARK)+1],amt[MON_LEN]; //First line, amount text
+        FILE *sp=fopen(path,"r"); //History file
+        Tran t; //Record
+        u64 cnt=0; //Records read
+        if(!sp){perror("oldHist");exit(1);}
+        if(!fgets(mark,sizeof(mark),sp)||strcmp(mark,HIST_MARK "\n"))rewind(sp);
+        while((fscanf(sp,"%llu,%23[^,],%c",&t.id,amt,&t.type)==3)&&!monParse(amt,strlen(amt),&t.amt)){
+                *sum+=t.id*31+(u64)t.amt*7+t.type;
+                cnt++;
+        }
+        fclose(sp);
+        return cnt;
+}
+
+/**
+ * @brief Reads a history file with csvLib, as loadHist does.
+ * @param path File to read.
+ * @param sum Checksum of the records.
+ * @return u64 Records read.
+ */
+static u64 newHist(const char *path,u64 *sum){
+        Csv c=CSV_INIT; //Reader
+        Tran t; //Record
+        u64 cnt=0; //Records read
+        if(csvOpen(&c,path)){perror("newHist");exit(1);}
+        csvLine(&c,HIST_MARK);
+        while(csvTran(&c,&t)==1){
+                *sum+=t.id*31+(u64)t.amt*7+t.type;
+                cnt++;
+        }
+        csvClose(&c);
+        csvFree(&c);
+        return cnt;
+}
+
+/**
+ * @brief Reads Db.csv rows with fscanf, as loadCsv did before csvLib.
+ * @param path File to read.
+ * @param sum Checksum of the rows.
+ * @return u64 Rows read.
+ */
+static u64 oldDb(const char *path,u64 *sum){
+        FILE *fp=fopen(path,"r"); //Db.csv
+        char bal[MON_LEN]; //Balance text
+        Acc a; //Row
+        u64 cnt=0; //Rows read
+        if(!fp){perror("oldDb");exit(1);}
+        while((fscanf(fp,"%llu,%[^,],%llu,%[^,],%[^,],%[^,],%[^,],%d,%23[^,],%llu",&a.num,a.name,&a.phno,a.usrName,a.pass,
+                                        a.rfid,a.pin,&a.cardStat,bal,&a.tranCnt)==10)&&!monParse(bal,strlen(bal),&a.bal)){
+                *sum+=a.num+a.phno+(u64)a.bal+a.tranCnt+a.cardStat+strlen(a.name)+a.usrName[4]+a.pass[0]+atoi(a.rfid)+atoi(a.pin);
+                cnt++;
+        }
+        fclose(fp);
+        return cnt;
+}
+
+/**
+ * @brief Reads Db.csv rows with csvLib, as loadCsv does.
+ * @param path File to read.
+ * @param sum Checksum of the rows.
+ * @return u64 Rows read.
+ */
+static u64 newDb(const char *path,u64 *sum){
+        Csv c=CSV_INIT; //Reader
+        Acc a; //Row
+        u64 cnt=0; //Rows read
+        if(csvOpen(&c,path)){perror("newDb");exit(1);}
+        while(csvAcc(&c,&a)==1){
+                *sum+=a.num+a.phno+(u64)a.bal+a.tranCnt+a.cardStat+strlen(a.name)+a.usrName[4]+a.pass[0]+atoi(a.rfid)+atoi(a.pin);
+                cnt++;
+        }
+        csvClose(&c);
+        csvFree(&c);
+        return cnt;
+}
+
+/**
+ * @brief Cuts a file into fields without converting them: the delimiter scan alone.
+ * @param path File to read.
+ * @param sum Sum of the field lengths.
+ * @return u64 Fields seen.
+ */
+static u64 scanFile(const char *path,u64 *sum){
+        Csv c=CSV_INIT; //Reader
+        const char *s; //Field
+        size_t n; //Field length
+        u64 cnt=0; //Fields seen
+        if(csvOpen(&c,path)){perror("scanFile");exit(1);}
+        while(csvFld(&c,&s,&n)>0){*sum+=n;cnt++;}
+        csvClose(&c);
+        csvFree(&c);
+        return cnt;
+}
+
+/**
+ * @brief Times parsing a synthetic history file of mb MB and a Db.csv of mb/8 MB with fscanf
+ * and with csvLib at every scan level the CPU has, in GB/s (warm page cache), and checks that
+ * both read the same records. Runs in a scratch directory under /tmp, removed afterwards.
+ * @param mb Size of the history file in MB.
+ */
+static void benchCsv(u64 mb){
+        static const char *lvName[3]={"scalar","SSE2","AVX2"}; //CSV_* level names
+        static const char *file[2]={"hist.csv","Db.csv"}; //Test files
+        u64 (*oldRd[2])(const char*,u64*)={oldHist,oldDb},(*newRd[2])(const char*,u64*)={newHist,newDb}; //Loaders per file
+        char dir[]="/tmp/atm_benchXXXXXX",path[2][64]; //Scratch directory, file names
+        u64 bytes[2],t,cnt,ref,sum,refSum; //File sizes, start time, records, fscanf records, checksums
+        double ms,old; //Time of a pass, fscanf time
+        int f,lv; //File, scan level
+
+        if(!mkdtemp(dir)){perror("benchCsv");exit(1);}
+        for(f=0;f<2;f++)sprintf(path[f],"%s/%s",dir,file[f]);
+        bytes[0]=fakeHistFile(path[0],mb);
+        bytes[1]=fakeDbFile(path[1],(mb/8)?mb/8:1);
+        for(f=0;f<2;f++){
+                sum=0; scanFile(path[f],&sum); //Warms the page cache
+                printf("%s %.1f MB\n",file[f],bytes[f]/1048576.0);
+                refSum=0; t=nowNs(); ref=oldRd[f](path[f],&refSum); old=ms=(nowNs()-t)/1e6;
+                printf("  fscanf         %9.1f ms %6.3f GB/s  %llu records\n",ms,bytes[f]/(ms*1e6),ref);
+                for(lv=CSV_AVX2;lv>=CSV_SCALAR;lv--){
+                        if(csvLevel(lv)!=lv){printf("  csvLib %-6s   not supported by this CPU\n",lvName[lv]);continue;}
+                        sum=0; t=nowNs(); cnt=newRd[f](path[f],&sum); ms=(nowNs()-t)/1e6;
+                        printf("  csvLib %-6s  %9.1f ms %6.3f GB/s  %5.2fx  %s\n",lvName[lv],ms,bytes[f]/(ms*1e6),old/ms,
+                                        ((cnt==ref)&&(sum==refSum))?"same records":"RECORDS DIFFER");
+                        sum=0; t=nowNs(); cnt=scanFile(path[f],&sum); ms=(nowNs()-t)/1e6;
+                        printf("    scan only    %9.1f ms %6.3f GB/s  %llu fields\n",ms,bytes[f]/(ms*1e6),cnt);
+                }
+                unlink(path[f]);
+        }
+        csvLevel(CSV_AVX2);
+        rmdir(dir);
+}
+
+static volatile int rptDone; //Set by rptWaiter once the background report is finished
+
+/**
+ * @brief Waits for the running report, then sets rptDone.
+ * @param arg Unused.
+ * @return void* NULL.
+ */
+static void* rptWaiter(void *arg){
+        (void)arg;
+        rptWait(NULL);
+        __atomic_store_n(&rptDone,1,__ATOMIC_RELEASE);
+        return NULL;
+}
+
+/**
+ * @brief Runs one request (lockAcc, one deposit, unlockAcc) on a random account.
+ * @param db Account array.
+ * @param n Number of accounts.
+ * @param s xorshift state.
+ * @return u64 Time the request took (ns), lock wait included.
+ */
+static u64 rptReq(Acc *db,u64 n,u64 *s){
+        u64 t=nowNs(); //Request start
+        Acc *a; //Account
+        *s^=*s<<13; *s^=*s>>7; *s^=*s<<17;
+        a=&db[*s%n];
+        lockAcc(a);
+        a->bal+=RUPEES(1);
+        addTran(a,RUPEES(1),DEPOSIT);
+        unlockAcc(a);
+        return nowNs()-t;
+}
+
+/**
+ * @brief Times the ../filez report for n accounts with k transactions each: fprintf in the
+ * caller (as saveFile did) vs the report threads of rptLib with 1, 2, 4 and 8 statement
+ * threads, in accounts/s, then a report of changed accounts only after 1% of them took a
+ * deposit, and the latency of requests made while a full report runs in the background.
+ * Checks that the report threads write the same bytes as fprintf.
+ * Runs in a scratch directory under /tmp, which is removed afterwards.
+ * @param n Number of accounts.
+ * @param k Transactions per account.
+ */
+static void benchReport(u64 n,u64 k){
+        static const char *sub[3]={"filez","ofilez","work"}; //Scratch subdirectories
+        char dir[]="/tmp/atm_benchXXXXXX",a[64],b[64]; //Scratch directory, file names
+        Acc *db; //Generated database
+        RptStat st; //Figures of a report
+        pthread_t wt; //rptWaiter
+        u64 t,i,diff=0,s=88172645463325252ULL,ns,req,sum,max; //Start time, counter, differing files, xorshift, request figures
+        double ms; //fprintf report time
+        int d,nt; //Subdirectory, thread count
+
+        if(!mkdtemp(dir)||chdir(dir)){perror("benchReport");exit(1);}
+        for(d=0;d<3;d++)if(mkdir(sub[d],0777)){perror("benchReport");exit(1);}
+        if(chdir("work")){perror("benchReport");exit(1);} //Same ../filez layout as atmz
+        db=fakeDb(n);
+        fakeHist(db,n,k);
+
+        printf("%llu accounts x %llu transactions, %ld CPUs\n",n,k,sysconf(_SC_NPROCESSORS_ONLN));
+        sync(); t=nowNs(); oldReport(db,"../ofilez"); ms=(nowNs()-t)/1e6;
+        printf("  fprintf in the caller        %9.1f ms %9.0f accounts/s (a request waits all of it)\n",ms,n/(ms/1e3));
+        for(nt=1;nt<=8;nt*=2){
+                rptThreads=nt;
+                sync(); rptStart(db,RPT_ALL); rptWait(&st);
+                printf("  rptLib, %d statement threads %9.1f ms %9.0f accounts/s  %.2fx\n",nt,st.ms,st.accounts/(st.ms/1e3),ms/st.ms);
+        }
+        rptThreads=0;
+        for(i=0;i<=n;i++){ //Every statement, DataBase.csv last
+                if(i<n){sprintf(a,"../filez/%llu.csv",db[i].num);sprintf(b,"../ofilez/%llu.csv",db[i].num);}
+                else{strcpy(a,"../filez/DataBase.csv");strcpy(b,"../ofilez/DataBase.csv");}
+                diff+=!sameFile(a,b); unlink(b);
+        }
+        printf("  output %s\n",diff?"DIFFERS":"identical");
+
+        for(i=0;i<n/100;i++)rptReq(db,n,&s); //1% of the accounts change
+        sync(); rptStart(db,RPT_CHANGED); rptWait(&st);
+        printf("  changed only: %llu statements %9.1f ms %9.0f accounts/s  %.2fx\n",st.statements,st.ms,st.accounts/(st.ms/1e3),ms/st.ms);
+
+        for(req=0,sum=0,max=0;req<200000;req++){sum+=ns=rptReq(db,n,&s);if(ns>max)max=ns;} //No report running
+        printf("  requests, no report          avg %7.2f us  max %9.1f us\n",sum/1e3/req,max/1e3);
+        rptDone=0;
+        rptStart(db,RPT_ALL);
+        if(pthread_create(&wt,NULL,rptWaiter,NULL)){perror("benchReport");exit(1);}
+        for(req=0,sum=0,max=0;!__atomic_load_n(&rptDone,__ATOMIC_ACQUIRE);req++){ //About one request per 50 us, as from a busy ATM network
+                sum+=ns=rptReq(db,n,&s);
+                if(ns>max)max=ns;
+                usleep(50);
+        }
+        pthread_join(wt,NULL);
+        rptWait(&st);
+        printf("  requests, report running     avg %7.2f us  max %9.1f us  (%llu requests during the %.1f ms report)\n",
+                        req?sum/1e3/req:0,max/1e3,req,st.ms);
+
+        for(i=0;i<=n;i++){
+                if(i<n)sprintf(a,"../filez/%llu.csv",db[i].num);
+                else strcpy(a,"../filez/DataBase.csv");
+                unlink(a);
+        }
+        chdir("/tmp"); //Leaves the scratch directory before removing it
+        for(d=0;d<3;d++){sprintf(a,"%s/%s",dir,sub[d]);rmdir(a);}
+        rmdir(dir);
+}
+
+/**
+ * @brief Totals by type of the matching transactions, walking every account's history list.
+ * @param db Account array.
+ * @param n Number of accounts.
+ * @param q Query.
+ * @param a Result (cleared first).
+ */
+static void colWalk(Acc *db,u64 n,const ColQry *q,ColAgg *a){
+        u64 i; //Account counter
+        Tran *t; //History walk
+        int k; //Type slot
+        memset(a,0,sizeof(*a));
+        for(i=0;i<n;i++){
+                if((db[i].num<q->accLo)||(db[i].num>q->accHi))continue;
+                for(t=db[i].tranHist;t;t=t->nxt){
+                        if((t->id<q->idLo)||(t->id>q->idHi))continue;
+                        k=((t->type>=WITHDRAW)&&(t->type<=TRANSFER_OUT))?t->type:0;
+                        a->cnt[k]++;
+                        a->sum[k]+=t->amt;
+                }
+        }
+}
+
+/**
+ * @brief Times the columnar ledger for n accounts with k transactions each: export, then three
+ * queries (every account but one, 1% of the time range, everything) answered by walking the
+ * history lists vs colScan with the plain C and AVX2 block scans, and checks that all agree.
+ * Runs in a scratch directory under /tmp, which is removed afterwards.
+ * @param n Number of accounts.
+ * @param k Transactions per account.
+ */
+static void benchCol(u64 n,u64 k){
+        static const char *qName[3]={"all but one account","1% of the time range","everything"}; //Queries
+        char dir[]="/tmp/atm_benchXXXXXX",path[64]; //Scratch directory, export file
+        Acc *db; //Generated database
+        Col c=COL_INIT; //Opened export
+        ColQry q[3]={COL_QRY_ALL,COL_QRY_ALL,COL_QRY_ALL}; //Queries
+        ColAgg ref,a; //List walk and scan results
+        u64 t,idLo=~0ULL,idHi=0,i; //Start time, ID range of the data, counter
+        double ms,walk; //Times
+        int lv,qi,bad=0; //Scan level, query, disagreements
+
+        if(!mkdtemp(dir)){perror("benchCol");exit(1);}
+        sprintf(path,"%s/Ledger.col",dir);
+        db=fakeDb(n);
+        fakeHist(db,n,k);
+        for(i=0;i<n;i++)if(db[i].tranHist){ //Newest first: the head is the largest ID, the last node the smallest
+                Tran *e=db[i].tranHist; //Oldest node
+                while(e->nxt)e=e->nxt;
+                if(db[i].tranHist->id>idHi)idHi=db[i].tranHist->id;
+                if(e->id<idLo)idLo=e->id;
+        }
+        q[0].accLo=db[0].num+1; //Cuts every block that holds account 0
+        q[1].idLo=idLo+(idHi-idLo)/2;
+        q[1].idHi=q[1].idLo+(idHi-idLo)/100;
+
+        t=nowNs(); if(colWrite(db,path))exit(1); ms=(nowNs()-t)/1e6;
+        if(colOpen(&c,path)){perror("benchCol");exit(1);}
+        printf("%llu accounts x %llu transactions, export %.1f MB in %.1f ms (%.0f rows/s), %llu blocks\n",
+                        n,k,c.size/1048576.0,ms,n*k/(ms/1e3),c.h->blocks);
+        for(qi=0;qi<3;qi++){
+                t=nowNs(); colWalk(db,n,&q[qi],&ref); walk=(nowNs()-t)/1e6;
+                printf("  %s\n    list walk %9.2f ms\n",qName[qi],walk);
+                for(lv=COL_SCALAR;lv<=COL_AVX2;lv++){
+                        if(colLevel(lv)!=lv){printf("    AVX2 not supported by this CPU\n");continue;}
+                        colScan(&c,&q[qi],&a); //Warms the mapping
+                        t=nowNs(); colScan(&c,&q[qi],&a); ms=(nowNs()-t)/1e6;
+                        bad+=memcmp(a.cnt,ref.cnt,sizeof(a.cnt))||memcmp(a.sum,ref.sum,sizeof(a.sum));
+                        printf("    colScan %-4s %9.2f ms %6.2f GB/s  %6.1fx  (%llu skipped, %llu from the directory, %llu scanned)\n",
+                                        lv?"AVX2":"C",ms,a.rows*25/(ms*1e6),walk/ms,a.skipped,a.whole,a.scanned);
+                }
+        }
+        printf("  totals %s\n",bad?"DIFFER":"agree");
+        colLevel(COL_AVX2);
+        colClose(&c);
+        unlink(path);
+        rmdir(dir);
+}
+
+/**
+ * @brief Times the day totals by type from the rollups against a walk over every history,
+ * the rebuild done after a CSV import, and the share of rollAdd in addTran.
+ * @param n Number of accounts.
+ * @param k Transactions per account.
+ */
+static void benchRoll(u64 n,u64 k){
+        const u64 day=20250101ULL,reps=100000,adds=1000000; //Day of fakeHist, rollGet calls, addTran calls
+        const u64 today=getTimeStamp()/1000000*1000000000ULL+120000000ULL; //Noon today, the day addTran counts in
+        Acc *db=fakeDb(n); //Generated database
+        RollDay d; //Rollups read back
+        RollCell w[ROLL_TYPES]; //Totals of the walk
+        Tran *c; //History walk
+        u64 t,i; //Start time, counter
+        double walk,get,build,add,ra; //Times
+        int bad=0; //Disagreements
+
+        fakeHist(db,n,k);
+        t=nowNs(); rollBuild(db); build=(nowNs()-t)/1e6;
+        t=nowNs();
+        memset(w,0,sizeof(w));
+        for(i=0;i<n;i++)for(c=db[i].tranHist;c;c=c->nxt)if(c->id/1000000000ULL==day){
+                unsigned char ty=((unsigned char)c->type<ROLL_TYPES)?(unsigned char)c->type:0; //Slot 0 for an unknown type, as rollAdd
+                w[ty].cnt++;
+                w[ty].sum+=c->amt;
+        }
+        walk=(nowNs()-t)/1e6;
+        t=nowNs(); for(i=0;i<reps;i++)rollGet(day,&d); get=(nowNs()-t)/1e3/reps;
+        bad=memcmp(d.tot,w,sizeof(w))!=0;
+        printf("%llu accounts x %llu transactions\n",n,k);
+        printf("  day totals: history walk %9.2f ms, rollGet %6.2f us (%.0fx), totals %s\n",walk,get,walk*1e3/get,bad?"DIFFER":"agree");
+        printf("  rollBuild after a CSV import %9.2f ms\n",build);
+        t=nowNs(); for(i=0;i<adds;i++)addTran(&db[i%n],RUPEES(1),DEPOSIT); add=(double)(nowNs()-t)/adds;
+        t=nowNs(); for(i=0;i<adds;i++)rollAdd(today+i,RUPEES(1),DEPOSIT); ra=(double)(nowNs()-t)/adds;
+        printf("  addTran %.1f ns per call, of which rollAdd %.1f ns\n",add,ra);
+}
+
+//Entry point: selects the benchmark named on the command line.
+int main(int argc,char **argv){
+        if(argc<2){ //No test named
+                fprintf(stderr,"usage: %s idx [n ...] | snap [n] [k] | load [n] [k] [t] | save [n] [k] | write [n] [k] | pool [n] | rx [n] | tx [n] | lock [n] | parse [n] | mst [n] [k] | money [n] | csv [mb] | report [n] [k] | col [n] [k] | roll [n] [k]\n",argv[0]);
+                return 1;
+        }
+        if(!strcmp(argv[1],"idx")){ //RFID lookup benchmark
+                if(argc==2){benchIdx(10000);benchIdx(100000);benchIdx(1000000);}
+                else for(int i=2;i<argc;i++)benchIdx(strtoull(argv[i],NULL,10));
+                return 0;
+        }
+        if(!strcmp(argv[1],"snap")){ //Startup benchmark
+                benchSnap((argc>2)?strtoull(argv[2],NULL,10):100000,(argc>3)?strtoull(argv[3],NULL,10):20);
+                return 0;
+        }
+        if(!strcmp(argv[1],"load")){ //Parallel history loading benchmark
+                long t=(argc>4)?atol(argv[4]):sysconf(_SC_NPROCESSORS_ONLN); //Most threads
+                if((argc<=4)&&(t<8))t=8; //Small hosts still show the I/O overlap
+                benchLoad((argc>2)?strtoull(argv[2],NULL,10):100000,(argc>3)?strtoull(argv[3],NULL,10):20,
+                                (int)((t<1)?1:(t>LOAD_THREADS_MAX)?LOAD_THREADS_MAX:t));
+                return 0;
+        }
+        if(!strcmp(argv[1],"save")){ //History save benchmark
+                benchSave((argc>2)?strtoull(argv[2],NULL,10):20000,(argc>3)?strtoull(argv[3],NULL,10):200);
+                return 0;
+        }
+        if(!strcmp(argv[1],"write")){ //CSV and report writer benchmark
+                benchWrite((argc>2)?strtoull(argv[2],NULL,10):100000,(argc>3)?strtoull(argv[3],NULL,10):100);
+                return 0;
+        }
+        if(!strcmp(argv[1],"pool")){ //Node allocation benchmark
+                benchPool((argc>2)?strtoull(argv[2],NULL,10):4000000);
+                return 0;
+        }
+        if(!strcmp(argv[1],"rx")){ //Frame reception benchmark
+                benchRx((argc>2)?strtoull(argv[2],NULL,10):200000);
+                return 0;
+        }
+        if(!strcmp(argv[1],"tx")){ //Response transmission benchmark
+                benchTx((argc>2)?strtoull(argv[2],NULL,10):200000);
+                return 0;
+        }
+        if(!strcmp(argv[1],"lock")){ //Lock contention benchmark
+                benchLock((argc>2)?strtoull(argv[2],NULL,10):4000000);
+                return 0;
+        }
+        if(!strcmp(argv[1],"parse")){ //Request parsing benchmark
+                benchParse((argc>2)?strtoull(argv[2],NULL,10):5000000);
+                return 0;
+        }
+        if(!strcmp(argv[1],"mst")){ //Mini statement benchmark
+                benchMst((argc>2)?strtoull(argv[2],NULL,10):50000,(argc>3)?strtoull(argv[3],NULL,10):32);
+                return 0;
+        }
+        if(!strcmp(argv[1],"money")){ //Amount parse/format benchmark
+                benchMoney((argc>2)?strtoull(argv[2],NULL,10):10000000);
+                return 0;
+        }
+        if(!strcmp(argv[1],"csv")){ //CSV parsing benchmark
+                benchCsv((argc>2)?strtoull(argv[2],NULL,10):2048);
+                return 0;
+        }
+        if(!strcmp(argv[1],"report")){ //Background report benchmark
+                benchReport((argc>2)?strtoull(argv[2],NULL,10):100000,(argc>3)?strtoull(argv[3],NULL,10):100);
+                return 0;
+        }
+        if(!strcmp(argv[1],"col")){ //Columnar ledger benchmark
+                benchCol((argc>2)?strtoull(argv[2],NULL,10):100000,(argc>3)?strtoull(argv[3],NULL,10):100);
+                return 0;
+        }
+        if(!strcmp(argv[1],"roll")){ //Rollup benchmark
+                benchRoll((argc>2)?strtoull(argv[2],NULL,10):100000,(argc>3)?strtoull(argv[3],NULL,10):100);
+                return 0;
+        }
+        fprintf(stderr,"unknown test: %s\n",argv[1]);
+        return 1;
+}
@@ -0,0 +1,83 @@
+#include "atmLib.h" //Includes the atmLib.h header file which contains declarations for ATM functions and structures
+#include "colLib.h" //Columnar ledger export and scan
+
+//Ledger tool for analysts: exports the transaction ledger to one columnar file and answers
+//totals by type over a date range (and optionally one account) from it.
+//Usage: ./atm_col export [file]
+//           Loads ../dataz as the ATM does (Db.snap or Db.csv and the history files, then the journal;
+//           nothing in ../dataz is changed) and writes the ledger to file (default COL_FILE)
+//       ./atm_col scan [-s] [-f file] [from [to [account]]]
+//           Count and amount of every transaction type from day `from` to day `to` (YYYYMMDD, both
+//           included, 0 for no bound), of one account if given; -s uses the plain C scan
+
+/**
+ * @brief Returns a monotonic time stamp in nanoseconds.
+ * @return u64 Nanoseconds since an arbitrary point.
+ */
+static u64 nowNs(void){
+        struct timespec ts; //Monotonic clock reading
+        clock_gettime(CLOCK_MONOTONIC,&ts);
+        return ts.tv_sec*1000000000ULL+ts.tv_nsec;
+}
+
+/**
+ * @brief Prints the totals of a scan, one line per type.
+ * @param a Result.
+ */
+static void printAgg(const ColAgg *a){
+        static const char *name[COL_TYPES]={"Unknown","Withdraw","Deposit","Transfer IN","Transfer OUT"}; //Type slots
+        char amt[MON_LEN]; //Amount text
+        u64 cnt=0; //Rows in total
+        i64 sum=0; //Amount in total
+        int t; //Type slot
+        printf("%-14s %12s %24s\n","Type","Count","Amount");
+        for(t=WITHDRAW;t<COL_TYPES+1;t++){ //Unknown last, and only when there is any
+                int k=t%COL_TYPES; //Slot
+                if(!k&&!a->cnt[0])continue;
+                monFmt(amt,a->sum[k]);
+                printf("%-14s %12llu %24s\n",name[k],a->cnt[k],amt);
+                cnt+=a->cnt[k];
+                sum+=a->sum[k];
+        }
+        monFmt(amt,sum);
+        printf("%-14s %12llu %24s\n","Total",cnt,amt);
+}
+
+//Entry point: export or scan, as named on the command line.
+int main(int argc,char **argv){
+        Acc *db=NULL; //Loaded database
+        Col c=COL_INIT; //Opened export
+        ColQry q=COL_QRY_ALL; //Query
+        ColAgg a; //Result
+        const char *file=COL_FILE; //Export file
+        u64 t,v; //Start time, date argument
+        int i=2,lv=COL_AVX2; //Argument index, scan level
+
+        if((argc>1)&&!strcmp(argv[1],"export")){
+                if(argc>2)file=argv[2];
+                syncData(&db);
+                return colWrite(db,file)?1:0;
+        }
+        if((argc<2)||strcmp(argv[1],"scan")){
+                fprintf(stderr,"usage: %s export [file] | scan [-s] [-f file] [from [to [account]]]\n",argv[0]);
+                return 1;
+        }
+        for(;(i<argc)&&(argv[i][0]=='-');i++){ //Options
+                if(!strcmp(argv[i],"-s"))lv=COL_SCALAR;
+                else if(!strcmp(argv[i],"-f")&&(i+1<argc))file=argv[++i];
+                else{fprintf(stderr,"%s: unknown option %s\n",argv[0],argv[i]);return 1;}
+        }
+        if((i<argc)&&(v=strtoull(argv[i++],NULL,10)))q.idLo=v*1000000000ULL; //First ID of the day
+        if((i<argc)&&(v=strtoull(argv[i++],NULL,10)))q.idHi=v*1000000000ULL+999999999ULL; //Last ID of the day
+        if(i<argc)q.accLo=q.accHi=strtoull(argv[i],NULL,10);
+        if(colOpen(&c,file)){perror(file);return 1;}
+        lv=colLevel(lv);
+        t=nowNs();
+        colScan(&c,&q,&a);
+        t=nowNs()-t;
+        printf("%s: %llu rows in %llu blocks; %llu skipped, %llu from the directory, %llu scanned (%llu rows) in %.3f ms (%s)\n",
+                        file,c.h->rows,c.h->blocks,a.skipped,a.whole,a.scanned,a.rows,t/1e6,(lv==COL_AVX2)?"AVX2":"C");
+        printAgg(&a);
+        colClose(&c);
+        return 0;
+}
@@ -0,0 +1,333 @@
+#include "colLib.h" //Includes the colLib.h header file for the export layout and prototypes
+#include "lockLib.h" //Account stripes held while a history head is taken
+#include "wrLib.h" //Buffered writer the export goes through
+#include <pthread.h> //pthread_once for the scan choice
+#include <sys/mman.h> //mmap, madvise
+#include <sys/stat.h> //fstat
+#if defined(__x86_64__)||defined(__i386__)
+#include <immintrin.h> //AVX2 compare intrinsics
+#define COL_X86 1 //x86 vector scan is compiled in
+#endif
+
+typedef struct{ //One account's history being merged
+        Tran *t; //Next (newest unwritten) transaction
+        u64 acc; //Account number
+}Cur;
+
+typedef struct{ //Block being filled, one array per column
+        u64 *acc; //Account numbers
+        u64 *id; //Transaction IDs
+        i64 *amt; //Amounts
+        unsigned char *type; //Type slots
+        u64 n; //Rows filled
+}Blk;
+
+/**
+ * @brief Restores the max-heap order (newest transaction on top) below slot i.
+ * @param h Heap of history cursors.
+ * @param n Cursors in the heap.
+ * @param i Slot that may be out of order.
+ */
+static void siftDown(Cur *h,u64 n,u64 i){
+        Cur c=h[i]; //Cursor being moved down
+        u64 k; //Larger child
+        while((k=2*i+1)<n){
+                if((k+1<n)&&(h[k+1].t->id>h[k].t->id))k++;
+                if(h[k].t->id<=c.t->id)break;
+                h[i]=h[k];
+                i=k;
+        }
+        h[i]=c;
+}
+
+/**
+ * @brief Writes a filled block column by column and appends its directory entry.
+ * @param w Writer.
+ * @param b Block (emptied).
+ * @param dir Directory, grown as needed.
+ * @param nb Entries in dir.
+ * @param cap Room in dir.
+ * @param off File offset of the block, advanced past it.
+ * @return int 0 on success, -1 if the directory could not grow.
+ */
+static int flushBlk(Wr *w,Blk *b,ColBlk **dir,u64 *nb,u64 *cap,u64 *off){
+        static const char zero[8]; //Padding
+        ColBlk *d; //New entry
+        u64 i,pad=(8-(b->n&7))&7; //Row counter, bytes after the type column
+        if(*nb==*cap){
+                u64 nc=*cap?*cap*2:64; //New capacity
+                if(!(d=realloc(*dir,nc*sizeof(ColBlk))))return -1;
+                *dir=d;
+                *cap=nc;
+        }
+        d=&(*dir)[(*nb)++];
+        memset(d,0,sizeof(*d));
+        d->off=*off;
+        d->rows=b->n;
+        d->accMin=d->accMax=b->acc[0];
+        d->idMin=d->idMax=b->id[0];
+        d->amtMin=d->amtMax=b->amt[0];
+        for(i=0;i<b->n;i++){
+                if(b->acc[i]<d->accMin)d->accMin=b->acc[i];
+                if(b->acc[i]>d->accMax)d->accMax=b->acc[i];
+                if(b->id[i]<d->idMin)d->idMin=b->id[i];
+                if(b->id[i]>d->idMax)d->idMax=b->id[i];
+                if(b->amt[i]<d->amtMin)d->amtMin=b->amt[i];
+                if(b->amt[i]>d->amtMax)d->amtMax=b->amt[i];
+                d->cnt[b->type[i]]++;
+                d->sum[b->type[i]]+=b->amt[i];
+        }
+        wrMem(w,(const char*)b->acc,b->n*sizeof(u64));
+        wrMem(w,(const char*)b->id,b->n*sizeof(u64));
+        wrMem(w,(const char*)b->amt,b->n*sizeof(i64));
+        wrMem(w,(const char*)b->type,b->n);
+        wrMem(w,zero,pad);
+        *off+=b->n*(2*sizeof(u64)+sizeof(i64)+1)+pad;
+        b->n=0;
+        return 0;
+}
+
+/**
+ * @brief Writes every account's transactions to a columnar file.
+ * @param head Pointer to the head of the account database.
+ * @param path Output file.
+ * @return int 0 on success, -1 on error.
+ */
+int colWrite(Acc *head,const char *path){
+        char tmp[256]; //Temporary file name
+        Wr w=WR_INIT; //Export
+        ColHdr hd; //Header, written last
+        ColBlk *dir=NULL; //Block directory
+        Cur *h; //Heap of history cursors
+        Blk b; //Block being filled
+        Acc *a; //Account iterator
+        Tran *t; //Transaction being written
+        u64 n=0,i,nb=0,cap=0,rows=0,off=sizeof(ColHdr); //Cursors, counter, blocks, directory room, rows, file offset
+        int err=0; //Set when anything fails
+
+        for(a=head;a;a=a->nxt)n++;
+        snprintf(tmp,sizeof(tmp),"%s.tmp",path);
+        h=malloc((n?n:1)*sizeof(Cur));
+        b.acc=malloc(COL_BLOCK*(2*sizeof(u64)+sizeof(i64)+1));
+        if(!h||!b.acc||wrOpen(&w,tmp,0)){perror("colWrite");free(h);free(b.acc);wrFree(&w);return -1;}
+        b.id=b.acc+COL_BLOCK;
+        b.amt=(i64*)(b.id+COL_BLOCK);
+        b.type=(unsigned char*)(b.amt+COL_BLOCK);
+        b.n=0;
+
+        for(n=0,a=head;a;a=a->nxt){ //One cursor per non-empty history
+                histFetch(a); //Whole history is exported; a lazy one is read without the lock
+                lockAcc(a);
+                h[n].t=a->tranHist; //Linked nodes do not change, the merge needs no lock
+                unlockAcc(a);
+                h[n].acc=a->num;
+                if(h[n].t)n++;
+        }
+        for(i=n/2;i-->0;)siftDown(h,n,i);
+
+        memset(&hd,0,sizeof(hd));
+        wrMem(&w,(const char*)&hd,sizeof(hd)); //Placeholder until the counts are known
+        while(n&&!err){ //Newest transaction of all histories next
+                t=h[0].t;
+                b.acc[b.n]=h[0].acc;
+                b.id[b.n]=t->id;
+                b.amt[b.n]=t->amt;
+                b.type[b.n]=((t->type>=WITHDRAW)&&(t->type<=TRANSFER_OUT))?t->type:0;
+                rows++;
+                if((++b.n==COL_BLOCK)&&flushBlk(&w,&b,&dir,&nb,&cap,&off))err=-1;
+                if(!(h[0].t=t->nxt))h[0]=h[--n]; //History used up
+                if(n)siftDown(h,n,0);
+        }
+        if(!err&&b.n&&flushBlk(&w,&b,&dir,&nb,&cap,&off))err=-1;
+        if(!err)wrMem(&w,(const char*)dir,nb*sizeof(ColBlk));
+
+        memcpy(hd.magic,COL_MAGIC,sizeof(hd.magic));
+        hd.ver=COL_VER;
+        hd.blkSz=sizeof(ColBlk);
+        hd.rows=rows;
+        hd.blocks=nb;
+        hd.dir=off;
+        if(!err&&(wrFlush(&w)||(pwrite(w.fd,&hd,sizeof(hd),0)!=(ssize_t)sizeof(hd))))err=-1;
+        if(wrClose(&w)||err||rename(tmp,path)){perror("colWrite");unlink(tmp);err=-1;}
+        else printf("colWrite: %llu rows, %llu blocks, %llu bytes\n",rows,nb,w.bytes);
+        wrFree(&w);
+        free(dir);
+        free(b.acc);
+        free(h);
+        return err;
+}
+
+/**
+ * @brief Maps an export for scanning.
+ * @param c Handle, closed.
+ * @param path Export file.
+ * @return int 0 on success, -1 on error.
+ */
+int colOpen(Col *c,const char *path){
+        struct stat st; //File size
+        const ColHdr *h; //Header
+        const ColBlk *d; //Directory entry
+        u64 i; //Block counter
+        c->map=NULL;
+        if((c->fd=open(path,O_RDONLY))<0)return -1;
+        errno=0; //Checks below fail with EINVAL
+        if(fstat(c->fd,&st)||((size_t)st.st_size<sizeof(ColHdr)))goto bad;
+        c->size=st.st_size;
+        if((c->map=mmap(NULL,c->size,PROT_READ,MAP_SHARED,c->fd,0))==MAP_FAILED){c->map=NULL;goto bad;}
+        madvise((void*)c->map,c->size,MADV_SEQUENTIAL); //Blocks are read front to back
+        h=(const ColHdr*)c->map;
+        if(memcmp(h->magic,COL_MAGIC,sizeof(h->magic))||(h->ver!=COL_VER)||(h->blkSz!=sizeof(ColBlk)))goto bad;
+        if((h->dir&7)||(h->dir>c->size)||(h->blocks>(c->size-h->dir)/sizeof(ColBlk)))goto bad;
+        d=(const ColBlk*)(c->map+h->dir);
+        for(i=0;i<h->blocks;i++) //Every block must lie between the header and the directory
+                if((d[i].off&7)||(d[i].off<sizeof(ColHdr))||!d[i].rows||(d[i].rows>COL_BLOCK)||
+                                (d[i].off+d[i].rows*(2*sizeof(u64)+sizeof(i64)+1)>h->dir))goto bad;
+        c->h=h;
+        c->dir=d;
+        return 0;
+bad:
+        colClose(c);
+        errno=errno?errno:EINVAL;
+        return -1;
+}
+
+/**
+ * @brief Unmaps and closes an export.
+ * @param c Handle.
+ */
+void colClose(Col *c){
+        if(c->map)munmap((void*)c->map,c->size);
+        if(c->fd>=0)close(c->fd);
+        c->fd=-1;
+        c->map=NULL;
+        c->size=0;
+        c->h=NULL;
+        c->dir=NULL;
+}
+
+/**
+ * @brief Counts and sums the matching rows of a block one row at a time, without branches.
+ * Totals go through 256 slots, so a damaged type byte cannot index past them.
+ * @param acc Account column.
+ * @param id Transaction ID column.
+ * @param amt Amount column.
+ * @param type Type column.
+ * @param n Rows.
+ * @param q Query (lo<=hi).
+ * @param a Result, added to.
+ */
+static void scanScalar(const u64 *acc,const u64 *id,const i64 *amt,const unsigned char *type,u64 n,const ColQry *q,ColAgg *a){
+        u64 cnt[256]={0},i,m,idSpan=q->idHi-q->idLo,accSpan=q->accHi-q->accLo; //Totals per type byte, counter, row mask, range widths
+        i64 sum[256]={0}; //Amounts per type byte
+        int t; //Type slot
+        for(i=0;i<n;i++){
+                m=-(u64)((id[i]-q->idLo<=idSpan)&(acc[i]-q->accLo<=accSpan)); //All ones if the row matches
+                cnt[type[i]]+=m&1;
+                sum[type[i]]+=amt[i]&(i64)m;
+        }
+        for(t=0;t<COL_TYPES;t++){a->cnt[t]+=cnt[t];a->sum[t]+=sum[t];}
+}
+
+#ifdef COL_X86
+/**
+ * @brief Counts and sums the matching rows of a block four rows per compare.
+ * AVX2 only compares signed 64-bit lanes, so values and bounds get their sign bit flipped.
+ * @param acc Account column.
+ * @param id Transaction ID column.
+ * @param amt Amount column.
+ * @param type Type column.
+ * @param n Rows.
+ * @param q Query (lo<=hi).
+ * @param a Result, added to.
+ */
+__attribute__((target("avx2"))) static void scanAvx2(const u64 *acc,const u64 *id,const i64 *amt,const unsigned char *type,u64 n,
+                const ColQry *q,ColAgg *a){
+        const __m256i s=_mm256_set1_epi64x((long long)0x8000000000000000ULL); //Sign flip
+        const __m256i il=_mm256_xor_si256(_mm256_set1_epi64x(q->idLo),s),ih=_mm256_xor_si256(_mm256_set1_epi64x(q->idHi),s); //ID bounds
+        const __m256i al=_mm256_xor_si256(_mm256_set1_epi64x(q->accLo),s),ah=_mm256_xor_si256(_mm256_set1_epi64x(q->accHi),s); //Account bounds
+        __m256i tv[COL_TYPES],cv[COL_TYPES],sv[COL_TYPES],x,y,v,ty,out,m; //Type slots, counts and sums per type, row values, masks
+        long long lane[4]; //One vector's lanes
+        unsigned int tw; //Four type bytes
+        u64 i; //Row counter
+        int t,k; //Type slot, lane
+        for(t=0;t<COL_TYPES;t++){tv[t]=_mm256_set1_epi64x(t);cv[t]=sv[t]=_mm256_setzero_si256();}
+        for(i=0;i+4<=n;i+=4){
+                x=_mm256_xor_si256(_mm256_loadu_si256((const __m256i*)(id+i)),s);
+                y=_mm256_xor_si256(_mm256_loadu_si256((const __m256i*)(acc+i)),s);
+                out=_mm256_or_si256(_mm256_or_si256(_mm256_cmpgt_epi64(il,x),_mm256_cmpgt_epi64(x,ih)),
+                                _mm256_or_si256(_mm256_cmpgt_epi64(al,y),_mm256_cmpgt_epi64(y,ah))); //Lanes outside the query
+                v=_mm256_loadu_si256((const __m256i*)(amt+i));
+                memcpy(&tw,type+i,4);
+                ty=_mm256_cvtepu8_epi64(_mm_cvtsi32_si128(tw));
+                for(t=0;t<COL_TYPES;t++){
+                        m=_mm256_andnot_si256(out,_mm256_cmpeq_epi64(ty,tv[t])); //Matching lanes of this type
+                        cv[t]=_mm256_sub_epi64(cv[t],m); //Mask lanes are -1
+                        sv[t]=_mm256_add_epi64(sv[t],_mm256_and_si256(v,m));
+                }
+        }
+        for(t=0;t<COL_TYPES;t++){
+                _mm256_storeu_si256((__m256i*)lane,cv[t]);
+                for(k=0;k<4;k++)a->cnt[t]+=lane[k];
+                _mm256_storeu_si256((__m256i*)lane,sv[t]);
+                for(k=0;k<4;k++)a->sum[t]+=lane[k];
+        }
+        if(i<n)scanScalar(acc+i,id+i,amt+i,type+i,n-i,q,a); //Last rows
+}
+#endif
+
+static void (*scan)(const u64*,const u64*,const i64*,const unsigned char*,u64,const ColQry*,ColAgg*)=scanScalar; //Block scan in use
+static int level=COL_SCALAR; //Its COL_* level
+static pthread_once_t picked=PTHREAD_ONCE_INIT; //Default chosen by the first colScan
+static int chosen; //Set by colLevel, a level picked before the first colScan stays
+
+/**
+ * @brief Selects the block scan.
+ * @param want Highest level to use.
+ * @return int The level in use.
+ */
+int colLevel(int want){
+        scan=scanScalar;
+        level=COL_SCALAR;
+#ifdef COL_X86
+        __builtin_cpu_init(); //CPU feature bits for __builtin_cpu_supports
+        if((want>=COL_AVX2)&&__builtin_cpu_supports("avx2")){scan=scanAvx2;level=COL_AVX2;}
+#endif
+        chosen=1;
+        return level;
+}
+
+/**
+ * @brief Picks the best scan the CPU has (run once).
+ */
+static void pickBest(void){
+        if(!chosen)colLevel(COL_AVX2);
+}
+
+/**
+ * @brief Counts and sums, by type, the rows matching a query.
+ * @param c Open export.
+ * @param q Query.
+ * @param a Result.
+ */
+void colScan(const Col *c,const ColQry *q,ColAgg *a){
+        const ColBlk *b; //Directory entry
+        const u64 *col; //First column of a block
+        u64 i; //Block counter
+        int t; //Type slot
+        memset(a,0,sizeof(*a));
+        pthread_once(&picked,pickBest);
+        if((q->idLo>q->idHi)||(q->accLo>q->accHi)){a->skipped=c->h->blocks;return;} //Empty query
+        for(i=0;i<c->h->blocks;i++){
+                b=&c->dir[i];
+                if((b->idMax<q->idLo)||(b->idMin>q->idHi)||(b->accMax<q->accLo)||(b->accMin>q->accHi)){a->skipped++;continue;}
+                if((b->idMin>=q->idLo)&&(b->idMax<=q->idHi)&&(b->accMin>=q->accLo)&&(b->accMax<=q->accHi)){ //Every row matches
+                        for(t=0;t<COL_TYPES;t++){a->cnt[t]+=b->cnt[t];a->sum[t]+=b->sum[t];}
+                        a->whole++;
+                        continue;
+                }
+                col=(const u64*)(c->map+b->off);
+                scan(col,col+b->rows,(const i64*)(col+2*b->rows),(const unsigned char*)(col+3*b->rows),b->rows,q,a);
+                a->scanned++;
+                a->rows+=b->rows;
+        }
+}
@@ -0,0 +1,119 @@
+#ifndef _COLLIB_H //If _COLLIB_H is not defined
+#define _COLLIB_H //Define _COLLIB_H to prevent multiple inclusions of this header file
+
+/*
+ * colLib.h
+ *
+ * Columnar export of the whole transaction ledger for analysis
+ * (../filez/Ledger.col), so a question about all accounts reads one file
+ * instead of a statement per account.
+ * Layout: ColHdr, then blocks of up to COL_BLOCK rows, then the block
+ * directory (one ColBlk per block). A block holds its rows column by column:
+ * account numbers (u64), transaction IDs (u64, YYYYMMDDHHMMSSRRR, so they
+ * double as time stamps), amounts (i64 paise) and types (one byte each),
+ * padded to 8 bytes. Rows are in transaction ID order, newest first, merged
+ * from the per-account histories, so the ID range of a block is narrow.
+ * Each ColBlk carries the min/max of every column and the count and sum of
+ * every type: colScan skips blocks outside a query and answers blocks wholly
+ * inside it from the directory; only blocks cut by the query are scanned,
+ * in one pass with AVX2 (4 rows per compare) or plain C, picked at run time.
+ * The format is machine specific (native byte order), like Db.snap.
+ */
+
+#include "atmLib.h" //Acc, Tran, u64, i64
+
+#define COL_FILE  "../filez/Ledger.col" //Default export file
+#define COL_MAGIC "ATMCOL1" //First 8 bytes of every export (with the null terminator)
+#define COL_VER   1 //Format version
+#define COL_BLOCK 65536 //Most rows per block
+#define COL_TYPES 5 //Type slots: 0 for an unknown type, then WITHDRAW..TRANSFER_OUT
+
+#define COL_SCALAR 0 //Block scan in plain C
+#define COL_AVX2 1 //4 rows per compare
+
+typedef struct{ //Export file header
+        char magic[8]; //COL_MAGIC
+        unsigned int ver; //COL_VER
+        unsigned int blkSz; //sizeof(ColBlk) of the writer
+        u64 rows; //Rows in the file
+        u64 blocks; //Blocks in the file
+        u64 dir; //Offset of the block directory
+}ColHdr;
+
+typedef struct{ //Directory entry of one block
+        u64 off; //Offset of the block's first column
+        u64 rows; //Rows in the block
+        u64 accMin,accMax; //Account number range
+        u64 idMin,idMax; //Transaction ID (time stamp) range
+        i64 amtMin,amtMax; //Amount range
+        u64 cnt[COL_TYPES]; //Rows of every type
+        i64 sum[COL_TYPES]; //Amount total of every type
+}ColBlk;
+
+typedef struct{ //Export opened for scanning
+        int fd; //File, -1 when closed
+        const char *map; //Read-only mapping of the whole file
+        size_t size; //Bytes mapped
+        const ColHdr *h; //Header
+        const ColBlk *dir; //Block directory
+}Col;
+
+#define COL_INIT {-1,NULL,0,NULL,NULL} //Static initializer, nothing open
+
+typedef struct{ //Rows a scan counts (bounds included)
+        u64 idLo,idHi; //Transaction ID range; YYYYMMDD*1000000000 starts a day
+        u64 accLo,accHi; //Account number range
+}ColQry;
+
+#define COL_QRY_ALL {0,~0ULL,0,~0ULL} //Every row
+
+typedef struct{ //Result of a scan
+        u64 cnt[COL_TYPES]; //Matching rows of every type
+        i64 sum[COL_TYPES]; //Amount total of every type
+        u64 skipped; //Blocks outside the query
+        u64 whole; //Blocks answered from the directory
+        u64 scanned; //Blocks read row by row
+        u64 rows; //Rows read
+}ColAgg;
+
+/**
+ * @brief Writes every account's transactions to a columnar file (via a temporary file and rename).
+ * Each account is locked only while its history head is taken (or a lazily loaded history
+ * is linked in, see histFetch), so it may run next to requests.
+ * Prints how many rows, blocks and bytes were written.
+ * @param head Pointer to the head of the account database.
+ * @param path Output file, e.g. COL_FILE.
+ * @return int 0 on success, -1 on error (an existing file is kept).
+ */
+int colWrite(Acc *head,const char *path);
+
+/**
+ * @brief Maps an export for scanning and checks its header and directory.
+ * @param c Handle, closed.
+ * @param path Export file.
+ * @return int 0 on success, -1 if the file is missing, damaged or from another build.
+ */
+int colOpen(Col *c,const char *path);
+
+/**
+ * @brief Unmaps and closes an export.
+ * @param c Handle.
+ */
+void colClose(Col *c);
+
+/**
+ * @brief Selects the block scan; by default the best one the CPU has is used.
+ * @param want COL_AVX2 or COL_SCALAR.
+ * @return int The level in use, `want` or COL_SCALAR if the CPU lacks AVX2.
+ */
+int colLevel(int want);
+
+/**
+ * @brief Counts and sums, by type, the rows matching a query.
+ * @param c Open export.
+ * @param q Query.
+ * @param a Result (cleared first).
+ */
+void colScan(const Col *c,const ColQry *q,ColAgg *a);
+
+#endif //End of _COLLIB_H guard
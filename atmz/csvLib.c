@@ -0,0 +1,329 @@
+#include "csvLib.h" //Includes the csvLib.h header file for the Csv structure and prototypes
+#include <pthread.h> //pthread_once, loader threads open files concurrently
+#if defined(__x86_64__)||defined(__i386__)
+#include <immintrin.h> //SSE2 and AVX2 compare/movemask intrinsics
+#define CSV_X86 1 //x86 vector scans are compiled in
+#endif
+
+/**
+ * @brief Classifies 64 bytes one at a time.
+ * @param p First byte.
+ * @return u64 Bit i set if p[i] is ',' or '\n'.
+ */
+static u64 scanScalar(const char *p){
+        u64 m=0; //Result
+        int i; //Byte index
+        for(i=0;i<64;i++)if((p[i]==',')||(p[i]=='\n'))m|=1ULL<<i;
+        return m;
+}
+
+#ifdef CSV_X86
+/**
+ * @brief Classifies 64 bytes as four 16-byte SSE2 compares.
+ * @param p First byte (no alignment needed).
+ * @return u64 Bit i set if p[i] is ',' or '\n'.
+ */
+__attribute__((target("sse2"))) static u64 scanSse2(const char *p){
+        const __m128i cm=_mm_set1_epi8(','),nl=_mm_set1_epi8('\n'); //Delimiters in every lane
+        __m128i v; //16 bytes of input
+        u64 m=0; //Result
+        int i; //Quarter
+        for(i=0;i<4;i++){
+                v=_mm_loadu_si128((const __m128i*)(p+16*i));
+                m|=(u64)(unsigned int)_mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(v,cm),_mm_cmpeq_epi8(v,nl)))<<(16*i);
+        }
+        return m;
+}
+
+/**
+ * @brief Classifies 64 bytes as two 32-byte AVX2 compares.
+ * @param p First byte (no alignment needed).
+ * @return u64 Bit i set if p[i] is ',' or '\n'.
+ */
+__attribute__((target("avx2"))) static u64 scanAvx2(const char *p){
+        const __m256i cm=_mm256_set1_epi8(','),nl=_mm256_set1_epi8('\n'); //Delimiters in every lane
+        __m256i lo=_mm256_loadu_si256((const __m256i*)p),hi=_mm256_loadu_si256((const __m256i*)(p+32)); //Both halves
+        u64 a=(unsigned int)_mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpeq_epi8(lo,cm),_mm256_cmpeq_epi8(lo,nl)));
+        u64 b=(unsigned int)_mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpeq_epi8(hi,cm),_mm256_cmpeq_epi8(hi,nl)));
+        return a|(b<<32);
+}
+#endif
+
+static u64 (*scan)(const char*)=scanScalar; //Delimiter scan in use
+static int level=CSV_SCALAR; //Its CSV_* level
+static pthread_once_t picked=PTHREAD_ONCE_INIT; //Default chosen by the first csvOpen
+static int chosen; //Set by csvLevel, a level picked before the first csvOpen stays
+
+/**
+ * @brief Selects the delimiter scan.
+ * @param want Highest level to use.
+ * @return int The level in use.
+ */
+int csvLevel(int want){
+        scan=scanScalar;
+        level=CSV_SCALAR;
+#ifdef CSV_X86
+        __builtin_cpu_init(); //CPU feature bits for __builtin_cpu_supports
+        if((want>=CSV_AVX2)&&__builtin_cpu_supports("avx2")){scan=scanAvx2;level=CSV_AVX2;}
+        else if((want>=CSV_SSE2)&&__builtin_cpu_supports("sse2")){scan=scanSse2;level=CSV_SSE2;}
+#endif
+        chosen=1;
+        return level;
+}
+
+/**
+ * @brief Picks the best scan the CPU has (run once).
+ */
+static void pickBest(void){
+        if(!chosen)csvLevel(CSV_AVX2);
+}
+
+/**
+ * @brief Classifies the 64 bytes at c->blk, dropping bits past the data and before pos.
+ * @param c Reader.
+ */
+static void classify(Csv *c){
+        size_t end=c->len-c->blk; //Data bytes in the block
+        c->mask=scan(c->buf+c->blk); //The padding makes the last block readable whole
+        if(end<64)c->mask&=(1ULL<<end)-1;
+        if(c->pos>c->blk)c->mask&=(c->pos-c->blk<64)?~0ULL<<(c->pos-c->blk):0;
+}
+
+/**
+ * @brief Keeps the bytes from `keep` on and reads more after them.
+ * @param c Reader.
+ * @param keep Start of the field being cut.
+ * @return int 0 if bytes were added or the end of file was seen, -1 on error.
+ */
+static int fill(Csv *c,size_t keep){
+        ssize_t r; //Result of read
+        if(!keep&&(c->len==CSV_BUF)){c->err=E2BIG;return -1;} //One field fills the buffer
+        if(keep){ //Moves the unfinished field to the front
+                memmove(c->buf,c->buf+keep,c->len-keep);
+                c->len-=keep;
+                c->pos-=keep;
+                c->blk=(c->blk>keep)?c->blk-keep:0;
+        }
+        while(((r=read(c->fd,c->buf+c->len,CSV_BUF-c->len))<0)&&(errno==EINTR));
+        if(r<0){c->err=errno;return -1;}
+        if(!r)c->eof=1;
+        c->len+=r;
+        c->bytes+=r;
+        classify(c); //The block at blk may have gained bytes
+        return 0;
+}
+
+/**
+ * @brief Finds the next delimiter at or after pos in the buffered bytes.
+ * @param c Reader.
+ * @return size_t Its offset, c->len if the buffer has none.
+ */
+static size_t delim(Csv *c){
+        for(;;){
+                if(c->mask)return c->blk+__builtin_ctzll(c->mask);
+                if(c->blk+64>=c->len)return c->len; //fill reclassifies this block
+                c->blk+=64;
+                classify(c);
+        }
+}
+
+/**
+ * @brief Opens a file for reading and reads its first block.
+ * @param c Reader, closed.
+ * @param path File name.
+ * @return int 0 on success, -1 on error (errno set).
+ */
+int csvOpen(Csv *c,const char *path){
+        pthread_once(&picked,pickBest);
+        if(!c->buf&&!(c->buf=calloc(1,CSV_BUF+CSV_PAD)))return -1; //First file of this reader; the padding stays zero
+        if((c->fd=open(path,O_RDONLY))<0)return -1;
+        c->eof=c->err=0;
+        c->len=c->pos=c->blk=0;
+        c->bytes=0;
+        if(fill(c,0)){errno=c->err;csvClose(c);return -1;}
+        return 0;
+}
+
+/**
+ * @brief Closes the file; the buffer is kept.
+ * @param c Reader.
+ */
+void csvClose(Csv *c){
+        if(c->fd>=0)close(c->fd);
+        c->fd=-1;
+}
+
+/**
+ * @brief Releases the buffer of a closed reader.
+ * @param c Reader.
+ */
+void csvFree(Csv *c){
+        free(c->buf);
+        c->buf=NULL;
+}
+
+/**
+ * @brief Skips the first line if it is exactly `line` (a '\r' may precede its '\n').
+ * @param c Reader, just opened.
+ * @param line Expected line, without its '\n'.
+ * @return int 1 if skipped, 0 otherwise.
+ */
+int csvLine(Csv *c,const char *line){
+        size_t k=strlen(line); //Line length
+        if((c->len-c->pos<=k)||memcmp(c->buf+c->pos,line,k))return 0;
+        if((c->buf[c->pos+k]=='\r')&&(c->len-c->pos>k+1))k++; //CRLF line end
+        if(c->buf[c->pos+k]!='\n')return 0;
+        c->pos+=k+1;
+        classify(c);
+        return 1;
+}
+
+/**
+ * @brief Takes the next field.
+ * @param c Reader.
+ * @param s First byte of the field.
+ * @param n Field length.
+ * @return int ',' or '\n', CSV_END at end of file, CSV_ERR on error.
+ */
+int csvFld(Csv *c,const char **s,size_t *n){
+        size_t i; //Delimiter offset
+        for(;;){
+                if(c->mask){i=c->blk+__builtin_ctzll(c->mask);break;} //Usual case: the block has one
+                if((i=delim(c))<c->len)break;
+                if(c->eof||c->err||fill(c,c->pos)){ //Rest of the file is the field
+                        *s=c->buf+c->pos;
+                        *n=c->len-c->pos;
+                        c->pos=c->len;
+                        return c->err?CSV_ERR:CSV_END;
+                }
+        }
+        *s=c->buf+c->pos;
+        *n=i-c->pos;
+        c->pos=i+1;
+        c->mask&=c->mask-1; //Delimiter taken
+        if((c->buf[i]=='\n')&&*n&&((*s)[*n-1]=='\r'))(*n)--; //CRLF line end
+        return c->buf[i];
+}
+
+/**
+ * @brief Converts a field of decimal digits.
+ * @param s Field.
+ * @param n Field length.
+ * @param v Value.
+ * @return int 0 on success, -1 otherwise.
+ */
+int csvU64(const char *s,size_t n,u64 *v){
+        u64 r=0; //Value so far
+        unsigned int d; //Digit
+        size_t i; //Character index
+        if(!n||(n>20)||((n==20)&&(memcmp(s,"18446744073709551615",20)>0)))return -1; //19 digits always fit
+        for(i=0;i<n;i++){
+                if((d=(unsigned char)s[i]-'0')>9)return -1;
+                r=r*10+d;
+        }
+        *v=r;
+        return 0;
+}
+
+/**
+ * @brief Converts a field holding an optionally negative decimal int.
+ * @param s Field.
+ * @param n Field length.
+ * @param v Value.
+ * @return int 0 on success, -1 otherwise.
+ */
+int csvInt(const char *s,size_t n,int *v){
+        u64 m; //Magnitude
+        int neg=n&&(s[0]=='-'); //Sign
+        if(csvU64(s+neg,n-neg,&m)||(m>(neg?2147483648ULL:2147483647ULL)))return -1;
+        *v=neg?(int)(0-m):(int)m;
+        return 0;
+}
+
+/**
+ * @brief Copies a non-empty field into a string buffer.
+ * @param s Field.
+ * @param n Field length.
+ * @param d Destination.
+ * @param cap Size of d.
+ * @return int 0 on success, -1 otherwise.
+ */
+int csvStr(const char *s,size_t n,char *d,size_t cap){
+        if(!n||(n>=cap))return -1;
+        memcpy(d,s,n);
+        d[n]='\0';
+        return 0;
+}
+
+/**
+ * @brief Takes one field that must end with the expected delimiter.
+ * @param c Reader.
+ * @param s Field.
+ * @param n Field length.
+ * @param last Non-zero for the last field of a record ('\n', or the end of file if `eofOk`).
+ * @param eofOk Non-zero if a last record may lack its '\n'.
+ * @return int 0 if the delimiter is right, -1 otherwise.
+ */
+static int field(Csv *c,const char **s,size_t *n,int last,int eofOk){
+        int d=csvFld(c,s,n); //Delimiter
+        if(!last)return (d==',')?0:-1;
+        return ((d=='\n')||(eofOk&&(d==CSV_END)&&*n))?0:-1;
+}
+
+/**
+ * @brief Takes the first field of a record, skipping blank lines.
+ * @param c Reader.
+ * @param s Field.
+ * @param n Field length.
+ * @return int 1 for a field ended by ',', 0 at end of file, -1 otherwise.
+ */
+static int first(Csv *c,const char **s,size_t *n){
+        int d; //Delimiter
+        while(((d=csvFld(c,s,n))=='\n')&&!*n); //Blank lines
+        if((d==CSV_END)&&!*n)return 0;
+        return (d==',')?1:-1;
+}
+
+/**
+ * @brief Reads one Db.csv record.
+ * @param c Reader.
+ * @param a Account.
+ * @return int 1, 0 at end of file, -1 if malformed.
+ */
+int csvAcc(Csv *c,Acc *a){
+        const char *s; //Field
+        size_t n; //Field length
+        int r=first(c,&s,&n); //First field
+        if(r<=0)return r;
+        if(csvU64(s,n,&a->num)||
+                        field(c,&s,&n,0,0)||csvStr(s,n,a->name,sizeof(a->name))||
+                        field(c,&s,&n,0,0)||csvU64(s,n,&a->phno)||
+                        field(c,&s,&n,0,0)||csvStr(s,n,a->usrName,sizeof(a->usrName))||
+                        field(c,&s,&n,0,0)||csvStr(s,n,a->pass,sizeof(a->pass))||
+                        field(c,&s,&n,0,0)||csvStr(s,n,a->rfid,sizeof(a->rfid))||
+                        field(c,&s,&n,0,0)||csvStr(s,n,a->pin,sizeof(a->pin))||
+                        field(c,&s,&n,0,0)||csvInt(s,n,&a->cardStat)||
+                        field(c,&s,&n,0,0)||monParse(s,n,&a->bal)||
+                        field(c,&s,&n,1,1)||csvU64(s,n,&a->tranCnt))
+                return -1;
+        return 1;
+}
+
+/**
+ * @brief Reads one history record.
+ * @param c Reader.
+ * @param t Transaction.
+ * @return int 1, 0 at end of file, -1 if malformed or cut.
+ */
+int csvTran(Csv *c,Tran *t){
+        const char *s; //Field
+        size_t n; //Field length
+        int r=first(c,&s,&n); //First field
+        if(r<=0)return r;
+        if(csvU64(s,n,&t->id)||
+                        field(c,&s,&n,0,0)||monParse(s,n,&t->amt)||
+                        field(c,&s,&n,1,0)||(n!=1))
+                return -1;
+        t->type=s[0]; //Type is one raw byte (WITHDRAW .. TRANSFER_OUT)
+        return 1;
+}
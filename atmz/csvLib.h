@@ -0,0 +1,139 @@
+#ifndef _CSVLIB_H //If _CSVLIB_H is not defined
+#define _CSVLIB_H //Define _CSVLIB_H to prevent multiple inclusions of this header file
+
+/*
+ * csvLib.h
+ *
+ * Vectorized CSV reader for Db.csv and the history files, replacing the
+ * fscanf("%[^,]") loops of loadCsv and loadHist.
+ * The file is read CSV_BUF bytes per read() into one buffer. The buffer is
+ * classified 64 bytes at a time into a bit mask of ',' and '\n' positions,
+ * with AVX2 (two 32-byte compares), SSE2 (four 16-byte compares) or plain C,
+ * picked once at run time from what the CPU has; fields are then cut at the
+ * set bits (count trailing zeros) without looking at their bytes again.
+ * A field is a (pointer,length) view into the buffer, valid until the next
+ * call; the typed parsers convert it in place: csvU64, csvInt, csvStr and
+ * monParse for amounts. csvAcc and csvTran read one record of the Db.csv and
+ * history layouts.
+ * Like Wr, the buffer comes with the first csvOpen and is kept by later ones,
+ * so one Csv reads a file per account without a malloc per file.
+ */
+
+#include "atmLib.h" //Acc, Tran, u64
+
+#define CSV_BUF (64<<10) //Bytes per read() system call, also the longest field
+#define CSV_PAD 64 //Slack after the buffer, the last block is classified whole
+
+#define CSV_END 0 //csvFld: end of file
+#define CSV_ERR -1 //csvFld: read error, or a field longer than CSV_BUF
+
+#define CSV_SCALAR 0 //Delimiter scan in plain C
+#define CSV_SSE2 1 //16 bytes per compare
+#define CSV_AVX2 2 //32 bytes per compare
+
+typedef struct{ //One input file being read
+        int fd; //Source file, -1 when closed
+        int eof; //Set once read() returned 0
+        int err; //errno of a failed read, E2BIG for an oversized field, 0 if none
+        char *buf; //Input buffer (CSV_BUF+CSV_PAD bytes), kept across files until csvFree
+        size_t len; //Bytes in buf
+        size_t pos; //Start of the next field
+        size_t blk; //Offset of the 64 bytes `mask` covers
+        u64 mask; //Delimiters at blk+bit, the ones before pos already taken
+        u64 bytes; //Bytes read since csvOpen
+}Csv;
+
+#define CSV_INIT {-1,0,0,NULL,0,0,0,0,0} //Static initializer, no buffer yet
+
+/**
+ * @brief Selects the delimiter scan; by default the best one the CPU has is used.
+ * @param want CSV_AVX2, CSV_SSE2 or CSV_SCALAR.
+ * @return int The level in use, `want` or the best one below it the CPU supports.
+ */
+int csvLevel(int want);
+
+/**
+ * @brief Opens a file for reading and reads its first block.
+ * @param c Reader, closed.
+ * @param path File name.
+ * @return int 0 on success, -1 if the file or the buffer could not be had (errno set).
+ */
+int csvOpen(Csv *c,const char *path);
+
+/**
+ * @brief Closes the file; the buffer is kept for the next csvOpen.
+ * @param c Reader.
+ */
+void csvClose(Csv *c);
+
+/**
+ * @brief Releases the buffer of a closed reader.
+ * @param c Reader.
+ */
+void csvFree(Csv *c);
+
+/**
+ * @brief Skips the first line of a freshly opened file if it is exactly `line` (a '\r' may precede its '\n').
+ * @param c Reader, just opened.
+ * @param line Expected line, without its '\n'.
+ * @return int 1 if the line was there and skipped, 0 otherwise (nothing consumed).
+ */
+int csvLine(Csv *c,const char *line);
+
+/**
+ * @brief Takes the next field. A '\r' before the '\n' is not part of the field.
+ * @param c Reader.
+ * @param s First byte of the field (not null-terminated), valid until the next call.
+ * @param n Length of the field.
+ * @return int ',' or '\n' for the delimiter that ended the field, CSV_END at end of file
+ * (n>0 for a last line without '\n'), CSV_ERR on error.
+ */
+int csvFld(Csv *c,const char **s,size_t *n);
+
+/**
+ * @brief Converts a field of 1 to 20 decimal digits, like "%llu" without sign or blanks.
+ * @param s Field.
+ * @param n Field length.
+ * @param v Value.
+ * @return int 0 on success, -1 if the field is not a number or overflows.
+ */
+int csvU64(const char *s,size_t n,u64 *v);
+
+/**
+ * @brief Converts a field holding an optionally negative decimal int, like "%d".
+ * @param s Field.
+ * @param n Field length.
+ * @param v Value.
+ * @return int 0 on success, -1 if the field is not a number or overflows.
+ */
+int csvInt(const char *s,size_t n,int *v);
+
+/**
+ * @brief Copies a non-empty field into a string buffer, like "%[^,]" bounded by the buffer.
+ * @param s Field.
+ * @param n Field length.
+ * @param d Destination.
+ * @param cap Size of d, the null included.
+ * @return int 0 on success, -1 if the field is empty or does not fit.
+ */
+int csvStr(const char *s,size_t n,char *d,size_t cap);
+
+/**
+ * @brief Reads one Db.csv record: num,name,phno,usrName,pass,rfid,pin,cardStat,bal,tranCnt.
+ * Blank lines are skipped; a last record without '\n' is accepted.
+ * @param c Reader.
+ * @param a Account the fields are stored in (other fields are left alone).
+ * @return int 1 for a record, 0 at end of file, -1 for a malformed record or a read error.
+ */
+int csvAcc(Csv *c,Acc *a);
+
+/**
+ * @brief Reads one history record: id,amount,type.
+ * Blank lines are skipped; a last record without '\n' (cut by a crash) is malformed.
+ * @param c Reader.
+ * @param t Transaction the fields are stored in (nxt is left alone).
+ * @return int 1 for a record, 0 at end of file, -1 for a malformed record or a read error.
+ */
+int csvTran(Csv *c,Tran *t);
+
+#endif //End of _CSVLIB_H guard
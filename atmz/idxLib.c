@@ -0,0 +1,144 @@
+#include "idxLib.h" //Includes the idxLib.h header file for the index structure and prototypes
+
+/**
+ * @brief Mixes the bits of a packed RFID key (splitmix64 finalizer).
+ * Card numbers are handed out in sequence, so the raw key would cluster badly.
+ * @param k Packed RFID key.
+ * @return u64 Well distributed hash value.
+ */
+static u64 mix(u64 k){
+        k^=k>>30; k*=0xbf58476d1ce4e5b9ULL; //First xor-shift-multiply round
+        k^=k>>27; k*=0x94d049bb133111ebULL; //Second xor-shift-multiply round
+        return k^(k>>31); //Final xor-shift
+}
+
+/**
+ * @brief Packs an 8 character RFID string into a u64 key.
+ * Every byte of the card number is kept, so two different cards never share a key.
+ * @param rfid The RFID string (8 chars + null terminator).
+ * @return u64 Packed key, never 0 for a non-empty RFID.
+ */
+u64 idxKey(const char *rfid){
+        u64 k=0; //Packed key
+        int i; //Byte index
+        for(i=0;i<8&&rfid[i];i++) //Copies up to 8 characters, stopping early on short strings
+                k|=((u64)(unsigned char)rfid[i])<<(8*i); //Places character i in byte i of the key
+        return k; //Returns the packed key
+}
+
+/**
+ * @brief Allocates an empty index sized for at least 'hint' cards at a load factor of 1/2.
+ * @param idx Index to initialize.
+ * @param hint Expected number of cards.
+ * @return int 0 on success, -1 on allocation failure.
+ */
+int idxInit(Idx *idx,u64 hint){
+        u64 cap=IDX_MIN_CAP; //Table size, doubled until it fits twice the hint
+        while(cap<hint*2)cap<<=1; //Keeps the table at most half full
+        idx->key=calloc(cap,sizeof(u64)); //Zeroed keys mean every slot starts empty
+        idx->val=calloc(cap,sizeof(Acc*)); //Account pointers for each slot
+        if(!idx->key||!idx->val){ //If either allocation failed
+                free(idx->key); free(idx->val); //Releases whichever part was allocated
+                idx->key=NULL; idx->val=NULL; idx->cap=idx->cnt=0; //Leaves the index in the "not built" state
+                return -1; //Reports the failure
+        }
+        idx->cap=cap; //Records the table size
+        idx->cnt=0; //No entries yet
+        return 0; //Success
+}
+
+/**
+ * @brief Releases the memory of an index. The indexed accounts are not touched.
+ * @param idx Index to release.
+ */
+void idxFree(Idx *idx){
+        free(idx->key); //Frees the key array
+        free(idx->val); //Frees the value array
+        idx->key=NULL; idx->val=NULL; //Clears dangling pointers
+        idx->cap=idx->cnt=0; //Marks the index as not built
+}
+
+/**
+ * @brief Finds the slot holding 'k', or the empty slot where it would be inserted.
+ * @param idx Index to probe.
+ * @param k Packed RFID key.
+ * @return u64 Slot number.
+ */
+static u64 probe(const Idx *idx,u64 k){
+        u64 m=idx->cap-1; //Mask for wrapping around the table
+        u64 i=mix(k)&m; //Home slot of the key
+        while(idx->key[i]&&idx->key[i]!=k) //Walks forward over slots used by other keys
+                i=(i+1)&m; //Linear probing with wrap-around
+        return i; //Slot holding the key, or the first empty slot
+}
+
+/**
+ * @brief Doubles the table and reinserts every entry.
+ * @param idx Index to grow.
+ * @return int 0 on success, -1 on allocation failure (the old table stays valid).
+ */
+static int grow(Idx *idx){
+        Idx big; //New, larger table
+        u64 i; //Slot counter over the old table
+        if(idxInit(&big,idx->cap))return -1; //cap entries at load 1/2 gives a table twice as large
+        for(i=0;i<idx->cap;i++){ //Moves every used slot into the new table
+                if(!idx->key[i])continue; //Skips empty slots
+                u64 j=probe(&big,idx->key[i]); //Finds the slot in the new table
+                big.key[j]=idx->key[i]; //Copies the key
+                big.val[j]=idx->val[i]; //Copies the account pointer
+        }
+        big.cnt=idx->cnt; //Entry count is unchanged
+        idxFree(idx); //Releases the old table
+        *idx=big; //Installs the new table
+        return 0; //Success
+}
+
+/**
+ * @brief Inserts or replaces the entry for usr->rfid.
+ * @param idx Index to update.
+ * @param usr Account to index.
+ * @return int 0 on success, -1 on allocation failure.
+ */
+static int idxPut(Idx *idx,Acc *usr){
+        u64 k=idxKey(usr->rfid),i; //Packed key and its slot
+        if(!k)return 0; //Accounts without a card are not indexed
+        if(!idx->cap&&idxInit(idx,0))return -1; //Builds an empty table on first use
+        if((idx->cnt+1)*2>idx->cap&&grow(idx))return -1; //Keeps the load factor at or below 1/2
+        i=probe(idx,k); //Finds the slot for the key
+        if(!idx->key[i]){ //New card
+                idx->key[i]=k; //Claims the empty slot
+                idx->cnt++; //Counts the new entry
+        }
+        idx->val[i]=usr; //Points the card at the account (replaces a stale entry)
+        return 0; //Success
+}
+
+/**
+ * @brief Looks up the account holding an RFID.
+ * @param idx Index to search.
+ * @param rfid The RFID string to search for.
+ * @return Acc* Pointer to the account, or NULL if the card is unknown.
+ */
+Acc* idxGet(const Idx *idx,const char *rfid){
+        u64 k=idxKey(rfid),i; //Packed key and its slot
+        if(!idx->cap||!k)return NULL; //Empty index or empty card number
+        i=probe(idx,k); //Finds the key or the empty slot ending its probe run
+        return idx->key[i]?idx->val[i]:NULL; //Returns the account if the key was found
+}
+
+/**
+ * @brief (Re)builds the index from a linked list of accounts.
+ * @param idx Index to build (previous contents are released).
+ * @param head Pointer to the head of the account list.
+ * @return int 0 on success, -1 on allocation failure.
+ */
+int idxBuild(Idx *idx,Acc *head){
+        u64 n=0; //Number of accounts in the list
+        Acc *a; //Account iterator
+        for(a=head;a;a=a->nxt)n++; //Counts the accounts to size the table once
+        idxFree(idx); //Drops any previous table
+        if(idxInit(idx,n))return -1; //Allocates a table for all cards
+        for(a=head;a;a=a->nxt) //Indexes every account
+                if(idxPut(idx,a))return -1; //Stops on allocation failure
+        return 0; //Success
+}
@@ -0,0 +1,65 @@
+#ifndef _IDXLIB_H //If _IDXLIB_H is not defined
+#define _IDXLIB_H //Define _IDXLIB_H to prevent multiple inclusions of this header file
+
+/*
+ * idxLib.h
+ *
+ * RFID index for the ATM backend.
+ * An open addressing (linear probing) hash table that maps the 8 character
+ * RFID, packed into a u64 key, to the Acc node holding that card.
+ * Replaces the full list walk of getAcc() with an O(1) lookup.
+ * Built once by syncData: the ATM never issues or replaces a card (the bank
+ * does, and the ATM picks it up at its next start), so entries never change.
+ */
+
+#include "atmLib.h" //Acc, u64
+
+#define IDX_MIN_CAP 1024 //Smallest table size (must be a power of two)
+
+typedef struct{ //Structure holding one RFID index
+        u64 *key; //Packed RFID keys, 0 marks an empty slot
+        Acc **val; //Account for the key in the same slot
+        u64 cap; //Number of slots (power of two), 0 when the index is not built
+        u64 cnt; //Number of used slots
+}Idx;
+
+extern Idx rfIdx; //Index over all loaded accounts, built by syncData and used by getAcc
+
+/**
+ * @brief Packs an 8 character RFID string into a u64 key.
+ * @param rfid The RFID string (8 chars + null terminator).
+ * @return u64 Packed key, never 0 for a non-empty RFID.
+ */
+u64 idxKey(const char *rfid);
+
+/**
+ * @brief Allocates an empty index sized for at least 'hint' cards.
+ * @param idx Index to initialize.
+ * @param hint Expected number of cards.
+ * @return int 0 on success, -1 on allocation failure.
+ */
+int idxInit(Idx *idx,u64 hint);
+
+/**
+ * @brief Releases the memory of an index (the accounts are not touched).
+ * @param idx Index to release.
+ */
+void idxFree(Idx *idx);
+
+/**
+ * @brief (Re)builds the index from a linked list of accounts.
+ * @param idx Index to build (previous contents are released).
+ * @param head Pointer to the head of the account list.
+ * @return int 0 on success, -1 on allocation failure.
+ */
+int idxBuild(Idx *idx,Acc *head);
+
+/**
+ * @brief Looks up the account holding an RFID.
+ * @param idx Index to search.
+ * @param rfid The RFID string to search for.
+ * @return Acc* Pointer to the account, or NULL if the card is unknown.
+ */
+Acc* idxGet(const Idx *idx,const char *rfid);
+
+#endif //End of _IDXLIB_H guard
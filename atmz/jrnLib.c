@@ -0,0 +1,256 @@
+#include "jrnLib.h" //Includes the jrnLib.h header file for journal settings and prototypes
+#include "snapLib.h" //Binary snapshot written by the checkpoint
+#include "lockLib.h" //Account stripes, all held while the snapshot child is forked
+#include "poolLib.h" //Slab the replayed transaction nodes come from
+#include "rollLib.h" //Rollups the replayed transactions are added to
+#include <sys/wait.h> //waitpid for reaping the snapshot child
+
+static int jfd=-1; //File descriptor of the open journal, -1 when closed
+static int pend=0; //Records written since the last fdatasync
+static long sinceSnap=0; //Records written since the last snapshot was started
+static pid_t snapPid=0; //Process id of the running snapshot child, 0 if none
+static pthread_mutex_t jmx=PTHREAD_MUTEX_INITIALIZER; //Guards the state above; taken after account stripes, never before
+int jrnGroup; //Non-zero: jrnLog leaves the fdatasync to the caller's jrnSync
+
+static void syncLocked(void); //jrnSync with jmx held
+static void pollLocked(int wait); //jrnPoll with jmx held
+static int snapWait(Acc *head); //saveSnap in a child, waited for
+
+/**
+ * @brief Opens the journal for appending if it is not open yet.
+ * @return int File descriptor of the journal, or -1 on error.
+ */
+static int jrnOpen(void){
+        if(jfd<0)jfd=open(JRN_FILE,O_WRONLY|O_APPEND|O_CREAT,0644); //O_APPEND keeps every record write atomic at the end of file
+        return jfd; //Returns the descriptor (or -1)
+}
+
+/**
+ * @brief Appends the current state of an account to the journal.
+ * Called with the account locked, so the record matches the account.
+ * @param head Pointer to the head of the account database (unused, kept for callers).
+ * @param usr Account that was changed.
+ * @param op One of JRN_WTD, JRN_DEP, JRN_PIN, JRN_BLK.
+ * @return int 0 on success, -1 if the record could not be written.
+ */
+int jrnLog(Acc *head,Acc *usr,char op){
+        char buf[256],bal[MON_LEN],amt[MON_LEN]; //Formatted record, balance and amount in rupees
+        int n; //Record length
+        Tran *t=((op==JRN_WTD)||(op==JRN_DEP))?usr->tranHist:NULL; //Transaction added by the request, if any
+
+        monFmt(bal,usr->bal);
+        monFmt(amt,t?t->amt:0);
+        n=snprintf(buf,sizeof(buf),"%llu,%s,%c,%s,%s,%d,%llu,%llu,%s,%d\n",usr->num,usr->rfid,op,bal,
+                        usr->pin,usr->cardStat,usr->tranCnt,t?t->id:0ULL,amt,t?t->type:0); //One record per line
+        (void)head;
+        usr->dirty|=DIRTY_ROW|DIRTY_RPT; //Every journaled change is a change of the Db.csv row and of the report
+        if((n<0)||(n>=(int)sizeof(buf))){perror("jrnLog");return -1;} //Formatting failed
+        pthread_mutex_lock(&jmx);
+        if((jrnOpen()<0)||(write(jfd,buf,n)!=n)){ //Open or write failed
+                pthread_mutex_unlock(&jmx);
+                perror("jrnLog"); //Reports the failure, the change stays in memory only
+                return -1;
+        }
+        if((++pend>=JRN_BATCH)&&!jrnGroup)syncLocked(); //Makes the batch durable; grouped, the caller syncs once per batch
+        sinceSnap++; //jrnMaint starts a snapshot when the journal is long enough
+        pthread_mutex_unlock(&jmx);
+        return 0; //Success
+}
+
+/**
+ * @brief Housekeeping after a request, called with no account locked.
+ * Reaps a finished snapshot and starts a new one every JRN_SNAP_EVERY records.
+ * @param head Pointer to the head of the account database.
+ */
+void jrnMaint(Acc *head){
+        long due; //Records since the last snapshot
+        pthread_mutex_lock(&jmx);
+        pollLocked(0); //Reaps a finished snapshot without blocking
+        due=sinceSnap;
+        pthread_mutex_unlock(&jmx);
+        if(due>=JRN_SNAP_EVERY)jrnCheckpoint(head); //Journal is long enough for a new snapshot
+}
+
+/**
+ * @brief Forces pending journal records to disk.
+ */
+void jrnSync(void){
+        pthread_mutex_lock(&jmx);
+        syncLocked();
+        pthread_mutex_unlock(&jmx);
+}
+
+/**
+ * @brief Forces pending journal records to disk, jmx held.
+ */
+static void syncLocked(void){
+        if((jfd>=0)&&pend){ //Only if something was written since the last sync
+                if(fdatasync(jfd))perror("jrnSync"); //Data only, the file size is covered by fdatasync too
+                pend=0; //Batch done
+        }
+}
+
+/**
+ * @brief Moves the current journal aside as JRN_OLD so a snapshot can cover it (jmx held).
+ * If JRN_OLD is still there (its snapshot failed) the current journal is appended to it instead.
+ * @return int 0 on success, -1 on error.
+ */
+static int rotate(void){
+        char buf[4096]; //Copy buffer for folding the journal into an old segment
+        ssize_t n; //Bytes read
+        int src,dst; //Descriptors used while folding
+        syncLocked(); //Everything written so far must be on disk before it moves
+        if(jfd>=0){close(jfd);jfd=-1;} //Next record opens a fresh journal
+        if(access(JRN_OLD,F_OK)){ //No old segment: a plain rename is enough
+                if(rename(JRN_FILE,JRN_OLD)&&(errno!=ENOENT))return -1; //A missing journal is fine (nothing logged)
+                return 0;
+        }
+        src=open(JRN_FILE,O_RDONLY); //Current journal
+        if(src<0)return (errno==ENOENT)?0:-1; //Nothing to fold
+        dst=open(JRN_OLD,O_WRONLY|O_APPEND); //Old segment, records stay in order
+        if(dst<0){close(src);return -1;}
+        while((n=read(src,buf,sizeof(buf)))>0) //Copies the current journal behind the old records
+                if(write(dst,buf,n)!=n){n=-1;break;}
+        if((n<0)||fdatasync(dst)){close(src);close(dst);return -1;} //Keeps both files if the copy failed
+        close(src);
+        close(dst);
+        return unlink(JRN_FILE); //Records now live in the old segment only
+}
+
+/**
+ * @brief Starts a background snapshot of the whole database.
+ * Every account stripe is held across rotate and fork, so the child's copy-on-write
+ * image contains no half-applied request and exactly the records of JRN_OLD;
+ * the parent releases them right after fork and goes back to serving requests.
+ * Must be called with no account locked.
+ * @param head Pointer to the head of the account database.
+ */
+void jrnCheckpoint(Acc *head){
+        pid_t pid; //Child process id
+        if(histScanning())return; //Rollups still being counted: the snapshot would keep them partial, retried later
+        lockAll(); //Quiesces every account
+        pthread_mutex_lock(&jmx);
+        pollLocked(0); //Picks up a snapshot that has just finished
+        if(snapPid>0){pthread_mutex_unlock(&jmx);unlockAll();return;} //One snapshot at a time, retried on a later record
+        if(rotate()){pthread_mutex_unlock(&jmx);unlockAll();perror("jrnCheckpoint");return;} //Journal stays where it was, nothing is lost
+        sinceSnap=0; //New journal starts empty
+        pid=fork(); //Snapshot process
+        if(pid==0)_exit(saveSnap(head)?1:0); //Child: write the snapshot, skip atexit/stdio flushing of the parent's buffers
+        if(pid<0)perror("jrnCheckpoint: fork"); //JRN_OLD stays and is folded into the next attempt
+        else snapPid=pid; //Parent: remember the child for jrnPoll
+        pthread_mutex_unlock(&jmx);
+        unlockAll();
+}
+
+/**
+ * @brief Reaps a finished snapshot child and removes the journal segment it covered.
+ * @param wait Non-zero to block until the running snapshot (if any) has finished.
+ */
+void jrnPoll(int wait){
+        pthread_mutex_lock(&jmx);
+        pollLocked(wait);
+        pthread_mutex_unlock(&jmx);
+}
+
+/**
+ * @brief jrnPoll with jmx held.
+ * @param wait Non-zero to block until the running snapshot (if any) has finished.
+ */
+static void pollLocked(int wait){
+        int st; //Exit status of the child
+        pid_t r; //Result of waitpid
+        if(snapPid<=0)return; //No snapshot running
+        r=waitpid(snapPid,&st,wait?0:WNOHANG); //Checks (or waits) for the child
+        if(r==0)return; //Still running
+        snapPid=0; //Child is gone either way
+        if((r>0)&&WIFEXITED(st)&&!WEXITSTATUS(st))unlink(JRN_OLD); //Snapshot on disk, its journal is no longer needed
+        else fputs("jrnPoll: snapshot failed, journal kept for replay\n",stderr); //JRN_OLD is replayed at next start
+}
+
+/**
+ * @brief Runs saveSnap in a child and waits for it (every stripe and jmx held).
+ * saveSnap reads every lazily loaded history; in the child those reads vanish with it,
+ * so this process keeps only the histories it has used. Saves in-process if fork fails.
+ * @param head Pointer to the head of the account database.
+ * @return int 0 on success, -1 on error.
+ */
+static int snapWait(Acc *head){
+        int st; //Exit status of the child
+        pid_t pid=fork(); //Snapshot process
+        if(pid==0)_exit(saveSnap(head)?1:0); //Child: as in jrnCheckpoint
+        if(pid<0){perror("jrnFlush: fork");return saveSnap(head);} //Slower, but the save still happens
+        while(waitpid(pid,&st,0)<0)if(errno!=EINTR){perror("jrnFlush: waitpid");return -1;}
+        return (WIFEXITED(st)&&!WEXITSTATUS(st))?0:-1;
+}
+
+/**
+ * @brief Exports Db.csv, takes a synchronous snapshot and empties the journal.
+ * Waits for a running background snapshot first so its older image cannot overwrite this one.
+ * The snapshot is written by a child (snapWait), which this waits for.
+ * Holds every account stripe while saving; must be called with no account locked.
+ * @param head Pointer to the head of the account database.
+ * @return int 0 on success, -1 if a save failed (the journal is kept).
+ */
+int jrnFlush(Acc *head){
+        int r=-1; //Result
+        lockAll(); //No account changes during the save
+        pthread_mutex_lock(&jmx);
+        pollLocked(1); //Lets a background snapshot finish first
+        syncLocked(); //Journal is complete on disk in case saveData fails
+        if(!saveData(head)&&!snapWait(head)){ //CSV export and binary snapshot; the journal still covers every change on failure
+                if(jfd>=0){close(jfd);jfd=-1;} //Next record starts a new journal
+                unlink(JRN_FILE); //Both segments are covered by the snapshot
+                unlink(JRN_OLD);
+                pend=0; //Nothing pending any more
+                sinceSnap=0;
+                r=0; //Success
+        }
+        pthread_mutex_unlock(&jmx);
+        unlockAll();
+        return r;
+}
+
+/**
+ * @brief Applies the journal records of one file to the loaded accounts.
+ * @param head Pointer to the head of the account database.
+ * @param path Journal file to replay.
+ * @return long Number of records applied, -1 if the file does not exist.
+ */
+long jrnReplay(Acc *head,const char *path){
+        FILE *fp=fopen(path,"r"); //Journal to replay
+        u64 num,cnt,tid; //Account number, transaction count and transaction id of a record
+        char rfid[9],pin[5],op,balTxt[MON_LEN],amtTxt[MON_LEN]; //Card, PIN, op code, balance and amount text of a record
+        i64 bal,amt; //Balance and transaction amount of a record, in paise
+        int stat,type,r; //Card status, transaction type, fscanf result
+        long n=0; //Records applied
+        if(!fp)return -1; //No journal, nothing to do
+        while(((r=fscanf(fp,"%llu,%8[^,],%c,%23[^,],%4[^,],%d,%llu,%llu,%23[^,],%d\n",&num,rfid,&op,balTxt,pin,&stat,&cnt,&tid,amtTxt,&type))==10)
+                        &&!monParse(balTxt,strlen(balTxt),&bal)&&!monParse(amtTxt,strlen(amtTxt),&amt)){
+                Acc *usr=getAcc(head,rfid); //Records are keyed by card, the account number double checks the match
+                if(!usr||(usr->num!=num)){ //Account missing from the snapshot
+                        fprintf(stderr,"jrnReplay: unknown account %llu\n",num);
+                        continue;
+                }
+                usr->bal=bal; //Absolute values: replaying a record twice gives the same state
+                strcpy(usr->pin,pin);
+                usr->cardStat=stat;
+                usr->dirty|=DIRTY_ROW; //Db.csv row may be older than the record
+                if(tid&&usr->tranLazy)histFault(usr); //Count must come from the history file, not Db.csv
+                if(tid&&(cnt>usr->tranCnt)){ //Transaction not in the snapshot yet
+                        Tran *t=poolGet(&tranPool); //Same node addTran would have created
+                        if(!t){perror("jrnReplay");break;}
+                        t->id=tid;
+                        t->amt=amt;
+                        t->type=type;
+                        t->nxt=usr->tranHist; //Newest first, as addTran does
+                        usr->tranHist=t;
+                        usr->tranCnt++;
+                        usr->dirty|=DIRTY_HIST; //History file lacks it
+                        rollAdd(tid,amt,type); //Rollups of the snapshot or the import lack it too
+                }
+                n++; //Counts the applied record
+        }
+        if(r!=EOF)fprintf(stderr,"jrnReplay: %s: incomplete record after %ld records, rest ignored\n",path,n); //Torn write at a crash
+        fclose(fp);
+        return n; //Records applied
+}
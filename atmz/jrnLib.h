@@ -0,0 +1,92 @@
+#ifndef _JRNLIB_H //If _JRNLIB_H is not defined
+#define _JRNLIB_H //Define _JRNLIB_H to prevent multiple inclusions of this header file
+
+/*
+ * jrnLib.h
+ *
+ * Write-ahead journal for the ATM backend.
+ * Every WTD, DEP, PIN and BLK request appends one line describing the new
+ * state of the account to ../dataz/Db.jrn instead of rewriting the whole
+ * database. A full snapshot (saveSnap) is taken every JRN_SNAP_EVERY records
+ * by a forked child, so the request loop never waits for it. syncData loads
+ * the last snapshot and replays the journal on top of it.
+ *
+ * Record format (one line, fields as saved in Db.csv):
+ * "%llu,%s,%c,<bal>,%s,%d,%llu,%llu,<amt>,%d",num,rfid,op,bal,pin,cardStat,tranCnt,tranId,tranAmt,tranType
+ * with <bal> and <amt> in rupees as written by monFmt (older journals with %lf read back the same).
+ * Records carry absolute values, so replaying one twice is harmless.
+ */
+
+#include "atmLib.h" //Acc, u64, i64
+
+#define JRN_FILE "../dataz/Db.jrn" //Journal being appended to
+#define JRN_OLD  "../dataz/Db.jrn.old" //Journal segment being folded into a running snapshot
+
+#define JRN_BATCH      1    //fsync after this many records (1 = every request is durable before the next one), unless jrnGroup is set
+#define JRN_SNAP_EVERY 1000 //Records between two background snapshots
+
+#define JRN_WTD 'W' //Record op code for a withdrawal
+#define JRN_DEP 'D' //Record op code for a deposit
+#define JRN_PIN 'P' //Record op code for a PIN change
+#define JRN_BLK 'B' //Record op code for a card block
+#define JRN_CLS 'C' //Record op code for an account closed at the bank (written by bankz dltAcc, cardStat CLOSED)
+
+extern int jrnGroup; //Non-zero: jrnLog does not sync; the caller runs jrnSync once per batch of requests, before their replies are sent (group commit)
+
+/**
+ * @brief Appends the current state of an account to the journal.
+ * For JRN_WTD/JRN_DEP the newest transaction (head of tranHist) is recorded too.
+ * Flushes to disk every JRN_BATCH records, or not at all when jrnGroup is set. Call with the account locked.
+ * @param head Pointer to the head of the account database (for the snapshot).
+ * @param usr Account that was changed.
+ * @param op One of JRN_WTD, JRN_DEP, JRN_PIN, JRN_BLK.
+ * @return int 0 on success, -1 if the record could not be written.
+ */
+int jrnLog(Acc *head,Acc *usr,char op);
+
+/**
+ * @brief Reaps a finished snapshot and starts a background snapshot every JRN_SNAP_EVERY records.
+ * Call after a request, with no account locked.
+ * @param head Pointer to the head of the account database.
+ */
+void jrnMaint(Acc *head);
+
+/**
+ * @brief Forces pending journal records to disk (fdatasync).
+ */
+void jrnSync(void);
+
+/**
+ * @brief Starts a background snapshot: rotates the journal and forks a child running saveSnap.
+ * Does nothing if a previous snapshot, or the rollup scan of a lazy import, is still running.
+ * Takes every account stripe (lockAll).
+ * @param head Pointer to the head of the account database.
+ */
+void jrnCheckpoint(Acc *head);
+
+/**
+ * @brief Reaps a finished snapshot child and drops the journal segment it covered.
+ * @param wait Non-zero to block until the running snapshot (if any) has finished.
+ */
+void jrnPoll(int wait);
+
+/**
+ * @brief Exports Db.csv (saveData), takes a synchronous snapshot (saveSnap) and empties the journal.
+ * Waits for a running background snapshot first so it cannot overwrite the newer save.
+ * The snapshot is written by a child this waits for, so lazily loaded histories stay on disk.
+ * Takes every account stripe (lockAll).
+ * @param head Pointer to the head of the account database.
+ * @return int 0 on success, -1 if a save failed (the journal is kept).
+ */
+int jrnFlush(Acc *head);
+
+/**
+ * @brief Applies the journal records of one file to the loaded accounts.
+ * Stops at the first incomplete record (a write cut short by a crash).
+ * @param head Pointer to the head of the account database.
+ * @param path Journal file to replay.
+ * @return long Number of records applied, -1 if the file does not exist.
+ */
+long jrnReplay(Acc *head,const char *path);
+
+#endif //End of _JRNLIB_H guard
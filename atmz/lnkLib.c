@@ -0,0 +1,212 @@
+#include "lnkLib.h" //Includes the lnkLib.h header file for the link structure and prototypes
+#include <sys/uio.h> //readv
+
+static Lnk **lnkTab; //Links by descriptor, NULL until first use
+static int lnkCap; //Slots in lnkTab
+
+/**
+ * @brief Returns the link of a descriptor, creating it on first use.
+ * The table grows (doubling) to cover the highest descriptor seen.
+ * @param fd Descriptor of the link.
+ * @return Lnk* The link, or NULL if fd is negative or memory is exhausted.
+ */
+Lnk* lnkGet(const int fd){
+        if(fd<0){errno=EBADF;return NULL;} //Not a descriptor
+        if(fd>=lnkCap){ //Table too small
+                int cap=lnkCap?lnkCap:64; //New size
+                Lnk **t; //Grown table
+                while(cap<=fd)cap*=2;
+                t=realloc(lnkTab,cap*sizeof(Lnk*));
+                if(!t)return NULL;
+                memset(t+lnkCap,0,(cap-lnkCap)*sizeof(Lnk*)); //New slots are empty
+                lnkTab=t;
+                lnkCap=cap;
+        }
+        if(!lnkTab[fd])lnkTab[fd]=calloc(1,sizeof(Lnk)); //Empty ring, hunting for the first '#'
+        return lnkTab[fd]; //NULL if calloc failed (errno set)
+}
+
+/**
+ * @brief Releases the link of a descriptor. Queued output is flushed, unread input dropped.
+ * @param fd Descriptor of the link.
+ */
+void lnkClose(const int fd){
+        if((fd<0)||(fd>=lnkCap))return; //Never had a link
+        if(lnkTab[fd]&&lnkTab[fd]->txLen)lnkFlush(fd); //Last responses still go out
+        free(lnkTab[fd]);
+        lnkTab[fd]=NULL; //A reused descriptor starts clean
+}
+
+/**
+ * @brief Reads as many bytes as are available (and fit) into the link's ring with one system call.
+ * The free space may wrap around the end of the ring, so both parts are passed to readv.
+ * @param fd Descriptor of the link.
+ * @return int Bytes read, 0 at end of file, -1 on error (errno set, EAGAIN for an empty non-blocking link).
+ */
+int lnkRead(const int fd){
+        Lnk *l=lnkGet(fd); //Link to fill
+        struct iovec iov[2]; //Free space up to the end of the ring, then from its start
+        unsigned int wr,room; //Masked write position, free bytes
+        ssize_t n; //Bytes read
+        if(!l)return -1;
+        room=LNK_RX_SZ-(l->wr-l->rd); //Unconsumed bytes stay
+        if(!room){ //Cannot happen while frames fit the ring (lnkFrame drops longer ones); recover anyway
+                l->rd=l->scan=l->wr;
+                l->inFrame=0;
+                l->rxErrs++;
+                room=LNK_RX_SZ;
+        }
+        wr=l->wr&LNK_RX_MASK;
+        iov[0].iov_base=l->rx+wr;
+        iov[0].iov_len=(room<LNK_RX_SZ-wr)?room:LNK_RX_SZ-wr; //Up to the end of the ring
+        iov[1].iov_base=l->rx;
+        iov[1].iov_len=room-iov[0].iov_len; //Wrapped part
+        n=readv(fd,iov,iov[1].iov_len?2:1);
+        l->rxCalls++;
+        if(n>0){l->wr+=n;l->rxBytes+=n;} //Indices are free running, unsigned overflow is harmless
+        return n; //Bytes read, 0 or -1
+}
+
+/**
+ * @brief Extracts the next complete frame from the link's ring.
+ * Scanning resumes where the previous call stopped, so a frame arriving in pieces
+ * is looked at only once. Outside a frame every byte up to the next '#' is skipped;
+ * line ends between frames are not counted as garbage.
+ * @param fd Descriptor of the link.
+ * @param str Buffer for the frame.
+ * @param len Size of 'str'.
+ * @return int Length of the frame, 0 if no complete frame is buffered, -1 if bytes were dropped (framing error).
+ */
+int lnkFrame(const int fd,char *str,size_t len){
+        Lnk *l=lnkGet(fd); //Link to read from
+        unsigned int max,n,i; //Longest frame that fits 'str' and the ring, frame length, copy index
+        char ch; //Byte being looked at
+        if(!l||!len)return -1;
+        max=(len<LNK_RX_SZ)?len:LNK_RX_SZ-1; //Frame and its '\r' must fit both
+        while(l->scan!=l->wr){
+                ch=l->rx[l->scan&LNK_RX_MASK];
+                if(!l->inFrame){ //Hunting for the start of a frame
+                        if(ch=='#'){
+                                if(l->junk){ //Garbage before this frame: report it first, the '#' is kept
+                                        l->junk=0;
+                                        l->rxErrs++;
+                                        return -1;
+                                }
+                                l->inFrame=1;
+                                l->rd=l->scan++; //Frame starts here
+                                continue;
+                        }
+                        if((ch!='\r')&&(ch!='\n'))l->junk++; //Noise on the line
+                        l->rd=++l->scan; //Skipped bytes are consumed
+                        continue;
+                }
+                if(ch=='#'){ //A new frame starts before the current one ended: drop the partial frame
+                        l->rd=l->scan; //Next call starts the new frame at this '#'
+                        l->inFrame=0;
+                        l->rxErrs++;
+                        return -1;
+                }
+                if(ch=='\n'){ //Frame complete
+                        n=l->scan-l->rd; //Length without the '\n'
+                        if(n&&(l->rx[(l->scan-1)&LNK_RX_MASK]=='\r'))n--; //Drops the '\r' too
+                        if(n>=len){ //No room for the terminator
+                                l->rd=++l->scan;
+                                l->inFrame=0;
+                                l->rxErrs++;
+                                return -1;
+                        }
+                        for(i=0;i<n;i++)str[i]=l->rx[(l->rd+i)&LNK_RX_MASK]; //Copies out of the ring (may wrap)
+                        str[n]='\0';
+                        l->rd=++l->scan; //Consumed, including the line end
+                        l->inFrame=0;
+                        l->rxFrames++;
+                        return n;
+                }
+                if(++l->scan-l->rd>max){ //No line end within 'max' bytes: too long for the caller
+                        l->rd=l->scan; //Dropped, hunt for the next '#'
+                        l->inFrame=0;
+                        l->rxErrs++;
+                        return -1;
+                }
+        }
+        return 0; //Need more bytes
+}
+
+/**
+ * @brief Appends bytes to the link's output buffer (flushing first if they do not fit).
+ * Data larger than the whole buffer is written directly after the queued bytes.
+ * @param fd Descriptor of the link.
+ * @param s Bytes to send.
+ * @param n Number of bytes.
+ * @return int n on success, -1 if a flush needed to make room failed.
+ */
+int lnkPut(const int fd,const char *s,size_t n){
+        Lnk *l=lnkGet(fd); //Link to queue on
+        if(!l)return -1;
+        if((n>LNK_TX_SZ-l->txLen)&&lnkFlush(fd))return -1; //Makes room
+        if(n>LNK_TX_SZ){ //Never fits: bypasses the buffer
+                if(write(fd,s,n)!=(ssize_t)n)return -1;
+                l->txCalls++;
+                l->txBytes+=n;
+                return n;
+        }
+        memcpy(l->tx+l->txLen,s,n);
+        l->txLen+=n;
+        return n;
+}
+
+/**
+ * @brief Formats one response followed by "\r\n" directly into the link's output buffer.
+ * No intermediate buffer: vsnprintf writes into the free space and only when that
+ * is too small is the link flushed and the formatting repeated.
+ * @param fd Descriptor of the link.
+ * @param fmt printf style format of the response.
+ * @param ap Arguments for fmt.
+ * @return int Length of the response (without "\r\n"), -1 on error.
+ */
+int lnkVfmt(const int fd,const char *fmt,va_list ap){
+        Lnk *l=lnkGet(fd); //Link to queue on
+        va_list cp; //Copy of ap for the second attempt
+        int n,room; //Formatted length, free bytes
+        if(!l)return -1;
+        va_copy(cp,ap);
+        room=LNK_TX_SZ-l->txLen;
+        n=vsnprintf(l->tx+l->txLen,room,fmt,ap);
+        if((n>=0)&&(n+2>room)){ //Did not fit with "\r\n": flush and format again
+                if(lnkFlush(fd)||(n+2>LNK_TX_SZ)){va_end(cp);return -1;} //Longer than a whole buffer is not a response
+                n=vsnprintf(l->tx,LNK_TX_SZ,fmt,cp);
+        }
+        va_end(cp);
+        if(n<0)return -1;
+        memcpy(l->tx+l->txLen+n,"\r\n",2); //Replaces vsnprintf's terminator
+        l->txLen+=n+2;
+        l->txFrames++;
+        return n;
+}
+
+/**
+ * @brief Writes everything queued on the link with one write() (repeated only after a partial write).
+ * @param fd Descriptor of the link.
+ * @return int 0 when the buffer is empty, -1 on error (EAGAIN: the rest stays queued).
+ */
+int lnkFlush(const int fd){
+        Lnk *l=lnkGet(fd); //Link to flush
+        unsigned int off=0; //Bytes written so far
+        ssize_t n; //Result of write
+        if(!l)return -1;
+        while(off<l->txLen){
+                n=write(fd,l->tx+off,l->txLen-off);
+                if(n<0){
+                        if(errno==EINTR)continue; //Interrupted, try again
+                        break; //EAGAIN or a real error: keep what is left
+                }
+                l->txCalls++;
+                l->txBytes+=n;
+                off+=n;
+        }
+        if(off){ //Moves the unwritten rest to the front
+                memmove(l->tx,l->tx+off,l->txLen-off);
+                l->txLen-=off;
+        }
+        return l->txLen?-1:0;
+}
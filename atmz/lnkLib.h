@@ -0,0 +1,101 @@
+#ifndef _LNKLIB_H //If _LNKLIB_H is not defined
+#define _LNKLIB_H //Define _LNKLIB_H to prevent multiple inclusions of this header file
+
+/*
+ * lnkLib.h
+ *
+ * Per-link receive buffering for the ATM backend.
+ * Every descriptor used with rx_str gets a Lnk holding a ring buffer. lnkRead
+ * fills the ring with as many bytes as one read can return, lnkFrame cuts
+ * complete "#...\r\n" frames out of it. Bytes outside a frame are skipped
+ * (resync on the next '#'); garbage, frames cut short by a new '#' and
+ * frames longer than the caller's buffer are dropped and reported as framing
+ * errors instead of ending the process.
+ * Links are looked up by descriptor, so tx_str/rx_str keep their signatures.
+ *
+ * Responses are built straight into the link's output buffer (lnkPut, lnkFmt)
+ * and leave with one write() in lnkFlush. rx_str flushes before it waits for
+ * input, so all replies to the frames of one read go out together.
+ */
+
+#include "atmLib.h" //u64
+#include <stdarg.h> //va_list for lnkVfmt
+
+#define LNK_RX_SZ   1024 //Receive ring size per link (must be a power of two)
+#define LNK_RX_MASK (LNK_RX_SZ-1) //Ring index mask
+#define LNK_TX_SZ   4096 //Output buffer size per link
+
+typedef struct{ //Structure holding the state of one link
+        char rx[LNK_RX_SZ]; //Receive ring
+        unsigned int rd; //Start of the unconsumed bytes (free running, masked on access)
+        unsigned int wr; //End of the received bytes
+        unsigned int scan; //Bytes before this index have been looked at by lnkFrame
+        int inFrame; //1 while between a '#' and its line end
+        unsigned int junk; //Bytes skipped outside a frame since the last report
+        u64 rxBytes; //Bytes received
+        u64 rxFrames; //Complete frames delivered
+        u64 rxErrs; //Framing errors
+        u64 rxCalls; //read system calls
+        char tx[LNK_TX_SZ]; //Output buffer, bytes [0,txLen) not yet written
+        unsigned int txLen; //Bytes waiting in tx
+        u64 txBytes; //Bytes written
+        u64 txFrames; //Responses queued
+        u64 txCalls; //write system calls
+}Lnk;
+
+/**
+ * @brief Returns the link of a descriptor, creating it on first use.
+ * @param fd Descriptor of the link.
+ * @return Lnk* The link, or NULL if fd is negative or memory is exhausted.
+ */
+Lnk* lnkGet(const int fd);
+
+/**
+ * @brief Releases the link of a descriptor (buffered bytes are dropped).
+ * @param fd Descriptor of the link.
+ */
+void lnkClose(const int fd);
+
+/**
+ * @brief Reads as many bytes as are available (and fit) into the link's ring with one system call.
+ * @param fd Descriptor of the link.
+ * @return int Bytes read, 0 at end of file, -1 on error (errno set, EAGAIN for an empty non-blocking link).
+ */
+int lnkRead(const int fd);
+
+/**
+ * @brief Extracts the next complete frame from the link's ring.
+ * The frame runs from '#' up to the line end; "\r\n" is removed and the result null terminated.
+ * @param fd Descriptor of the link.
+ * @param str Buffer for the frame.
+ * @param len Size of 'str'.
+ * @return int Length of the frame, 0 if no complete frame is buffered, -1 if bytes were dropped (framing error).
+ */
+int lnkFrame(const int fd,char *str,size_t len);
+
+/**
+ * @brief Appends bytes to the link's output buffer (flushing first if they do not fit).
+ * @param fd Descriptor of the link.
+ * @param s Bytes to send.
+ * @param n Number of bytes.
+ * @return int n on success, -1 if a flush needed to make room failed.
+ */
+int lnkPut(const int fd,const char *s,size_t n);
+
+/**
+ * @brief Formats one response followed by "\r\n" directly into the link's output buffer.
+ * @param fd Descriptor of the link.
+ * @param fmt printf style format of the response.
+ * @param ap Arguments for fmt.
+ * @return int Length of the response (without "\r\n"), -1 on error.
+ */
+int lnkVfmt(const int fd,const char *fmt,va_list ap);
+
+/**
+ * @brief Writes everything queued on the link with one write() (repeated only after a partial write).
+ * @param fd Descriptor of the link.
+ * @return int 0 when the buffer is empty, -1 on error (EAGAIN: the rest stays queued).
+ */
+int lnkFlush(const int fd);
+
+#endif //End of _LNKLIB_H guard
@@ -0,0 +1,72 @@
+#include "lockLib.h" //Includes the lockLib.h header file for the stripe count and prototypes
+
+typedef struct{ //One stripe, alone on its cache line so stripes do not share lines
+        pthread_mutex_t m; //Stripe mutex
+}__attribute__((aligned(64)))Stripe;
+
+static Stripe stripe[LOCK_STRIPES]={[0 ... LOCK_STRIPES-1]={PTHREAD_MUTEX_INITIALIZER}}; //All stripes, ready to use
+
+/**
+ * @brief Returns the stripe an account is mapped to.
+ * The account number is multiplied by a 64 bit odd constant and the top bits are
+ * taken, so sequential account numbers spread over all stripes.
+ * @param usr Account.
+ * @return unsigned int Stripe index, 0..LOCK_STRIPES-1.
+ */
+unsigned int lockStripe(const Acc *usr){
+        return (unsigned int)((usr->num*0x9E3779B97F4A7C15ULL)>>56)&(LOCK_STRIPES-1); //Fibonacci hashing
+}
+
+/**
+ * @brief Locks one account (its stripe).
+ * @param usr Account.
+ */
+void lockAcc(const Acc *usr){
+        pthread_mutex_lock(&stripe[lockStripe(usr)].m);
+}
+
+/**
+ * @brief Unlocks one account.
+ * @param usr Account.
+ */
+void unlockAcc(const Acc *usr){
+        pthread_mutex_unlock(&stripe[lockStripe(usr)].m);
+}
+
+/**
+ * @brief Locks two accounts in stripe order (once if they share a stripe).
+ * @param a First account.
+ * @param b Second account.
+ */
+void lockPair(const Acc *a,const Acc *b){
+        unsigned int x=lockStripe(a),y=lockStripe(b); //Stripes of both accounts
+        if(x==y){pthread_mutex_lock(&stripe[x].m);return;} //Same stripe: one lock covers both
+        if(x>y){unsigned int t=x;x=y;y=t;} //Lower stripe first, whatever the argument order
+        pthread_mutex_lock(&stripe[x].m);
+        pthread_mutex_lock(&stripe[y].m);
+}
+
+/**
+ * @brief Unlocks two accounts locked with lockPair.
+ * @param a First account.
+ * @param b Second account.
+ */
+void unlockPair(const Acc *a,const Acc *b){
+        unsigned int x=lockStripe(a),y=lockStripe(b); //Stripes of both accounts
+        pthread_mutex_unlock(&stripe[x].m);
+        if(x!=y)pthread_mutex_unlock(&stripe[y].m);
+}
+
+/**
+ * @brief Locks every stripe, in order: no account changes until unlockAll.
+ */
+void lockAll(void){
+        for(int i=0;i<LOCK_STRIPES;i++)pthread_mutex_lock(&stripe[i].m);
+}
+
+/**
+ * @brief Unlocks every stripe.
+ */
+void unlockAll(void){
+        for(int i=LOCK_STRIPES-1;i>=0;i--)pthread_mutex_unlock(&stripe[i].m);
+}
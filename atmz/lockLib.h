@@ -0,0 +1,65 @@
+#ifndef _LOCKLIB_H //If _LOCKLIB_H is not defined
+#define _LOCKLIB_H //Define _LOCKLIB_H to prevent multiple inclusions of this header file
+
+/*
+ * lockLib.h
+ *
+ * Striped account locks for the ATM backend.
+ * Accounts are mapped by account number onto LOCK_STRIPES mutexes, so
+ * requests for different accounts usually take different locks and run in
+ * parallel, while requests for the same account always serialize.
+ * Deadlock-free ordering: whenever more than one stripe is held they are
+ * taken in ascending stripe order (lockPair, lockAll), and the journal
+ * mutex is only ever taken after stripes, never before.
+ */
+
+#include "atmLib.h" //Acc
+#include <pthread.h> //pthread_mutex_t
+
+#define LOCK_STRIPES 256 //Number of stripes (must be a power of two)
+
+/**
+ * @brief Returns the stripe an account is mapped to.
+ * @param usr Account.
+ * @return unsigned int Stripe index, 0..LOCK_STRIPES-1.
+ */
+unsigned int lockStripe(const Acc *usr);
+
+/**
+ * @brief Locks one account (its stripe).
+ * @param usr Account.
+ */
+void lockAcc(const Acc *usr);
+
+/**
+ * @brief Unlocks one account.
+ * @param usr Account.
+ */
+void unlockAcc(const Acc *usr);
+
+/**
+ * @brief Locks two accounts in stripe order (once if they share a stripe).
+ * @param a First account.
+ * @param b Second account.
+ */
+void lockPair(const Acc *a,const Acc *b);
+
+/**
+ * @brief Unlocks two accounts locked with lockPair.
+ * @param a First account.
+ * @param b Second account.
+ */
+void unlockPair(const Acc *a,const Acc *b);
+
+/**
+ * @brief Locks every stripe, in order: no account changes until unlockAll.
+ * Used around fork (snapshot) and full saves.
+ */
+void lockAll(void);
+
+/**
+ * @brief Unlocks every stripe.
+ */
+void unlockAll(void);
+
+#endif //End of _LOCKLIB_H guard
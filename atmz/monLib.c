@@ -0,0 +1,75 @@
+#include "monLib.h" //Includes the monLib.h header file for the money type and prototypes
+#include<string.h> //memcpy
+
+static const char dig2[201]= //Two-digit groups 00..99, so monFmt divides once per pair of digits
+        "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+        "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+        "8081828384858687888990919293949596979899";
+
+/**
+ * @brief Converts a rupee amount to paise: optional sign, digits, optional '.' and decimals.
+ * @param s First character of the amount (need not be null-terminated).
+ * @param len Length of the amount.
+ * @param v Converted amount in paise.
+ * @return int 0 on success, -1 if the text is not an amount or has too many digits.
+ */
+int monParse(const char *s,size_t len,i64 *v){
+        unsigned long long r=0; //Rupees, then paise
+        unsigned int dig=0,dec=0,p=0,up=0; //Rupee digits, decimals seen, paise digits, round up
+        size_t i=0; //Character index
+        int neg=0; //Sign
+        if(len&&((s[0]=='-')||(s[0]=='+'))){neg=(s[0]=='-');i++;} //Optional sign
+        for(;(i<len)&&(s[i]>='0')&&(s[i]<='9');i++){
+                if(++dig>MON_MAX_DIGITS)return -1; //Paise would overflow
+                r=r*10+(s[i]-'0');
+        }
+        if((i<len)&&(s[i]=='.'))
+                for(i++;(i<len)&&(s[i]>='0')&&(s[i]<='9');i++,dec++){
+                        if(dec<MON_DEC)p=p*10+(s[i]-'0');
+                        else if(dec==MON_DEC)up=(s[i]>='5'); //The third decimal rounds, later ones cannot change it
+                }
+        if((i<len)||(!dig&&!dec))return -1; //Stray character, or sign or point alone
+        for(;dec<MON_DEC;dec++)p*=10; //"5" and "5.5" are 500 and 550 paise
+        r=r*MON_SCALE+p+up;
+        *v=neg?-(i64)r:(i64)r;
+        return 0;
+}
+
+/**
+ * @brief Writes the decimal digits of a value backwards, two at a time.
+ * @param end One past the place of the last digit.
+ * @param v Value.
+ * @return char* First digit.
+ */
+char* monDigits(char *end,unsigned long long v){
+        unsigned int d; //Offset of a digit pair in dig2
+        while(v>=100){
+                d=(unsigned int)(v%100)*2;
+                v/=100;
+                *--end=dig2[d+1];*--end=dig2[d];
+        }
+        if(v>=10){d=(unsigned int)v*2;*--end=dig2[d+1];*--end=dig2[d];}
+        else *--end=(char)('0'+v);
+        return end;
+}
+
+/**
+ * @brief Writes an amount in paise as rupees with two decimals.
+ * Digits are produced two at a time from the end of a scratch buffer.
+ * @param buf Destination, at least MON_LEN bytes; null-terminated.
+ * @param v Amount in paise.
+ * @return int Length written (without the null).
+ */
+int monFmt(char *buf,i64 v){
+        char tmp[MON_LEN],*p=tmp+sizeof(tmp); //Scratch buffer, filled backwards
+        unsigned long long m=(v<0)?0ULL-(unsigned long long)v:(unsigned long long)v; //Magnitude (the most negative value included)
+        unsigned int d=(unsigned int)(m%100)*2; //Offset of the paise in dig2
+        int len; //Result length
+        *--p=dig2[d+1];*--p=dig2[d];*--p='.';
+        p=monDigits(p,m/100); //Rupees
+        if(v<0)*--p='-';
+        len=(int)(tmp+sizeof(tmp)-p);
+        memcpy(buf,p,len);
+        buf[len]='\0';
+        return len;
+}
@@ -0,0 +1,82 @@
+#include "msgLib.h" //Includes the msgLib.h header file for the field views and prototypes
+#include<string.h> //memchr, memcpy
+
+#define FLD_MAX_DIGITS 15 //Longest numeric field accepted (card numbers, transaction numbers)
+
+/**
+ * @brief Splits a frame into its op code and field views, in one pass.
+ * Accepts "#<op>$" (no fields) and "#<op>:<f0>:...:<fn>$"; empty fields are kept
+ * as zero length views so the field count always matches the separators.
+ * @param buf The received frame, starting at '#'.
+ * @param len Length of the frame.
+ * @param m Tokenized frame, valid as long as buf is.
+ * @return int 0 on success, -1 if the frame is malformed or has too many fields.
+ */
+int msgParse(const char *buf,size_t len,Msg *m){
+        const char *p,*end,*sep; //Scan position, closing '$', next ':'
+        if((len<3)||(buf[0]!='#')||(buf[len-1]!='$'))return -1; //Frame markers
+        m->op=buf[1]; //Op code
+        m->nf=0;
+        if(len==3)return 0; //"#<op>$": no fields
+        if(buf[2]!=':')return -1; //Op code is exactly one character
+        end=buf+len-1; //Fields end at the '$'
+        for(p=buf+3;;p=sep+1){ //One field per ':'
+                sep=memchr(p,':',end-p); //Next separator inside the frame
+                if(m->nf==MSG_MAX_FLD)return -1; //More fields than any request has
+                m->f[m->nf].p=p;
+                m->f[m->nf].len=(sep?sep:end)-p;
+                m->nf++;
+                if(!sep)return 0; //Last field
+        }
+}
+
+/**
+ * @brief Checks that a field is exactly n decimal digits.
+ * Eight characters are checked at a time: a byte is a digit if its high nibble
+ * is 3 and stays 3 after adding 6 ('0'..'9' are 0x30..0x39), so a card number
+ * takes one test instead of eight.
+ * @param f Field view.
+ * @param n Required length.
+ * @return int 1 if it is, 0 otherwise.
+ */
+int fldDigits(Fld f,unsigned int n){
+        unsigned long long w; //Eight characters of the field
+        unsigned int i=0; //Character index
+        if(f.len!=n)return 0;
+        for(;i+8<=n;i+=8){ //Whole words
+                memcpy(&w,f.p+i,8); //Unaligned load
+                if(((w&0xF0F0F0F0F0F0F0F0ULL)!=0x3030303030303030ULL)||
+                                (((w+0x0606060606060606ULL)&0xF0F0F0F0F0F0F0F0ULL)!=0x3030303030303030ULL))return 0;
+        }
+        for(;i<n;i++)if((f.p[i]<'0')||(f.p[i]>'9'))return 0; //Tail
+        return 1;
+}
+
+/**
+ * @brief Converts an unsigned decimal field.
+ * @param f Field view.
+ * @param v Converted value.
+ * @return int 0 on success, -1 if the field is empty, not a number or too long.
+ */
+int fldNum(Fld f,unsigned long long *v){
+        unsigned long long r=0; //Value so far
+        unsigned int i; //Character index
+        if(!f.len||(f.len>FLD_MAX_DIGITS))return -1;
+        for(i=0;i<f.len;i++){
+                if((f.p[i]<'0')||(f.p[i]>'9'))return -1;
+                r=r*10+(f.p[i]-'0');
+        }
+        *v=r;
+        return 0;
+}
+
+/**
+ * @brief Converts an amount field to paise with monParse: optional sign, digits, optional '.' and decimals.
+ * Exponents and trailing text are rejected; decimals past the second are rounded.
+ * @param f Field view.
+ * @param amt Converted amount in paise.
+ * @return int 0 on success, -1 if the field is not an amount.
+ */
+int fldAmt(Fld f,i64 *amt){
+        return monParse(f.p,f.len,amt);
+}
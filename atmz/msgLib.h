@@ -0,0 +1,70 @@
+#ifndef _MSGLIB_H //If _MSGLIB_H is not defined
+#define _MSGLIB_H //Define _MSGLIB_H to prevent multiple inclusions of this header file
+
+/*
+ * msgLib.h
+ *
+ * Zero-copy tokenizer for ATM request frames.
+ * A frame "#<op>:<f0>:<f1>:...$" is split in one pass into field views
+ * (pointer + length) that point into the receive buffer; nothing is copied
+ * and the buffer does not need to be null-terminated. Numeric fields are
+ * converted straight from their view, and every field length is checked
+ * against the protocol before it is used.
+ */
+
+#include<stddef.h> //size_t
+#include<string.h> //memcmp for FLD_IS
+#include "monLib.h" //i64 and monParse for amount fields
+
+#define MSG_MAX_FLD 4 //Most fields after the op code ("#A:WTD:<rfid>:<amt>$" has 3)
+#define MSG_RFID_LEN 8 //Card number length
+#define MSG_PIN_LEN 4 //PIN length
+#define MSG_REQ_LEN 3 //Action code length (WTD, DEP, ...)
+
+#define FLD_IS(f,lit) (((f).len==sizeof(lit)-1)&&!memcmp((f).p,lit,sizeof(lit)-1)) //Field equals a string literal (length known at compile time)
+
+typedef struct{ //View of one field inside a frame
+        const char *p; //First character of the field (not null-terminated)
+        unsigned int len; //Length of the field
+}Fld;
+
+typedef struct{ //Tokenized frame
+        char op; //Op code: the character after '#'
+        int nf; //Number of fields after the op code
+        Fld f[MSG_MAX_FLD]; //Field views, in frame order
+}Msg;
+
+/**
+ * @brief Splits a frame into its op code and field views, in one pass.
+ * @param buf The received frame, starting at '#'.
+ * @param len Length of the frame (as returned by rx_str/lnkFrame).
+ * @param m Tokenized frame, valid as long as buf is.
+ * @return int 0 on success, -1 if the frame is malformed or has too many fields.
+ */
+int msgParse(const char *buf,size_t len,Msg *m);
+
+/**
+ * @brief Checks that a field is exactly n decimal digits (card numbers, PINs).
+ * @param f Field view.
+ * @param n Required length.
+ * @return int 1 if it is, 0 otherwise.
+ */
+int fldDigits(Fld f,unsigned int n);
+
+/**
+ * @brief Converts an unsigned decimal field.
+ * @param f Field view.
+ * @param v Converted value.
+ * @return int 0 on success, -1 if the field is empty, not a number or too long.
+ */
+int fldNum(Fld f,unsigned long long *v);
+
+/**
+ * @brief Converts an amount field (rupees, e.g. "500" or "99.50") to paise.
+ * @param f Field view.
+ * @param amt Converted amount in paise.
+ * @return int 0 on success, -1 if the field is not an amount.
+ */
+int fldAmt(Fld f,i64 *amt);
+
+#endif //End of _MSGLIB_H guard
@@ -0,0 +1,95 @@
+#ifndef _POOLLIB_H //If _POOLLIB_H is not defined
+#define _POOLLIB_H //Define _POOLLIB_H to prevent multiple inclusions of this header file
+
+/*
+ * poolLib.h
+ *
+ * Slab allocator for the account and transaction nodes of the ATM backend.
+ * A pool hands out objects of one size from large blocks: loading takes a whole
+ * history as one contiguous run (poolGetN), a request takes one node (poolGet)
+ * with a pointer bump or from the list of returned nodes. No per-object malloc
+ * header, no per-object call into malloc, and the nodes of one history sit next
+ * to each other in memory.
+ * Blocks are only given back to the system when the process exits.
+ * Every pool has its own mutex, so loader threads and request threads may share it.
+ */
+
+#include "atmLib.h" //u64
+#include <pthread.h> //pthread_mutex_t
+
+#define POOL_ALIGN 8 //Object sizes are rounded up to this (objects of pointer size or more)
+#define POOL_MHDR (2*sizeof(size_t)) //malloc's own header in front of a block, so a block fills whole pages
+
+typedef struct PoolBlk{ //Header of one block, objects follow it
+        struct PoolBlk *nxt; //Next block of the pool
+        size_t cap; //Objects the block holds
+        size_t used; //Objects handed out from it so far (returned ones included)
+        size_t pad; //Keeps the objects 16-byte aligned on 64 bit hosts
+}PoolBlk;
+
+typedef struct{ //One pool of equal-size objects
+        size_t sz; //Object size as given (1 for a byte pool, see poolStr)
+        size_t blkSz; //Bytes per block, malloc's header included
+        const char *name; //Printed by poolStats
+        PoolBlk *blk; //Blocks, the one being filled first
+        void *free; //Returned objects, linked through their first bytes
+        u64 live; //Objects handed out and not returned
+        u64 freeCnt; //Objects on the free list
+        u64 blkCnt; //Blocks allocated
+        u64 reserved; //Bytes allocated for blocks, headers included
+        pthread_mutex_t mx; //Guards every field above
+}Pool;
+
+#define POOL_INIT(size,blkSz,name) {(size),(blkSz),(name),NULL,NULL,0,0,0,0,PTHREAD_MUTEX_INITIALIZER} //Static initializer
+
+extern Pool accPool; //Acc nodes of loadCsv
+extern Pool tranPool; //Tran nodes of loadCsv, addTran and jrnReplay
+
+/**
+ * @brief Takes one zeroed object, from the free list if any.
+ * @param p Pool.
+ * @return void* The object, NULL if memory is exhausted.
+ */
+void* poolGet(Pool *p);
+
+/**
+ * @brief Takes n zeroed objects lying next to each other.
+ * Runs longer than a block get a block of their own.
+ * @param p Pool.
+ * @param n Number of objects (at least 1).
+ * @return void* The first object, NULL if memory is exhausted.
+ */
+void* poolGetN(Pool *p,size_t n);
+
+/**
+ * @brief Returns one object taken with poolGet or poolGetN for reuse.
+ * @param p Pool the object came from.
+ * @param o Object.
+ */
+void poolPut(Pool *p,void *o);
+
+/**
+ * @brief Copies a string into a byte pool (size 1). Such strings cannot be returned.
+ * @param p Byte pool.
+ * @param s String.
+ * @return char* The copy, NULL if memory is exhausted.
+ */
+char* poolStr(Pool *p,const char *s);
+
+/**
+ * @brief Tells whether an address lies in one of the pool's blocks.
+ * @param p Pool.
+ * @param o Address.
+ * @return int 1 if it does, 0 otherwise.
+ */
+int poolOwns(Pool *p,const void *o);
+
+/**
+ * @brief Prints a pool's bytes in use against bytes wasted (block headers, unused block
+ * tails and returned objects), e.g. "tran: 400000 live, 12.2 MB used, 0.1 MB wasted of 12.3 MB in 98 blocks".
+ * @param p Pool.
+ * @param fp Output stream.
+ */
+void poolStats(Pool *p,FILE *fp);
+
+#endif //End of _POOLLIB_H guard
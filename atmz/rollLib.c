@@ -0,0 +1,91 @@
+#include "rollLib.h" //Includes the rollLib.h header file for the rollup layout and prototypes
+#include <pthread.h> //Mutex for taking over a day slot
+
+RollDay roll[ROLL_DAYS]; //Ring of the newest days
+
+static pthread_mutex_t rmx=PTHREAD_MUTEX_INITIALIZER; //Guards the takeover of a slot by a new day
+
+/**
+ * @brief Checks a YYYYMMDD value and returns its day number (days since 1 March of year 0).
+ * @param ymd YYYYMMDD.
+ * @return u64 Day number, 0 if ymd is not a date.
+ */
+static u64 dayNum(u64 ymd){
+        u64 y=ymd/10000,m=ymd/100%100,d=ymd%100; //Year, month, day
+        if(!y||(y>9999)||(m<1)||(m>12)||(d<1)||(d>31))return 0;
+        if(m<3){y--;m+=12;} //Years start in March, so the leap day is last
+        return 365*y+y/4-y/100+y/400+(153*(m-3)+2)/5+d;
+}
+
+/**
+ * @brief Adds one transaction to a cell with atomic adds.
+ * @param c Cell.
+ * @param amt Amount in paise.
+ */
+static void cellAdd(RollCell *c,i64 amt){
+        __atomic_fetch_add(&c->cnt,1,__ATOMIC_RELAXED);
+        __atomic_fetch_add(&c->sum,amt,__ATOMIC_RELAXED);
+}
+
+/**
+ * @brief Counts one transaction in its day and hour.
+ * @param id Transaction ID (YYYYMMDDHHMMSSRRR).
+ * @param amt Amount in paise.
+ * @param type Transaction type.
+ */
+void rollAdd(u64 id,i64 amt,int type){
+        u64 day=id/1000000000ULL,hh=id/10000000ULL%100,n=dayNum(day); //YYYYMMDD, hour, day number
+        int t=((type>=WITHDRAW)&&(type<=TRANSFER_OUT))?type:0; //Type slot
+        RollDay *d=&roll[n%ROLL_DAYS]; //Slot of the day
+        if(!n||(hh>23))return; //Not a time stamp ID
+        if(__atomic_load_n(&d->day,__ATOMIC_ACQUIRE)!=day){
+                pthread_mutex_lock(&rmx);
+                if(d->day<day){ //First transaction of a new day: the day ROLL_DAYS before goes
+                        memset(d->tot,0,sizeof(d->tot));
+                        memset(d->hour,0,sizeof(d->hour));
+                        __atomic_store_n(&d->day,day,__ATOMIC_RELEASE);
+                }
+                pthread_mutex_unlock(&rmx);
+                if(__atomic_load_n(&d->day,__ATOMIC_ACQUIRE)!=day)return; //Older than the days kept
+        }
+        cellAdd(&d->tot[t],amt);
+        cellAdd(&d->hour[hh][t],amt);
+}
+
+/**
+ * @brief Clears the rollups and counts every linked transaction.
+ * @param head Pointer to the head of the account database.
+ */
+void rollBuild(Acc *head){
+        Tran *t; //History walk
+        memset(roll,0,sizeof(roll));
+        for(;head;head=head->nxt)
+                for(t=head->tranHist;t;t=t->nxt)rollAdd(t->id,t->amt,t->type);
+}
+
+/**
+ * @brief Copies the rollups of one day.
+ * @param day YYYYMMDD.
+ * @param out Rollups of the day.
+ * @return int 0 on success, -1 if the day is not kept.
+ */
+int rollGet(u64 day,RollDay *out){
+        u64 n=dayNum(day),newest=0,i,h; //Day number, newest day kept, counters
+        const RollCell *s; //Source cells
+        RollCell *c; //Copied cells
+        if(!n)return -1;
+        for(i=0;i<ROLL_DAYS;i++)if(__atomic_load_n(&roll[i].day,__ATOMIC_ACQUIRE)>newest)newest=roll[i].day;
+        if(newest&&(n+ROLL_DAYS<=dayNum(newest)))return -1; //Its slot belongs to a newer day
+        memset(out,0,sizeof(*out));
+        out->day=day;
+        if(__atomic_load_n(&roll[n%ROLL_DAYS].day,__ATOMIC_ACQUIRE)!=day)return 0; //Nothing happened that day
+        for(h=0;h<25;h++){ //Whole day, then every hour
+                s=h?roll[n%ROLL_DAYS].hour[h-1]:roll[n%ROLL_DAYS].tot;
+                c=h?out->hour[h-1]:out->tot;
+                for(i=0;i<ROLL_TYPES;i++){
+                        c[i].cnt=__atomic_load_n(&s[i].cnt,__ATOMIC_RELAXED);
+                        c[i].sum=__atomic_load_n(&s[i].sum,__ATOMIC_RELAXED);
+                }
+        }
+        return 0;
+}
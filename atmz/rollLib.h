@@ -0,0 +1,62 @@
+#ifndef _ROLLLIB_H //If _ROLLLIB_H is not defined
+#define _ROLLLIB_H //Define _ROLLLIB_H to prevent multiple inclusions of this header file
+
+/*
+ * rollLib.h
+ *
+ * Bank-wide rollups: count and amount of every transaction type per day and
+ * per hour, kept up to date by addTran so "total deposits today" or
+ * "withdrawals by hour" need no walk over the accounts.
+ * The day and hour come from the transaction ID (YYYYMMDDHHMMSSRRR). The
+ * newest ROLL_DAYS days are kept, one RollDay per day, in a ring indexed by
+ * day number: the first transaction of a new day takes over the slot of the
+ * day ROLL_DAYS before it. rollAdd is O(1) and lock free (atomic adds); only
+ * that takeover is done under a mutex.
+ * The ring is saved with Db.snap (see snapLib.h) and loaded with it; when
+ * Db.csv is imported instead it is rebuilt from the loaded histories, and
+ * histories read later by histFault or added by the journal replay are
+ * added as they come in. The layout is shared with bankz/rollLib.h.
+ */
+
+#include "atmLib.h" //Acc, u64, i64
+
+#define ROLL_DAYS 64 //Days kept
+#define ROLL_TYPES 5 //Type slots: 0 for an unknown type, then WITHDRAW..TRANSFER_OUT
+
+typedef struct{ //Totals of one type in one period
+        u64 cnt; //Transactions
+        i64 sum; //Amount in paise (withdrawals and transfers out are negative)
+}RollCell;
+
+typedef struct{ //Rollups of one day
+        u64 day; //YYYYMMDD, 0 for an unused slot
+        RollCell tot[ROLL_TYPES]; //Whole day
+        RollCell hour[24][ROLL_TYPES]; //Hour by hour
+}RollDay;
+
+extern RollDay roll[ROLL_DAYS]; //Ring of the newest days (saved and loaded by snapLib)
+
+/**
+ * @brief Counts one transaction in its day and hour, in O(1).
+ * Transactions older than the days kept, or whose ID is not a time stamp, are not counted.
+ * @param id Transaction ID (YYYYMMDDHHMMSSRRR).
+ * @param amt Amount in paise.
+ * @param type WITHDRAW, DEPOSIT, TRANSFER_IN or TRANSFER_OUT.
+ */
+void rollAdd(u64 id,i64 amt,int type);
+
+/**
+ * @brief Clears the rollups and counts every transaction linked in the account list.
+ * @param head Pointer to the head of the account database.
+ */
+void rollBuild(Acc *head);
+
+/**
+ * @brief Copies the rollups of one day.
+ * @param day YYYYMMDD.
+ * @param out Rollups of the day (all zero if nothing happened that day).
+ * @return int 0 on success, -1 if the day is not a date or is older than the days kept.
+ */
+int rollGet(u64 day,RollDay *out);
+
+#endif //End of _ROLLLIB_H guard
@@ -0,0 +1,256 @@
+#include "rptLib.h" //Includes the rptLib.h header file for the report prototypes
+#include "lockLib.h" //Account stripes held while a row or a history head is copied
+#include "wrLib.h" //Buffered writer every report file goes through
+#include <pthread.h> //Report and statement threads
+
+int rptThreads; //Statement threads, 0 for one per online CPU
+
+typedef struct{ //One report being written
+        Acc **acc; //Accounts in list order
+        u64 cnt; //Number of accounts
+        int all; //RPT_ALL or RPT_CHANGED
+        u64 next; //First account no statement thread has taken yet
+        u64 stmts; //Statements written
+        u64 bytes; //Bytes written
+        u64 errs; //Files that failed
+        u64 t0; //Start time (ns)
+        pthread_mutex_t mx; //Guards next and the totals
+}RptJob;
+
+static pthread_mutex_t rmx=PTHREAD_MUTEX_INITIALIZER; //Guards running and last
+static pthread_cond_t rcv=PTHREAD_COND_INITIALIZER; //Signalled when a report ends
+static int running; //A report thread is active
+static RptStat last; //Figures of the last finished report
+
+/**
+ * @brief Returns a monotonic time stamp in nanoseconds.
+ * @return u64 Nanoseconds since an arbitrary point.
+ */
+static u64 nowNs(void){
+        struct timespec ts; //Monotonic clock reading
+        clock_gettime(CLOCK_MONOTONIC,&ts);
+        return ts.tv_sec*1000000000ULL+ts.tv_nsec;
+}
+
+/**
+ * @brief Appends a two-digit field without its leading zero, like "%u".
+ * @param w Writer.
+ * @param d The two digits.
+ */
+static void put2(Wr *w,const char *d){
+        if(d[0]=='0')wrChr(w,d[1]);
+        else wrMem(w,d,2);
+}
+
+/**
+ * @brief Appends one statement line: "%u/%u/%u,%u:%u,<id>,<amount>,<type>".
+ * A 17-digit ID (YYYYMMDDHHMMSSRRR, see getTranId) is formatted once and the date and
+ * time are cut from its digits; other IDs are split by division as before.
+ * @param w Writer.
+ * @param t Transaction.
+ */
+static void stmtLine(Wr *w,const Tran *t){
+        static const char *type[5]={"","Withdraw\n","Deposit\n","Tranfer IN\n","Tranfer OUT\n"}; //Type names ("Tranfer" typo kept)
+        char id[WR_NUM],*e=id+sizeof(id),*p=monDigits(e,t->id); //ID digits
+        u64 dum; //Time stamp being split
+        if(e-p==17){
+                put2(w,p+6); wrChr(w,'/'); put2(w,p+4); wrChr(w,'/'); wrMem(w,p,4); wrChr(w,',');
+                put2(w,p+8); wrChr(w,':'); put2(w,p+10);
+        }else{
+                dum=t->id/100000; //YYYYMMDDHHMM
+                wrU64(w,dum/10000%100,0); wrChr(w,'/'); wrU64(w,dum/1000000%100,0); wrChr(w,'/'); wrU64(w,dum/100000000,0); wrChr(w,',');
+                wrU64(w,dum/100%100,0); wrChr(w,':'); wrU64(w,dum%100,0);
+        }
+        wrChr(w,','); wrMem(w,p,e-p); wrChr(w,',');
+        wrMon(w,t->amt); wrChr(w,',');
+        if((t->type>=WITHDRAW)&&(t->type<=TRANSFER_OUT))wrStr(w,type[(int)t->type]);
+}
+
+/**
+ * @brief Writes one account's statement, "../filez/<num>.csv", newest transaction first.
+ * @param a Account.
+ * @param all Non-zero to write it even if the account is not marked DIRTY_RPT.
+ * @param w Writer to use (closed; its buffer is reused from file to file).
+ * @return int 1 if written, 0 if skipped (unchanged), -1 on a write error (the account stays marked).
+ */
+static int stmt(Acc *a,int all,Wr *w){
+        char name[40]; //Statement file name
+        Tran *t; //History walk
+        if(!all){ //Unchanged accounts are skipped
+                lockAcc(a);
+                all=a->dirty&DIRTY_RPT;
+                unlockAcc(a);
+                if(!all)return 0;
+        }
+        histFetch(a); //Whole history is printed; a lazy one is read without the lock
+        lockAcc(a);
+        t=a->tranHist; //Linked nodes do not change, the walk needs no lock
+        a->dirty&=~DIRTY_RPT; //Changes from now on go into the next report
+        unlockAcc(a);
+        sprintf(name,"../filez/%llu.csv",a->num);
+        if(wrOpen(w,name,0)){perror("saveFile: statement");goto fail;}
+        wrStr(w,"Date,Time,Transaction ID,Amount,Type\n");
+        for(;t;t=t->nxt)stmtLine(w,t);
+        if(!wrClose(w))return 1;
+        perror("saveFile: statement");
+fail:
+        lockAcc(a);
+        a->dirty|=DIRTY_RPT;
+        unlockAcc(a);
+        return -1;
+}
+
+/**
+ * @brief Statement thread: takes RPT_CHUNK accounts at a time until none is left.
+ * @param arg Pointer to the `RptJob`.
+ * @return void* NULL.
+ */
+static void* stmtWork(void *arg){
+        RptJob *j=arg; //Shared job
+        Wr w=WR_INIT; //This thread's writer
+        u64 i,end,n=0,bytes=0,errs=0; //Chunk taken, statements, bytes and failures of this thread
+        int r; //stmt result
+        for(;;){
+                pthread_mutex_lock(&j->mx);
+                i=j->next;
+                end=j->next=(i+RPT_CHUNK<j->cnt)?i+RPT_CHUNK:j->cnt;
+                pthread_mutex_unlock(&j->mx);
+                if(i>=end)break; //Every account is taken
+                for(;i<end;i++){
+                        if((r=stmt(j->acc[i],j->all,&w))>0){n++;bytes+=w.bytes;}
+                        else if(r<0)errs++;
+                }
+        }
+        wrFree(&w);
+        pthread_mutex_lock(&j->mx);
+        j->stmts+=n;
+        j->bytes+=bytes;
+        j->errs+=errs;
+        pthread_mutex_unlock(&j->mx);
+        return NULL;
+}
+
+/**
+ * @brief Writes "../filez/DataBase.csv" (through a ".tmp" name), one row per account,
+ * each row copied under its account's lock.
+ * @param j Job.
+ */
+static void dbRows(RptJob *j){
+        Wr w=WR_INIT; //DataBase.csv
+        Acc a; //Copy of one account
+        u64 i; //Account counter
+        int err=0; //Write error
+        if(wrOpen(&w,"../filez/DataBase.csv.tmp",0)){perror("saveFile: DataBase.csv");err=1;}
+        else{
+                wrStr(&w,"Account ID,Holder's name,Mobile no.,Username,Password,ATM card no.,ATM pin,Card Satus,Balance,Transactions count\n");
+                for(i=0;i<j->cnt;i++){
+                        lockAcc(j->acc[i]);
+                        a=*j->acc[i]; //Row as of now
+                        unlockAcc(j->acc[i]);
+                        wrU64(&w,a.num,0); wrChr(&w,',');
+                        wrStr(&w,a.name); wrChr(&w,',');
+                        wrU64(&w,a.phno,0); wrChr(&w,',');
+                        wrStr(&w,a.usrName); wrChr(&w,',');
+                        wrStr(&w,a.pass); wrChr(&w,',');
+                        wrStr(&w,a.rfid); wrChr(&w,',');
+                        wrStr(&w,a.pin); wrChr(&w,',');
+                        wrStr(&w,a.cardStat?"ACTIVE":"BLOCKED"); wrChr(&w,',');
+                        wrMon(&w,a.bal); wrChr(&w,',');
+                        wrU64(&w,a.tranCnt,0); wrChr(&w,'\n');
+                }
+                if(wrClose(&w)||rename("../filez/DataBase.csv.tmp","../filez/DataBase.csv")){perror("saveFile: DataBase.csv");err=1;}
+        }
+        wrFree(&w);
+        pthread_mutex_lock(&j->mx);
+        j->bytes+=w.bytes;
+        j->errs+=err;
+        pthread_mutex_unlock(&j->mx);
+}
+
+/**
+ * @brief Report thread: starts the statement threads, writes DataBase.csv meanwhile,
+ * waits for them, prints the figures and marks the report finished.
+ * @param arg Pointer to the `RptJob` (freed here).
+ * @return void* NULL.
+ */
+static void* rptWork(void *arg){
+        RptJob *j=arg; //Report
+        pthread_t th[RPT_THREADS_MAX]; //Statement threads
+        long nt=rptThreads?rptThreads:sysconf(_SC_NPROCESSORS_ONLN),i,run=0; //Threads asked for, counter, threads started
+        RptStat st; //Figures
+        if(nt>RPT_THREADS_MAX)nt=RPT_THREADS_MAX;
+        if(nt>(long)((j->cnt+RPT_CHUNK-1)/RPT_CHUNK))nt=(j->cnt+RPT_CHUNK-1)/RPT_CHUNK; //No idle threads
+        for(i=0;i<nt;i++)if(!pthread_create(&th[run],NULL,stmtWork,j))run++;
+        dbRows(j); //Alongside the statements
+        if(!run)stmtWork(j); //No thread could be started: statements here
+        for(i=0;i<run;i++)pthread_join(th[i],NULL);
+
+        st.accounts=j->cnt;
+        st.statements=j->stmts;
+        st.bytes=j->bytes;
+        st.errs=j->errs;
+        st.ms=(nowNs()-j->t0)/1e6;
+        printf("saveFile: %llu accounts, %llu statements, %.1f MB in %.1f ms (%.0f accounts/s)%s\n",st.accounts,st.statements,
+                        st.bytes/1048576.0,st.ms,st.accounts/((st.ms>0?st.ms:1e-3)/1e3),st.errs?", some files failed":"");
+        fflush(stdout);
+        pthread_mutex_destroy(&j->mx);
+        free(j->acc);
+        free(j);
+
+        pthread_mutex_lock(&rmx);
+        last=st;
+        running=0;
+        pthread_cond_broadcast(&rcv);
+        pthread_mutex_unlock(&rmx);
+        return NULL;
+}
+
+/**
+ * @brief Starts a report in the background.
+ * @param head Pointer to the head of the account database.
+ * @param all RPT_ALL or RPT_CHANGED.
+ * @return int 0 if started, 1 if one is already running, -1 on error.
+ */
+int rptStart(Acc *head,int all){
+        RptJob *j; //New report
+        pthread_t th; //Report thread
+        Acc *a; //Account iterator
+        u64 n=0; //Accounts
+        pthread_mutex_lock(&rmx);
+        if(running){pthread_mutex_unlock(&rmx);return 1;}
+        for(a=head;a;a=a->nxt)n++;
+        if(!(j=calloc(1,sizeof(RptJob)))||!(j->acc=malloc((n?n:1)*sizeof(Acc*)))){
+                free(j);
+                pthread_mutex_unlock(&rmx);
+                perror("saveFile");
+                return -1;
+        }
+        for(n=0,a=head;a;a=a->nxt)j->acc[n++]=a;
+        j->cnt=n;
+        j->all=all;
+        j->t0=nowNs();
+        pthread_mutex_init(&j->mx,NULL);
+        if(pthread_create(&th,NULL,rptWork,j)){
+                pthread_mutex_destroy(&j->mx);
+                free(j->acc);
+                free(j);
+                pthread_mutex_unlock(&rmx);
+                perror("saveFile: thread");
+                return -1;
+        }
+        pthread_detach(th); //rptWait waits on rcv instead of joining
+        running=1;
+        pthread_mutex_unlock(&rmx);
+        return 0;
+}
+
+/**
+ * @brief Waits until no report is running.
+ * @param st Figures of the last finished report (may be NULL).
+ */
+void rptWait(RptStat *st){
+        pthread_mutex_lock(&rmx);
+        while(running)pthread_cond_wait(&rcv,&rmx);
+        if(st)*st=last;
+        pthread_mutex_unlock(&rmx);
+}
@@ -0,0 +1,57 @@
+#ifndef _RPTLIB_H //If _RPTLIB_H is not defined
+#define _RPTLIB_H //Define _RPTLIB_H to prevent multiple inclusions of this header file
+
+/*
+ * rptLib.h
+ *
+ * Human-readable report (../filez/DataBase.csv and one statement per account)
+ * written in the background, so a #Q request or a quitting server never waits
+ * for it.
+ * rptStart hands the account list to a report thread and returns at once. The
+ * report thread streams DataBase.csv itself while `rptThreads` statement
+ * threads take RPT_CHUNK accounts at a time, each writing through its own Wr
+ * (one write() per WR_BUF bytes). An account is only locked (lockAcc) while
+ * its row or its history head is copied, or while a lazily loaded history
+ * read by histFetch is linked in; never while a file is read, formatted or
+ * written, so requests for it wait for one copy at most.
+ * Transaction nodes are never changed once linked (addTran only puts new ones
+ * in front), so a copied head stays valid without the lock.
+ * Every change sets the account's DIRTY_RPT bit; a report of RPT_CHANGED only
+ * rewrites the statements of marked accounts (DataBase.csv is always whole),
+ * and a change made while the report runs stays marked for the next one.
+ */
+
+#include "atmLib.h" //Acc, u64
+
+#define RPT_THREADS_MAX 16 //Most statement threads
+#define RPT_CHUNK 64 //Accounts a statement thread takes at a time
+
+#define RPT_CHANGED 0 //rptStart: statements of accounts changed since their last report
+#define RPT_ALL 1 //rptStart: statements of every account
+
+typedef struct{ //Figures of a finished report
+        u64 accounts; //Rows in DataBase.csv
+        u64 statements; //Statement files written
+        u64 bytes; //Bytes written, DataBase.csv included
+        u64 errs; //Files that could not be written (their accounts stay marked)
+        double ms; //Wall time from rptStart to the last file
+}RptStat;
+
+extern int rptThreads; //Statement threads, 0 for one per online CPU
+
+/**
+ * @brief Starts a report in the background.
+ * @param head Pointer to the head of the account database (the list itself must not change).
+ * @param all RPT_ALL for every statement, RPT_CHANGED for the changed ones.
+ * @return int 0 if started, 1 if a report is already running (changes stay marked for the next one),
+ * -1 if no thread or memory could be had.
+ */
+int rptStart(Acc *head,int all);
+
+/**
+ * @brief Waits until no report is running; returns at once when none is.
+ * @param st Receives the figures of the last finished report (may be NULL).
+ */
+void rptWait(RptStat *st);
+
+#endif //End of _RPTLIB_H guard
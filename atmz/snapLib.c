@@ -0,0 +1,152 @@
+#include "snapLib.h" //Includes the snapLib.h header file for the snapshot layout and prototypes
+#include "rollLib.h" //Rollup ring saved after the transactions
+#include <sys/mman.h> //mmap, madvise
+#include <sys/stat.h> //fstat
+
+#define SNAP_TMP SNAP_FILE".tmp" //Snapshot being written
+
+/**
+ * @brief Writes the whole database to SNAP_FILE.
+ * Two passes over the list: one for the header counts and account records,
+ * one for the transaction array; the rollup ring follows.
+ * @param head Pointer to the head of the account database.
+ * @return int 0 on success, -1 on error (the previous snapshot is kept).
+ */
+int saveSnap(Acc *head){
+        SnapHdr h; //File header
+        SnapAcc r; //Account record being written
+        Tran t; //Transaction record being written (nxt always NULL on disk)
+        Acc *a; //Account iterator
+        Tran *c; //Transaction iterator
+        u64 off=0; //Next free slot in the transaction array
+        FILE *fp=fopen(SNAP_TMP,"w"); //Temporary file, renamed over the old snapshot when complete
+        if(!fp){perror("saveSnap");return -1;}
+        setvbuf(fp,NULL,_IOFBF,1<<20); //Large buffer, the file is written strictly sequentially
+
+        memset(&h,0,sizeof(h)); //Zeroes padding and reserved fields
+        strcpy(h.magic,SNAP_MAGIC);
+        h.ver=SNAP_VER;
+        h.accSz=sizeof(SnapAcc);
+        h.tranSz=sizeof(Tran);
+        h.rollSz=sizeof(RollDay);
+        h.rollDays=ROLL_DAYS;
+        h.flags=SNAP_CLEAN; //Cleared below if any account has unsaved changes
+        for(a=head;a;a=a->nxt)histFault(a); //Every transaction goes into the snapshot
+        for(a=head;a;a=a->nxt){ //Counts records for the header
+                h.accCnt++;
+                h.tranCnt+=a->tranCnt;
+                if(a->dirty&(DIRTY_ROW|DIRTY_HIST))h.flags&=~SNAP_CLEAN; //CSV files are behind this snapshot
+        }
+        fwrite(&h,sizeof(h),1,fp);
+
+        for(a=head;a;a=a->nxt){ //Account records, each pointing at its slice of the transaction array
+                memset(&r,0,sizeof(r)); //No stale stack bytes in the file
+                r.num=a->num;
+                r.bal=a->bal;
+                r.phno=a->phno;
+                memcpy(r.usrName,a->usrName,strnlen(a->usrName,sizeof(r.usrName)-1));
+                memcpy(r.pass,a->pass,strnlen(a->pass,sizeof(r.pass)-1));
+                memcpy(r.rfid,a->rfid,strnlen(a->rfid,sizeof(r.rfid)-1));
+                memcpy(r.pin,a->pin,strnlen(a->pin,sizeof(r.pin)-1));
+                memcpy(r.name,a->name,strnlen(a->name,sizeof(r.name)-1));
+                r.cardStat=a->cardStat;
+                r.tranOff=off;
+                r.tranCnt=a->tranCnt;
+                off+=a->tranCnt; //Slices are laid out in list order
+                fwrite(&r,sizeof(r),1,fp);
+        }
+        for(a=head;a;a=a->nxt){ //Transaction array
+                u64 n=0; //Records written for this account
+                for(c=a->tranHist;c&&(n<a->tranCnt);c=c->nxt,n++){ //Newest first, as in memory
+                        memset(&t,0,sizeof(t));
+                        t.amt=c->amt;
+                        t.id=c->id;
+                        t.type=c->type;
+                        fwrite(&t,sizeof(t),1,fp);
+                }
+                memset(&t,0,sizeof(t)); //Pads a list shorter than tranCnt so offsets stay valid
+                for(;n<a->tranCnt;n++)fwrite(&t,sizeof(t),1,fp);
+        }
+        fwrite(roll,sizeof(roll),1,fp); //Rollups of the transactions above
+        int err=ferror(fp)||fflush(fp)||fsync(fileno(fp)); //Everything must reach the disk before the rename
+        if(fclose(fp)||err){
+                perror("saveSnap");
+                unlink(SNAP_TMP);
+                return -1;
+        }
+        if(rename(SNAP_TMP,SNAP_FILE)){perror("saveSnap");return -1;} //Atomically replaces the previous snapshot
+        return 0; //Success
+}
+
+/**
+ * @brief Loads SNAP_FILE into memory.
+ * The file is mapped MAP_PRIVATE and writable: linking the transaction records only
+ * dirties the mapped pages of this process, the file itself is never modified.
+ * The mapping is kept for the lifetime of the process.
+ * @param head Pointer to the head pointer of the (empty) account list.
+ * @return int 0 on success, -1 if the file is missing, damaged or from another build.
+ */
+int loadSnap(Acc **head){
+        struct stat st; //File size
+        char *m; //Mapped file
+        SnapHdr *h; //Header inside the mapping
+        SnapAcc *ra; //Account records inside the mapping
+        Tran *rt; //Transaction array inside the mapping
+        Acc *a=NULL; //Account nodes built from the records
+        u64 i,j; //Record counters
+        int fd=open(SNAP_FILE,O_RDONLY); //Snapshot file
+        if(fd<0)return -1; //No snapshot
+        if(fstat(fd,&st)||(st.st_size<(off_t)sizeof(SnapHdr))){close(fd);return -1;} //Too short for a header
+        m=mmap(NULL,st.st_size,PROT_READ|PROT_WRITE,MAP_PRIVATE,fd,0); //Private copy-on-write mapping
+        close(fd); //The mapping keeps the file referenced
+        if(m==MAP_FAILED){perror("loadSnap");return -1;}
+        madvise(m,st.st_size,MADV_SEQUENTIAL); //Pages are touched front to back
+
+        h=(SnapHdr*)m;
+        if(memcmp(h->magic,SNAP_MAGIC,sizeof(SNAP_MAGIC))||(h->ver!=SNAP_VER)||
+                        (h->accSz!=sizeof(SnapAcc))||(h->tranSz!=sizeof(Tran))||(h->rollSz!=sizeof(RollDay))||(h->rollDays!=ROLL_DAYS)||
+                        (h->accCnt>(u64)st.st_size/sizeof(SnapAcc))||(h->tranCnt>(u64)st.st_size/sizeof(Tran))||
+                        (sizeof(SnapHdr)+h->accCnt*sizeof(SnapAcc)+h->tranCnt*sizeof(Tran)+sizeof(roll)!=(u64)st.st_size)){ //Wrong file, version, build or size
+                fputs("loadSnap: "SNAP_FILE" is not a valid snapshot\n",stderr);
+                goto bad;
+        }
+        ra=(SnapAcc*)(m+sizeof(SnapHdr));
+        rt=(Tran*)(ra+h->accCnt);
+        if(h->accCnt&&!(a=calloc(h->accCnt,sizeof(Acc)))){perror("loadSnap");goto bad;} //One block for every account
+
+        for(i=0;i<h->accCnt;i++){
+                SnapAcc *r=&ra[i];
+                if((r->tranOff>h->tranCnt)||(r->tranCnt>h->tranCnt-r->tranOff)){ //Slice outside the transaction array
+                        fputs("loadSnap: damaged account record\n",stderr);
+                        goto bad;
+                }
+                a[i].num=r->num;
+                a[i].bal=r->bal;
+                a[i].phno=r->phno;
+                memcpy(a[i].usrName,r->usrName,sizeof(r->usrName)); a[i].usrName[sizeof(r->usrName)-1]='\0'; //Copies and terminates every string
+                memcpy(a[i].pass,r->pass,sizeof(r->pass)); a[i].pass[sizeof(r->pass)-1]='\0';
+                memcpy(a[i].rfid,r->rfid,sizeof(r->rfid)); a[i].rfid[sizeof(r->rfid)-1]='\0';
+                memcpy(a[i].pin,r->pin,sizeof(r->pin)); a[i].pin[sizeof(r->pin)-1]='\0';
+                memcpy(a[i].name,r->name,sizeof(r->name)); a[i].name[sizeof(r->name)-1]='\0';
+                a[i].cardStat=r->cardStat;
+                a[i].dirty=(h->flags&SNAP_CLEAN)?0:DIRTY_ROW|DIRTY_HIST; //CSV files of an unclean snapshot are stale
+                a[i].tranCnt=r->tranCnt;
+                a[i].tranSaved=(h->flags&SNAP_CLEAN)?r->tranCnt:0; //A clean snapshot matches every history file
+                if(lazyHist&&r->tranCnt){ //Slice is linked by histFault on first use, its pages stay untouched
+                        a[i].tranLazy=r->tranCnt;
+                        a[i].tranOld=&rt[r->tranOff];
+                }else{
+                        a[i].tranHist=r->tranCnt?&rt[r->tranOff]:NULL; //History starts at the account's slice
+                        for(j=0;j+1<r->tranCnt;j++)rt[r->tranOff+j].nxt=&rt[r->tranOff+j+1]; //Links the slice in place
+                        if(r->tranCnt)rt[r->tranOff+r->tranCnt-1].nxt=NULL; //Terminates the history
+                }
+                a[i].nxt=(i+1<h->accCnt)?&a[i+1]:NULL; //Links the accounts in file order
+        }
+        memcpy(roll,rt+h->tranCnt,sizeof(roll)); //Rollups of the loaded transactions
+        *head=a; //Publishes the loaded list
+        return 0; //Success
+bad:
+        free(a); //Nothing was published
+        munmap(m,st.st_size);
+        return -1;
+}
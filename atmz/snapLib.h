@@ -0,0 +1,68 @@
+#ifndef _SNAPLIB_H //If _SNAPLIB_H is not defined
+#define _SNAPLIB_H //Define _SNAPLIB_H to prevent multiple inclusions of this header file
+
+/*
+ * snapLib.h
+ *
+ * Binary snapshot of the account database (../dataz/Db.snap).
+ * Layout: SnapHdr, then accCnt fixed-size SnapAcc records, then one contiguous
+ * array of tranCnt Tran records, then the rollup ring (rollDays RollDay records,
+ * see rollLib.h). Each account's transactions are a slice of that array
+ * (newest first, as in tranHist). The loader mmaps the file
+ * privately and links the Tran records in place, so no transaction is parsed
+ * or allocated at startup. Db.csv stays the import/export format.
+ * The format is machine specific: the header records the record sizes and a
+ * snapshot written by a different build is rejected (syncData then imports Db.csv).
+ */
+
+#include "atmLib.h" //Acc, Tran, u64, i64
+
+#define SNAP_FILE  "../dataz/Db.snap" //Snapshot file
+#define SNAP_MAGIC "ATMSNAP" //First 8 bytes of every snapshot (with the null terminator)
+#define SNAP_VER   4 //Format version, bumped whenever SnapAcc, Tran or the CSV layout a clean snapshot vouches for change
+#define SNAP_CLEAN 1 //SnapHdr flag: written with no account dirty, so Db.csv and the history files hold the same state
+
+typedef struct{ //Snapshot file header
+        char magic[8]; //SNAP_MAGIC
+        unsigned int ver; //SNAP_VER
+        unsigned int accSz; //sizeof(SnapAcc) of the writer
+        unsigned int tranSz; //sizeof(Tran) of the writer
+        unsigned int flags; //SNAP_CLEAN or 0 (older snapshots: 0)
+        unsigned int rollSz; //sizeof(RollDay) of the writer
+        unsigned int rollDays; //ROLL_DAYS of the writer
+        u64 accCnt; //Number of account records
+        u64 tranCnt; //Number of transaction records
+}SnapHdr;
+
+typedef struct{ //Fixed-size account record
+        u64 num; //Account number
+        i64 bal; //Balance in paise
+        u64 phno; //Phone number
+        char usrName[MAX_USRN_LEN]; //Username
+        char pass[MAX_PASS_LEN]; //Password
+        char rfid[9]; //RFID card number
+        char pin[5]; //ATM PIN
+        char name[NAME_LEN]; //Holder name
+        int cardStat; //Card status
+        u64 tranOff; //Index of the account's newest transaction in the transaction array
+        u64 tranCnt; //Number of transactions of the account
+}SnapAcc;
+
+/**
+ * @brief Writes the whole database to SNAP_FILE (via a temporary file and rename).
+ * Reads every lazily loaded history in (histFault), so the server calls it in a
+ * child process (jrnCheckpoint, jrnFlush) whose memory is dropped afterwards.
+ * @param head Pointer to the head of the account database.
+ * @return int 0 on success, -1 on error (the previous snapshot is kept).
+ */
+int saveSnap(Acc *head);
+
+/**
+ * @brief Loads SNAP_FILE into memory.
+ * Accounts are copied into one Acc array; transactions are used in place from the private mapping.
+ * @param head Pointer to the head pointer of the (empty) account list.
+ * @return int 0 on success, -1 if the file is missing, damaged or from another build.
+ */
+int loadSnap(Acc **head);
+
+#endif //End of _SNAPLIB_H guard
@@ -0,0 +1,138 @@
+#include "wrLib.h" //Includes the wrLib.h header file for the Wr structure and prototypes
+
+/**
+ * @brief Makes room for n more bytes by flushing a buffer that cannot take them.
+ * @param w Writer.
+ * @param n Bytes about to be added (at most WR_BUF).
+ */
+static void room(Wr *w,size_t n){
+        if(WR_BUF-w->len<n)wrFlush(w); //On a write error the bytes are dropped and err stays set
+}
+
+/**
+ * @brief Opens (or creates) a file for writing.
+ * @param w Writer, closed.
+ * @param path File name.
+ * @param append Non-zero to append, zero to truncate.
+ * @return int 0 on success, -1 on error (errno set).
+ */
+int wrOpen(Wr *w,const char *path,int append){
+        if(!w->buf&&!(w->buf=malloc(WR_BUF)))return -1; //First file of this writer
+        w->fd=open(path,O_WRONLY|O_CREAT|(append?O_APPEND:O_TRUNC),0644);
+        w->err=0;
+        w->len=0;
+        w->bytes=0;
+        return (w->fd<0)?-1:0;
+}
+
+/**
+ * @brief Writes the buffered bytes, retrying short writes.
+ * @param w Writer.
+ * @return int 0 on success, -1 if this or an earlier write failed.
+ */
+int wrFlush(Wr *w){
+        size_t off=0; //Bytes of the buffer written so far
+        ssize_t r; //Result of one write
+        while(!w->err&&(off<w->len)){
+                r=write(w->fd,w->buf+off,w->len-off);
+                if(r>0){off+=r;continue;}
+                if((r<0)&&(errno==EINTR))continue;
+                w->err=r?errno:EIO; //A zero length write would loop forever
+        }
+        w->bytes+=off;
+        w->len=0; //Bytes that could not be written are dropped, err reports them
+        return w->err?-1:0;
+}
+
+/**
+ * @brief Flushes and closes the file; the buffer is kept.
+ * @param w Writer.
+ * @return int 0 on success, -1 if any write or the close failed (errno set).
+ */
+int wrClose(Wr *w){
+        wrFlush(w);
+        if(close(w->fd)&&!w->err)w->err=errno;
+        w->fd=-1;
+        if(w->err)errno=w->err; //For the caller's perror
+        return w->err?-1:0;
+}
+
+/**
+ * @brief Releases the buffer of a closed writer.
+ * @param w Writer.
+ */
+void wrFree(Wr *w){
+        free(w->buf);
+        w->buf=NULL;
+}
+
+/**
+ * @brief Appends bytes; a block larger than the buffer is written straight through.
+ * @param w Writer.
+ * @param p Bytes.
+ * @param n Number of bytes.
+ */
+void wrMem(Wr *w,const char *p,size_t n){
+        size_t k; //Bytes of one piece
+        while(n){
+                if(w->len==WR_BUF)wrFlush(w);
+                k=(n<WR_BUF-w->len)?n:WR_BUF-w->len;
+                memcpy(w->buf+w->len,p,k);
+                w->len+=k;
+                p+=k;
+                n-=k;
+        }
+}
+
+/**
+ * @brief Appends a null-terminated string.
+ * @param w Writer.
+ * @param s String.
+ */
+void wrStr(Wr *w,const char *s){
+        wrMem(w,s,strlen(s));
+}
+
+/**
+ * @brief Appends one character.
+ * @param w Writer.
+ * @param c Character.
+ */
+void wrChr(Wr *w,char c){
+        room(w,1);
+        w->buf[w->len++]=c;
+}
+
+/**
+ * @brief Appends an unsigned number in decimal, zero padded to `width` digits.
+ * @param w Writer.
+ * @param v Value.
+ * @param width Minimum number of digits.
+ */
+void wrU64(Wr *w,u64 v,int width){
+        char tmp[WR_NUM],*end=tmp+sizeof(tmp),*p=monDigits(end,v); //Digits, built backwards
+        while((end-p<width)&&(p>tmp))*--p='0';
+        room(w,end-p);
+        memcpy(w->buf+w->len,p,end-p);
+        w->len+=end-p;
+}
+
+/**
+ * @brief Appends a signed number in decimal.
+ * @param w Writer.
+ * @param v Value.
+ */
+void wrI64(Wr *w,i64 v){
+        if(v<0){wrChr(w,'-');wrU64(w,0ULL-(u64)v,0);}
+        else wrU64(w,(u64)v,0);
+}
+
+/**
+ * @brief Appends an amount in paise as rupees with two decimals.
+ * @param w Writer.
+ * @param v Amount in paise.
+ */
+void wrMon(Wr *w,i64 v){
+        room(w,MON_LEN); //monFmt also writes a null, which the next field overwrites
+        w->len+=monFmt(w->buf+w->len,v);
+}
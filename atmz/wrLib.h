@@ -0,0 +1,105 @@
+#ifndef _WRLIB_H //If _WRLIB_H is not defined
+#define _WRLIB_H //Define _WRLIB_H to prevent multiple inclusions of this header file
+
+/*
+ * wrLib.h
+ *
+ * Buffered output writer for the CSV and report files (Db.csv, history files,
+ * ../filez statements).
+ * Fields are formatted straight into a large user-space buffer, numbers with
+ * monDigits and amounts with monFmt instead of fprintf's format interpreter,
+ * and the buffer leaves with one write() per WR_BUF bytes. The buffer is
+ * allocated by the first wrOpen and kept by later ones, so one Wr can write
+ * any number of small files (one per account) without a malloc per file.
+ * A failed write is remembered; wrClose reports it, like fclose after fprintf.
+ */
+
+#include "atmLib.h" //u64, i64
+
+#define WR_BUF (1<<20) //Buffered bytes per write() system call
+#define WR_NUM 24 //Room one number or amount needs in the buffer
+
+typedef struct{ //One output file being written
+        int fd; //Destination file, -1 when closed
+        int err; //errno of the first failed write or close, 0 if none
+        char *buf; //Output buffer (WR_BUF bytes), kept across files until wrFree
+        size_t len; //Bytes waiting in buf
+        u64 bytes; //Bytes written to the file since wrOpen (valid after wrFlush or wrClose)
+}Wr;
+
+#define WR_INIT {-1,0,NULL,0,0} //Static initializer, no buffer yet
+
+/**
+ * @brief Opens (or creates, mode 0644) a file for writing.
+ * @param w Writer, closed.
+ * @param path File name.
+ * @param append Non-zero: writes go to the end of the file; zero: the file is truncated.
+ * @return int 0 on success, -1 if the file or the buffer could not be had (errno set).
+ */
+int wrOpen(Wr *w,const char *path,int append);
+
+/**
+ * @brief Writes the buffered bytes to the file.
+ * @param w Writer.
+ * @return int 0 on success, -1 if this or an earlier write failed.
+ */
+int wrFlush(Wr *w);
+
+/**
+ * @brief Flushes and closes the file; the buffer is kept for the next wrOpen.
+ * @param w Writer.
+ * @return int 0 on success, -1 if any write or the close failed (errno set).
+ */
+int wrClose(Wr *w);
+
+/**
+ * @brief Releases the buffer of a closed writer.
+ * @param w Writer.
+ */
+void wrFree(Wr *w);
+
+/**
+ * @brief Appends bytes.
+ * @param w Writer.
+ * @param p Bytes.
+ * @param n Number of bytes.
+ */
+void wrMem(Wr *w,const char *p,size_t n);
+
+/**
+ * @brief Appends a null-terminated string.
+ * @param w Writer.
+ * @param s String.
+ */
+void wrStr(Wr *w,const char *s);
+
+/**
+ * @brief Appends one character.
+ * @param w Writer.
+ * @param c Character.
+ */
+void wrChr(Wr *w,char c);
+
+/**
+ * @brief Appends an unsigned number in decimal, like "%0*llu".
+ * @param w Writer.
+ * @param v Value.
+ * @param width Minimum number of digits, zero padded (0 or 1 for none).
+ */
+void wrU64(Wr *w,u64 v,int width);
+
+/**
+ * @brief Appends a signed number in decimal, like "%lld".
+ * @param w Writer.
+ * @param v Value.
+ */
+void wrI64(Wr *w,i64 v);
+
+/**
+ * @brief Appends an amount in paise as rupees with two decimals (monFmt).
+ * @param w Writer.
+ * @param v Amount in paise.
+ */
+void wrMon(Wr *w,i64 v);
+
+#endif //End of _WRLIB_H guard
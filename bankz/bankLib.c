@@ -8,13 +8,22 @@
 
 #include <termios.h>   // For terminal I/O control (used in getch and the commented getKey).
 #include <fcntl.h>     // For file control options (used in getch).
+#include <sys/stat.h>  // For stat (snapshot and Db.csv modification times).
+#include "snapLib.h"   // Binary snapshot of the account database.
+#include "lockLib.h"   // Striped account locks (transfer).
+#include "idxLib.h"    // Username, phone, account number and RFID indexes.
+#include "poolLib.h"   // Slabs for account, transaction and name memory.
+#include "wrLib.h"     // Buffered writer for Db.csv, history files and reports.
+#include "csvLib.h"    // Vectorized reader for Db.csv and history files.
+#include "rollLib.h"   // Per-day and per-hour rollups.
+#include "stmtLib.h"   // Time-ordered history for date-range statements.
 
 // This file contains the implementation of the functions
 // declared in bankLib.h for the banking application.
 
 // Constant definition for szDb, likely intended for calculating the size of a database record for binary I/O.
 // However, current file operations use CSV (text-based) format.
-const int szDb=(sizeof(u64)*2+sizeof(f64)+sizeof(char)*(MAX_USRN_LEN+MAX_PASS_LEN));
+const int szDb=(sizeof(u64)*2+sizeof(i64)+sizeof(char)*(MAX_USRN_LEN+MAX_PASS_LEN));
 
 /**
  * @brief Displays the initial login menu.
@@ -34,6 +43,7 @@ void adminMenu(void){
                        "[KEY]  : ACTION\n"                         // Header for menu options.
                        "c/C    : Create New account.\n"            // Option to create an account.
                        "u/U    : Update Existing account.\n"       // Option to update an account.
+                       "r/R    : Remove (close) account.\n"        // Option to close an account.
                        "h/H    : Transaction history.\n"           // Option to view transaction history.
                        "w/W    : Withdraw amount.\n"               // Option to withdraw amount.
                        "d/D    : Deposit amount.\n"                // Option to deposit amount.
@@ -42,6 +52,7 @@ void adminMenu(void){
                        "x/X    : Activate card.\n"                 // Option to change card status.
                        "e/E    : Display all accounts details.\n"  // Option to display all accounts.
                        "f/F    : Finding/searching for specific account.\n" // Option to find an account.
+                       "s/S    : Day/hour totals (rollups).\n"   // Option to view the bank-wide rollups.
                        "q/Q    : Quit from app.\n"BYELLOW          // Option to quit the application.
                        "Enter choice:"RESET);                     // Prompt for choice.
 }
@@ -91,12 +102,9 @@ void menu(void){ // This function seems to be a duplicate or alternative general
  * @return A pointer to the matching `Acc` structure if credentials are valid, otherwise `NULL`.
  */
 Acc* isValid(Acc *head,char *usr,char *pass){
-        while(head){ // Iterate through the linked list of accounts.
-                if((!strcmp(usr,head->usrName))&&(!strcmp(pass,head->pass))) // Check if both username and password match.
-                         break; // If match found, exit loop.
-                head=head->nxt; // Move to the next account.
-        }
-        return head; // Return the pointer to the matched account, or NULL if no match.
+        Acc *a=idxUsr(usr); // Account with this username, found through the username index.
+        (void)head; // The list itself is not walked any more.
+        return (a&&!strcmp(pass,a->pass))?a:NULL; // Return the account if the password matches, otherwise NULL.
 }
 
 /**
@@ -106,8 +114,7 @@ Acc* isValid(Acc *head,char *usr,char *pass){
  */
 void newAcc( Acc **head){
         char *temp=NULL,flag=1; // temp: temporary string buffer, flag: for loop control and error indication.
-        double d; // Temporary variable for double input (initial balance).
-        Acc *new=calloc(1,sizeof(Acc)); // Allocate memory for a new account structure and initialize to zero.
+        Acc *new=poolGet(&accPool); // Zeroed account node from the slab.
         new->tranHist=NULL; // Initialize transaction history pointer to NULL.
         new->tranCnt=0;     // Initialize transaction count to 0.
         new->num=getUnqId(*head); // Generate a unique account number.
@@ -117,7 +124,7 @@ void newAcc( Acc **head){
         if(strlen(new->name)<3){  // Validate name length.
                 puts("no name");      // Inform user of invalid name.
                 free(new->name);      // Free allocated memory for name.
-                free(new);            // Free allocated memory for the new account structure.
+                poolPut(&accPool,new); // Return the account node.
                 return;               // Exit function if name is invalid.
         }
         format(new->name); // Format the name (e.g., capitalize first letters).
@@ -221,9 +228,8 @@ void newAcc( Acc **head){
         while(flag){ // Loop until a positive opening amount is entered.
                 if(flag>1)printf("Enter an posivite amount:"); // Display error/reminder.
                 else printf("Enter Opening Amount:"); // Prompt for opening balance.
-                scanf("%lf",&d); // Read opening balance. Note: this will add a transaction.
-                if(d>0){ // Validate if amount is positive.
-                        new->bal=d; // Set account balance.
+                new->bal=getAmt(); // Read opening balance. Note: this will add a transaction.
+                if(new->bal>0){ // Validate if amount is positive.
                         break;      // Exit loop.
                 }else flag++; // Increment flag if amount is not positive.
         }
@@ -232,7 +238,10 @@ void newAcc( Acc **head){
         dispAcc(new); // Display the details of the newly created account.
         //add to database (linked list)
         new->nxt=*head; // New account points to the current head of the list.
+        new->prv=NULL;  // New account is the new head.
+        if(*head)(*head)->prv=new; // Old head now has a predecessor.
         *head=new;      // The head of the list now points to the new account.
+        if(idxAdd(new))perror("newAcc: index"); // Make the account findable by username, phone, number and card.
         puts(BGREEN"Account Created."RESET); // Confirmation message.
 }
 
@@ -243,12 +252,9 @@ void newAcc( Acc **head){
  * @return 1 if the username is unique, 0 otherwise.
  */
 int isUnq(Acc *head,char *str){
+        (void)head; // Usernames are looked up in the username index.
         if(!strcmp(str,ADMIN_USRN)) return 0; // Username cannot be the admin's username.
-        while(head){ // Iterate through the accounts list.
-                if(!strcmp(str,head->usrName)) return 0; // If username matches an existing one, it's not unique.
-                head=head->nxt; // Move to the next account.
-        }
-        return 1; // If loop completes without finding a match, username is unique.
+        return !idxUsr(str); // Unique if no account has this username.
 }
 
 /**
@@ -258,11 +264,8 @@ int isUnq(Acc *head,char *str){
  * @return 1 if the RFID is new/unique, 0 otherwise.
  */
 int isNewRFID(Acc *head,char *rf){
-        while(head){ // Iterate through the accounts list.
-                if(!strcmp(rf,head->rfid)) return 0; // If RFID matches an existing one, it's not new.
-                head=head->nxt; // Move to the next account.
-        }
-        return 1; // If loop completes without finding a match, RFID is new.
+        (void)head; // Cards are looked up in the RFID index.
+        return !idxRfid(rf); // New if no account holds this card.
 }
 
 /**
@@ -274,21 +277,12 @@ int isNewRFID(Acc *head,char *rf){
  */
 u64 getUnqId(Acc *head){
         u64 num; // Variable to store the generated account number.
-        Acc *temp=NULL; // Temporary pointer to traverse the accounts list.
         int found=1; // Flag to control the loop, 1 means a collision was found or first run.
         while(found){ // Loop until a unique number is generated.
                 srand(getpid()+ (unsigned int)head); // Seed the random number generator. Using head's address might not be ideal if head is often NULL or changes predictably.
                 //18 digit unq ID
                 num=getTimeStamp()*10000 +(rand()%10000); // Generate number: timestamp (14 digits) * 10000 + 4 random digits.
-                temp=head; // Start checking from the beginning of the list.
-                found=0;   // Assume unique initially for this iteration.
-                while(temp){ // Traverse existing accounts.
-                        if(num==temp->num){ // If generated number matches an existing one.
-                                found=1;      // Set flag to indicate collision.
-                                break;        // Exit inner loop.
-                        }
-                        temp=temp->nxt; // Move to the next account.
-                }
+                found=(idxNum(num)!=NULL); // Collision if an account already has this number.
         }
         return num; // Return the unique account number.
 }
@@ -299,14 +293,14 @@ u64 getUnqId(Acc *head){
  */
 u64 getTimeStamp(void){
     time_t rawtime; // Variable to store raw time value.
-    struct tm *timeinfo; // Pointer to structure holding broken-down time.
+    struct tm tmBuf,*timeinfo; // Broken-down time, in a caller-owned buffer (thread-safe).
 
     // Get current UTC time
     time(&rawtime); // Get current calendar time.
 
     // Convert to IST (UTC +5:30)
    // rawtime +=19800;  // 19800 seconds = 5 hours 30 minutes // Commented out: IST conversion is not applied. Uses local time.
-    timeinfo =localtime(&rawtime); // Convert rawtime to local time structure.
+    timeinfo =localtime_r(&rawtime,&tmBuf); // Convert rawtime to local time structure.
 
     // Format as YYYYMMDDHHMMSS (14-digit ID)
     u64 timeStamp = // Construct the timestamp value.
@@ -333,6 +327,17 @@ char *getStr(void){
         return strdup(buff);     // Duplicate the string into dynamically allocated memory and return it.
 }
 
+/**
+ * @brief Reads an amount in rupees from standard input and converts it with monParse.
+ * @return The amount in paise, 0 if the input is not an amount (callers reject it as non-positive).
+ */
+i64 getAmt(void){
+        char buff[MON_LEN]={0}; // Amount as typed.
+        i64 amt; // Converted amount.
+        if(scanf("%23s",buff)!=1)return 0; // End of input.
+        return monParse(buff,strlen(buff),&amt)?0:amt;
+}
+
 /**
  * @brief Gets a single character from standard input without waiting for Enter (non-blocking).
  * This function is platform-dependent (uses termios for Unix-like systems).
@@ -475,10 +480,13 @@ void updateAcc(Acc **head,Acc *usr){ // usr is the account to be updated. head i
         key=getKey(); // Get user's choice.
         __fpurge(stdin); // Clear input buffer.
         puts(""); // Print a newline.
+        usr->dirty|=DIRTY_ROW; // Any choice may change the Db.csv row; a needless mark only costs a rewrite of Db.csv.
         switch(key){ // Process based on user's choice.
                 case 'P': // Update Phone number.
                         printf("Enter New phone number:");
+                        idxDel(&phIdx,usr); // Unindex the old number before it is overwritten.
                         scanf("%llu",&(usr->phno)); // Read new phone number.
+                        if(idxPut(&phIdx,usr))perror("updateAcc: index"); // Index the new number.
                         puts(BGREEN"Mobile Updated."RESET); // Confirmation.
                         break;
                 case 'O': // Update account hOlder's name.
@@ -496,7 +504,9 @@ void updateAcc(Acc **head,Acc *usr){ // usr is the account to be updated. head i
                         // It's safer to: free(usr->name); usr->name = temp;
                         // However, sticking to "don't touch code", this is how it is.
                         format(temp); // Format the new name.
+                        idxNameDel(usr); // Unindex the words of the old name.
                         usr->name=temp; // Assign new name. temp is not freed if it becomes the new name.
+                        if(idxNamePut(usr))perror("updateAcc: index"); // Index the new words.
                         puts(BGREEN"Name Updated."RESET); // Confirmation.
                         break;
                 case 'U': // Update Username.
@@ -525,7 +535,9 @@ void updateAcc(Acc **head,Acc *usr){ // usr is the account to be updated. head i
                                                 return; // Or handle appropriately. Assuming return for safety.
                                         }
                                 }else if(isUnq(*head,temp)){ // Check if new username is unique.
+                                        idxDel(&usrIdx,usr); // Unindex the old username.
                                         strcpy(usr->usrName,temp); // Copy new username.
+                                        if(idxPut(&usrIdx,usr))perror("updateAcc: index"); // Index the new one.
                                         free(temp); // Free temporary string.
                                         flag=0; // Exit loop.
                                 }else{
@@ -620,11 +632,13 @@ void accMenu(void){
  * @param usr Pointer to the `Acc` structure whose details are to be printed.
  */
 void dispAcc(Acc *usr){
+        char bal[MON_LEN];                       // Balance in rupees.
+        monFmt(bal,usr->bal);
         puts(BBLUE"\n==:Account Details:=="RESET); // Section title.
         printf("AccNo.:%llu\n",usr->num);        // Print account number.
         printf("Name  :%s\n",usr->name);         // Print account holder's name.
         printf("Ph.No.:%llu\n",usr->phno);       // Print phone number.
-        printf("Balanc:%lf\n",usr->bal);        // Print current balance.
+        printf("Balanc:%s\n",bal);               // Print current balance.
         printf("Usrnam:%s\n",usr->usrName);      // Print username.
         printf("Passwd:%s\n",usr->pass);        // Print password (for admin/debug, not for user).
         printf("RFID  :%s\n",usr->rfid);         // Print RFID.
@@ -644,6 +658,8 @@ void dispAcc(Acc *usr){
 Acc* getAcc(Acc *head){
         u64 num=0; // Variable for numerical search input (phone/account number).
         char key='\0',*str=NULL; // key for menu choice, str for string search input (name/username).
+        Acc *cand[IDX_NAME_MAX]; // Holder name candidates, best match first.
+        int n,i; // Number of candidates, candidate counter.
         printf( BBLUE"Find by:\n" // Menu for search options.
                 "[KEY]-ACTION\n"
                 "p/P  -Phone number.\n"
@@ -658,36 +674,32 @@ Acc* getAcc(Acc *head){
                 case 'P': // Search by Phone number.
                         printf("Enter phone number:");
                         scanf("%llu",&num); // Read phone number to search.
-                        while(head){ // Traverse list.
-                                if(num==head->phno)break; // Found.
-                                head=head->nxt;
-                        }
+                        head=idxPhone(num); // Newest account with this number.
                         break;
                 case 'N': // Search by Account number.
                         printf("Enter account number:");
                         scanf("%llu",&num); // Read account number to search.
-                        while(head){ // Traverse list.
-                                if(num==head->num)break; // Found.
-                                head=head->nxt;
-                        }
+                        head=idxNum(num); // Account number index.
                         break;
                 case 'O': // Search by hOlder name.
-                        printf("Enter holder name:");
+                        printf("Enter holder name (or part of it):");
                         str=getStr(); // Read name to search.
-                        format(str); // Format input name (capitalization) to match stored format.
-                        while(head){ // Traverse list.
-                                if(!strcmp(str,head->name))break; // Found.
-                                head=head->nxt;
-                        }
+                        n=idxName(str,cand,IDX_NAME_MAX); // Ranked matches; case and punctuation do not matter.
                         free(str); // Free temporary string.
+                        head=n?cand[0]:NULL; // A single match is taken as it is.
+                        if(n<2)break;
+                        for(i=0;i<n;i++) // Let the teller pick among several matches.
+                                printf("%d) %-20llu|%-30s|+91-%llu\n",i+1,cand[i]->num,cand[i]->name,cand[i]->phno);
+                        printf(BYELLOW"Select account:"RESET);
+                        str=getStr(); // Candidate number (getKey would upcase the digit away).
+                        i=atoi(str);
+                        free(str);
+                        head=((i>=1)&&(i<=n))?cand[i-1]:NULL; // Anything else cancels.
                         break;
                 case 'U': // Search by Username.
                         printf("Enter username:");
                         str=getStr(); // Read username to search.
-                        while(head){ // Traverse list.
-                                if(!strcmp(str,head->usrName))break; // Found.
-                                head=head->nxt;
-                        }
+                        head=idxUsr(str); // Username index.
                         free(str); // Free temporary string.
                         break;
                 default:puts("invalid choice"); // Invalid search option.
@@ -699,16 +711,105 @@ Acc* getAcc(Acc *head){
 ///
 
 ///
+static Acc *retired=NULL; // Closed accounts unlinked since the last save, chained through prv.
+
 /**
- * @brief Placeholder for deleting an account. Currently not implemented.
+ * @brief Unlinks a closed account from the list and the indexes in O(1).
+ * The node is not freed: its nxt is left alone, so a list walk standing on it still reaches
+ * the rest of the list, and it waits on the retired chain until saveData compacts it.
  * @param head Pointer to the pointer of the first account in the list.
+ * @param usr Pointer to the `Acc` structure, already marked CARD_CLOSED.
  */
-void dltAcc(Acc **head){ // Function to delete an account.
-        if(!(*head))return; // If list is empty, do nothing.
+static void unlinkAcc(Acc **head,Acc *usr){
+        idxRemove(usr); // No lookup finds it any more.
+        if(usr->prv)usr->prv->nxt=usr->nxt; // Predecessor skips it.
+        else *head=usr->nxt; // It was the head.
+        if(usr->nxt)usr->nxt->prv=usr->prv;
+        usr->prv=retired; // prv is free now, reused for the retired chain.
+        retired=usr;
+}
 
-        //travese to acc // Placeholder comment for traversal logic.
-        //delete         // Placeholder comment for deletion logic.
-        // This function is not implemented.
+/**
+ * @brief Appends the tombstone of a closed account to the ATM journal ("../dataz/Db.jrn").
+ * Same record layout as the ATM writes, op 'C' and card status CARD_CLOSED, so both
+ * syncData implementations replay it; it is durable before dltAcc returns.
+ * @param usr Pointer to the `Acc` structure.
+ */
+static void jrnClose(const Acc *usr){
+        char buf[256],bal[MON_LEN]; // Formatted record; balance in rupees.
+        int n;
+        monFmt(bal,usr->bal);
+        n=snprintf(buf,sizeof(buf),"%llu,%s,%c,%s,%s,%d,%llu,%llu,%s,%d\n",usr->num,usr->rfid,'C',bal,
+                        usr->pin,CARD_CLOSED,usr->tranCnt,0ULL,"0.00",0);
+        int fd=open("../dataz/Db.jrn",O_WRONLY|O_APPEND|O_CREAT,0644); // O_APPEND keeps the record whole next to ATM records.
+        if((fd<0)||(write(fd,buf,n)!=n)||fdatasync(fd))perror("dltAcc: journal"); // Still closed in memory and at the next save.
+        if(fd>=0)close(fd);
+}
+
+/**
+ * @brief Frees a retired account: node and history go back to their slabs, a typed-in holder name is freed;
+ * what lives in the loaded snapshot (or the name slab) is left alone.
+ * @param usr Pointer to the `Acc` structure.
+ */
+static void freeAcc(Acc *usr){
+        Tran *t,*n; // History walk.
+        for(t=usr->tranHist;t;t=n){
+                n=t->nxt;
+                if(!snapOwns(t))poolPut(&tranPool,t); // Loaded from CSV or added since the load.
+        }
+        stmtFree(usr); // Time-ordered history, if a statement built it.
+        if(!snapOwns(usr->name)&&!poolOwns(&namePool,usr->name))free(usr->name); // Names typed in newAcc/updateAcc.
+        if(!snapOwns(usr))poolPut(&accPool,usr);
+}
+
+/**
+ * @brief Compaction after a save: drops the history files of retired accounts and frees them.
+ * Db.csv was just rewritten without them. Every stripe is held, so no reader still works on a node.
+ * @return Number of accounts compacted.
+ */
+static int compact(void){
+        char path[40]; // History file name.
+        Acc *usr; // Retired account.
+        int n=0; // Accounts compacted.
+        lockAll();
+        while((usr=retired)){
+                retired=usr->prv;
+                sprintf(path,"../dataz/%llu.csv",usr->num); // History file.
+                unlink(path);
+                sprintf(path,"../filez/%llu.csv",usr->num); // Its report copy.
+                unlink(path);
+                freeAcc(usr);
+                n++;
+        }
+        unlockAll();
+        return n;
+}
+
+/**
+ * @brief Closes an account after confirmation.
+ * The account is locked while it is marked CARD_CLOSED (a reader that found it earlier sees
+ * the tombstone once it locks it), the tombstone is journaled, and the node is unlinked
+ * through its prv pointer and the indexes. saveData later compacts it away.
+ * @param head Pointer to the pointer of the first account in the list.
+ * @param usr Pointer to the `Acc` structure of the account to close.
+ */
+void dltAcc(Acc **head,Acc *usr){ // Function to delete an account.
+        char bal[MON_LEN]; // Balance in rupees.
+        if(!(*head)||!usr)return; // If list is empty, do nothing.
+        dispAcc(usr); // Show what is about to be closed.
+        monFmt(bal,usr->bal);
+        if(usr->bal>0)printf("Closing balance to pay out:%s\n",bal);
+        printf("Close this account?(y/n):");
+        if(getKey()!='Y'){
+                puts("Account not closed.");
+                return;
+        }
+        lockAcc(usr);
+        usr->cardStat=CARD_CLOSED; // Tombstone.
+        unlockAcc(usr);
+        jrnClose(usr); // Survives a crash before the next save.
+        unlinkAcc(head,usr);
+        puts(BGREEN"Account Closed."RESET);
 }
 /// End of account retrieval/deletion functions.
 
@@ -718,9 +819,11 @@ void dltAcc(Acc **head){ // Function to delete an account.
  * @param usr Pointer to the `Acc` structure.
  */
 void balance(Acc *usr){
+        char bal[MON_LEN]; // Balance in rupees.
+        monFmt(bal,usr->bal);
         printf("\nAccount Number : %llu\n",usr->num);    // Display account number.
         printf("Holder Name    : %s\n",usr->name);      // Display holder name.
-        printf("Current Balance: %+lf Rs/-\n",usr->bal); // Display current balance with sign and currency.
+        printf("Current Balance: %s%s Rs/-\n",(usr->bal>=0)?"+":"",bal); // Display current balance with sign and currency.
 }
 ///
 
@@ -731,9 +834,9 @@ void balance(Acc *usr){
  * @param usr Pointer to the `Acc` structure for the account.
  */
 void deposit(Acc *usr){
-        f64 amt=0; // Variable to store deposit amount.
+        i64 amt=0; // Variable to store deposit amount, in paise.
         printf("\nEnter Deposit Amount:");
-        scanf("%lf",&amt); // Read deposit amount.
+        amt=getAmt(); // Read deposit amount.
 
         if(amt<=0){ // Validate amount is positive.
                 puts("Amount cannot be negative!!");
@@ -757,9 +860,9 @@ void deposit(Acc *usr){
  * @param usr Pointer to the `Acc` structure for the account.
  */
 void withdraw(Acc *usr){
-        f64 amt=0; // Variable to store withdrawal amount.
+        i64 amt=0; // Variable to store withdrawal amount, in paise.
         printf("\nEnter Withdrawal Amount:");
-        scanf("%lf",&amt); // Read withdrawal amount.
+        amt=getAmt(); // Read withdrawal amount.
         if(amt<=0){ // Validate amount is positive.
                 puts("Amount cannot be negative!!");
                 puts("Try again!!");
@@ -783,25 +886,30 @@ void withdraw(Acc *usr){
 /**
  * @brief Processes a fund transfer from one account to another.
  * Validates amount against limits and sender's balance, updates balances and transaction histories for both accounts.
+ * Both accounts are locked (lockPair) from the balance check to the last history entry, so the
+ * transfer is applied as one step even when other threads work on either account.
  * @param from Pointer to the sender's `Acc` structure.
  * @param to Pointer to the receiver's `Acc` structure.
  */
 void transfer(Acc *from,Acc *to){
-        f64 amt=0; // Variable to store transfer amount.
+        i64 amt=0; // Variable to store transfer amount, in paise.
         printf("\nEnter Transfer Amount:");
-        scanf("%lf",&amt); // Read transfer amount.
+        amt=getAmt(); // Read transfer amount.
         if(amt<=0){ // Validate amount is positive.
                 puts("Amount cannot be negative!!");
                 puts("Try again!!");
         }else if(amt<MAX_TRANSFER){ // Validate against maximum transfer limit.
+                lockPair(from,to); // Ordered by stripe, so opposite transfers cannot deadlock.
                 if(amt<=from->bal){ // Check for sufficient balance in sender's account.
                         from->bal -= amt; // Deduct from sender.
                         to->bal   += amt; // Add to receiver.
                         //update 2 transc of both // Comment indicating transaction updates for both.
                         addTran(to,+amt,TRANSFER_IN);  // Record transfer-in for receiver.
                         addTran(from,-amt,TRANSFER_OUT); // Record transfer-out for sender.
+                        unlockPair(from,to);
                         puts(BGREEN"Amount Transfered."RESET); // Confirmation.
                 }else{
+                        unlockPair(from,to);
                         puts("Low Balance!!"); // Error for insufficient balance.
                 }
         }else{
@@ -819,8 +927,8 @@ void transfer(Acc *from,Acc *to){
  * @param amt The amount of the transaction (can be positive or negative).
  * @param type The type of transaction (e.g., DEPOSIT, WITHDRAW).
  */
-void addTran(Acc *usr,f64 amt,char type){
-        Tran *new=calloc(1,sizeof(Tran)); // Allocate memory for a new transaction.
+void addTran(Acc *usr,i64 amt,char type){
+        Tran *new=poolGet(&tranPool); // Zeroed transaction node from the slab.
         new->amt=amt; // Set transaction amount.
         new->id =getTranId(usr); // Generate a unique transaction ID.
         new->type=type; // Set transaction type.
@@ -830,6 +938,9 @@ void addTran(Acc *usr,f64 amt,char type){
         usr->tranHist=new;      // Head of history now points to the new transaction.
 
         (usr->tranCnt)++; // Increment the account's transaction counter.
+        usr->dirty|=DIRTY_ROW|DIRTY_HIST; // Balance row and history file both change.
+        stmtAdd(usr,new); // Time-ordered history, if a statement built it.
+        rollAdd(new->id,amt,type); // Day and hour totals.
 }
 
 /**
@@ -840,34 +951,110 @@ void addTran(Acc *usr,f64 amt,char type){
  */
 u64 getTranId(Acc *usr){
         //17 digit unq TranID
-        srand(usr->num); // Seed random number generator with account number for variability per account.
-        return getTimeStamp()*1000 +(rand()%1000); // Timestamp (14 digits) * 1000 + 3 random digits.
+        unsigned int seed=(unsigned int)usr->num; // Private seed (rand_r): account number for variability per account, no shared rand state.
+        return getTimeStamp()*1000 +(rand_r(&seed)%1000); // Timestamp (14 digits) * 1000 + 3 random digits.
 }
 /// End of transaction processing functions.
 
 /// Display and reporting functions.
 /**
- * @brief Displays the transaction history for a given account.
- * Lists transaction ID, amount, and type for each transaction.
+ * @brief Prints one page of an account's transactions from day `from` to day `to`, newest first.
+ * The range is found by binary search in the time-ordered history (stmtLib.h), and only the
+ * page's transactions are read, so the cost does not grow with the length of the history.
  * @param usr Pointer to the `Acc` structure.
+ * @param from First day (YYYYMMDD), 0 for the first transaction.
+ * @param to Last day (YYYYMMDD), 0 for the last transaction.
+ * @param page Page number, 0 for the newest STMT_PAGE transactions of the range (clamped to the last page).
+ * @return Number of pages in the range, 0 if it holds no transaction.
  */
-void statement(Acc *usr){
-    Tran *temp = usr->tranHist; // Temporary pointer to traverse transaction history.
-    if (temp) { // Check if there are any transactions.
+u64 stmtPage(Acc *usr,u64 from,u64 to,u64 page){
+        char amt[MON_LEN+1]; // Signed amount in rupees.
+        u64 first,cnt=stmtRange(usr,from,to,&first),pages=(cnt+STMT_PAGE-1)/STMT_PAGE,i,end; // Range, pages, slots of the page.
+        Tran *t; // Transaction printed.
+        if(!cnt){
+                puts((from||to)&&usr->tranCnt?"No transactions in this period!":"No Transaction History!");
+                return 0;
+        }
+        if(page>=pages)page=pages-1;
+        i=first+cnt-page*STMT_PAGE; // One past the newest transaction of the page.
+        end=(i-first>STMT_PAGE)?i-STMT_PAGE:first;
         printf(BCYAN"\n%-20s%-23s%-12s\n", "Transaction ID", "Amount (Rs)","Type"); // Header for statement.
         puts("----------------------------------------"); // Separator line.
-        while (temp) { // Loop through all transactions.
-            printf("%-20llu%-+20.2lf",temp->id,temp->amt); // Print ID and amount (with sign, 2 decimal places).
-            if(temp->type==DEPOSIT)      printf("%-12s\n","Deposit");      // Print type as "Deposit".
-            else if(temp->type==WITHDRAW)printf("%-12s\n","Withdraw");     // Print type as "Withdraw".
-            else if(temp->type==TRANSFER_IN)printf("%-12s\n","Tranfer IN"); // Print type as "Transfer IN".
-            else if(temp->type==TRANSFER_OUT)printf("%-12s\n","Tranfer OUT");// Print type as "Transfer OUT".
-            temp = temp->nxt; // Move to the next transaction.
+        while(i>end){ // Newest first.
+                t=usr->tranOrd[--i];
+                amt[0]='+';
+                monFmt(amt+(t->amt>=0),t->amt); // Sign always shown, monFmt writes the '-'.
+                printf("%-20llu%-20s",t->id,amt); // Print ID and amount (with sign, 2 decimal places).
+                if(t->type==DEPOSIT)      printf("%-12s\n","Deposit");      // Print type as "Deposit".
+                else if(t->type==WITHDRAW)printf("%-12s\n","Withdraw");     // Print type as "Withdraw".
+                else if(t->type==TRANSFER_IN)printf("%-12s\n","Tranfer IN"); // Print type as "Transfer IN".
+                else if(t->type==TRANSFER_OUT)printf("%-12s\n","Tranfer OUT");// Print type as "Transfer OUT".
+                else printf("\n");
         }
-    } else {
-        puts("No Transaction History!"); // Message if no transactions exist.
-    }
-    printf(RESET); // Reset text color.
+        printf("Page %llu of %llu (transactions %llu-%llu of %llu)\n"RESET,page+1,pages,page*STMT_PAGE+1,first+cnt-end,cnt);
+        return pages;
+}
+
+/**
+ * @brief Displays the transaction history of an account for a date range, one page at a time.
+ * Asks for the first and last day (Enter for no bound), then pages with n/N (older) and p/P (newer).
+ * @param usr Pointer to the `Acc` structure.
+ */
+void statement(Acc *usr){
+        char *str,key; // Date as typed, paging key.
+        u64 from,to,page=0,pages; // Range, page shown, pages in the range.
+        printf("\nFrom date (YYYYMMDD, Enter for the first):");
+        str=getStr(); from=strtoull(str,NULL,10); free(str);
+        printf("To date (YYYYMMDD, Enter for the last):");
+        str=getStr(); to=strtoull(str,NULL,10); free(str);
+        while((pages=stmtPage(usr,from,to,page))>1){
+                printf(BYELLOW"n/N: older page, p/P: newer page, other key: done:"RESET);
+                key=getKey();
+                if(key=='N'){if(page+1<pages)page++;}
+                else if(key=='P'){if(page)page--;}
+                else break;
+        }
+}
+
+/**
+ * @brief Displays the bank-wide totals of one day by transaction type, then hour by hour.
+ * Read from the rollups kept by addTran, so no account is visited.
+ */
+void rollups(void){
+        static const char *name[ROLL_TYPES]={"Unknown","Withdraw","Deposit","Tranfer IN","Tranfer OUT"}; // Type slots.
+        char *str,amt[MON_LEN]; // Date as typed, amount text.
+        u64 day; // YYYYMMDD.
+        RollDay d; // Rollups of the day.
+        int h,t; // Hour, type slot.
+        printf("\nEnter date (YYYYMMDD, Enter for today):");
+        str=getStr();
+        day=*str?strtoull(str,NULL,10):getTimeStamp()/1000000; // getTimeStamp is YYYYMMDDHHMMSS.
+        free(str);
+        if(rollGet(day,&d)){
+                printf(BRED"No totals for %llu (last %d days are kept).\n"RESET,day,ROLL_DAYS);
+                return;
+        }
+        printf(BCYAN"\nTotals of %llu\n%-14s%12s%24s\n",day,"Type","Count","Amount (Rs)");
+        puts("--------------------------------------------------");
+        for(t=0;t<ROLL_TYPES;t++){
+                if(!d.tot[t].cnt)continue; // Only types that occurred.
+                monFmt(amt,d.tot[t].sum);
+                printf("%-14s%12llu%24s\n",name[t],d.tot[t].cnt,amt);
+        }
+        printf("\n%-6s","Hour"); // Hour by hour: count and amount of every type.
+        for(t=WITHDRAW;t<ROLL_TYPES;t++)printf("%30s",name[t]);
+        puts("");
+        for(h=0;h<24;h++){
+                for(t=0;(t<ROLL_TYPES)&&!d.hour[h][t].cnt;t++);
+                if(t==ROLL_TYPES)continue; // Quiet hour.
+                printf("%02d    ",h);
+                for(t=WITHDRAW;t<ROLL_TYPES;t++){
+                        monFmt(amt,d.hour[h][t].sum);
+                        printf("%8llu%22s",d.hour[h][t].cnt,amt);
+                }
+                puts("");
+        }
+        printf(RESET); // Reset text color.
 }
 ///
 
@@ -901,67 +1088,285 @@ void database(Acc *head){
 /// End of display/reporting functions.
 
 // File format comments:
-// Transaction file entry format: "%lu,%lf,%c",id,amt,type
-// Account database file entry format: "%lu,%s,%llu,%s,%s,%s,%s,%d,%lf,%llu",num,name,phno,usrName,pass,rfid,pin,cardStat,bal,tranCnt
+// Transaction file entry format: "%lu,<amt>,%c",id,amt,type (oldest first after a HIST_MARK line, newest first in older files)
+// Account database file entry format: "%lu,%s,%llu,%s,%s,%s,%s,%d,<bal>,%llu",num,name,phno,usrName,pass,rfid,pin,cardStat,bal,tranCnt
+// (<amt> and <bal> in rupees with two decimals, written by monFmt and read by monParse)
 
 /// File handling functions.
 //
 
+/**
+ * @brief Brings an account's history file "../dataz/<account_number>.csv" up to date.
+ * When the file already holds the oldest `tranSaved` transactions, only the newer ones are appended,
+ * so a save costs as much as the new data and not the whole history. Otherwise (new account, file in
+ * the older newest-first layout, cut by a crash) the file is rewritten, oldest first after HIST_MARK.
+ * @param usr Pointer to the `Acc` structure.
+ * @param bytes Incremented by the bytes written.
+ * @return 0 on success, -1 if the file could not be written.
+ */
+static int saveHist(Acc *usr,Wr *w,u64 *bytes){
+        char spName[30]; // Buffer for transaction file name.
+        int app=usr->tranSaved&&(usr->tranSaved<=usr->tranCnt),err; // Append to the file; close failed.
+        u64 i=app?usr->tranCnt-usr->tranSaved:usr->tranCnt,k=0; // Newest records missing from the file; records collected.
+        Tran *t,**v=NULL; // History walk; records to write, newest first.
+        if(app&&!i)return 0; // Nothing new.
+        if(i&&!(v=malloc(i*sizeof(Tran*)))){perror("saveData: transaction file");return -1;}
+        for(t=usr->tranHist;t&&(k<i);t=t->nxt)v[k++]=t; // The list is newest first, the file oldest first.
+        sprintf(spName,"../dataz/%llu.csv",usr->num); // Create filename like "dataz/12345.csv".
+        if(wrOpen(w,spName,app)){perror("saveData: transaction file");free(v);return -1;}
+        if(!app)wrStr(w,HIST_MARK "\n");
+        while(k--){ // Write transaction details: "%llu,<amt>,%c\n".
+                wrU64(w,v[k]->id,0);
+                wrChr(w,',');
+                wrMon(w,v[k]->amt);
+                wrChr(w,',');
+                wrChr(w,v[k]->type);
+                wrChr(w,'\n');
+        }
+        free(v);
+        err=wrClose(w);
+        *bytes+=w->bytes;
+        if(err){
+                perror("saveData: transaction file");
+                usr->tranSaved=0; // Unknown tail, the next save rewrites the file.
+                return -1;
+        }
+        usr->tranSaved=usr->tranCnt;
+        return 0;
+}
+
 /**
  * @brief Saves account data and individual transaction histories to CSV files in the "../dataz/" directory.
  * `Db.csv` stores main account details. `<account_number>.csv` stores transaction history for each account.
- * These files are primarily for data persistence and are loaded by `syncData`.
+ * These files are primarily for data persistence and are loaded by `syncData`,
+ * together with the binary snapshot `Db.snap` written after them.
+ * Only changed data is written: nothing when no account is dirty and none was closed, otherwise
+ * Db.csv and the history files of accounts marked DIRTY_HIST, where only new transactions are appended
+ * (see saveHist). Prints how many files and bytes were written.
+ * Db.csv is written to "Db.csv.tmp", synced and renamed over the old file, so a killed save
+ * never leaves a torn Db.csv behind; the ATM journal is removed only once the rename is done.
  * @param head Pointer to the first account in the linked list.
  */
 void saveData(Acc *head){
+        int err=0,n,files=1,bad; // Set if any file could not be written; closed accounts compacted; files written; sync failed.
+        u64 bytes=0; // Bytes written.
+        Acc *db=head; // First account, head is advanced by the loop below.
+        Wr fp=WR_INIT,sp=WR_INIT; // Db.csv, then every history file in turn.
+
+        while(db&&!db->dirty)db=db->nxt; // Look for any change since the last save.
+        if(!db&&!retired){ // Files already hold this state.
+                puts("Saved 0 files, 0 bytes.");
+                return;
+        }
+        db=head;
 
-        FILE *fp=fopen("../dataz/Db.csv","w"); // Open/create the main database CSV file in write mode.
-                                               // This will overwrite the file if it exists.
-        if(!fp) { // Check if file opening failed.
+        // Create the new main database CSV file next to the old one, which stays intact until the rename.
+        if(wrOpen(&fp,"../dataz/Db.csv.tmp",0)) { // Check if file opening failed.
             perror("saveData: Db.csv"); // Print error if Db.csv cannot be opened.
+            wrFree(&fp);
             return;
         }
 
         while(head){ // Iterate through all accounts.
-                // Write account details to Db.csv.
-                fprintf(fp,"%llu,%s,%llu,%s,%s,%s,%s,%d,%lf,%llu\n",head->num,head->name,head->phno,
-                               head->usrName,head->pass,head->rfid,head->pin,head->cardStat,head->bal,head->tranCnt);
-
-                //save bank statement for the current account
-                char spName[30]; // Buffer for transaction file name.
-                sprintf(spName,"../dataz/%llu.csv",head->num); // Create filename like "dataz/12345.csv".
-                FILE *sp=fopen(spName,"w"); // Open/create transaction history file for this account.
-                if(!sp) { // Check if transaction file opening failed.
-                    perror("saveData: transaction file"); // Print error.
-                    // Decide if to continue with next account or stop. Current logic continues.
-                    head=head->nxt;
-                    continue;
+                // Write account details to Db.csv (every row, the file is rewritten as a whole).
+                wrU64(&fp,head->num,0); wrChr(&fp,',');
+                wrStr(&fp,head->name); wrChr(&fp,',');
+                wrU64(&fp,head->phno,0); wrChr(&fp,',');
+                wrStr(&fp,head->usrName); wrChr(&fp,',');
+                wrStr(&fp,head->pass); wrChr(&fp,',');
+                wrStr(&fp,head->rfid); wrChr(&fp,',');
+                wrStr(&fp,head->pin); wrChr(&fp,',');
+                wrI64(&fp,head->cardStat); wrChr(&fp,',');
+                wrMon(&fp,head->bal); wrChr(&fp,',');
+                wrU64(&fp,head->tranCnt,0); wrChr(&fp,'\n');
+                if(!(head->dirty&DIRTY_HIST)){ // History file is up to date.
+                        head=head->nxt;
+                        continue;
                 }
-                Tran *t=head->tranHist; // Pointer to traverse transaction history.
-                while(t){ // Iterate through transactions for this account.
-                        fprintf(sp,"%llu,%lf,%c\n",t->id,t->amt,t->type); // Write transaction details.
-                        t=t->nxt; // Move to next transaction.
-                }
-                fclose(sp); // Close the transaction history file for this account.
+
+                if(saveHist(head,&sp,&bytes))err=1; // The ATM journal is still needed for this account.
+                else{head->dirty&=~DIRTY_HIST;files++;} // History file is current.
                 head=head->nxt; // Move to the next account in the main list.
         }
 
-        fclose(fp); // Close the main database CSV file.
+        wrFree(&sp);
+        bad=wrFlush(&fp)||fsync(fp.fd); // Every row must be on disk before the rename.
+        if(wrClose(&fp)||bad||rename("../dataz/Db.csv.tmp","../dataz/Db.csv")){ // Replace the old file in one step.
+                perror("saveData: Db.csv");
+                unlink("../dataz/Db.csv.tmp");
+                err=1; // The old Db.csv and the journal still hold every change.
+        }else for(head=db;head;head=head->nxt)head->dirty&=~DIRTY_ROW; // Every row is current.
+        bytes+=fp.bytes;
+        wrFree(&fp);
+        printf("Saved %d file(s), %llu bytes.\n",files,bytes); // What this save touched.
+        saveSnap(db); // Binary copy for fast startup; if it fails the older snapshot loses to Db.csv.
+        if((n=compact()))printf("Compacted %d closed account(s).\n",n); // Db.csv no longer has them.
+        // Db.csv now holds every change replayed from the ATM journal, so the journal is done.
+        if(!err){ // Only after the rename and every history file succeeded.
+                unlink("../dataz/Db.jrn");
+                unlink("../dataz/Db.jrn.old");
+        }
+}
+
+/**
+ * @brief Replays the ATM backend's write-ahead journal on top of the loaded accounts.
+ * The ATM appends one line per WTD/DEP/PIN/BLK request to "../dataz/Db.jrn" (and "Db.jrn.old"
+ * while a snapshot is running) instead of rewriting Db.csv, so those changes are applied here.
+ * Record format: "%llu,%s,%c,<bal>,%s,%d,%llu,%llu,<amt>,%d",num,rfid,op,bal,pin,cardStat,tranCnt,tranId,tranAmt,tranType
+ * (<bal> and <amt> in rupees, read with monParse; journals written with %lf read back the same).
+ * Records carry absolute values, so applying one that is already in Db.csv changes nothing.
+ * @param head Pointer to the first account in the linked list.
+ * @param path Journal file to replay.
+ */
+static void jrnReplay(Acc *head,const char *path){
+        FILE *fp=fopen(path,"r"); // Open the journal, a missing file means nothing to replay.
+        u64 num,cnt,tid; // Account number, transaction count and transaction id of a record.
+        char rfid[9],pin[5],op,balTxt[MON_LEN],amtTxt[MON_LEN]; // Card number, PIN, op code, balance and amount text of a record.
+        i64 bal,amt; // Balance and transaction amount of a record, in paise.
+        int stat,type; // Card status and transaction type of a record.
+        Acc *usr; // Account the record belongs to.
+        (void)head; // Accounts are found through the account number index.
+        if(!fp)return;
+        while((fscanf(fp,"%llu,%8[^,],%c,%23[^,],%4[^,],%d,%llu,%llu,%23[^,],%d\n",&num,rfid,&op,balTxt,pin,&stat,&cnt,&tid,amtTxt,&type)==10)
+                        &&!monParse(balTxt,strlen(balTxt),&bal)&&!monParse(amtTxt,strlen(amtTxt),&amt)){
+                usr=idxNum(num); // Find the account by account number.
+                if(!usr)continue; // Account not in Db.csv, skip the record.
+                usr->bal=bal; // Absolute state written by the ATM.
+                strcpy(usr->pin,pin);
+                usr->cardStat=stat;
+                usr->dirty|=DIRTY_ROW; // Db.csv row may be older than the record.
+                if(tid&&(cnt>usr->tranCnt)){ // Transaction not in the history file yet.
+                        Tran *t=poolGet(&tranPool); // Same node addTran would have created.
+                        if(!t){perror("jrnReplay");break;}
+                        t->id=tid;
+                        t->amt=amt;
+                        t->type=type;
+                        t->nxt=usr->tranHist; // Newest first, like addTran.
+                        usr->tranHist=t;
+                        usr->tranCnt++;
+                        usr->dirty|=DIRTY_HIST; // History file lacks it.
+                        rollAdd(tid,amt,type); // Not in the loaded rollups either.
+                }
+        }
+        fclose(fp);
+}
+
+/**
+ * @brief Reads an account's history file "../dataz/<account_number>.csv" into memory, newest first.
+ * Files starting with HIST_MARK are oldest first, so each record is pushed on the head of the list;
+ * older files are newest first and are read in order. Those, and files whose last record was cut
+ * by a crash during an append, are marked to be rewritten by the next saveData.
+ * The nodes are taken from tranPool as one run, in list order.
+ * @param usr Pointer to the `Acc` structure, its history must be empty.
+ * @param cv Reader to use (closed; its buffer is reused from file to file).
+ * @return Number of transactions read, -1 if the file cannot be opened; exits when memory is exhausted.
+ */
+static int loadHist(Acc *usr,Csv *cv){
+        char spName[30]; // Transaction file name.
+        Tran stk[LOAD_BUF],*rec=stk,*c,*g; // Records as read (on the stack for short histories); list nodes; grown buffer.
+        u64 cnt=0,cap=LOAD_BUF,i; // Records read; buffer size; counter.
+        int r,app; // csvTran result; file is oldest first.
+        sprintf(spName,"../dataz/%llu.csv",usr->num); // Construct transaction file name.
+        if(csvOpen(cv,spName))return -1; // No history yet.
+        app=csvLine(cv,HIST_MARK); // Layout of the file; otherwise the first line is already a record.
+
+        // Read transactions from the account's specific CSV file.
+        while((r=csvTran(cv,&rec[cnt]))==1){ // 3 fields expected.
+                if(++cnt<cap)continue;
+                if(!(g=malloc(2*cap*sizeof(Tran)))){perror("syncData: history");exit(1);} // A partial history would be saved over the file.
+                memcpy(g,rec,cnt*sizeof(Tran));
+                if(rec!=stk)free(rec);
+                rec=g;
+                cap*=2;
+        }
+        csvClose(cv); // Close the transaction file.
+        if(cnt&&!(c=poolGetN(&tranPool,cnt))){perror("syncData: history");exit(1);} // One run of nodes for the whole history.
+        for(i=0;i<cnt;i++){ // The list is newest first.
+                c[i]=rec[app?cnt-1-i:i]; // Appendable files are oldest first.
+                c[i].nxt=(i+1<cnt)?&c[i+1]:NULL;
+        }
+        if(rec!=stk)free(rec);
+        usr->tranHist=cnt?c:NULL;
+        usr->tranCnt=cnt; // Could also use the one read from Db.csv, but this re-counts.
+        usr->tranSaved=(app&&!r)?cnt:0; // Anything else is rewritten in the appendable layout.
+        if(!usr->tranSaved)usr->dirty|=DIRTY_HIST;
+        return cnt;
+}
+
+// Accounts whose history files loadCsv's threads read.
+typedef struct{
+        Acc **acc;          // Accounts in list order.
+        u64 cnt;            // Number of accounts.
+        u64 next;           // First account no thread has taken yet.
+        pthread_mutex_t mx; // Guards next.
+}HistJob;
+
+/**
+ * @brief Loader thread: takes LOAD_CHUNK accounts at a time and reads their history files.
+ * Every account is filled by exactly one thread, so no account is shared.
+ * @param arg Pointer to the `HistJob`.
+ * @return NULL.
+ */
+static void* histWork(void *arg){
+        HistJob *j=arg;   // Shared job.
+        Csv c=CSV_INIT;   // This thread's reader.
+        u64 i,end;        // Chunk taken.
+        for(;;){
+                pthread_mutex_lock(&j->mx);
+                i=j->next;
+                end=j->next=(i+LOAD_CHUNK<j->cnt)?i+LOAD_CHUNK:j->cnt;
+                pthread_mutex_unlock(&j->mx);
+                if(i>=end)break; // Every account is taken.
+                for(;i<end;i++)loadHist(j->acc[i],&c);
+        }
+        csvFree(&c);
+        return NULL;
+}
+
+/**
+ * @brief Reads the history files of an account list on one thread per online CPU.
+ * Account rows are already loaded, so each thread only fills whole accounts and the
+ * result is the same for any thread count. Falls back to the calling thread alone
+ * when threads or memory are short.
+ * @param head Pointer to the first account.
+ * @param cnt Number of accounts in the list.
+ */
+static void loadHists(Acc *head,u64 cnt){
+        pthread_t th[LOAD_THREADS_MAX]; // Loader threads.
+        HistJob j={NULL,cnt,0,PTHREAD_MUTEX_INITIALIZER}; // Accounts to fill.
+        long nt=sysconf(_SC_NPROCESSORS_ONLN),i,run=0; // Threads asked for; counter; threads started.
+        if(nt>LOAD_THREADS_MAX)nt=LOAD_THREADS_MAX;
+        if(nt>(long)((cnt+LOAD_CHUNK-1)/LOAD_CHUNK))nt=(cnt+LOAD_CHUNK-1)/LOAD_CHUNK; // No idle threads.
+        if((nt<=1)||!(j.acc=malloc(cnt*sizeof(Acc*)))){ // One thread: no table needed.
+                Csv c=CSV_INIT; // Reader for every file.
+                for(;head;head=head->nxt)loadHist(head,&c);
+                csvFree(&c);
+                return;
+        }
+        for(i=0;head;head=head->nxt)j.acc[i++]=head;
+        for(i=1;i<nt;i++)if(!pthread_create(&th[run],NULL,histWork,&j))run++; // The calling thread is the last worker.
+        histWork(&j);
+        for(i=0;i<run;i++)pthread_join(th[i],NULL);
+        free(j.acc);
 }
 
 /**
  * @brief Loads account data and transaction histories from CSV files in "../dataz/" into memory.
- * Reconstructs the linked list of accounts and their respective transaction histories.
- * This function is typically called at application startup.
+ * Reconstructs the linked list of accounts first, then their transaction histories in parallel (see loadHists).
+ * Used by syncData when there is no usable snapshot. Both file kinds are parsed by csvLib;
+ * reading stops at the first malformed Db.csv row.
  * @param head Pointer to the pointer of the first account, to build/populate the linked list.
+ * @return 0 on success, -1 if Db.csv cannot be opened.
  */
-void syncData(Acc **head){
-        FILE *fp=fopen("../dataz/Db.csv","r"); // Open the main database CSV file in read mode.
-        // int d; // Variable 'd' seems unused in the loop's fscanf.
-        char buf[100]; // Buffer to read the account holder's name (since it can contain commas if not handled carefully, but scanf %[^,] handles it).
-        if(!fp){ // If Db.csv doesn't exist or cannot be opened.
+static int loadCsv(Acc **head){
+        Csv fp=CSV_INIT; // Reader for the main database CSV file.
+        u64 cnt=0; // Accounts read.
+        int r; // csvAcc result.
+        char buf[100]; // Buffer to read the account holder's name into before it is copied to the name slab.
+        if(csvOpen(&fp,"../dataz/Db.csv")){ // If Db.csv doesn't exist or cannot be opened.
                 perror("Sync"); // Print error message.
-                return; // Exit function.
+                csvFree(&fp);
+                return -1; // Exit function.
         }
         puts("syncing"); // Indicate that data synchronization is in progress.
         Acc temp,*tail=NULL; // temp: temporary Acc structure to read data into. tail: to efficiently append to the linked list.
@@ -969,12 +1374,14 @@ void syncData(Acc **head){
         temp.nxt=NULL; // Initialize temporary account's next pointer.
         temp.tranHist=NULL; // Initialize temporary account's transaction history.
         temp.tranCnt=0; // Initialize temporary account's transaction count.
+        temp.tranSaved=0; // Set by loadHist.
+        temp.tranOrd=NULL; // Built by the first ranged statement.
+        temp.ordCnt=temp.ordCap=0;
+        temp.dirty=0;   // Loaded rows match the files they came from.
 
         // Read account data from Db.csv line by line.
-        while(fscanf(fp,"%llu,%[^,],%llu,%[^,],%[^,],%[^,],%[^,],%d,%lf,%llu\n", // Note: added \n to consume newline
-                                &(temp.num),buf,&(temp.phno),temp.usrName,temp.pass,
-                                temp.rfid,temp.pin,&(temp.cardStat),&(temp.bal),&(temp.tranCnt))==10){ // 10 fields expected.
-                temp.name=strdup(buf); // Duplicate the read name into dynamically allocated memory.
+        while((r=csvAcc(&fp,&temp,buf,sizeof(buf)))==1){ // 10 fields expected.
+                temp.name=poolStr(&namePool,buf); // Copy the read name into the name slab.
                 /*
                 // Debugging printf block, commented out.
                 printf("%llu,%s,%llu,%s,%s,%s,%s,%d,%lf,%llu\n",
@@ -986,46 +1393,53 @@ void syncData(Acc **head){
                 while(1); // Infinite loop for debugging.
                 */
 
-                Acc *new =calloc(1,sizeof(Acc)); // Allocate memory for a new account node.
-                memmove(new,&temp,sizeof(Acc)); // Copy data from temp to the new node. new->name now points to the strdup'd memory.
-                                                // temp.name itself will be overwritten by next strdup or be a dangling pointer after loop if not careful.
-                                                // However, since strdup creates new memory each time, this is okay for new->name.
+                Acc *new =poolGet(&accPool); // Account node from the slab.
+                if(!new||!temp.name){perror("syncData");exit(1);} // Out of memory while loading.
+                memmove(new,&temp,sizeof(Acc)); // Copy data from temp to the new node. new->name points into the name slab.
                 new->nxt = NULL; // Ensure the new node's next pointer is NULL before linking.
+                new->prv = tail; // Previous account, NULL for the first one.
 
                 if(!(*head))*head=new; // If list is empty, new node becomes the head.
                 if(tail)tail->nxt=new; // If list is not empty, link previous tail to new node.
                 tail=new; // Update tail to the new node.
 
-                //load bank statement for the current account
-                char spName[30]; // Buffer for transaction file name.
-                sprintf(spName,"../dataz/%llu.csv",new->num); // Construct transaction file name.
-                FILE *sp=fopen(spName,"r"); // Open transaction file in read mode.
-                if(!sp)continue; // If transaction file doesn't exist, skip to next account.
-
-                Tran *th=NULL,*tt=NULL,tm; // th: head of transaction list, tt: tail of transaction list, tm: temporary transaction.
-                int cnt=0; // Counter for transactions read from file for this account.
-                tm.nxt=NULL; // Initialize temporary transaction's next pointer.
-
-                // Read transactions from the account's specific CSV file.
-                while(fscanf(sp,"%llu,%lf,%c\n",&(tm.id),&(tm.amt),&(tm.type))==3){ // 3 fields expected. Added \n.
-                        Tran *c=malloc(sizeof(Tran)); // Allocate memory for a new transaction node.
-                        if(!c) {perror("syncData: malloc Tran"); break;} // Handle allocation failure
-                        cnt++; // Increment transaction counter.
-                        memmove(c,&tm,sizeof(Tran)); // Copy data from tm to new transaction node c.
-                        c->nxt = NULL; // Ensure new transaction node's next pointer is NULL.
-
-                        if(!th)th=c; // If transaction list is empty, new node is head.
-                        if(tt)tt->nxt=c; // Link previous transaction tail to new node.
-                        tt=c; // Update transaction tail.
-                }
-                new->tranHist=th; // Link the reconstructed transaction history to the account.
-                new->tranCnt=cnt; // Update transaction count (could also use the one read from Db.csv, but this re-counts).
-                fclose(sp); // Close the transaction file.
+                cnt++;
         }
-        // After the loop, temp.name might hold a pointer to the last read name if strdup failed or loop exited prematurely.
-        // It's good practice to free(temp.name) if it was conditionally allocated and not transferred, but here it's always transferred or overwritten.
 
-        fclose(fp); // Close the main database file.
+        if(r)fprintf(stderr,"Sync: Db.csv row %llu is malformed, later rows are not loaded\n",cnt+1);
+        csvClose(&fp); // Close the main database file.
+        csvFree(&fp);
+        loadHists(*head,cnt); // Transaction histories, once every account row is in.
+        return 0;
+}
+
+/**
+ * @brief Loads the account database into memory at application startup.
+ * Uses the binary snapshot "../dataz/Db.snap" when it is at least as new as Db.csv,
+ * otherwise imports the CSV files. The ATM journal is replayed on top of either.
+ * @param head Pointer to the pointer of the first account, to build/populate the linked list.
+ */
+void syncData(Acc **head){
+        struct stat sn,cs; // Modification times of the snapshot and of Db.csv.
+        Acc *a,*n; // Account walk.
+        int snap=!stat(SNAP_FILE,&sn); // A snapshot exists.
+        if(snap&&!stat("../dataz/Db.csv",&cs)) // Db.csv saved after the snapshot wins.
+                snap=(sn.st_mtim.tv_sec>cs.st_mtim.tv_sec)||((sn.st_mtim.tv_sec==cs.st_mtim.tv_sec)&&(sn.st_mtim.tv_nsec>=cs.st_mtim.tv_nsec));
+        if(snap&&!loadSnap(head))puts("syncing");
+        else if(loadCsv(head))return; // Neither snapshot nor Db.csv.
+        else rollBuild(*head); // A snapshot carries its rollups, an import counts them.
+        if(idxBuild(*head))perror("syncData: index"); // Lookup indexes, also used by the journal replay.
+        jrnReplay(*head,"../dataz/Db.jrn.old"); // ATM changes of a snapshot that did not finish.
+        jrnReplay(*head,"../dataz/Db.jrn");     // ATM changes since its last snapshot.
+        for(a=*head;a;a=n){ // Tombstones from the journal or an ATM save: unlinked, compacted by the next save.
+                n=a->nxt;
+                if(a->cardStat==CARD_CLOSED)unlinkAcc(head,a);
+        }
+#ifdef DBG // Slab use after the load (build with -DDBG).
+        poolStats(&accPool,stdout);
+        poolStats(&tranPool,stdout);
+        poolStats(&namePool,stdout);
+#endif
 }
 
 /**
@@ -1038,25 +1452,33 @@ void syncData(Acc **head){
 void saveFile(Acc *head){
         unsigned int dd,mon,yy,hh,mm; // Variables to store parts of date and time.
         u64 dum; // Temporary variable for timestamp decomposition.
-        FILE *fp=fopen("../filez/DataBase.csv","w"); // Open/create the main report database file.
-        if(!fp) { perror("saveFile: DataBase.csv"); return; }
+        Wr fp=WR_INIT,sp=WR_INIT; // DataBase.csv, then every statement file in turn.
+        // Open/create the main report database file.
+        if(wrOpen(&fp,"../filez/DataBase.csv",0)) { perror("saveFile: DataBase.csv"); wrFree(&fp); return; }
 
         // Write header row to the main report database file.
-        fprintf(fp,"Account ID,Holder's name,Mobile no.,Username,Password,ATM card no.,ATM pin,Card Satus,Balance,Transactions count\n");
+        wrStr(&fp,"Account ID,Holder's name,Mobile no.,Username,Password,ATM card no.,ATM pin,Card Satus,Balance,Transactions count\n");
         while(head){ // Iterate through all accounts.
                 // Write account details to DataBase.csv.
-                fprintf(fp,"%llu,%s,%llu,%s,%s,%s,%s,%s,%lf,%llu\n",head->num,head->name,head->phno,
-                               head->usrName,head->pass,head->rfid,head->pin,(head->cardStat)?"ACTIVE":"BLOCKED"
-                               ,head->bal,head->tranCnt);
+                wrU64(&fp,head->num,0); wrChr(&fp,',');
+                wrStr(&fp,head->name); wrChr(&fp,',');
+                wrU64(&fp,head->phno,0); wrChr(&fp,',');
+                wrStr(&fp,head->usrName); wrChr(&fp,',');
+                wrStr(&fp,head->pass); wrChr(&fp,',');
+                wrStr(&fp,head->rfid); wrChr(&fp,',');
+                wrStr(&fp,head->pin); wrChr(&fp,',');
+                wrStr(&fp,(head->cardStat)?"ACTIVE":"BLOCKED"); wrChr(&fp,',');
+                wrMon(&fp,head->bal); wrChr(&fp,',');
+                wrU64(&fp,head->tranCnt,0); wrChr(&fp,'\n');
 
                 //save bank statement for the current account in filez directory
                 char spName[40]; // Buffer for transaction report file name.
                 sprintf(spName,"../filez/%llu.csv",head->num); // Create filename like "filez/12345.csv".
-                FILE *sp=fopen(spName,"w"); // Open/create transaction report file.
-                if(!sp) { perror("saveFile: transaction report file"); head=head->nxt; continue; }
+                // Open/create transaction report file.
+                if(wrOpen(&sp,spName,0)) { perror("saveFile: transaction report file"); head=head->nxt; continue; }
 
                 Tran *t=head->tranHist; // Pointer to traverse transaction history.
-                fprintf(sp,"Date,Time,Transaction ID,Amount,Type\n"); // Header for transaction report.
+                wrStr(&sp,"Date,Time,Transaction ID,Amount,Type\n"); // Header for transaction report.
                 while(t){ // Iterate through transactions.
                         // Decompose transaction ID (timestamp based) into date and time components.
                         // Assumes transaction ID structure: YYYYMMDDHHMMSSXXX (last 3 digits are random part)
@@ -1081,15 +1503,21 @@ void saveFile(Acc *head){
                         yy = datetime_part;               // Remaining is year
 
                         // Print formatted date, time, and transaction details.
-                        fprintf(sp,"%02u/%02u/%04u,%02u:%02u,%llu,%.2lf,",dd,mon,yy,hh,mm,t->id,t->amt);
-                        if(t->type==DEPOSIT)            fprintf(sp,"%s\n","Deposit");
-                        else if(t->type==WITHDRAW)      fprintf(sp,"%s\n","Withdraw");
-                        else if(t->type==TRANSFER_IN)   fprintf(sp,"%s\n","Tranfer IN");
-                        else if(t->type==TRANSFER_OUT)  fprintf(sp,"%s\n","Tranfer OUT");
+                        // ("%02u/%02u/%04u,%02u:%02u,%llu,<amt>,").
+                        wrU64(&sp,dd,2); wrChr(&sp,'/'); wrU64(&sp,mon,2); wrChr(&sp,'/'); wrU64(&sp,yy,4); wrChr(&sp,',');
+                        wrU64(&sp,hh,2); wrChr(&sp,':'); wrU64(&sp,mm,2); wrChr(&sp,',');
+                        wrU64(&sp,t->id,0); wrChr(&sp,',');
+                        wrMon(&sp,t->amt); wrChr(&sp,',');
+                        if(t->type==DEPOSIT)            wrStr(&sp,"Deposit\n");
+                        else if(t->type==WITHDRAW)      wrStr(&sp,"Withdraw\n");
+                        else if(t->type==TRANSFER_IN)   wrStr(&sp,"Tranfer IN\n");
+                        else if(t->type==TRANSFER_OUT)  wrStr(&sp,"Tranfer OUT\n");
                         t=t->nxt; // Move to next transaction.
                 }
-                fclose(sp); // Close the transaction report file.
+                if(wrClose(&sp))perror("saveFile: transaction report file"); // Close the transaction report file.
                 head=head->nxt; // Move to the next account.
         }
-        fclose(fp); // Close the main report database file.
+        wrFree(&sp);
+        if(wrClose(&fp))perror("saveFile: DataBase.csv"); // Close the main report database file.
+        wrFree(&fp);
 }
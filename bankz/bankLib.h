@@ -7,10 +7,11 @@
 #ifndef _BANKLIB_H_ // Inclusion guard to prevent multiple inclusions of this header.
 #define _BANKLIB_H_ // Defines the macro _BANKLIB_H_ if not already defined.
 
+#include "monLib.h" // Money in paise (i64) and its parse/format routines.
 
-#define MAX_DEPOSIT      30000 //30K // Maximum amount allowed for a single deposit transaction.
-#define MAX_WITHDRAW     30000 //30k // Maximum amount allowed for a single withdrawal transaction.
-#define MAX_TRANSFER     100000//1lk // Maximum amount allowed for a single transfer transaction.
+#define MAX_DEPOSIT      RUPEES(30000) //30K // Maximum amount allowed for a single deposit transaction, in paise.
+#define MAX_WITHDRAW     RUPEES(30000) //30k // Maximum amount allowed for a single withdrawal transaction, in paise.
+#define MAX_TRANSFER     RUPEES(100000)//1lk // Maximum amount allowed for a single transfer transaction, in paise.
 
 #define NAME_LEN 30 // Maximum length for names (e.g., account holder name, buffer for general strings).
 #define MAX_PASS_LEN 20 // Maximum length for user passwords.
@@ -25,6 +26,16 @@
 #define TRANSFER_IN 3    // Constant representing a transfer-in transaction type.
 #define TRANSFER_OUT 4   // Constant representing a transfer-out transaction type.
 
+#define CARD_CLOSED 3    // Card status of a closed account: a tombstone until the next saveData compacts it away.
+
+#define DIRTY_ROW  1     // Account fields differ from its Db.csv row.
+#define DIRTY_HIST 2     // History differs from its <num>.csv file.
+#define LOAD_THREADS_MAX 64 // Most threads syncData reads history files with (one per online CPU up to this).
+#define LOAD_CHUNK 32        // Accounts a loader thread takes at a time.
+#define LOAD_BUF 64          // History records loadHist reads on the stack before it needs the heap.
+
+#define HIST_MARK "#APPEND" // First line of a history file kept oldest first (saveData appends new records); older files are newest first.
+
 #define CAPS(ch) (ch &=~(32)) // Macro to convert a lowercase character to uppercase by clearing the 6th bit.
 
 //decorations - ANSI escape codes for text coloring in the console.
@@ -39,13 +50,12 @@
 #define BWHITE  "\033[1;37m"    // Bold White text.
 
 typedef unsigned long long int u64; // Typedef for unsigned 64-bit integer, commonly used for IDs and large numbers.
-typedef double f64;                 // Typedef for double-precision floating-point number, used for monetary amounts.
 
 // Structure to represent a single transaction.
 // Used to store details of each financial operation like deposit, withdrawal, or transfer.
-// Format for storage/parsing: "%lu,%lf,%c",id,amt,type
+// Format for storage/parsing: "%lu,<amt>,%c",id,amt,type (<amt> in rupees, see monFmt)
 typedef struct A{
-        f64 amt;          // The amount of money involved in the transaction. Positive for deposit/transfer_in, negative for withdrawal/transfer_out.
+        i64 amt;          // The amount of money involved in the transaction, in paise. Positive for deposit/transfer_in, negative for withdrawal/transfer_out.
         u64 id;           // Unique identifier for this transaction.
         char type;        // Type of the transaction (e.g., WITHDRAW, DEPOSIT, TRANSFER_IN, TRANSFER_OUT).
 
@@ -54,21 +64,27 @@ typedef struct A{
 
 // Structure to represent a bank account.
 // Contains all details related to a customer's account.
-// Format for storage/parsing: "%lu,%s,%lu,%s,%s,%s,%s,%d,%lf,%lu",num,name,phno,usrName,pass,rfid,pin,cardStat,bal,tranCnt
+// Format for storage/parsing: "%lu,%s,%lu,%s,%s,%s,%s,%d,<bal>,%lu",num,name,phno,usrName,pass,rfid,pin,cardStat,bal,tranCnt
 typedef struct B{
         u64 num;                    // Unique account number/identifier for this account.
-        f64 bal;                    // Current bank balance of the account.
+        i64 bal;                    // Current bank balance of the account, in paise.
         u64 phno;                   // Phone number of the account holder.
         char usrName[MAX_USRN_LEN]; // Username for logging into the account.
         char pass[MAX_PASS_LEN];    // Password for logging into the account.
         char rfid[9];               // RFID card number associated with the account (8 digits + null terminator).
         char pin[5];                // ATM PIN for the card (4 digits + null terminator).
-        int cardStat;               // Status of the ATM card: 1-active, 0-blocked due to wrong login, 2-blocked during pin change.
+        int cardStat;               // Status of the ATM card: 1-active, 0-blocked due to wrong login, 2-blocked during pin change, 3-account closed.
         char *name;                 // Name of the account holder (dynamically allocated).
 
         Tran *tranHist;             // Pointer to the head of a linked list of transactions (transaction history).
         u64 tranCnt;                // Total count of transactions for this account.
+        u64 tranSaved;              // Oldest transactions already in the history file, 0 if saveData must rewrite it.
+        Tran **tranOrd;             // History oldest first, by ID (see stmtLib.h); NULL until the first ranged statement.
+        u64 ordCnt;                 // Transactions in tranOrd.
+        u64 ordCap;                 // Slots allocated for tranOrd.
+        unsigned char dirty;        // DIRTY_ROW|DIRTY_HIST: what saveData still has to write for this account.
         struct B *nxt;              // Pointer to the next account in a linked list (for the database of accounts).
+        struct B *prv;              // Previous account (NULL for the head), so a closed account is unlinked in O(1).
 }Acc;
 
 extern const int szDb; // Declaration of a global constant, likely representing a size related to database entries.
@@ -154,11 +170,13 @@ void newAcc(Acc**);
 void updateAcc(Acc**,Acc*);
 
 /**
- * @brief Deletes an existing bank account from the database.
- * (Note: Implementation might be missing or incomplete based on bankLib.c).
+ * @brief Closes an account after confirmation.
+ * The account is marked CARD_CLOSED (journaled at once), dropped from the indexes and unlinked
+ * from the list; the node itself is freed, and its Db.csv row and history file removed, by the next saveData.
  * @param head Double pointer to the head of the accounts linked list, allowing modification of the list.
+ * @param usr Pointer to the Acc structure of the account to be closed.
  */
-void dltAcc(Acc**);
+void dltAcc(Acc**,Acc*);
 
 /**
  * @brief Retrieves a specific account from the database based on search criteria.
@@ -193,10 +211,10 @@ void transfer(Acc*,Acc*);
 /**
  * @brief Adds a new transaction record to an account's transaction history.
  * @param usr Pointer to the Acc structure to which the transaction belongs.
- * @param amt The amount of the transaction.
+ * @param amt The amount of the transaction, in paise.
  * @param type The type of the transaction (WITHDRAW, DEPOSIT, etc.).
  */
-void addTran(Acc*,f64,char);
+void addTran(Acc*,i64,char);
 
 /**
  * @brief Displays the current balance of the specified account.
@@ -205,11 +223,26 @@ void addTran(Acc*,f64,char);
 void balance(Acc*);
 
 /**
- * @brief Displays the transaction history for the specified account.
+ * @brief Displays the transaction history of the specified account for a date range, page by page.
  * @param usr Pointer to the Acc structure.
  */
 void statement(Acc*);
 
+/**
+ * @brief Prints one page (STMT_PAGE transactions, newest first) of an account's transactions in a date range.
+ * @param usr Pointer to the Acc structure.
+ * @param from First day (YYYYMMDD), 0 for the first transaction.
+ * @param to Last day (YYYYMMDD), 0 for the last transaction.
+ * @param page Page number, 0 for the newest.
+ * @return Number of pages in the range, 0 if it holds no transaction.
+ */
+u64 stmtPage(Acc *usr,u64 from,u64 to,u64 page);
+
+/**
+ * @brief Displays the bank-wide totals of a day, by transaction type and hour (see rollLib.h).
+ */
+void rollups(void);
+
 /**
  * @brief Displays a summary of all accounts in the database.
  * Shows Account ID, Holder Name, Mobile, and Transaction Count for each account.
@@ -255,6 +288,12 @@ char   getKey(void);
  */
 char* getStr(void);
 
+/**
+ * @brief Reads an amount in rupees (e.g. 500 or 99.50) from standard input.
+ * @return The amount in paise, 0 if the input is not an amount.
+ */
+i64   getAmt(void);
+
 /**
  * @brief Formats a string, typically by capitalizing the first letter of each word.
  * @param str Pointer to the string to be formatted in place.
@@ -265,7 +304,8 @@ void  format(char*);
 
 /**
  * @brief Saves the current state of all accounts and their transaction histories to data files.
- * Typically creates/overwrites CSV files in a 'dataz' directory.
+ * Typically creates/overwrites CSV files in a 'dataz' directory, then the binary snapshot Db.snap.
+ * Removes the ATM journal it now covers.
  * @param head Pointer to the head of the accounts linked list.
  */
 void saveData(Acc *);
@@ -279,7 +319,8 @@ void saveFile(Acc *head);
 
 /**
  * @brief Loads account data and transaction histories from data files into memory at startup.
- * Reads from CSV files in the 'dataz' directory to reconstruct the linked list of accounts.
+ * Maps the binary snapshot Db.snap when it is at least as new as Db.csv, otherwise reads
+ * the CSV files in the 'dataz' directory to reconstruct the linked list of accounts, then applies the ATM backend's journal (Db.jrn) so its latest changes are visible.
  * @param head Double pointer to the head of the accounts linked list, to populate the list.
  */
 void syncData(Acc **);
@@ -76,7 +76,7 @@ int main(){
                                 }
 
                                 // For operations requiring an existing account, prompt for customer/sender info.
-                                if(key=='H'||key=='W'||key=='D'||key=='T'||key=='B'||key=='F'||key=='U'||key=='X'){
+                                if(key=='H'||key=='W'||key=='D'||key=='T'||key=='B'||key=='F'||key=='U'||key=='X'||key=='R'){
                                         puts(BGREEN"=== Enter Customer/Sender Info ==="RESET); // Prompt.
                                         from=getAcc(db); // Search for and get the specified account.
                                         if(!from){ // If account not found.
@@ -89,6 +89,9 @@ int main(){
                                                  break;
                                         case 'U':updateAcc(&db,from); // Update an existing account.
                                                  break;
+                                        case 'R':dltAcc(&db,from); // Close an account.
+                                                 from=NULL; // May be closed, freed by the next save.
+                                                 break;
                                         case 'H':statement(from); // View transaction history for an account.
                                                  break;
                                         case 'W':withdraw(from); // Perform withdrawal for an account.
@@ -104,6 +107,7 @@ int main(){
                                                          key=getKey(); // Get confirmation.
                                                          if(key=='Y'){
                                                          from->cardStat=1; // Activate card.
+                                                         from->dirty|=DIRTY_ROW; // Saved by the next 'Q'.
                                                          puts("card is activated.");
                                                          }
                                                  }else{ // If card is currently ACTIVE.
@@ -112,6 +116,7 @@ int main(){
                                                          key=getKey(); // Get confirmation.
                                                          if(key=='Y'){
                                                          from->cardStat=0; // Deactivate (block) card.
+                                                         from->dirty|=DIRTY_ROW; // Saved by the next 'Q'.
                                                          puts("card is blocked.");
                                                          }
                                                  }
@@ -129,6 +134,8 @@ int main(){
                                                  break;
                                         case 'F':dispAcc(from); // Display details of a specific (found) account.
                                                  break;
+                                        case 'S':rollups(); // Day and hour totals of the whole bank.
+                                                 break;
                                         case 'Q':saveData(db); // Save all data to persistent storage.
                                                  saveFile(db); // Save data to human-readable report files.
                                                  bye=1; // Set flag to exit admin operations loop.
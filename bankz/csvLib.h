@@ -0,0 +1,54 @@
+// csv reader header file
+// Vectorized CSV reader for Db.csv and the history files of the bank application,
+// same scheme as atmz/csvLib.h; it replaces the fscanf("%[^,]") loops of loadCsv and loadHist.
+// The file is read CSV_BUF bytes per read() into one buffer, which is classified 64 bytes at
+// a time into a bit mask of ',' and '\n' positions (AVX2, SSE2 or plain C, picked once at run
+// time from what the CPU has). Fields are cut at the set bits and handed out as (pointer,length)
+// views into the buffer, converted in place by csvU64, csvInt, csvStr and monParse.
+// The buffer comes with the first csvOpen and is kept by later ones, like the Wr of wrLib.h.
+//
+
+#ifndef _CSVLIB_H_ // Inclusion guard to prevent multiple inclusions of this header.
+#define _CSVLIB_H_ // Defines the macro _CSVLIB_H_ if not already defined.
+
+#include "bankLib.h" // Acc, Tran, u64.
+
+#define CSV_BUF (64<<10) // Bytes per read() system call, also the longest field.
+#define CSV_PAD 64       // Slack after the buffer, the last block is classified whole.
+
+#define CSV_END 0  // csvFld: end of file.
+#define CSV_ERR -1 // csvFld: read error, or a field longer than CSV_BUF.
+
+#define CSV_SCALAR 0 // Delimiter scan in plain C.
+#define CSV_SSE2 1   // 16 bytes per compare.
+#define CSV_AVX2 2   // 32 bytes per compare.
+
+// One input file being read.
+typedef struct{
+        int fd;      // Source file, -1 when closed.
+        int eof;     // Set once read() returned 0.
+        int err;     // errno of a failed read, E2BIG for an oversized field, 0 if none.
+        char *buf;   // Input buffer (CSV_BUF+CSV_PAD bytes), kept across files until csvFree.
+        size_t len;  // Bytes in buf.
+        size_t pos;  // Start of the next field.
+        size_t blk;  // Offset of the 64 bytes `mask` covers.
+        u64 mask;    // Delimiters at blk+bit, the ones before pos already taken.
+        u64 bytes;   // Bytes read since csvOpen.
+}Csv;
+
+#define CSV_INIT {-1,0,0,NULL,0,0,0,0,0} // Static initializer, no buffer yet.
+
+// Function prototypes.
+int  csvLevel(int want);                         // Selects CSV_AVX2, CSV_SSE2 or CSV_SCALAR (or the best level below it the CPU has); returns the level in use.
+int  csvOpen(Csv *c,const char *path);           // Opens a file and reads its first block; -1 with errno set on error.
+void csvClose(Csv *c);                           // Closes the file, the buffer is kept.
+void csvFree(Csv *c);                            // Releases the buffer of a closed reader.
+int  csvLine(Csv *c,const char *line);           // Skips the first line if it is exactly `line` (CRLF allowed); 1 if skipped.
+int  csvFld(Csv *c,const char **s,size_t *n);    // Next field, valid until the next call; returns ',' or '\n', CSV_END or CSV_ERR.
+int  csvU64(const char *s,size_t n,u64 *v);      // 1 to 20 digits like "%llu"; -1 if not a number or too large.
+int  csvInt(const char *s,size_t n,int *v);      // Optionally negative int like "%d"; -1 if not a number or too large.
+int  csvStr(const char *s,size_t n,char *d,size_t cap);    // Copies a non-empty field that fits `cap` (null included); -1 otherwise.
+int  csvAcc(Csv *c,Acc *a,char *name,size_t cap);          // One Db.csv row, the holder's name into `name`; 1, 0 at end of file, -1 if malformed.
+int  csvTran(Csv *c,Tran *t);                    // One history record; 1, 0 at end of file, -1 if malformed or cut (no '\n').
+
+#endif // End of inclusion guard _CSVLIB_H_.
@@ -0,0 +1,488 @@
+#include <stdlib.h>  // calloc, realloc, free, qsort.
+#include <string.h>  // strcmp, memmove.
+#include <ctype.h>   // isalnum, tolower.
+#include <stdint.h>  // uintptr_t.
+#include "idxLib.h"  // Index structure and prototypes.
+
+// Secondary indexes over the account list, see idxLib.h.
+
+Idx usrIdx={.kind=IDX_USR}; // Username index.
+Idx phIdx ={.kind=IDX_PH};  // Phone number index.
+Idx numIdx={.kind=IDX_NUM}; // Account number index.
+Idx rfIdx ={.kind=IDX_RF};  // RFID card index.
+NameIdx nameIdx;            // Holder name word index.
+
+#define NAME_WORDS 16 // Words of a name or query looked at when ranking.
+#define WORD_MAX   64 // Longest word kept when ranking (the rest is ignored).
+
+/**
+ * @brief Mixes the bits of a key (splitmix64 finalizer).
+ * Account numbers, phone numbers and card numbers are handed out close together,
+ * so their raw values would cluster in the low bits used as the home slot.
+ * @param k Key or string hash.
+ * @return Well distributed hash value.
+ */
+static u64 mix(u64 k){
+        k^=k>>30; k*=0xbf58476d1ce4e5b9ULL; // First xor-shift-multiply round.
+        k^=k>>27; k*=0x94d049bb133111ebULL; // Second xor-shift-multiply round.
+        return k^(k>>31);                   // Final xor-shift.
+}
+
+/**
+ * @brief Returns a pointer to the key an account is indexed by.
+ * @param kind Index kind.
+ * @param usr Pointer to the `Acc` structure.
+ * @return The username or RFID string, or a pointer to the u64 phone/account number.
+ */
+static const void* keyOf(int kind,const Acc *usr){
+        switch(kind){
+                case IDX_USR:return usr->usrName;
+                case IDX_PH :return &usr->phno;
+                case IDX_NUM:return &usr->num;
+                default     :return usr->rfid;
+        }
+}
+
+/**
+ * @brief Hashes a key of the given kind (FNV-1a for strings, then mixed).
+ * @param kind Index kind.
+ * @param key Key as returned by keyOf.
+ * @return 64-bit hash.
+ */
+static u64 hashKey(int kind,const void *key){
+        const unsigned char *s=key; // String keys.
+        u64 h=0xcbf29ce484222325ULL; // FNV-1a offset basis.
+        if((kind==IDX_PH)||(kind==IDX_NUM))return mix(*(const u64*)key); // Numeric keys.
+        while(*s){h^=*s++; h*=0x100000001b3ULL;} // FNV-1a over the string.
+        return mix(h);
+}
+
+/**
+ * @brief Checks whether an account is indexed by the given key.
+ * @param kind Index kind.
+ * @param usr Pointer to the `Acc` structure.
+ * @param key Key as returned by keyOf.
+ * @return 1 if the account's key equals `key`, 0 otherwise.
+ */
+static int keyIs(int kind,const Acc *usr,const void *key){
+        switch(kind){
+                case IDX_USR:return !strcmp(usr->usrName,key);
+                case IDX_PH :return usr->phno==*(const u64*)key;
+                case IDX_NUM:return usr->num==*(const u64*)key;
+                default     :return !strcmp(usr->rfid,key);
+        }
+}
+
+/**
+ * @brief Allocates an empty table sized for at least `hint` accounts at a load factor of 1/2.
+ * @param idx Index to initialize (its kind is kept).
+ * @param hint Expected number of accounts.
+ * @return 0 on success, -1 on allocation failure.
+ */
+static int init(Idx *idx,u64 hint){
+        u64 cap=IDX_MIN_CAP; // Table size, doubled until it fits twice the hint.
+        while(cap<hint*2)cap<<=1;
+        idx->slot=calloc(cap,sizeof(Acc*)); // NULL slots are empty.
+        idx->hash=calloc(cap,sizeof(u64));
+        if(!idx->slot||!idx->hash){
+                free(idx->slot); free(idx->hash);
+                idx->slot=NULL; idx->hash=NULL; idx->cap=idx->cnt=0;
+                return -1;
+        }
+        idx->cap=cap;
+        idx->cnt=0;
+        return 0;
+}
+
+/**
+ * @brief Releases the table of an index (the accounts are not touched).
+ * @param idx Index to release.
+ */
+static void release(Idx *idx){
+        free(idx->slot);
+        free(idx->hash);
+        idx->slot=NULL; idx->hash=NULL;
+        idx->cap=idx->cnt=0;
+}
+
+/**
+ * @brief Doubles the table and reinserts every entry.
+ * @param idx Index to grow.
+ * @return 0 on success, -1 on allocation failure (the old table stays valid).
+ */
+static int grow(Idx *idx){
+        Idx big={.kind=idx->kind}; // New, larger table.
+        u64 i,j,m; // Old slot, new slot, new mask.
+        if(init(&big,idx->cap))return -1; // cap entries at load 1/2 gives twice the slots.
+        m=big.cap-1;
+        for(i=0;i<idx->cap;i++){
+                if(!idx->slot[i])continue;
+                for(j=idx->hash[i]&m;big.slot[j];j=(j+1)&m); // First free slot of the entry's run.
+                big.slot[j]=idx->slot[i];
+                big.hash[j]=idx->hash[i];
+        }
+        big.cnt=idx->cnt;
+        release(idx);
+        *idx=big;
+        return 0;
+}
+
+/**
+ * @brief Adds an account to one index under its current key.
+ * For unique keys an entry of another account with the same key is replaced;
+ * the phone index keeps every account sharing a number.
+ * @param idx Index to update.
+ * @param usr Pointer to the `Acc` structure.
+ * @return 0 on success, -1 on allocation failure.
+ */
+int idxPut(Idx *idx,Acc *usr){
+        const void *key=keyOf(idx->kind,usr); // Key of the account.
+        u64 h=hashKey(idx->kind,key),i,m; // Hash, slot, mask.
+        if(!idx->cap&&init(idx,0))return -1; // First insert.
+        if(((idx->cnt+1)*2>idx->cap)&&grow(idx))return -1; // Keeps the load factor at or below 1/2.
+        m=idx->cap-1;
+        for(i=h&m;idx->slot[i];i=(i+1)&m){ // Walks the probe run.
+                if(idx->slot[i]==usr)return 0; // Already indexed.
+                if((idx->kind!=IDX_PH)&&(idx->hash[i]==h)&&keyIs(idx->kind,idx->slot[i],key)){
+                        idx->slot[i]=usr; // Unique key now belongs to this account.
+                        return 0;
+                }
+        }
+        idx->slot[i]=usr; // Claims the empty slot at the end of the run.
+        idx->hash[i]=h;
+        idx->cnt++;
+        return 0;
+}
+
+/**
+ * @brief Removes an account from one index.
+ * Must be called while the account still has the key it was indexed by.
+ * Uses backward-shift deletion, so no tombstones are left and probe runs stay short.
+ * @param idx Index to update.
+ * @param usr Pointer to the `Acc` structure.
+ * @return 1 if the entry was removed, 0 if the account was not indexed.
+ */
+int idxDel(Idx *idx,const Acc *usr){
+        u64 i,j,m; // Hole, scan position, mask.
+        if(!idx->cap)return 0;
+        m=idx->cap-1;
+        for(i=hashKey(idx->kind,keyOf(idx->kind,usr))&m;idx->slot[i]!=usr;i=(i+1)&m)
+                if(!idx->slot[i])return 0; // End of the run, not indexed.
+        for(j=i;;){
+                j=(j+1)&m; // Next slot of the run.
+                if(!idx->slot[j])break; // End of the run.
+                if(((j-(idx->hash[j]&m))&m)<((j-i)&m))continue; // Home lies between the hole and j, entry stays.
+                idx->slot[i]=idx->slot[j]; // Moves the entry back into the hole.
+                idx->hash[i]=idx->hash[j];
+                i=j; // Moved-from slot is the new hole.
+        }
+        idx->slot[i]=NULL;
+        idx->cnt--;
+        return 1;
+}
+
+/**
+ * @brief Looks up a key in one index.
+ * @param idx Index to search.
+ * @param key Key as returned by keyOf.
+ * @return The account (on the phone index the one with the highest account number), or NULL.
+ */
+static Acc* find(const Idx *idx,const void *key){
+        u64 h,i,m; // Hash, slot, mask.
+        Acc *hit=NULL; // Match found so far.
+        if(!idx->cap)return NULL;
+        h=hashKey(idx->kind,key);
+        m=idx->cap-1;
+        for(i=h&m;idx->slot[i];i=(i+1)&m){
+                if((idx->hash[i]!=h)||!keyIs(idx->kind,idx->slot[i],key))continue;
+                if(idx->kind!=IDX_PH)return idx->slot[i]; // Unique key.
+                if(!hit||(idx->slot[i]->num>hit->num))hit=idx->slot[i]; // Newest account, as getAcc's list walk found first.
+        }
+        return hit;
+}
+
+/**
+ * @brief Copies the next word of a name, normalized (letters and digits, lower case).
+ * @param s Pointer to the read position, advanced past the word.
+ * @param w Destination, at least `cap` bytes; longer words are cut.
+ * @param cap Size of `w`.
+ * @return Length of the word before cutting, 0 when the name has no more words.
+ */
+static int nextWord(const char **s,char *w,int cap){
+        const unsigned char *p=(const unsigned char*)*s; // Read position.
+        int n=0; // Characters of the word.
+        while(*p&&!isalnum(*p))p++; // Skips spaces and punctuation.
+        for(;*p&&isalnum(*p);p++,n++)
+                if(n<cap-1)w[n]=tolower(*p);
+        w[(n<cap-1)?n:cap-1]='\0';
+        *s=(const char*)p;
+        return n;
+}
+
+/**
+ * @brief Orders a word and account against a name index entry (word first, then account).
+ * @param w Normalized word.
+ * @param usr Account, NULL sorts before every account.
+ * @param e Entry.
+ * @return <0, 0 or >0 like strcmp.
+ */
+static int entCmp(const char *w,const Acc *usr,const NameEnt *e){
+        int c=strcmp(w,e->word);
+        if(c)return c;
+        return ((uintptr_t)usr>(uintptr_t)e->acc)-((uintptr_t)usr<(uintptr_t)e->acc);
+}
+
+/**
+ * @brief qsort comparator for name index entries.
+ */
+static int entSort(const void *a,const void *b){
+        const NameEnt *x=a; // Left entry.
+        return entCmp(x->word,x->acc,b);
+}
+
+/**
+ * @brief Binary search for the first entry not ordered before (w, usr).
+ * @param w Normalized word.
+ * @param usr Account, NULL for the first entry of the word.
+ * @return Entry position, nameIdx.cnt if every entry is smaller.
+ */
+static u64 lower(const char *w,const Acc *usr){
+        u64 lo=0,hi=nameIdx.cnt,mid; // Search range [lo,hi).
+        while(lo<hi){
+                mid=lo+(hi-lo)/2;
+                if(entCmp(w,usr,&nameIdx.ent[mid])>0)lo=mid+1;
+                else hi=mid;
+        }
+        return lo;
+}
+
+/**
+ * @brief Adds an account's name words to the name index, keeping it sorted.
+ * Each insert shifts the entries behind it; names change rarely, lookups often.
+ * @param usr Pointer to the `Acc` structure.
+ * @return 0 on success, -1 on allocation failure.
+ */
+int idxNamePut(Acc *usr){
+        const char *s=usr->name; // Read position in the name.
+        char w[IDX_WORD_LEN]; // Normalized word.
+        u64 i; // Insert position.
+        if(!s)return 0;
+        while(nextWord(&s,w,sizeof(w))){
+                i=lower(w,usr);
+                if((i<nameIdx.cnt)&&!entCmp(w,usr,&nameIdx.ent[i]))continue; // Word repeats in the name.
+                if(nameIdx.cnt==nameIdx.cap){ // Doubles the array.
+                        u64 cap=nameIdx.cap?nameIdx.cap*2:IDX_MIN_CAP;
+                        NameEnt *ent=realloc(nameIdx.ent,cap*sizeof(NameEnt));
+                        if(!ent)return -1;
+                        nameIdx.ent=ent;
+                        nameIdx.cap=cap;
+                }
+                memmove(&nameIdx.ent[i+1],&nameIdx.ent[i],(nameIdx.cnt-i)*sizeof(NameEnt));
+                memcpy(nameIdx.ent[i].word,w,sizeof(w));
+                nameIdx.ent[i].acc=usr;
+                nameIdx.cnt++;
+        }
+        return 0;
+}
+
+/**
+ * @brief Removes an account's name words from the name index.
+ * Must be called while the account still has the name it was indexed by.
+ * @param usr Pointer to the `Acc` structure.
+ */
+void idxNameDel(const Acc *usr){
+        const char *s=usr->name; // Read position in the name.
+        char w[IDX_WORD_LEN]; // Normalized word.
+        u64 i; // Entry position.
+        if(!s)return;
+        while(nextWord(&s,w,sizeof(w))){
+                i=lower(w,usr);
+                if((i>=nameIdx.cnt)||entCmp(w,usr,&nameIdx.ent[i]))continue; // Already removed (repeated word).
+                nameIdx.cnt--;
+                memmove(&nameIdx.ent[i],&nameIdx.ent[i+1],(nameIdx.cnt-i)*sizeof(NameEnt));
+        }
+}
+
+/**
+ * @brief Rebuilds the name index: collects every word, then sorts once.
+ * @param head Pointer to the first account in the linked list.
+ * @return 0 on success, -1 on allocation failure.
+ */
+static int nameBuild(Acc *head){
+        char w[IDX_WORD_LEN]; // Normalized word.
+        const char *s; // Read position in a name.
+        u64 n=0,i=0,cap=IDX_MIN_CAP; // Words, entries filled, allocated entries.
+        Acc *a; // Account iterator.
+        for(a=head;a;a=a->nxt)
+                for(s=a->name;s&&nextWord(&s,w,sizeof(w));)n++;
+        while(cap<n)cap<<=1;
+        free(nameIdx.ent);
+        nameIdx.cnt=nameIdx.cap=0;
+        if(!(nameIdx.ent=malloc(cap*sizeof(NameEnt))))return -1;
+        nameIdx.cap=cap;
+        for(a=head;a;a=a->nxt)
+                for(s=a->name;s&&nextWord(&s,w,sizeof(w));i++){
+                        memcpy(nameIdx.ent[i].word,w,sizeof(w));
+                        nameIdx.ent[i].acc=a;
+                }
+        qsort(nameIdx.ent,i,sizeof(NameEnt),entSort);
+        for(n=0;n<i;n++) // Drops words repeated within one name.
+                if(!n||entSort(&nameIdx.ent[n],&nameIdx.ent[nameIdx.cnt-1]))nameIdx.ent[nameIdx.cnt++]=nameIdx.ent[n];
+        return 0;
+}
+
+/**
+ * @brief Splits a name or query into normalized words.
+ * @param s Name or query.
+ * @param w Words.
+ * @param len Length of each word.
+ * @return Number of words (at most NAME_WORDS).
+ */
+static int words(const char *s,char w[][WORD_MAX],int *len){
+        int n=0; // Words.
+        while((n<NAME_WORDS)&&(len[n]=nextWord(&s,w[n],WORD_MAX)))n++;
+        return n;
+}
+
+/**
+ * @brief Ranks how well an account's name matches a query (lower is better).
+ * 0: same words; 1: the name starts with the query (last query word may be partial);
+ * 2: every query word is a word of the name; 3: every query word starts a word of the name.
+ * @param usr Pointer to the `Acc` structure.
+ * @param q Query words.
+ * @param nq Number of query words.
+ * @return Rank, -1 if some query word starts no word of the name.
+ */
+static int rank(const Acc *usr,char q[][WORD_MAX],int nq){
+        char w[NAME_WORDS][WORD_MAX]; // Name words.
+        int len[NAME_WORDS],nw=words(usr->name,w,len),i,j,whole=1,lead=(nq<=nw); // Word lengths, counts, flags.
+        for(i=0;i<nq;i++){
+                if(lead&&strcmp(q[i],w[i])&&((i<nq-1)||strncmp(q[i],w[i],strlen(q[i]))))lead=0; // Name does not start with the query.
+                for(j=0;j<nw&&strcmp(q[i],w[j]);j++);
+                if(j<nw)continue; // Whole word.
+                whole=0;
+                for(j=0;j<nw&&strncmp(q[i],w[j],strlen(q[i]));j++);
+                if(j==nw)return -1; // Query word matches no word of the name.
+        }
+        if(lead)return ((nq==nw)&&whole)?0:1;
+        return whole?2:3;
+}
+
+/**
+ * @brief Finds accounts whose holder name matches a partial name, best match first.
+ * Only the entries starting with the longest query word are looked at: a binary search
+ * finds the first one, and every candidate is then ranked against all query words.
+ * Ties are ordered by name, then account number.
+ * @param query Partial name, e.g. "siva", "jan ven" or "G Janaki".
+ * @param out Candidates, best first.
+ * @param max Size of `out`.
+ * @return Number of candidates stored in `out`.
+ */
+int idxName(const char *query,Acc **out,int max){
+        char q[NAME_WORDS][WORD_MAX],key[IDX_WORD_LEN]; // Query words, search key.
+        int len[NAME_WORDS],nq=words(query,q,len),k=0,n=0,r,i,j; // Word lengths, count, longest word, results, rank, counters.
+        int rk[IDX_NAME_MAX]; // Rank of every result.
+        u64 e; // Entry position.
+        size_t kl; // Compared length of the search key.
+        Acc *a; // Candidate.
+        if(max>IDX_NAME_MAX)max=IDX_NAME_MAX;
+        if(!nq||(max<=0))return 0;
+        for(i=1;i<nq;i++)if(len[i]>len[k])k=i; // Longest word narrows the range most.
+        strncpy(key,q[k],sizeof(key)-1); // Indexed words are cut to IDX_WORD_LEN-1 characters.
+        key[sizeof(key)-1]='\0';
+        kl=strlen(key);
+        for(e=lower(key,NULL);(e<nameIdx.cnt)&&!strncmp(nameIdx.ent[e].word,key,kl);e++){
+                a=nameIdx.ent[e].acc;
+                for(i=0;(i<n)&&(out[i]!=a);i++);
+                if(i<n)continue; // Already a result (two of its words share the prefix).
+                if((r=rank(a,q,nq))<0)continue;
+                for(i=n;i>0;i--){ // Insertion point among the results.
+                        int c=(rk[i-1]!=r)?rk[i-1]-r:strcmp(out[i-1]->name,a->name);
+                        if(!c)c=(out[i-1]->num>a->num)-(out[i-1]->num<a->num);
+                        if(c<=0)break;
+                }
+                if(i>=max)continue; // Worse than every kept result.
+                for(j=(n<max)?n++:max-1;j>i;j--){out[j]=out[j-1];rk[j]=rk[j-1];}
+                out[i]=a;
+                rk[i]=r;
+        }
+        return n;
+}
+
+/**
+ * @brief Adds an account to every index.
+ * @param usr Pointer to the `Acc` structure.
+ * @return 0 on success, -1 on allocation failure.
+ */
+int idxAdd(Acc *usr){
+        if(idxPut(&usrIdx,usr)||idxPut(&phIdx,usr)||idxPut(&numIdx,usr)||idxPut(&rfIdx,usr))return -1;
+        return idxNamePut(usr);
+}
+
+/**
+ * @brief Removes an account from every index.
+ * @param usr Pointer to the `Acc` structure.
+ */
+void idxRemove(const Acc *usr){
+        idxDel(&usrIdx,usr);
+        idxDel(&phIdx,usr);
+        idxDel(&numIdx,usr);
+        idxDel(&rfIdx,usr);
+        idxNameDel(usr);
+}
+
+/**
+ * @brief (Re)builds every index from the account list, each table sized once for the whole list.
+ * @param head Pointer to the first account in the linked list.
+ * @return 0 on success, -1 on allocation failure.
+ */
+int idxBuild(Acc *head){
+        Idx *all[]={&usrIdx,&phIdx,&numIdx,&rfIdx}; // Every index.
+        u64 n=0; // Number of accounts.
+        Acc *a; // Account iterator.
+        int k; // Index counter.
+        for(a=head;a;a=a->nxt)n++;
+        for(k=0;k<4;k++){
+                release(all[k]);
+                if(init(all[k],n))return -1;
+                for(a=head;a;a=a->nxt)
+                        if(idxPut(all[k],a))return -1;
+        }
+        return nameBuild(head);
+}
+
+/**
+ * @brief Finds the account with a username.
+ * @param usrName Username to search for.
+ * @return Pointer to the account, or NULL.
+ */
+Acc* idxUsr(const char *usrName){
+        return find(&usrIdx,usrName);
+}
+
+/**
+ * @brief Finds an account by phone number.
+ * @param phno Phone number to search for.
+ * @return The newest account (highest account number) with this phone number, or NULL.
+ */
+Acc* idxPhone(u64 phno){
+        return find(&phIdx,&phno);
+}
+
+/**
+ * @brief Finds the account with an account number.
+ * @param num Account number to search for.
+ * @return Pointer to the account, or NULL.
+ */
+Acc* idxNum(u64 num){
+        return find(&numIdx,&num);
+}
+
+/**
+ * @brief Finds the account holding an RFID card.
+ * @param rfid Card number to search for.
+ * @return Pointer to the account, or NULL.
+ */
+Acc* idxRfid(const char *rfid){
+        return find(&rfIdx,rfid);
+}
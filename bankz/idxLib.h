@@ -0,0 +1,71 @@
+// index header file
+// Secondary hash indexes over the account list, so lookups by username, phone number,
+// account number and RFID card no longer walk every account.
+// Each index is an open addressing (linear probing) table of Acc pointers with the
+// 64-bit hash of the key stored beside them, so a probe only touches an account
+// whose hash already matches. Username, account number and RFID are unique keys;
+// several accounts may share a phone number, the phone index keeps all of them.
+// A fifth index serves holder name search: a sorted array of the normalized words
+// of every name (lower case, letters and digits only), so a partial name is found by
+// binary search on its word prefixes and the candidates are ranked by how well
+// they match (see idxName).
+// The indexes are built by syncData and kept current by newAcc and updateAcc.
+// They are changed only from the console thread, like the account list itself.
+//
+
+#ifndef _IDXLIB_H_ // Inclusion guard to prevent multiple inclusions of this header.
+#define _IDXLIB_H_ // Defines the macro _IDXLIB_H_ if not already defined.
+
+#include "bankLib.h" // Acc, u64.
+
+#define IDX_MIN_CAP 256 // Smallest table size (must be a power of two).
+
+#define IDX_USR 0 // Index kind: username.
+#define IDX_PH  1 // Index kind: phone number (not unique).
+#define IDX_NUM 2 // Index kind: account number.
+#define IDX_RF  3 // Index kind: RFID card number.
+
+// One hash index.
+typedef struct{
+        Acc **slot; // Indexed account per slot, NULL marks an empty slot.
+        u64 *hash;  // Hash of the slot's key, compared before the account is touched.
+        u64 cap;    // Number of slots (power of two), 0 until the first insert.
+        u64 cnt;    // Number of used slots.
+        int kind;   // IDX_USR, IDX_PH, IDX_NUM or IDX_RF.
+}Idx;
+
+extern Idx usrIdx,phIdx,numIdx,rfIdx; // The four indexes over the loaded accounts.
+
+#define IDX_WORD_LEN 16 // Indexed bytes of a name word (longer words are compared in full on a hit).
+#define IDX_NAME_MAX 9  // Most candidates getAcc offers for a partial name.
+
+// One word of a holder name in the name index.
+typedef struct{
+        char word[IDX_WORD_LEN]; // Normalized word, cut to IDX_WORD_LEN-1 characters.
+        Acc *acc;                // Account whose name contains the word.
+}NameEnt;
+
+// Holder name index: every word of every name, sorted by word then account.
+typedef struct{
+        NameEnt *ent; // Entries.
+        u64 cnt;      // Used entries.
+        u64 cap;      // Allocated entries.
+}NameIdx;
+
+extern NameIdx nameIdx; // Name index over the loaded accounts.
+
+// Function prototypes.
+int  idxBuild(Acc *head);               // (Re)builds every index from the account list; 0 or -1 on allocation failure.
+int  idxAdd(Acc *usr);                  // Adds an account to every index; 0 or -1 on allocation failure.
+void idxRemove(const Acc *usr);         // Removes an account from every index.
+int  idxPut(Idx *idx,Acc *usr);         // Adds an account to one index (call after changing the key); 0 or -1.
+int  idxDel(Idx *idx,const Acc *usr);   // Removes an account from one index (call before changing the key); 1 if removed.
+Acc* idxUsr(const char *usrName);       // Account with this username, or NULL.
+Acc* idxPhone(u64 phno);                // Newest account (highest account number) with this phone number, or NULL.
+Acc* idxNum(u64 num);                   // Account with this account number, or NULL.
+Acc* idxRfid(const char *rfid);         // Account holding this RFID card, or NULL.
+int  idxNamePut(Acc *usr);              // Adds an account's name words to the name index (call after changing the name); 0 or -1.
+void idxNameDel(const Acc *usr);        // Removes an account's name words (call before changing the name).
+int  idxName(const char *query,Acc **out,int max); // Up to max accounts matching a partial name, best first; returns the count.
+
+#endif // End of inclusion guard _IDXLIB_H_.
@@ -0,0 +1,71 @@
+#include "lockLib.h" // Stripe count and prototypes.
+
+// One stripe, alone on its cache line so neighbouring stripes do not share lines.
+typedef struct{
+        pthread_mutex_t m; // Stripe mutex.
+}__attribute__((aligned(64)))Stripe;
+
+static Stripe stripe[LOCK_STRIPES]={[0 ... LOCK_STRIPES-1]={PTHREAD_MUTEX_INITIALIZER}}; // All stripes, ready to use.
+
+/**
+ * @brief Returns the stripe an account is mapped to (Fibonacci hash of the account number).
+ * @param usr Pointer to the `Acc` structure.
+ * @return Stripe index, 0..LOCK_STRIPES-1.
+ */
+unsigned int lockStripe(const Acc *usr){
+        return (unsigned int)((usr->num*0x9E3779B97F4A7C15ULL)>>56)&(LOCK_STRIPES-1); // Top bits spread sequential numbers.
+}
+
+/**
+ * @brief Locks one account (its stripe).
+ * @param usr Pointer to the `Acc` structure.
+ */
+void lockAcc(const Acc *usr){
+        pthread_mutex_lock(&stripe[lockStripe(usr)].m);
+}
+
+/**
+ * @brief Unlocks one account.
+ * @param usr Pointer to the `Acc` structure.
+ */
+void unlockAcc(const Acc *usr){
+        pthread_mutex_unlock(&stripe[lockStripe(usr)].m);
+}
+
+/**
+ * @brief Locks two accounts, lower stripe first, once if both share a stripe.
+ * @param a Pointer to the first `Acc` structure.
+ * @param b Pointer to the second `Acc` structure.
+ */
+void lockPair(const Acc *a,const Acc *b){
+        unsigned int x=lockStripe(a),y=lockStripe(b); // Stripes of both accounts.
+        if(x==y){pthread_mutex_lock(&stripe[x].m);return;} // One lock covers both.
+        if(x>y){unsigned int t=x;x=y;y=t;} // Same order whatever the argument order.
+        pthread_mutex_lock(&stripe[x].m);
+        pthread_mutex_lock(&stripe[y].m);
+}
+
+/**
+ * @brief Unlocks two accounts locked with lockPair.
+ * @param a Pointer to the first `Acc` structure.
+ * @param b Pointer to the second `Acc` structure.
+ */
+void unlockPair(const Acc *a,const Acc *b){
+        unsigned int x=lockStripe(a),y=lockStripe(b); // Stripes of both accounts.
+        pthread_mutex_unlock(&stripe[x].m);
+        if(x!=y)pthread_mutex_unlock(&stripe[y].m);
+}
+
+/**
+ * @brief Locks every stripe in ascending order; no account changes until unlockAll.
+ */
+void lockAll(void){
+        for(int i=0;i<LOCK_STRIPES;i++)pthread_mutex_lock(&stripe[i].m);
+}
+
+/**
+ * @brief Unlocks every stripe.
+ */
+void unlockAll(void){
+        for(int i=LOCK_STRIPES-1;i>=0;i--)pthread_mutex_unlock(&stripe[i].m);
+}
@@ -0,0 +1,26 @@
+// lock header file
+// Striped account locks for the bank application, same scheme as atmz/lockLib.h.
+// Accounts are mapped by account number onto LOCK_STRIPES mutexes; operations on
+// different accounts usually take different stripes and can run in parallel.
+// Deadlock-free ordering: when more than one stripe is held they are always taken
+// in ascending stripe order (lockPair, lockAll).
+//
+
+#ifndef _LOCKLIB_H_ // Inclusion guard to prevent multiple inclusions of this header.
+#define _LOCKLIB_H_ // Defines the macro _LOCKLIB_H_ if not already defined.
+
+#include "bankLib.h" // Acc.
+#include <pthread.h>  // pthread_mutex_t.
+
+#define LOCK_STRIPES 256 // Number of stripes (must be a power of two).
+
+// Function prototypes.
+unsigned int lockStripe(const Acc *usr);        // Stripe an account is mapped to.
+void lockAcc(const Acc *usr);                   // Locks one account.
+void unlockAcc(const Acc *usr);                 // Unlocks one account.
+void lockPair(const Acc *a,const Acc *b);       // Locks two accounts in stripe order.
+void unlockPair(const Acc *a,const Acc *b);     // Unlocks two accounts locked with lockPair.
+void lockAll(void);                             // Locks every stripe, in order.
+void unlockAll(void);                           // Unlocks every stripe.
+
+#endif // End of inclusion guard _LOCKLIB_H_.
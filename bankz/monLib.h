@@ -0,0 +1,52 @@
+// money header file
+// Money as a signed 64-bit count of paise (100 paise = 1 rupee), same scheme as atmz/monLib.h.
+// Balances and amounts are added and compared as integers, so repeated deposits, withdrawals
+// and transfers never pick up binary rounding error. Every text form (Db.csv, history files,
+// the ATM journal, reports, the console) stays rupees with a decimal point: monParse converts
+// it straight from a (pointer,length) view and monFmt writes it with two decimals, neither
+// going through double, atof or printf.
+//
+
+#ifndef _MONLIB_H_ // Inclusion guard to prevent multiple inclusions of this header.
+#define _MONLIB_H_ // Defines the macro _MONLIB_H_ if not already defined.
+
+#include <stddef.h> // size_t.
+
+typedef long long int i64; // Typedef for signed 64-bit integer, used for money in paise.
+
+#define MON_SCALE 100      // Paise per rupee.
+#define MON_DEC 2          // Decimals of MON_SCALE.
+#define MON_MAX_DIGITS 16  // Most rupee digits monParse accepts (the paise still fit an i64).
+#define MON_LEN 24         // Buffer size that holds any monFmt result ("-92233720368547758.08" and the null).
+
+#define RUPEES(r) ((i64)(r)*MON_SCALE) // Whole rupees in paise (limits, constants).
+
+/**
+ * @brief Converts a rupee amount to paise: optional sign, digits, optional '.' and decimals.
+ * Decimals past the second round half away from zero ("1.005" is 101 paise), so files
+ * written with %lf by older builds read back exactly.
+ * @param s First character of the amount (need not be null-terminated).
+ * @param len Length of the amount.
+ * @param v Converted amount in paise.
+ * @return 0 on success, -1 if the text is not an amount or has too many digits.
+ */
+int monParse(const char *s,size_t len,i64 *v);
+
+/**
+ * @brief Writes the decimal digits of a value backwards, ending just before `end`
+ * (shared by monFmt and the output writer, see wrLib.h).
+ * @param end One past the place of the last digit; at least 20 bytes must precede it.
+ * @param v Value.
+ * @return First digit.
+ */
+char* monDigits(char *end,unsigned long long v);
+
+/**
+ * @brief Writes an amount in paise as rupees with two decimals, e.g. -1234.50.
+ * @param buf Destination, at least MON_LEN bytes; null-terminated.
+ * @param v Amount in paise.
+ * @return Length written (without the null).
+ */
+int monFmt(char *buf,i64 v);
+
+#endif // End of inclusion guard _MONLIB_H_.
@@ -0,0 +1,137 @@
+#include <stdlib.h>  // calloc.
+#include <string.h>  // memset, memcpy, strlen.
+#include "poolLib.h" // Pool structure and prototypes.
+
+Pool accPool=POOL_INIT(sizeof(Acc),128<<10,"acc");    // Account nodes, 128 KB blocks.
+Pool tranPool=POOL_INIT(sizeof(Tran),128<<10,"tran"); // Transaction nodes, 128 KB blocks.
+Pool namePool=POOL_INIT(1,64<<10,"name");             // Holder names, 64 KB blocks.
+
+/**
+ * @brief Size an object takes in a block.
+ * @param p Pointer to the `Pool`.
+ * @return Object size rounded up to POOL_ALIGN; byte pools are not rounded.
+ */
+static size_t objSz(const Pool *p){
+        return (p->sz<POOL_ALIGN)?p->sz:(p->sz+POOL_ALIGN-1)&~(size_t)(POOL_ALIGN-1);
+}
+
+/**
+ * @brief poolGetN with the pool mutex held.
+ * A run that does not fit the current block starts a new one, the old block's tail stays unused;
+ * a run longer than a regular block gets a block of its own and the current block keeps filling.
+ * @param p Pointer to the `Pool`.
+ * @param n Number of objects.
+ * @return The first object, NULL if memory is exhausted.
+ */
+static void* getLocked(Pool *p,size_t n){
+        size_t sz=objSz(p),per=(p->blkSz-POOL_MHDR-sizeof(PoolBlk))/sz,cap; // Object size; objects of a regular block and of a new one.
+        PoolBlk *b=p->blk; // Block being filled.
+        char *o;           // Objects handed out.
+        if(!b||(b->cap-b->used<n)){
+                cap=(n>per)?n:per;
+                if(!(b=calloc(1,sizeof(PoolBlk)+cap*sz)))return NULL; // Zeroed; large blocks come zeroed from mmap.
+                b->cap=cap;
+                if((n>per)&&p->blk){b->nxt=p->blk->nxt;p->blk->nxt=b;}
+                else{b->nxt=p->blk;p->blk=b;}
+                p->blkCnt++;
+                p->reserved+=sizeof(PoolBlk)+cap*sz;
+        }
+        o=(char*)(b+1)+b->used*sz;
+        b->used+=n;
+        p->live+=n;
+        return o;
+}
+
+/**
+ * @brief Takes one zeroed object, from the free list if any.
+ * @param p Pointer to the `Pool`.
+ * @return The object, NULL if memory is exhausted.
+ */
+void* poolGet(Pool *p){
+        void *o; // Object handed out.
+        pthread_mutex_lock(&p->mx);
+        if((o=p->free)){ // Reuse a returned object.
+                p->free=*(void**)o;
+                p->freeCnt--;
+                p->live++;
+                pthread_mutex_unlock(&p->mx);
+                memset(o,0,p->sz);
+                return o;
+        }
+        o=getLocked(p,1);
+        pthread_mutex_unlock(&p->mx);
+        return o;
+}
+
+/**
+ * @brief Takes n zeroed objects lying next to each other.
+ * @param p Pointer to the `Pool`.
+ * @param n Number of objects (at least 1).
+ * @return The first object, NULL if memory is exhausted.
+ */
+void* poolGetN(Pool *p,size_t n){
+        void *o; // First object.
+        pthread_mutex_lock(&p->mx);
+        o=getLocked(p,n);
+        pthread_mutex_unlock(&p->mx);
+        return o;
+}
+
+/**
+ * @brief Returns one object for reuse; its first bytes link the free list.
+ * @param p Pointer to the `Pool` the object came from.
+ * @param o Object.
+ */
+void poolPut(Pool *p,void *o){
+        if(!o)return;
+        pthread_mutex_lock(&p->mx);
+        *(void**)o=p->free;
+        p->free=o;
+        p->freeCnt++;
+        p->live--;
+        pthread_mutex_unlock(&p->mx);
+}
+
+/**
+ * @brief Copies a string into a byte pool.
+ * @param p Pointer to a byte `Pool` (size 1).
+ * @param s String.
+ * @return The copy, NULL if memory is exhausted.
+ */
+char* poolStr(Pool *p,const char *s){
+        size_t n=strlen(s)+1; // Bytes with the terminator.
+        char *d=poolGetN(p,n); // Copy.
+        if(d)memcpy(d,s,n);
+        return d;
+}
+
+/**
+ * @brief Tells whether an address lies in one of the pool's blocks.
+ * @param p Pointer to the `Pool`.
+ * @param o Address.
+ * @return 1 if it does, 0 otherwise.
+ */
+int poolOwns(Pool *p,const void *o){
+        PoolBlk *b;        // Block walk.
+        const char *c=o;   // Address as bytes.
+        int r=0;           // Result.
+        pthread_mutex_lock(&p->mx);
+        for(b=p->blk;b&&!r;b=b->nxt)r=(c>=(const char*)(b+1))&&(c<(const char*)(b+1)+b->cap*objSz(p));
+        pthread_mutex_unlock(&p->mx);
+        return r;
+}
+
+/**
+ * @brief Prints a pool's bytes in use against bytes wasted (block headers, unused block tails
+ * and returned objects).
+ * @param p Pointer to the `Pool`.
+ * @param fp Output stream.
+ */
+void poolStats(Pool *p,FILE *fp){
+        u64 used; // Bytes of live objects.
+        pthread_mutex_lock(&p->mx);
+        used=p->live*objSz(p);
+        fprintf(fp,"%s: %llu live, %.1f MB used, %.1f MB wasted of %.1f MB in %llu blocks (%llu returned)\n",p->name,p->live,
+                        used/1048576.0,(p->reserved-used)/1048576.0,p->reserved/1048576.0,p->blkCnt,p->freeCnt);
+        pthread_mutex_unlock(&p->mx);
+}
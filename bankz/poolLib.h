@@ -0,0 +1,59 @@
+// pool header file
+// Slab allocator for the account, transaction and holder name memory of the bank
+// application, same scheme as atmz/poolLib.h.
+// A pool hands out objects of one size from large blocks: loading takes a whole history
+// as one contiguous run (poolGetN), addTran takes one node (poolGet) with a pointer bump
+// or from the list of returned nodes. There is no malloc header per object, and the
+// nodes of one history sit next to each other in memory.
+// Holder names read from Db.csv are copied into a byte pool (poolStr); such strings
+// are never returned one by one, freeAcc checks poolOwns before freeing a name.
+// Blocks are only given back to the system when the process exits.
+//
+
+#ifndef _POOLLIB_H_ // Inclusion guard to prevent multiple inclusions of this header.
+#define _POOLLIB_H_ // Defines the macro _POOLLIB_H_ if not already defined.
+
+#include "bankLib.h" // Acc, Tran, u64.
+#include <pthread.h>  // pthread_mutex_t.
+#include <stdio.h>    // FILE for poolStats.
+
+#define POOL_ALIGN 8                 // Object sizes are rounded up to this (objects of pointer size or more).
+#define POOL_MHDR (2*sizeof(size_t)) // malloc's own header in front of a block, so a block fills whole pages.
+
+// Header of one block, the objects follow it.
+typedef struct PoolBlk{
+        struct PoolBlk *nxt; // Next block of the pool.
+        size_t cap;          // Objects the block holds.
+        size_t used;         // Objects handed out from it so far (returned ones included).
+        size_t pad;          // Keeps the objects 16-byte aligned on 64 bit hosts.
+}PoolBlk;
+
+// One pool of equal-size objects.
+typedef struct{
+        size_t sz;           // Object size as given (1 for a byte pool, see poolStr).
+        size_t blkSz;        // Bytes per block, malloc's header included.
+        const char *name;    // Printed by poolStats.
+        PoolBlk *blk;        // Blocks, the one being filled first.
+        void *free;          // Returned objects, linked through their first bytes.
+        u64 live;            // Objects handed out and not returned.
+        u64 freeCnt;         // Objects on the free list.
+        u64 blkCnt;          // Blocks allocated.
+        u64 reserved;        // Bytes allocated for blocks, headers included.
+        pthread_mutex_t mx;  // Guards every field above.
+}Pool;
+
+#define POOL_INIT(size,blkSz,name) {(size),(blkSz),(name),NULL,NULL,0,0,0,0,PTHREAD_MUTEX_INITIALIZER} // Static initializer.
+
+extern Pool accPool;  // Acc nodes of loadCsv and newAcc.
+extern Pool tranPool; // Tran nodes of loadCsv, addTran and jrnReplay.
+extern Pool namePool; // Holder names read from Db.csv (byte pool).
+
+// Function prototypes.
+void* poolGet(Pool *p);                 // One zeroed object, from the free list if any; NULL when memory is exhausted.
+void* poolGetN(Pool *p,size_t n);       // n zeroed objects lying next to each other; NULL when memory is exhausted.
+void  poolPut(Pool *p,void *o);         // Returns one object taken with poolGet or poolGetN for reuse.
+char* poolStr(Pool *p,const char *s);   // Copies a string into a byte pool; NULL when memory is exhausted.
+int   poolOwns(Pool *p,const void *o);  // 1 if the address lies in one of the pool's blocks.
+void  poolStats(Pool *p,FILE *fp);      // Prints bytes in use against bytes wasted (headers, block tails, returned objects).
+
+#endif // End of inclusion guard _POOLLIB_H_.
@@ -0,0 +1,67 @@
+#include <string.h>  // For memset.
+#include "rollLib.h" // Rollup layout and prototypes.
+
+RollDay roll[ROLL_DAYS]; // Ring of the newest days.
+
+/**
+ * @brief Checks a YYYYMMDD value and returns its day number (days since 1 March of year 0).
+ * @param ymd YYYYMMDD.
+ * @return Day number, 0 if ymd is not a date.
+ */
+static u64 dayNum(u64 ymd){
+        u64 y=ymd/10000,m=ymd/100%100,d=ymd%100; // Year, month, day.
+        if(!y||(y>9999)||(m<1)||(m>12)||(d<1)||(d>31))return 0;
+        if(m<3){y--;m+=12;} // Years start in March, so the leap day is last.
+        return 365*y+y/4-y/100+y/400+(153*(m-3)+2)/5+d;
+}
+
+/**
+ * @brief Counts one transaction in its day and hour.
+ * Transactions older than the days kept, or whose ID is not a time stamp, are not counted.
+ * @param id Transaction ID (YYYYMMDDHHMMSSRRR).
+ * @param amt Amount in paise.
+ * @param type WITHDRAW, DEPOSIT, TRANSFER_IN or TRANSFER_OUT.
+ */
+void rollAdd(u64 id,i64 amt,int type){
+        u64 day=id/1000000000ULL,hh=id/10000000ULL%100,n=dayNum(day); // YYYYMMDD, hour, day number.
+        int t=((type>=WITHDRAW)&&(type<=TRANSFER_OUT))?type:0; // Type slot.
+        RollDay *d=&roll[n%ROLL_DAYS]; // Slot of the day.
+        if(!n||(hh>23))return; // Not a time stamp ID.
+        if(d->day!=day){
+                if(d->day>day)return; // Older than the days kept.
+                memset(d,0,sizeof(*d)); // First transaction of a new day: the day ROLL_DAYS before goes.
+                d->day=day;
+        }
+        d->tot[t].cnt++;
+        d->tot[t].sum+=amt;
+        d->hour[hh][t].cnt++;
+        d->hour[hh][t].sum+=amt;
+}
+
+/**
+ * @brief Clears the rollups and counts every transaction linked in the account list.
+ * @param head Pointer to the head of the account database.
+ */
+void rollBuild(Acc *head){
+        Tran *t; // History walk.
+        memset(roll,0,sizeof(roll));
+        for(;head;head=head->nxt)
+                for(t=head->tranHist;t;t=t->nxt)rollAdd(t->id,t->amt,t->type);
+}
+
+/**
+ * @brief Copies the rollups of one day.
+ * @param day YYYYMMDD.
+ * @param out Rollups of the day (all zero if nothing happened that day).
+ * @return 0 on success, -1 if the day is not a date or is older than the days kept.
+ */
+int rollGet(u64 day,RollDay *out){
+        u64 n=dayNum(day),newest=0; // Day number, newest day kept.
+        int i; // Slot.
+        if(!n)return -1;
+        for(i=0;i<ROLL_DAYS;i++)if(roll[i].day>newest)newest=roll[i].day;
+        if(newest&&(n+ROLL_DAYS<=dayNum(newest)))return -1; // Its slot belongs to a newer day.
+        if(roll[n%ROLL_DAYS].day==day)*out=roll[n%ROLL_DAYS];
+        else{memset(out,0,sizeof(*out));out->day=day;} // Nothing happened that day.
+        return 0;
+}
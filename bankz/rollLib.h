@@ -0,0 +1,39 @@
+// rollup header file
+// Bank-wide rollups: count and amount of every transaction type per day and per hour,
+// kept up to date by addTran so the admin's day/hour totals need no walk over the accounts.
+// The day and hour come from the transaction ID (YYYYMMDDHHMMSSRRR). The newest ROLL_DAYS
+// days are kept in a ring indexed by day number; the first transaction of a new day takes
+// over the slot of the day ROLL_DAYS before it.
+// The ring is saved with Db.snap and loaded with it; when Db.csv is imported instead it is
+// rebuilt from the loaded histories. The layout must match atmz/rollLib.h.
+//
+
+#ifndef _ROLLLIB_H_ // Inclusion guard to prevent multiple inclusions of this header.
+#define _ROLLLIB_H_ // Defines the macro _ROLLLIB_H_ if not already defined.
+
+#include "bankLib.h" // Acc, u64, i64.
+
+#define ROLL_DAYS  64 // Days kept.
+#define ROLL_TYPES 5  // Type slots: 0 for an unknown type, then WITHDRAW..TRANSFER_OUT.
+
+// Totals of one type in one period.
+typedef struct{
+        u64 cnt; // Transactions.
+        i64 sum; // Amount in paise (withdrawals and transfers out are negative).
+}RollCell;
+
+// Rollups of one day.
+typedef struct{
+        u64 day;                       // YYYYMMDD, 0 for an unused slot.
+        RollCell tot[ROLL_TYPES];      // Whole day.
+        RollCell hour[24][ROLL_TYPES]; // Hour by hour.
+}RollDay;
+
+extern RollDay roll[ROLL_DAYS]; // Ring of the newest days (saved and loaded by snapLib).
+
+// Function prototypes.
+void rollAdd(u64 id,i64 amt,int type); // Counts one transaction in its day and hour, in O(1).
+void rollBuild(Acc *head);             // Clears the rollups and counts every linked transaction.
+int  rollGet(u64 day,RollDay *out);    // Copies the rollups of one day.
+
+#endif // End of inclusion guard _ROLLLIB_H_.
@@ -0,0 +1,173 @@
+#include <stdio.h>     // For fopen, fwrite, setvbuf, perror.
+#include <stdlib.h>    // For calloc, free.
+#include <string.h>    // For memset, memcmp, memcpy, strnlen.
+#include <unistd.h>    // For fsync, unlink, close.
+#include <fcntl.h>     // For open.
+#include <sys/mman.h>  // For mmap, munmap, madvise.
+#include <sys/stat.h>  // For fstat.
+#include "snapLib.h"   // Snapshot layout and prototypes.
+#include "rollLib.h"   // Rollup ring saved after the transactions.
+
+// This file contains the implementation of the binary snapshot
+// declared in snapLib.h. The format is shared with the ATM backend.
+
+#define SNAP_TMP SNAP_FILE".tmp" // Snapshot being written.
+
+static char *map;     // Mapping of the loaded snapshot (names and transactions live here).
+static size_t mapLen; // Its length.
+static Acc *blk;      // Account block built by loadSnap.
+static u64 blkCnt;    // Accounts in the block.
+
+/**
+ * @brief Writes the whole database to SNAP_FILE.
+ * Two passes over the list: one for the header counts and account records,
+ * one for the transaction array; the rollup ring follows.
+ * @param head Pointer to the first account in the linked list.
+ * @return 0 on success, -1 on error (the previous snapshot is kept).
+ */
+int saveSnap(Acc *head){
+        SnapHdr h; // File header.
+        SnapAcc r; // Account record being written.
+        Tran t;    // Transaction record being written (nxt is always NULL on disk).
+        Acc *a;    // Account iterator.
+        Tran *c;   // Transaction iterator.
+        u64 off=0; // Next free slot in the transaction array.
+        FILE *fp=fopen(SNAP_TMP,"w"); // Temporary file, renamed over the old snapshot when complete.
+        if(!fp){perror("saveSnap");return -1;}
+        setvbuf(fp,NULL,_IOFBF,1<<20); // Large buffer, the file is written strictly sequentially.
+
+        memset(&h,0,sizeof(h)); // Zeroes padding and reserved fields.
+        strcpy(h.magic,SNAP_MAGIC);
+        h.ver=SNAP_VER;
+        h.accSz=sizeof(SnapAcc);
+        h.tranSz=sizeof(Tran);
+        h.rollSz=sizeof(RollDay);
+        h.rollDays=ROLL_DAYS;
+        h.flags=SNAP_CLEAN; // Cleared below if any account has unsaved changes.
+        for(a=head;a;a=a->nxt){ // Counts records for the header.
+                h.accCnt++;
+                h.tranCnt+=a->tranCnt;
+                if(a->dirty)h.flags&=~SNAP_CLEAN; // CSV files are behind this snapshot.
+        }
+        fwrite(&h,sizeof(h),1,fp);
+
+        for(a=head;a;a=a->nxt){ // Account records, each pointing at its slice of the transaction array.
+                memset(&r,0,sizeof(r)); // No stale stack bytes in the file.
+                r.num=a->num;
+                r.bal=a->bal;
+                r.phno=a->phno;
+                memcpy(r.usrName,a->usrName,strnlen(a->usrName,sizeof(r.usrName)-1));
+                memcpy(r.pass,a->pass,strnlen(a->pass,sizeof(r.pass)-1));
+                memcpy(r.rfid,a->rfid,strnlen(a->rfid,sizeof(r.rfid)-1));
+                memcpy(r.pin,a->pin,strnlen(a->pin,sizeof(r.pin)-1));
+                if(a->name)memcpy(r.name,a->name,strnlen(a->name,sizeof(r.name)-1));
+                r.cardStat=a->cardStat;
+                r.tranOff=off;
+                r.tranCnt=a->tranCnt;
+                off+=a->tranCnt; // Slices are laid out in list order.
+                fwrite(&r,sizeof(r),1,fp);
+        }
+        for(a=head;a;a=a->nxt){ // Transaction array.
+                u64 n=0; // Records written for this account.
+                for(c=a->tranHist;c&&(n<a->tranCnt);c=c->nxt,n++){ // Newest first, as in memory.
+                        memset(&t,0,sizeof(t));
+                        t.amt=c->amt;
+                        t.id=c->id;
+                        t.type=c->type;
+                        fwrite(&t,sizeof(t),1,fp);
+                }
+                memset(&t,0,sizeof(t)); // Pads a history shorter than tranCnt so offsets stay valid.
+                for(;n<a->tranCnt;n++)fwrite(&t,sizeof(t),1,fp);
+        }
+        fwrite(roll,sizeof(roll),1,fp); // Rollups of the transactions above.
+        int err=ferror(fp)||fflush(fp)||fsync(fileno(fp)); // Everything must reach the disk before the rename.
+        if(fclose(fp)||err){
+                perror("saveSnap");
+                unlink(SNAP_TMP);
+                return -1;
+        }
+        if(rename(SNAP_TMP,SNAP_FILE)){perror("saveSnap");return -1;} // Atomically replaces the previous snapshot.
+        return 0;
+}
+
+/**
+ * @brief Loads SNAP_FILE into memory.
+ * The file is mapped MAP_PRIVATE and writable: linking the transaction records and
+ * terminating the names only dirties this process's pages, the file is never modified.
+ * @param head Pointer to the pointer of the first account (list must be empty).
+ * @return 0 on success, -1 if the file is missing, damaged or from another build.
+ */
+int loadSnap(Acc **head){
+        struct stat st; // File size.
+        char *m;        // Mapped file.
+        SnapHdr *h;     // Header inside the mapping.
+        SnapAcc *ra;    // Account records inside the mapping.
+        Tran *rt;       // Transaction array inside the mapping.
+        Acc *a=NULL;    // Account nodes built from the records.
+        u64 i,j;        // Record counters.
+        int fd=open(SNAP_FILE,O_RDONLY); // Snapshot file.
+        if(fd<0)return -1; // No snapshot.
+        if(fstat(fd,&st)||(st.st_size<(off_t)sizeof(SnapHdr))){close(fd);return -1;} // Too short for a header.
+        m=mmap(NULL,st.st_size,PROT_READ|PROT_WRITE,MAP_PRIVATE,fd,0); // Private copy-on-write mapping.
+        close(fd); // The mapping keeps the file referenced.
+        if(m==MAP_FAILED){perror("loadSnap");return -1;}
+        madvise(m,st.st_size,MADV_SEQUENTIAL); // Pages are touched front to back.
+
+        h=(SnapHdr*)m;
+        if(memcmp(h->magic,SNAP_MAGIC,sizeof(SNAP_MAGIC))||(h->ver!=SNAP_VER)||
+                        (h->accSz!=sizeof(SnapAcc))||(h->tranSz!=sizeof(Tran))||(h->rollSz!=sizeof(RollDay))||(h->rollDays!=ROLL_DAYS)||
+                        (h->accCnt>(u64)st.st_size/sizeof(SnapAcc))||(h->tranCnt>(u64)st.st_size/sizeof(Tran))||
+                        (sizeof(SnapHdr)+h->accCnt*sizeof(SnapAcc)+h->tranCnt*sizeof(Tran)+sizeof(roll)!=(u64)st.st_size)){ // Wrong file, version, build or size.
+                fputs("loadSnap: "SNAP_FILE" is not a valid snapshot\n",stderr);
+                goto bad;
+        }
+        ra=(SnapAcc*)(m+sizeof(SnapHdr));
+        rt=(Tran*)(ra+h->accCnt);
+        if(h->accCnt&&!(a=calloc(h->accCnt,sizeof(Acc)))){perror("loadSnap");goto bad;} // One block for every account.
+
+        for(i=0;i<h->accCnt;i++){
+                SnapAcc *r=&ra[i];
+                if((r->tranOff>h->tranCnt)||(r->tranCnt>h->tranCnt-r->tranOff)){ // Slice outside the transaction array.
+                        fputs("loadSnap: damaged account record\n",stderr);
+                        goto bad;
+                }
+                a[i].num=r->num;
+                a[i].bal=r->bal;
+                a[i].phno=r->phno;
+                memcpy(a[i].usrName,r->usrName,sizeof(r->usrName)); a[i].usrName[sizeof(r->usrName)-1]='\0'; // Copies and terminates every string.
+                memcpy(a[i].pass,r->pass,sizeof(r->pass)); a[i].pass[sizeof(r->pass)-1]='\0';
+                memcpy(a[i].rfid,r->rfid,sizeof(r->rfid)); a[i].rfid[sizeof(r->rfid)-1]='\0';
+                memcpy(a[i].pin,r->pin,sizeof(r->pin)); a[i].pin[sizeof(r->pin)-1]='\0';
+                r->name[sizeof(r->name)-1]='\0'; // Terminated in the private copy.
+                a[i].name=r->name; // Used in place; names are replaced, never freed (see updateAcc).
+                a[i].cardStat=r->cardStat;
+                a[i].dirty=(h->flags&SNAP_CLEAN)?0:DIRTY_ROW|DIRTY_HIST; // CSV files of an unclean snapshot are stale.
+                a[i].tranCnt=r->tranCnt;
+                a[i].tranSaved=(h->flags&SNAP_CLEAN)?r->tranCnt:0; // A clean snapshot matches every history file.
+                a[i].tranHist=r->tranCnt?&rt[r->tranOff]:NULL; // History starts at the account's slice.
+                for(j=0;j+1<r->tranCnt;j++)rt[r->tranOff+j].nxt=&rt[r->tranOff+j+1]; // Links the slice in place.
+                if(r->tranCnt)rt[r->tranOff+r->tranCnt-1].nxt=NULL; // Terminates the history.
+                a[i].nxt=(i+1<h->accCnt)?&a[i+1]:NULL; // Links the accounts in file order.
+                a[i].prv=i?&a[i-1]:NULL;
+        }
+        memcpy(roll,rt+h->tranCnt,sizeof(roll)); // Rollups of the loaded transactions.
+        *head=a; // Publishes the loaded list.
+        map=m; mapLen=st.st_size; // Remembered for snapOwns.
+        blk=a; blkCnt=h->accCnt;
+        return 0;
+bad:
+        free(a); // Nothing was published.
+        munmap(m,st.st_size);
+        return -1;
+}
+
+/**
+ * @brief Tells whether memory belongs to the loaded snapshot (account block or mapping).
+ * @param p Any pointer.
+ * @return 1 if `p` lies inside the loaded snapshot, 0 otherwise.
+ */
+int snapOwns(const void *p){
+        const char *c=p; // Byte address.
+        if(map&&(c>=map)&&(c<map+mapLen))return 1; // Holder name or transaction in the mapping.
+        return blk&&(c>=(const char*)blk)&&(c<(const char*)(blk+blkCnt)); // Account node of the block.
+}
@@ -0,0 +1,74 @@
+// snapshot header file
+// Binary snapshot of the account database ("../dataz/Db.snap"), shared with the ATM backend.
+// Layout: SnapHdr, then accCnt fixed-size SnapAcc records, then one contiguous array of
+// tranCnt Tran records, then the rollup ring (rollDays RollDay records, see rollLib.h).
+// Each account's history is a slice of that array (newest first).
+// The loader maps the file privately and links the Tran records in place, so nothing is
+// parsed or allocated per transaction at startup. Db.csv stays the import/export format.
+// The layout must match atmz/snapLib.h; a snapshot written by another build is rejected
+// (its record sizes are checked) and syncData falls back to Db.csv.
+//
+
+#ifndef _SNAPLIB_H_ // Inclusion guard to prevent multiple inclusions of this header.
+#define _SNAPLIB_H_ // Defines the macro _SNAPLIB_H_ if not already defined.
+
+#include "bankLib.h" // Acc, Tran, u64, i64 and the field lengths.
+
+#define SNAP_FILE  "../dataz/Db.snap" // Snapshot file.
+#define SNAP_MAGIC "ATMSNAP"          // First 8 bytes of every snapshot (with the null terminator).
+#define SNAP_VER   4                  // Format version, bumped whenever SnapAcc, Tran or the CSV layout a clean snapshot vouches for change.
+#define SNAP_CLEAN 1                  // SnapHdr flag: written with no account dirty (the CSV files hold the same state).
+
+// Snapshot file header.
+typedef struct{
+        char magic[8];        // SNAP_MAGIC.
+        unsigned int ver;     // SNAP_VER.
+        unsigned int accSz;   // sizeof(SnapAcc) of the writer.
+        unsigned int tranSz;  // sizeof(Tran) of the writer.
+        unsigned int flags;   // SNAP_CLEAN or 0 (older snapshots: 0).
+        unsigned int rollSz;  // sizeof(RollDay) of the writer.
+        unsigned int rollDays;// ROLL_DAYS of the writer.
+        u64 accCnt;           // Number of account records.
+        u64 tranCnt;          // Number of transaction records.
+}SnapHdr;
+
+// Fixed-size account record.
+typedef struct{
+        u64 num;                    // Account number.
+        i64 bal;                    // Balance, in paise.
+        u64 phno;                   // Phone number.
+        char usrName[MAX_USRN_LEN]; // Username.
+        char pass[MAX_PASS_LEN];    // Password.
+        char rfid[9];               // RFID card number.
+        char pin[5];                // ATM PIN.
+        char name[NAME_LEN];        // Holder name (longer names are cut to NAME_LEN-1 characters).
+        int cardStat;               // Card status.
+        u64 tranOff;                // Index of the account's newest transaction in the transaction array.
+        u64 tranCnt;                // Number of transactions of the account.
+}SnapAcc;
+
+/**
+ * @brief Writes the whole database to SNAP_FILE (via a temporary file and rename).
+ * @param head Pointer to the first account in the linked list.
+ * @return 0 on success, -1 on error (the previous snapshot is kept).
+ */
+int saveSnap(Acc *head);
+
+/**
+ * @brief Loads SNAP_FILE into memory.
+ * Accounts are copied into one Acc array; holder names and transactions are used in place
+ * from the private mapping, which stays for the lifetime of the process.
+ * @param head Pointer to the pointer of the first account (list must be empty).
+ * @return 0 on success, -1 if the file is missing, damaged or from another build.
+ */
+int loadSnap(Acc **head);
+
+/**
+ * @brief Tells whether memory belongs to the loaded snapshot (account block or mapping).
+ * Such memory is never passed to free(); everything else in an account is heap memory.
+ * @param p Any pointer.
+ * @return 1 if `p` lies inside the loaded snapshot, 0 otherwise.
+ */
+int snapOwns(const void *p);
+
+#endif // _SNAPLIB_H_
@@ -0,0 +1,101 @@
+#include <stdio.h>     // For perror.
+#include <stdlib.h>    // For malloc, realloc, free.
+#include <string.h>    // For memmove.
+#include "stmtLib.h"   // Time-ordered history layout and prototypes.
+
+// This file contains the implementation of the time-ordered history
+// declared in stmtLib.h.
+
+/**
+ * @brief Returns the first slot of the array whose transaction ID is not below id.
+ * @param usr Pointer to the `Acc` structure, its array built.
+ * @param id Transaction ID.
+ * @return Slot, usr->ordCnt if every ID is below id.
+ */
+static u64 lowerBound(const Acc *usr,u64 id){
+        u64 lo=0,hi=usr->ordCnt,mid; // Search window [lo,hi).
+        while(lo<hi){
+                mid=lo+(hi-lo)/2;
+                if(usr->tranOrd[mid]->id<id)lo=mid+1;
+                else hi=mid;
+        }
+        return lo;
+}
+
+/**
+ * @brief Builds the time-ordered array of an account from its history list.
+ * tranHist is newest first, so it is filled back to front; IDs made within the
+ * same second are not in order (random last digits) and are sorted into place.
+ * @param usr Pointer to the `Acc` structure.
+ * @return 0 on success (or if already built), -1 if out of memory.
+ */
+int stmtBuild(Acc *usr){
+        Tran *t; // History walk.
+        u64 i,j,cap; // Slots, slots to allocate.
+        if(usr->tranOrd||!usr->tranCnt)return 0;
+        cap=usr->tranCnt+STMT_PAGE; // Room for the next few addTran calls.
+        usr->tranOrd=malloc(cap*sizeof(Tran*));
+        if(!usr->tranOrd){perror("stmtBuild");return -1;}
+        for(i=usr->tranCnt,t=usr->tranHist;i&&t;t=t->nxt)usr->tranOrd[--i]=t;
+        if(i)memmove(usr->tranOrd,usr->tranOrd+i,(usr->tranCnt-i)*sizeof(Tran*)); // List shorter than tranCnt.
+        usr->ordCnt=usr->tranCnt-i;
+        usr->ordCap=cap;
+        for(i=1;i<usr->ordCnt;i++){ // Insertion sort: stable, and linear when only same-second IDs are out of order.
+                t=usr->tranOrd[i];
+                for(j=i;j&&(usr->tranOrd[j-1]->id>t->id);j--)usr->tranOrd[j]=usr->tranOrd[j-1];
+                usr->tranOrd[j]=t;
+        }
+        return 0;
+}
+
+/**
+ * @brief Adds a transaction just linked by addTran to the account's array, if it is built.
+ * A new ID is nearly always the largest and is appended; one made in the same second
+ * as the last (smaller random digits) is shifted into place.
+ * @param usr Pointer to the `Acc` structure.
+ * @param t The new transaction.
+ */
+void stmtAdd(Acc *usr,Tran *t){
+        u64 at; // Slot of the new transaction.
+        if(!usr->tranOrd)return; // Built on the first ranged statement.
+        if(usr->ordCnt==usr->ordCap){ // Grows by half, so appends stay amortized O(1).
+                Tran **n=realloc(usr->tranOrd,(usr->ordCap+usr->ordCap/2+STMT_PAGE)*sizeof(Tran*));
+                if(!n){stmtFree(usr);return;} // Rebuilt by the next ranged statement.
+                usr->tranOrd=n;
+                usr->ordCap+=usr->ordCap/2+STMT_PAGE;
+        }
+        at=(!usr->ordCnt||(usr->tranOrd[usr->ordCnt-1]->id<=t->id))?usr->ordCnt:lowerBound(usr,t->id);
+        memmove(usr->tranOrd+at+1,usr->tranOrd+at,(usr->ordCnt-at)*sizeof(Tran*));
+        usr->tranOrd[at]=t;
+        usr->ordCnt++;
+}
+
+/**
+ * @brief Finds the transactions of an account from day `from` to day `to`, both included.
+ * Builds the array on first use, then two binary searches: O(log n).
+ * @param usr Pointer to the `Acc` structure.
+ * @param from First day (YYYYMMDD), 0 for the first transaction.
+ * @param to Last day (YYYYMMDD), 0 for the last transaction.
+ * @param first Set to the slot of the oldest transaction in the range (usr->tranOrd[*first]).
+ * @return Number of transactions in the range, the newest at usr->tranOrd[*first+count-1].
+ */
+u64 stmtRange(Acc *usr,u64 from,u64 to,u64 *first){
+        u64 lo,hi; // Range [lo,hi) of slots.
+        *first=0;
+        if(stmtBuild(usr)||!usr->ordCnt)return 0;
+        lo=from?lowerBound(usr,STMT_ID(from)):0;
+        hi=to?lowerBound(usr,STMT_ID(to+1)):usr->ordCnt; // Day after `to` (YYYYMMDD+1 is above every ID of `to`).
+        if(hi<=lo)return 0;
+        *first=lo;
+        return hi-lo;
+}
+
+/**
+ * @brief Frees the array of an account (the transactions are not touched).
+ * @param usr Pointer to the `Acc` structure.
+ */
+void stmtFree(Acc *usr){
+        free(usr->tranOrd);
+        usr->tranOrd=NULL;
+        usr->ordCnt=usr->ordCap=0;
+}
@@ -0,0 +1,26 @@
+// statement header file
+// Time-ordered view of an account's history for date-range statements.
+// Transaction IDs start with the time they were made (YYYYMMDDHHMMSS, then 3 random digits),
+// so sorted by ID the history is sorted by time. Each account gets one contiguous array of
+// pointers to its transactions, oldest first (Acc.tranOrd), built from tranHist by the first
+// ranged statement and kept up to date by addTran. A date range is then two binary searches
+// and a page is read straight out of the array, however long the history is.
+// tranHist stays the history everything else walks; the array only points into it.
+//
+
+#ifndef _STMTLIB_H_ // Inclusion guard to prevent multiple inclusions of this header.
+#define _STMTLIB_H_ // Defines the macro _STMTLIB_H_ if not already defined.
+
+#include "bankLib.h" // Acc, Tran, u64.
+
+#define STMT_PAGE 20 // Transactions per statement page.
+
+#define STMT_ID(ymd) ((ymd)*1000000000ULL) // First transaction ID of a day (YYYYMMDD).
+
+// Function prototypes.
+int  stmtBuild(Acc *usr);                            // Builds the time-ordered array from tranHist (no-op if built).
+void stmtAdd(Acc *usr,Tran *t);                      // Adds a new transaction to a built array.
+u64  stmtRange(Acc *usr,u64 from,u64 to,u64 *first); // Transactions from day `from` to day `to`, by binary search.
+void stmtFree(Acc *usr);                             // Frees the array of a retired account.
+
+#endif // End of inclusion guard _STMTLIB_H_.
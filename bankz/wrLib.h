@@ -0,0 +1,43 @@
+// writer header file
+// Buffered output writer for the bank's CSV and report files (Db.csv, history
+// files, ../filez statements), same scheme as atmz/wrLib.h.
+// Fields are formatted straight into a large user-space buffer (numbers with
+// monDigits, amounts with monFmt) instead of going through fprintf's format
+// interpreter, and the buffer leaves with one write() per WR_BUF bytes. The
+// buffer comes with the first wrOpen and is kept by later ones, so one Wr writes
+// a file per account without a malloc per file.
+// A failed write is remembered; wrClose reports it, like fclose after fprintf.
+//
+
+#ifndef _WRLIB_H_ // Inclusion guard to prevent multiple inclusions of this header.
+#define _WRLIB_H_ // Defines the macro _WRLIB_H_ if not already defined.
+
+#include "bankLib.h" // u64, i64.
+
+#define WR_BUF (1<<20) // Buffered bytes per write() system call.
+#define WR_NUM 24      // Room one number or amount needs in the buffer.
+
+// One output file being written.
+typedef struct{
+        int fd;      // Destination file, -1 when closed.
+        int err;     // errno of the first failed write or close, 0 if none.
+        char *buf;   // Output buffer (WR_BUF bytes), kept across files until wrFree.
+        size_t len;  // Bytes waiting in buf.
+        u64 bytes;   // Bytes written to the file since wrOpen (valid after wrFlush or wrClose).
+}Wr;
+
+#define WR_INIT {-1,0,NULL,0,0} // Static initializer, no buffer yet.
+
+// Function prototypes.
+int  wrOpen(Wr *w,const char *path,int append); // Opens (mode 0644) appending or truncating; -1 with errno set on error.
+int  wrFlush(Wr *w);                            // Writes the buffered bytes; -1 if this or an earlier write failed.
+int  wrClose(Wr *w);                            // Flushes and closes, the buffer is kept; -1 with errno set if anything failed.
+void wrFree(Wr *w);                             // Releases the buffer of a closed writer.
+void wrMem(Wr *w,const char *p,size_t n);       // Appends bytes.
+void wrStr(Wr *w,const char *s);                // Appends a null-terminated string.
+void wrChr(Wr *w,char c);                       // Appends one character.
+void wrU64(Wr *w,u64 v,int width);              // Appends an unsigned number like "%0*llu" (width 0 or 1 for no padding).
+void wrI64(Wr *w,i64 v);                        // Appends a signed number like "%lld".
+void wrMon(Wr *w,i64 v);                        // Appends an amount in paise as rupees with two decimals (monFmt).
+
+#endif // End of inclusion guard _WRLIB_H_.